@@ -2,6 +2,9 @@
 // Created by llogan on 7/1/23.
 //
 
+#include <algorithm>
+#include <list>
+#include <random>
 #include <thread>
 #include "basic_test.h"
 #include "hrun/api/hrun_client.h"
@@ -11,6 +14,8 @@
 #include "hrun/work_orchestrator/affinity.h"
 #include "hermes/hermes.h"
 #include "hrun/api/hrun_runtime.h"
+#include "hermes_data_op/reduce_kernels.h"
+#include "hermes/crc32c.h"
 
 /** The performance of getting a queue */
 TEST_CASE("TestGetQueue") {
@@ -52,6 +57,84 @@ TEST_CASE("TestHshmAllocateFree") {
   HILOG(kInfo, "Latency: {} MOps", ops / t.GetUsec());
 }
 
+/** Allocate + free tasks of a given type, bypassing the task cache */
+template<typename TaskT>
+void AllocateFreeUncached(size_t ops, size_t count) {
+  hipc::Allocator *alloc = HRUN_CLIENT->main_alloc_;
+  std::vector<LPointer<TaskT>> tasks(count);
+  for (size_t i = 0; i < ops / count; ++i) {
+    for (size_t j = 0; j < count; ++j) {
+      tasks[j] = alloc->NewObjLocal<TaskT>(alloc);
+    }
+    for (size_t j = 0; j < count; ++j) {
+      alloc->DelObjLocal<TaskT>(tasks[j]);
+    }
+  }
+}
+
+/** Allocate + free tasks of a given type through the task cache */
+template<typename TaskT>
+void AllocateFreeCached(size_t ops, size_t count) {
+  std::vector<LPointer<TaskT>> tasks(count);
+  for (size_t i = 0; i < ops / count; ++i) {
+    for (size_t j = 0; j < count; ++j) {
+      tasks[j] = HRUN_CLIENT->NewEmptyTask<TaskT>();
+    }
+    for (size_t j = 0; j < count; ++j) {
+      HRUN_CLIENT->DelTask(tasks[j]);
+    }
+  }
+  HRUN_CLIENT->FlushTaskCache();
+}
+
+/** Run \a fn on \a nthreads threads and print the aggregate throughput */
+template<typename FUNC>
+void BenchAllocateFree(const std::string &name, size_t nthreads,
+                       size_t ops, FUNC &&fn) {
+  hshm::Timer t;
+  t.Resume();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < nthreads; ++i) {
+    threads.emplace_back([&fn, ops]() { fn(ops); });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  t.Pause();
+  HILOG(kInfo, "{} ({} threads): {} MOps",
+        name, nthreads, nthreads * ops / t.GetUsec());
+}
+
+/** Multi-thread performance of allocating + freeing tasks with and
+ * without the per-thread task cache */
+TEST_CASE("TestTaskCacheAllocateFree") {
+  size_t ops = (1 << 20);
+  for (size_t nthreads : {1, 4, 16}) {
+    for (size_t count : {1, 256}) {
+      BenchAllocateFree(
+          hshm::Formatter::format("Uncached small batch={}", count),
+          nthreads, ops, [count](size_t ops) {
+            AllocateFreeUncached<hrun::Task>(ops, count);
+          });
+      BenchAllocateFree(
+          hshm::Formatter::format("Cached small batch={}", count),
+          nthreads, ops, [count](size_t ops) {
+            AllocateFreeCached<hrun::Task>(ops, count);
+          });
+      BenchAllocateFree(
+          hshm::Formatter::format("Uncached large batch={}", count),
+          nthreads, ops, [count](size_t ops) {
+            AllocateFreeUncached<hrun::Admin::CreateTaskStateTask>(ops, count);
+          });
+      BenchAllocateFree(
+          hshm::Formatter::format("Cached large batch={}", count),
+          nthreads, ops, [count](size_t ops) {
+            AllocateFreeCached<hrun::Admin::CreateTaskStateTask>(ops, count);
+          });
+    }
+  }
+}
+
 /** Single-thread performance of emplacing, and popping a mpsc_ptr_queue */
 TEST_CASE("TestPointerQueueEmplacePop") {
   size_t ops = (1 << 20);
@@ -115,6 +198,47 @@ TEST_CASE("TestHshmQueueEmplacePop") {
   HILOG(kInfo, "Latency: {} MOps", ops / t.GetUsec());
 }
 
+/** Single-thread performance of batched emplace + pop on a lane */
+TEST_CASE("TestLaneEmplacePopN") {
+  hrun::QueueId qid(0, 3);
+  u32 ops = (1 << 20);
+  std::vector<PriorityInfo> queue_info = {
+      {TaskPrio::kAdmin, 1, 1, 1024, 0}
+  };
+  auto queue = hipc::make_uptr<hrun::MultiQueue>(
+      qid, queue_info);
+  auto task = HRUN_CLIENT->NewTaskRoot<hrun::Task>();
+  hrun::LaneGroup &group = queue->GetGroup(0);
+  hrun::Lane &lane = queue->GetLane(0, 0);
+
+  // One entry per atomic
+  hshm::Timer t;
+  t.Resume();
+  hrun::LaneData entry(task.shm_, false);
+  for (size_t i = 0; i < ops; ++i) {
+    lane.emplace(entry);
+    lane.pop(entry);
+  }
+  t.Pause();
+  HILOG(kInfo, "Emplace/Pop: {} MOps", ops / t.GetUsec());
+
+  // Batches of entries per atomic
+  for (size_t batch : {1, 4, 16, 64, 256}) {
+    std::vector<hrun::LaneData> entries(batch, entry);
+    hshm::Timer tb;
+    tb.Resume();
+    for (size_t i = 0; i < ops; i += batch) {
+      group.EmplaceN(0, entries.data(), batch);
+      group.PopN(0, entries.data(), batch);
+    }
+    tb.Pause();
+    HILOG(kInfo, "EmplaceN/PopN (batch={}): {} MOps",
+          batch, ops / tb.GetUsec());
+  }
+
+  HRUN_CLIENT->DelTask(task);
+}
+
 /** Single-thread performance of getting a lane from a queue */
 TEST_CASE("TestHshmQueueGetLane") {
   hrun::QueueId qid(0, 3);
@@ -321,6 +445,163 @@ TEST_CASE("TestTimepointLatency") {
   HILOG(kInfo, "Latency: {} MOps (usec={})", ops / t.GetUsec(), usec);
 }
 
+/** Throughput of the data operator reductions at each SIMD level */
+template<typename T>
+void BenchmarkReduceKernels(const std::string &type_name) {
+  using hermes::data_op::SimdLevel;
+  using hermes::data_op::ReduceKernels;
+  using hermes::data_op::GetReduceKernels;
+  size_t count = MEGABYTES(4) / sizeof(T);
+  size_t reps = 64;
+  std::vector<T> data(count);
+  for (size_t i = 0; i < count; ++i) {
+    data[i] = (T)(i % 1000);
+  }
+  std::vector<u64> bins(16);
+  const ReduceKernels<T> &scalar = GetReduceKernels<T>(SimdLevel::kScalar);
+  for (SimdLevel level : {SimdLevel::kScalar, SimdLevel::kAvx2,
+                          SimdLevel::kAvx512}) {
+    if (level > hermes::data_op::GetSimdLevel()) {
+      break;
+    }
+    const ReduceKernels<T> &kernels = GetReduceKernels<T>(level);
+    hshm::Timer min_t, sum_t, var_t, hist_t;
+    T min = 0;
+    double sum = 0, var = 0;
+    for (size_t i = 0; i < reps; ++i) {
+      min_t.Resume();
+      min = kernels.min_(data.data(), count);
+      min_t.Pause();
+      sum_t.Resume();
+      sum = kernels.sum_(data.data(), count);
+      sum_t.Pause();
+      var_t.Resume();
+      var = kernels.sum_sq_diff_(data.data(), count, sum / count) / count;
+      var_t.Pause();
+      hist_t.Resume();
+      kernels.histogram_(data.data(), count, 0, 1000,
+                         bins.data(), bins.size());
+      hist_t.Pause();
+    }
+    REQUIRE(min == scalar.min_(data.data(), count));
+    REQUIRE(sum == Catch::Approx(scalar.sum_(data.data(), count)));
+    size_t bytes = reps * count * sizeof(T);
+    HILOG(kInfo, "{} (level {}): min={} MBps, sum={} MBps, "
+          "variance={} MBps ({}), histogram={} MBps",
+          type_name, (int)level,
+          bytes / min_t.GetUsec(), bytes / sum_t.GetUsec(),
+          bytes / var_t.GetUsec(), var, bytes / hist_t.GetUsec());
+  }
+}
+
+TEST_CASE("TestReduceKernels") {
+  BenchmarkReduceKernels<float>("float");
+  BenchmarkReduceKernels<double>("double");
+  BenchmarkReduceKernels<int32_t>("int32");
+  BenchmarkReduceKernels<int64_t>("int64");
+}
+
+/** Insert, enumerate and erase \a count members of a tag's blob set */
+void BenchmarkTagBlobSet(size_t count) {
+  std::vector<hermes::BlobId> ids(count);
+  for (size_t i = 0; i < count; ++i) {
+    ids[i] = hermes::BlobId(1, i + 1);
+  }
+  hermes::TagBlobSet<hermes::BlobId> set;
+  hshm::Timer insert_t, iter_t, erase_t;
+  insert_t.Resume();
+  for (hermes::BlobId &id : ids) {
+    set.insert(id);
+  }
+  insert_t.Pause();
+  iter_t.Resume();
+  size_t found = 0;
+  for (const hermes::BlobId &id : set) {
+    found += id.unique_ & 1;
+  }
+  iter_t.Pause();
+  REQUIRE(found == (count + 1) / 2);
+  // Erase in a different order than inserted
+  std::mt19937_64 rng(count);
+  std::shuffle(ids.begin(), ids.end(), rng);
+  erase_t.Resume();
+  for (hermes::BlobId &id : ids) {
+    set.erase(id);
+  }
+  erase_t.Pause();
+  REQUIRE(set.empty());
+  HILOG(kInfo, "TagBlobSet ({} members): insert={} MOps, iterate={} MOps, "
+        "erase={} MOps", count, count / insert_t.GetUsec(),
+        count / iter_t.GetUsec(), count / erase_t.GetUsec());
+}
+
+/** The list previously used for tag membership, for comparison */
+void BenchmarkTagBlobList(size_t count) {
+  std::list<hermes::BlobId> list;
+  for (size_t i = 0; i < count; ++i) {
+    list.emplace_back(1, i + 1);
+  }
+  hshm::Timer erase_t;
+  erase_t.Resume();
+  for (size_t i = count; i > 0; --i) {
+    hermes::BlobId id(1, i);
+    list.erase(std::find(list.begin(), list.end(), id));
+  }
+  erase_t.Pause();
+  HILOG(kInfo, "std::list ({} members): erase={} MOps",
+        count, count / erase_t.GetUsec());
+}
+
+TEST_CASE("TestTagBlobSet") {
+  BenchmarkTagBlobList(1 << 14);
+  BenchmarkTagBlobSet(1 << 14);
+  BenchmarkTagBlobSet(1000000);
+  BenchmarkTagBlobSet(10000000);
+}
+
+/**
+ * Throughput of checksumming \a size bytes while copying them, as the
+ * bdevs do, compared with a plain copy and a copy followed by a checksum
+ * */
+void BenchmarkCrc32c(size_t size, size_t reps) {
+  std::vector<char> src(size), dst(size);
+  for (size_t i = 0; i < size; ++i) {
+    src[i] = (char)(i * 31);
+  }
+  hshm::Timer copy_t, fused_t, two_pass_t, sw_t;
+  u32 fused = 0, two_pass = 0, sw = 0;
+  for (size_t i = 0; i < reps; ++i) {
+    copy_t.Resume();
+    memcpy(dst.data(), src.data(), size);
+    copy_t.Pause();
+    fused_t.Resume();
+    fused = hermes::Crc32c::Copy(dst.data(), src.data(), size);
+    fused_t.Pause();
+    two_pass_t.Resume();
+    memcpy(dst.data(), src.data(), size);
+    two_pass = hermes::Crc32c::Compute(dst.data(), size);
+    two_pass_t.Pause();
+  }
+  sw_t.Resume();
+  sw = hermes::Crc32c::Get().RunSw<false>(nullptr, src.data(), size, 0);
+  sw_t.Pause();
+  REQUIRE(fused == two_pass);
+  REQUIRE(fused == sw);
+  size_t bytes = reps * size;
+  HILOG(kInfo, "CRC32C ({} bytes, hardware={}): memcpy={} MBps, "
+        "copy+crc={} MBps ({}% of memcpy), memcpy then crc={} MBps, "
+        "table crc={} MBps", size, hermes::Crc32c::IsHardware(),
+        bytes / copy_t.GetUsec(), bytes / fused_t.GetUsec(),
+        100 * copy_t.GetUsec() / fused_t.GetUsec(),
+        bytes / two_pass_t.GetUsec(), size / sw_t.GetUsec());
+}
+
+TEST_CASE("TestCrc32c") {
+  BenchmarkCrc32c(KILOBYTES(4), 16384);
+  BenchmarkCrc32c(MEGABYTES(1), 256);
+  BenchmarkCrc32c(MEGABYTES(64), 8);
+}
+
 /** Time to process a request */
 //TEST_CASE("TestHermesGetBlobIdLatency") {
 //  HERMES->ClientInit();
@@ -43,6 +43,8 @@ enum class AdapterMode {
 struct AdapterObjectConfig {
   AdapterMode mode_;
   size_t page_size_;
+  size_t write_buffer_size_ = 0;      /**< Write-back buffer size, 0 = off */
+  size_t write_buffer_flush_ms_ = 0;  /**< Max age of buffered writes */
 };
 
 /** Adapter Mode converter */
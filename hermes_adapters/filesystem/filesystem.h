@@ -82,7 +82,7 @@ class Filesystem : public FilesystemIoClient {
       if (!exists) {
         HILOG(kDebug, "File not opened before by adapter")
         // Normalize path strings
-        stat.path_ = stdfs::absolute(path).string();
+        stat.path_ = mdm->GetCanonicalPath(path);
         auto path_shm = hipc::make_uptr<hipc::charbuf>(stat.path_);
         // Verify the bucket exists if not in CREATE mode
         if (stat.adapter_mode_ == AdapterMode::kScratch &&
@@ -94,8 +94,23 @@ class Filesystem : public FilesystemIoClient {
             return;
           }
         }
-        // Update page size
-        stat.page_size_ = mdm->GetAdapterPageSize(path);
+        // Update page size, unless the caller chose one
+        if (stat.page_size_ == 0) {
+          stat.page_size_ = mdm->GetAdapterPageSize(path);
+        }
+        // Share the write-back buffer of the file's other descriptors
+        AdapterObjectConfig conf = mdm->GetAdapterConfig(path);
+        if (conf.write_buffer_size_ > 0 &&
+            stat.adapter_mode_ != AdapterMode::kBypass) {
+          stat.wbuf_ = mdm->GetWriteBuffer(
+              stat.path_, conf.write_buffer_size_,
+              conf.write_buffer_flush_ms_, stat.page_size_);
+          if (stat.hflags_.Any(HERMES_FS_TRUNC)) {
+            // Dirty data of the other descriptors is truncated as well
+            hshm::ScopedMutex lock(stat.wbuf_->lock_, 0);
+            stat.wbuf_->Clear();
+          }
+        }
         // Bucket parameters
         ctx.bkt_params_ = hermes::data_stager::BinaryFileStager::BuildFileParams(stat.page_size_);
         // Get or create the bucket
@@ -167,22 +182,29 @@ class Filesystem : public FilesystemIoClient {
 
     if (is_append) {
       // Perform append
+      Flush(stat);
       const Blob page((const char*)ptr, total_size);
       bkt.Append(page, stat.page_size_, ctx);
-    } else {
-      // Fragment I/O request into pages
-      BlobPlacements mapping;
-      auto mapper = MapperFactory::Get(MapperType::kBalancedMapper);
-      mapper->map(off, total_size, stat.page_size_, mapping);
-      size_t data_offset = 0;
-
-      // Perform a PartialPut for each page
-      for (const BlobPlacement &p : mapping) {
-        const Blob page((const char*)ptr + data_offset, p.blob_size_);
-        std::string blob_name(p.CreateBlobName().str());
-        bkt.AsyncPartialPut(blob_name, page, p.blob_off_, ctx);
-        data_offset += p.blob_size_;
+    } else if (stat.wbuf_) {
+      // Coalesce the write with the dirty extent
+      WriteBuffer &wbuf = *stat.wbuf_;
+      hshm::ScopedMutex lock(wbuf.lock_, 0);
+      if (!wbuf.CanAbsorb(off, total_size)) {
+        FlushWriteBuffer(stat, wbuf);
+      }
+      if (wbuf.CanAbsorb(off, total_size)) {
+        wbuf.Absorb((const char*)ptr, off, total_size);
+        if (wbuf.IsFull() || wbuf.IsExpired()) {
+          FlushWriteBuffer(stat, wbuf);
+        }
+      } else {
+        PutPages(stat, (const char*)ptr, off, total_size, ctx);
+      }
+      if (opts.DoSeek()) {
+        stat.st_ptr_ = off + total_size;
       }
+    } else {
+      PutPages(stat, (const char*)ptr, off, total_size, ctx);
       if (opts.DoSeek()) {
         stat.st_ptr_ = off + total_size;
       }
@@ -196,6 +218,55 @@ class Filesystem : public FilesystemIoClient {
     return total_size;
   }
 
+  /**
+   * Perform a PartialPut for each page touched by a write. The puts are
+   * added to \a batch if given, and submitted before returning otherwise.
+   * */
+  void PutPages(AdapterStat &stat, const char *ptr, size_t off,
+                size_t total_size, Context &ctx,
+                TaskBatch *batch = nullptr) {
+    hapi::Bucket &bkt = stat.bkt_id_;
+    // Fragment I/O request into pages
+    BlobPlacements mapping;
+    auto mapper = MapperFactory::Get(MapperType::kBalancedMapper);
+    mapper->map(off, total_size, stat.page_size_, mapping);
+    size_t data_offset = 0;
+
+    // Perform a PartialPut for each page, submitted in batches
+    TaskBatch local_batch;
+    TaskBatch &put_batch = batch ? *batch : local_batch;
+    for (const BlobPlacement &p : mapping) {
+      const Blob page(ptr + data_offset, p.blob_size_);
+      std::string blob_name(p.CreateBlobName().str());
+      bkt.AsyncPartialPut(put_batch, blob_name, page, p.blob_off_, ctx);
+      data_offset += p.blob_size_;
+    }
+    local_batch.Submit();
+    // The puts update the bucket size asynchronously
+    bkt.UpdateLocalSize(off + total_size);
+  }
+
+  /** Send the dirty extent to Hermes. Requires the buffer lock. */
+  void FlushWriteBuffer(AdapterStat &stat, WriteBuffer &wbuf) {
+    if (wbuf.IsEmpty()) {
+      return;
+    }
+    Context ctx;
+    ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
+    PutPages(stat, wbuf.data_.data(), wbuf.off_, wbuf.data_.size(), ctx);
+    wbuf.Clear();
+  }
+
+  /** Flush the write-back buffer of a file, if any */
+  void Flush(AdapterStat &stat) {
+    if (!stat.wbuf_) {
+      return;
+    }
+    WriteBuffer &wbuf = *stat.wbuf_;
+    hshm::ScopedMutex lock(wbuf.lock_, 0);
+    FlushWriteBuffer(stat, wbuf);
+  }
+
   /** base read function */
   template<bool ASYNC>
   size_t BaseRead(File &f, AdapterStat &stat, void *ptr, size_t off,
@@ -244,6 +315,25 @@ class Filesystem : public FilesystemIoClient {
       }
     }
 
+    // Serve the read from dirty data, or flush it before reading
+    if (stat.wbuf_) {
+      WriteBuffer &wbuf = *stat.wbuf_;
+      hshm::ScopedMutex lock(wbuf.lock_, 0);
+      if (wbuf.Contains(off, total_size)) {
+        wbuf.Read((char*)ptr, off, total_size);
+        if (opts.DoSeek()) {
+          stat.st_ptr_ = off + total_size;
+        }
+        stat.UpdateTime();
+        io_status.size_ = total_size;
+        UpdateIoStatus(opts, io_status);
+        return total_size;
+      }
+      if (wbuf.Overlaps(off, total_size) || wbuf.IsExpired()) {
+        FlushWriteBuffer(stat, wbuf);
+      }
+    }
+
     // Fragment I/O request into pages
     BlobPlacements mapping;
     auto mapper = MapperFactory::Get(MapperType::kBalancedMapper);
@@ -285,6 +375,135 @@ class Filesystem : public FilesystemIoClient {
     return BaseRead<false>(f, stat, ptr, off, total_size, 0, tasks, io_status, opts);
   }
 
+  /**
+   * Write several extents. The puts of all extents are submitted as a
+   * single batch. Does not move the file pointer. In bypass mode,
+   * io_status.success_ is false if an extent could not be written.
+   * */
+  size_t WriteVector(File &f, AdapterStat &stat,
+                     const std::vector<FsIoVec> &iov,
+                     IoStatus &io_status, FsIoOptions opts = FsIoOptions()) {
+    bool is_append = stat.st_ptr_ == std::numeric_limits<size_t>::max();
+    opts.UnsetSeek();
+    size_t total_size = 0;
+    if (stat.adapter_mode_ == AdapterMode::kBypass || is_append) {
+      for (const FsIoVec &v : iov) {
+        IoStatus sub_status;
+        total_size += Write(f, stat, v.buf_, v.off_, v.size_,
+                            sub_status, opts);
+        if (!sub_status.success_) {
+          io_status.success_ = false;
+        }
+      }
+    } else {
+      // Buffered data must not be flushed over the newer extents
+      Flush(stat);
+      Context ctx;
+      ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
+      TaskBatch batch;
+      for (const FsIoVec &v : iov) {
+        PutPages(stat, v.buf_, v.off_, v.size_, ctx, &batch);
+        total_size += v.size_;
+      }
+      batch.Submit();
+      stat.UpdateTime();
+    }
+    io_status.size_ = total_size;
+    UpdateIoStatus(opts, io_status);
+    return total_size;
+  }
+
+  /**
+   * Read several extents. The gets of all extents are in flight at once,
+   * up to TaskBatch::kMaxTasks pages. Each extent's size_ is set to the
+   * end of the last byte read, and holes before it are zero-filled.
+   * Does not move the file pointer. io_status.success_ is false if a page
+   * failed checksum verification.
+   * */
+  size_t ReadVector(File &f, AdapterStat &stat, std::vector<FsIoVec> &iov,
+                    IoStatus &io_status, FsIoOptions opts = FsIoOptions()) {
+    opts.UnsetSeek();
+    size_t total_size = 0;
+    if (stat.adapter_mode_ == AdapterMode::kBypass) {
+      for (FsIoVec &v : iov) {
+        IoStatus sub_status;
+        v.size_ = Read(f, stat, v.buf_, v.off_, v.size_, sub_status, opts);
+        total_size += v.size_;
+      }
+      io_status.size_ = total_size;
+      UpdateIoStatus(opts, io_status);
+      return total_size;
+    }
+    Flush(stat);
+    hapi::Bucket &bkt = stat.bkt_id_;
+    Context ctx;
+    ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
+    std::vector<PendingGet> pending;
+    pending.reserve(TaskBatch::kMaxTasks);
+    for (FsIoVec &v : iov) {
+      BlobPlacements mapping;
+      auto mapper = MapperFactory::Get(MapperType::kBalancedMapper);
+      mapper->map(v.off_, v.size_, stat.page_size_, mapping);
+      v.size_ = 0;
+      size_t data_offset = 0;
+      for (const BlobPlacement &p : mapping) {
+        Blob page(v.buf_ + data_offset, p.blob_size_);
+        std::string blob_name(p.CreateBlobName().str());
+        pending.emplace_back(PendingGet{
+            bkt.AsyncPartialGet(blob_name, page, p.blob_off_, ctx),
+            v.buf_ + data_offset, data_offset, p.blob_size_, &v});
+        data_offset += p.blob_size_;
+        if (pending.size() >= TaskBatch::kMaxTasks) {
+          total_size += WaitGets(pending, io_status);
+        }
+      }
+    }
+    total_size += WaitGets(pending, io_status);
+    stat.UpdateTime();
+    io_status.size_ = total_size;
+    UpdateIoStatus(opts, io_status);
+    return total_size;
+  }
+
+ private:
+  /** A get issued by ReadVector */
+  struct PendingGet {
+    LPointer<hrunpq::TypedPushTask<GetBlobTask>> task_;
+    char *dst_;       /**< Where the data goes */
+    size_t vec_off_;  /**< Offset of the page in the extent */
+    size_t size_;     /**< Number of bytes requested */
+    FsIoVec *vec_;    /**< The extent the get belongs to */
+  };
+
+  /** Wait for the gets of ReadVector and copy out their data */
+  size_t WaitGets(std::vector<PendingGet> &pending, IoStatus &io_status) {
+    size_t total_size = 0;
+    for (PendingGet &get : pending) {
+      get.task_->Wait();
+      GetBlobTask *task = get.task_->get();
+      if (task->rc_ != 0) {
+        io_status.success_ = false;
+      }
+      memcpy(get.dst_, HRUN_CLIENT->GetDataPointer(task->data_),
+             task->data_size_);
+      // Zero the rest of a short page, which is a hole if a later page has data
+      if (task->data_size_ < get.size_) {
+        memset(get.dst_ + task->data_size_, 0,
+               get.size_ - task->data_size_);
+      }
+      if (task->data_size_ > 0) {
+        get.vec_->size_ = std::max(get.vec_->size_,
+                                   get.vec_off_ + task->data_size_);
+      }
+      total_size += task->data_size_;
+      HRUN_CLIENT->FreeBuffer(task->data_);
+      HRUN_CLIENT->DelTask(get.task_);
+    }
+    pending.clear();
+    return total_size;
+  }
+
+ public:
   /** write asynchronously */
   FsAsyncTask* AWrite(File &f, AdapterStat &stat, const void *ptr, size_t off,
                       size_t total_size, size_t req_id, IoStatus &io_status,
@@ -340,6 +559,11 @@ class Filesystem : public FilesystemIoClient {
   /** seek */
   size_t Seek(File &f, AdapterStat &stat, SeekMode whence, off64_t offset) {
     auto mdm = HERMES_FS_METADATA_MANAGER;
+    if (whence == SeekMode::kEnd ||
+        stat.st_ptr_ == std::numeric_limits<size_t>::max()) {
+      // Positions relative to the end need the buffered data
+      Flush(stat);
+    }
     switch (whence) {
       case SeekMode::kSet: {
         stat.st_ptr_ = offset;
@@ -370,6 +594,14 @@ class Filesystem : public FilesystemIoClient {
         return -1;
       }
     }
+    if (stat.wbuf_) {
+      // Flush if the next write will not extend the dirty extent
+      WriteBuffer &wbuf = *stat.wbuf_;
+      hshm::ScopedMutex lock(wbuf.lock_, 0);
+      if (wbuf.GetEnd() != stat.st_ptr_) {
+        FlushWriteBuffer(stat, wbuf);
+      }
+    }
     mdm->Update(f, stat);
     return offset;
   }
@@ -378,7 +610,16 @@ class Filesystem : public FilesystemIoClient {
   size_t GetSize(File &f, AdapterStat &stat) {
     (void) stat;
     if (stat.adapter_mode_ != AdapterMode::kBypass) {
-      return stat.bkt_id_.GetSize();
+      size_t size = stat.bkt_id_.GetSize();
+      if (stat.wbuf_) {
+        // Account for dirty data past the end of the bucket
+        WriteBuffer &wbuf = *stat.wbuf_;
+        hshm::ScopedMutex lock(wbuf.lock_, 0);
+        if (!wbuf.IsEmpty()) {
+          size = std::max(size, wbuf.GetEnd());
+        }
+      }
+      return size;
     } else {
       return stdfs::file_size(stat.path_);
     }
@@ -396,6 +637,7 @@ class Filesystem : public FilesystemIoClient {
 
   /** sync */
   int Sync(File &f, AdapterStat &stat) {
+    Flush(stat);
     if (HERMES_CLIENT_CONF.flushing_mode_ == FlushingMode::kSync) {
       // NOTE(llogan): only for the unit tests
       // Please don't enable synchronous flushing
@@ -406,9 +648,50 @@ class Filesystem : public FilesystemIoClient {
 
   /** truncate */
   int Truncate(File &f, AdapterStat &stat, size_t new_size) {
-    // hapi::Bucket &bkt = stat.bkt_id_;
-    // TODO(llogan)
-    return 0;
+    (void) f;
+    Flush(stat);
+    if (stat.adapter_mode_ != AdapterMode::kBypass) {
+      stat.bkt_id_.Truncate(new_size, stat.page_size_);
+    }
+    if (stat.adapter_mode_ == AdapterMode::kScratch) {
+      return 0;
+    }
+    return RealTruncate(stat.path_, new_size);
+  }
+
+  /** truncate \a pathname file */
+  int Truncate(const std::string &pathname, size_t new_size) {
+    auto mdm = HERMES_FS_METADATA_MANAGER;
+    try {
+      std::string canon_path = mdm->GetCanonicalPath(pathname);
+      AdapterMode mode = mdm->GetAdapterMode(canon_path);
+      if (mode == AdapterMode::kBypass) {
+        return RealTruncate(canon_path, new_size);
+      }
+      // Buffered writes of open files must land before truncating
+      std::list<File> *filesp = mdm->Find(pathname);
+      if (filesp != nullptr) {
+        std::list<File> files = *filesp;
+        for (File &f : files) {
+          std::shared_ptr<AdapterStat> stat = mdm->Find(f);
+          if (stat != nullptr) {
+            Flush(*stat);
+          }
+        }
+      }
+      TagId tag_id = HERMES->GetTagId(canon_path);
+      if (!tag_id.IsNull()) {
+        Bucket bkt(tag_id);
+        bkt.Truncate(new_size, mdm->GetAdapterPageSize(canon_path));
+        if (mode == AdapterMode::kScratch) {
+          return 0;
+        }
+      }
+      return RealTruncate(canon_path, new_size);
+    } catch (const std::exception &e) {
+      HELOG(kError, "Error truncating path: {}", e.what())
+      return -1;
+    }
   }
 
   /** close */
@@ -436,7 +719,7 @@ class Filesystem : public FilesystemIoClient {
     int ret = RealRemove(pathname);
     // Destroy the bucket
     try {
-      std::string canon_path = stdfs::absolute(pathname).string();
+      std::string canon_path = mdm->GetCanonicalPath(pathname);
       Bucket bkt = HERMES->GetBucket(canon_path);
       bkt.Destroy();
       // Destroy all file descriptors
@@ -699,20 +982,9 @@ class Filesystem : public FilesystemIoClient {
       return false;
     }
     try {
-      std::string abs_path = stdfs::absolute(path).string();
-      auto &paths = HERMES_CLIENT_CONF.path_list_;
-      // Check if path is included or excluded
-      for (config::UserPathInfo &pth : paths) {
-        if (pth.Match(abs_path)) {
-          if (abs_path == pth.path_ && pth.is_directory_) {
-            // Do not include if path is a tracked directory
-            return false;
-          }
-          return pth.include_;
-        }
-      }
-      // Assume it is excluded
-      return false;
+      std::string abs_path =
+          HERMES_FS_METADATA_MANAGER->GetCanonicalPath(path);
+      return HERMES_CLIENT_CONF.IsPathTracked(abs_path);
     } catch (const std::exception &e) {
       HELOG(kError, "Error checking path: {}", e.what())
       return false;
@@ -16,6 +16,7 @@
 #include "hermes_adapters/mapper/balanced_mapper.h"
 #include "hermes/hermes.h"
 #include "hermes/bucket.h"
+#include "write_buffer.h"
 #include <filesystem>
 #include <limits>
 #include <future>
@@ -25,6 +26,8 @@ namespace stdfs = std::filesystem;
 
 namespace hermes::adapter {
 
+struct CollectiveBuffering;
+
 /** Put or get data directly from I/O client */
 #define HERMES_IO_CLIENT_BYPASS BIT_OPT(uint32_t, 0)
 /** Only put or get data from a Hermes buffer; no fallback to I/O client */
@@ -124,6 +127,13 @@ struct FsIoOptions {
   }
 };
 
+/** One extent of a vectored I/O request */
+struct FsIoVec {
+  size_t off_;   /**< Offset of the extent in the file */
+  size_t size_;  /**< Size of the extent */
+  char *buf_;    /**< The data to write, or where to read into */
+};
+
 /** A structure to represent Hermes request */
 struct FsAsyncTask {
   std::vector<LPointer<hrunpq::TypedPushTask<PutBlobTask>>> put_tasks_;
@@ -218,6 +228,10 @@ struct AdapterStat {
   hapi::Bucket bkt_id_; /**< bucket associated with the file */
   /** Page size used for file */
   size_t page_size_;
+  /** Write-back buffer for small writes, null if disabled */
+  std::shared_ptr<WriteBuffer> wbuf_;
+  /** Two-phase collective I/O state (MPI-IO), null if disabled */
+  std::shared_ptr<CollectiveBuffering> coll_;
 
   /** Default constructor */
   AdapterStat()
@@ -235,7 +249,8 @@ struct AdapterStat {
         mpi_fh_(nullptr),
         amode_(0),
         comm_(MPI_COMM_SELF),
-        atomicity_(false) {}
+        atomicity_(false),
+        page_size_(0) {}
 
   /** Update to the current time */
   void UpdateTime() {
@@ -348,6 +363,9 @@ class FilesystemIoClient {
   /** real remove */
   virtual int RealRemove(const std::string &path) = 0;
 
+  /** real truncate */
+  virtual int RealTruncate(const std::string &path, size_t new_size) = 0;
+
   /**
    * Called before RealClose. Releases information provisioned during
    * the allocation phase.
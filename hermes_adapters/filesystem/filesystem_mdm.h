@@ -13,6 +13,7 @@
 #ifndef HERMES_ADAPTER_METADATA_MANAGER_H
 #define HERMES_ADAPTER_METADATA_MANAGER_H
 
+#include <atomic>
 #include <cstdio>
 #include <unordered_map>
 #include "filesystem_io_client.h"
@@ -20,15 +21,35 @@
 namespace hermes::adapter {
 
 /**
- * Metadata manager for POSIX adapter
- */
-class MetadataManager {
- private:
+ * One partition of the adapter metadata.
+ *
+ * Paths are placed in a shard by hashing the path and stats by hashing
+ * the File, so the per-I/O Find(File) only takes the lock of one shard.
+ * */
+struct MetadataShard {
   std::unordered_map<std::string, std::list<File>>
       path_to_hermes_file_;  /**< Map to determine if path is buffered. */
   std::unordered_map<File, std::shared_ptr<AdapterStat>>
       hermes_file_to_stat_;  /**< Map for metadata */
+  std::unordered_map<std::string, std::weak_ptr<WriteBuffer>>
+      path_to_wbuf_;         /**< The write-back buffer of each path */
   RwLock lock_;              /**< Lock to synchronize MD updates*/
+};
+
+/**
+ * Metadata manager for POSIX adapter
+ */
+class MetadataManager {
+ public:
+  /** Number of shards. Must be a power of two. */
+  static const size_t kNumShards = 64;
+
+ private:
+  MetadataShard shards_[kNumShards];   /**< Partitioned metadata */
+  RwLock task_lock_;                   /**< Protects request_map_ */
+  RwLock conf_lock_;                   /**< Protects the client config */
+  std::atomic<u64> cwd_epoch_;         /**< Incremented on chdir */
+  std::atomic<bool> cwd_tracked_;      /**< Whether chdir is intercepted */
 
  public:
   std::unordered_map<uint64_t, FsAsyncTask*>
@@ -36,26 +57,74 @@ class MetadataManager {
   FsIoClientMetadata fs_mdm_;  /**< Context needed for I/O clients */
 
   /** Constructor */
-  MetadataManager() = default;
+  MetadataManager() : cwd_epoch_(0), cwd_tracked_(false) {}
 
   /** Get the current adapter mode */
   AdapterMode GetBaseAdapterMode() {
-    ScopedRwReadLock md_lock(lock_, 1);
+    ScopedRwReadLock md_lock(conf_lock_, 1);
     return HERMES_CLIENT_CONF.GetBaseAdapterMode();
   }
 
   /** Get the adapter mode for a particular file */
   AdapterMode GetAdapterMode(const std::string &path) {
-    ScopedRwReadLock md_lock(lock_, 2);
+    ScopedRwReadLock md_lock(conf_lock_, 2);
     return HERMES_CLIENT_CONF.GetAdapterConfig(path).mode_;
   }
 
   /** Get the adapter page size for a particular file */
   size_t GetAdapterPageSize(const std::string &path) {
-    ScopedRwReadLock md_lock(lock_, 3);
+    ScopedRwReadLock md_lock(conf_lock_, 3);
     return HERMES_CLIENT_CONF.GetAdapterConfig(path).page_size_;
   }
 
+  /** Get the adapter configuration for a particular file */
+  AdapterObjectConfig GetAdapterConfig(const std::string &path) {
+    ScopedRwReadLock md_lock(conf_lock_, 4);
+    return HERMES_CLIENT_CONF.GetAdapterConfig(path);
+  }
+
+  /**
+   * Convert \a path to an absolute path.
+   *
+   * Equivalent to stdfs::absolute. Once TrackCwd has been called, the
+   * working directory is cached per-thread instead of calling getcwd on
+   * every lookup, and revalidated against cwd_epoch_, which the chdir
+   * interceptors bump. Until then nothing would invalidate the cache
+   * (e.g., the stdio, MPI-IO, or VFD adapters without the POSIX
+   * interceptor), so getcwd is called every time. A raw SYS_chdir
+   * bypasses the interceptors and is not supported.
+   * */
+  std::string GetCanonicalPath(const std::string &path) {
+    if (!path.empty() && path[0] == '/') {
+      return path;
+    }
+    thread_local std::string cwd;
+    thread_local u64 cwd_epoch = 0;
+    u64 epoch = cwd_epoch_.load(std::memory_order_acquire) + 1;
+    if (!cwd_tracked_.load(std::memory_order_acquire) || cwd_epoch != epoch) {
+      cwd = stdfs::current_path().string();
+      cwd_epoch = epoch;
+    }
+    if (path.empty()) {
+      return cwd;
+    }
+    return (stdfs::path(cwd) / path).string();
+  }
+
+  /** Invalidate the cached working directory of all threads */
+  void InvalidateCwd() {
+    cwd_epoch_.fetch_add(1, std::memory_order_release);
+  }
+
+  /**
+   * Enable the working directory cache. Only call this once every
+   * function which changes the working directory is intercepted.
+   * */
+  void TrackCwd() {
+    InvalidateCwd();
+    cwd_tracked_.store(true, std::memory_order_release);
+  }
+
   /**
    * Create a metadata entry for filesystem adapters given File handler.
    * @param f original file handler of the file on the destination
@@ -66,12 +135,14 @@ class MetadataManager {
    */
   bool Create(const File& f, std::shared_ptr<AdapterStat> &stat) {
     HILOG(kDebug, "Create metadata for file handler")
-    ScopedRwWriteLock md_lock(lock_, kMDM_Create);
-    if (path_to_hermes_file_.find(stat->path_) == path_to_hermes_file_.end()) {
-      path_to_hermes_file_.emplace(stat->path_, std::list<File>());
+    {
+      MetadataShard &shard = GetShard(stat->path_);
+      ScopedRwWriteLock md_lock(shard.lock_, kMDM_Create);
+      shard.path_to_hermes_file_[stat->path_].emplace_back(f);
     }
-    path_to_hermes_file_[stat->path_].emplace_back(f);
-    auto ret = hermes_file_to_stat_.emplace(f, std::move(stat));
+    MetadataShard &shard = GetShard(f);
+    ScopedRwWriteLock md_lock(shard.lock_, kMDM_Create);
+    auto ret = shard.hermes_file_to_stat_.emplace(f, std::move(stat));
     return ret.second;
   }
 
@@ -84,9 +155,10 @@ class MetadataManager {
    */
   bool Update(const File& f, const AdapterStat& stat) {
     HILOG(kDebug, "Update metadata for file handler")
-    ScopedRwWriteLock md_lock(lock_, kMDM_Update);
-    auto iter = hermes_file_to_stat_.find(f);
-    if (iter != hermes_file_to_stat_.end()) {
+    MetadataShard &shard = GetShard(f);
+    ScopedRwWriteLock md_lock(shard.lock_, kMDM_Update);
+    auto iter = shard.hermes_file_to_stat_.find(f);
+    if (iter != shard.hermes_file_to_stat_.end()) {
       *(*iter).second = stat;
       return true;
     } else {
@@ -102,20 +174,51 @@ class MetadataManager {
    */
   bool Delete(const std::string &path, const File& f) {
     HILOG(kDebug, "Delete metadata for file handler")
-    ScopedRwWriteLock md_lock(lock_, kMDM_Delete);
-    auto iter = hermes_file_to_stat_.find(f);
-    if (iter != hermes_file_to_stat_.end()) {
-      hermes_file_to_stat_.erase(iter);
-      auto &list = path_to_hermes_file_[path];
-      auto f_iter = std::find(list.begin(), list.end(), f);
-      path_to_hermes_file_[path].erase(f_iter);
-      if (list.size() == 0) {
-        path_to_hermes_file_.erase(path);
+    {
+      MetadataShard &shard = GetShard(f);
+      ScopedRwWriteLock md_lock(shard.lock_, kMDM_Delete);
+      auto iter = shard.hermes_file_to_stat_.find(f);
+      if (iter == shard.hermes_file_to_stat_.end()) {
+        return false;
       }
+      shard.hermes_file_to_stat_.erase(iter);
+    }
+    MetadataShard &shard = GetShard(path);
+    ScopedRwWriteLock md_lock(shard.lock_, kMDM_Delete);
+    auto list_iter = shard.path_to_hermes_file_.find(path);
+    if (list_iter == shard.path_to_hermes_file_.end()) {
       return true;
-    } else {
-      return false;
     }
+    auto &list = list_iter->second;
+    auto f_iter = std::find(list.begin(), list.end(), f);
+    if (f_iter != list.end()) {
+      list.erase(f_iter);
+    }
+    if (list.size() == 0) {
+      shard.path_to_hermes_file_.erase(list_iter);
+      shard.path_to_wbuf_.erase(path);
+    }
+    return true;
+  }
+
+  /**
+   * Get the write-back buffer of \a path, creating it if no open file
+   * of the path has one. Every open file of a path shares its buffer, so
+   * a file descriptor sees the dirty data written through the others.
+   * */
+  std::shared_ptr<WriteBuffer> GetWriteBuffer(const std::string &path,
+                                              size_t max_size,
+                                              size_t max_age_ms,
+                                              size_t page_size) {
+    MetadataShard &shard = GetShard(path);
+    ScopedRwWriteLock md_lock(shard.lock_, kMDM_Create);
+    std::weak_ptr<WriteBuffer> &entry = shard.path_to_wbuf_[path];
+    std::shared_ptr<WriteBuffer> wbuf = entry.lock();
+    if (!wbuf) {
+      wbuf = std::make_shared<WriteBuffer>(max_size, max_age_ms, page_size);
+      entry = wbuf;
+    }
+    return wbuf;
   }
 
   /**
@@ -125,10 +228,11 @@ class MetadataManager {
    * */
   std::list<File>* Find(const std::string &path) {
     try {
-      std::string canon_path = stdfs::absolute(path).string();
-      ScopedRwReadLock md_lock(lock_, kMDM_Find);
-      auto iter = path_to_hermes_file_.find(canon_path);
-      if (iter == path_to_hermes_file_.end())
+      std::string canon_path = GetCanonicalPath(path);
+      MetadataShard &shard = GetShard(canon_path);
+      ScopedRwReadLock md_lock(shard.lock_, kMDM_Find);
+      auto iter = shard.path_to_hermes_file_.find(canon_path);
+      if (iter == shard.path_to_hermes_file_.end())
         return nullptr;
       else
         return &iter->second;
@@ -145,9 +249,10 @@ class MetadataManager {
    *            The bool in pair indicated whether metadata entry exists.
    */
   std::shared_ptr<AdapterStat> Find(const File& f) {
-    ScopedRwReadLock md_lock(lock_, kMDM_Find2);
-    auto iter = hermes_file_to_stat_.find(f);
-    if (iter == hermes_file_to_stat_.end())
+    MetadataShard &shard = GetShard(f);
+    ScopedRwReadLock md_lock(shard.lock_, kMDM_Find2);
+    auto iter = shard.hermes_file_to_stat_.find(f);
+    if (iter == shard.hermes_file_to_stat_.end())
       return nullptr;
     else
       return iter->second;
@@ -157,7 +262,7 @@ class MetadataManager {
    * Add a request to the request map.
    * */
   void EmplaceTask(uint64_t id, FsAsyncTask* task) {
-    ScopedRwWriteLock md_lock(lock_, 0);
+    ScopedRwWriteLock md_lock(task_lock_, 0);
     request_map_.emplace(id, task);
   }
 
@@ -165,7 +270,7 @@ class MetadataManager {
    * Find a request in the request map.
    * */
   FsAsyncTask* FindTask(uint64_t id) {
-    ScopedRwReadLock md_lock(lock_, 0);
+    ScopedRwReadLock md_lock(task_lock_, 0);
     auto iter = request_map_.find(id);
     if (iter == request_map_.end()) {
       return nullptr;
@@ -178,12 +283,23 @@ class MetadataManager {
    * Delete a request in the request map.
    * */
   void DeleteTask(uint64_t id) {
-    ScopedRwWriteLock md_lock(lock_, 0);
+    ScopedRwWriteLock md_lock(task_lock_, 0);
     auto iter = request_map_.find(id);
     if (iter != request_map_.end()) {
       request_map_.erase(iter);
     }
   }
+
+ private:
+  /** Get the shard a canonical path belongs to */
+  MetadataShard& GetShard(const std::string &path) {
+    return shards_[std::hash<std::string>{}(path) & (kNumShards - 1)];
+  }
+
+  /** Get the shard the stat of \a f belongs to */
+  MetadataShard& GetShard(const File &f) {
+    return shards_[std::hash<File>{}(f) & (kNumShards - 1)];
+  }
 };
 }  // namespace hermes::adapter
 
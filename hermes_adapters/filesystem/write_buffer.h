@@ -0,0 +1,134 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_ADAPTER_FILESYSTEM_WRITE_BUFFER_H_
+#define HERMES_ADAPTER_FILESYSTEM_WRITE_BUFFER_H_
+
+#include <cstring>
+#include <vector>
+#include "hermes/hermes_types.h"
+
+namespace hermes::adapter {
+
+/**
+ * A client-side write-back buffer for a file.
+ *
+ * Small sequential or overlapping writes are absorbed into a single
+ * contiguous dirty extent instead of each becoming a PartialPut. The
+ * extent is handed back to the filesystem for flushing when it fills a
+ * page, exceeds the byte threshold, grows too old, or when a write is
+ * not contiguous with it. The buffer is shared by the open files of a
+ * path in this process (see MetadataManager::GetWriteBuffer).
+ * */
+class WriteBuffer {
+ public:
+  Mutex lock_;                  /**< Serializes I/O on the file */
+  size_t max_size_;             /**< Flush once this many bytes are dirty */
+  size_t max_age_ns_;           /**< Flush dirty data older than this */
+  size_t page_size_;            /**< The page size of the file */
+  size_t off_;                  /**< File offset of the dirty extent */
+  std::vector<char> data_;      /**< The dirty extent */
+  hshm::Timepoint first_dirty_;  /**< When the extent became dirty */
+
+ public:
+  /** Emplace constructor */
+  WriteBuffer(size_t max_size, size_t max_age_ms, size_t page_size)
+  : max_size_(max_size), max_age_ns_(max_age_ms * 1000000),
+    page_size_(page_size), off_(0) {
+    data_.reserve(max_size_);
+  }
+
+  /** Whether there is dirty data */
+  bool IsEmpty() const {
+    return data_.empty();
+  }
+
+  /** The file offset after the dirty extent */
+  size_t GetEnd() const {
+    return off_ + data_.size();
+  }
+
+  /** Whether [off, off + size) touches the dirty extent */
+  bool Overlaps(size_t off, size_t size) const {
+    return !IsEmpty() && off < GetEnd() && off_ < off + size;
+  }
+
+  /** Whether [off, off + size) is entirely dirty */
+  bool Contains(size_t off, size_t size) const {
+    return !IsEmpty() && off_ <= off && off + size <= GetEnd();
+  }
+
+  /**
+   * Whether a write can be merged into the extent. Writes must overlap
+   * or be adjacent to the extent, and the merged extent must stay below
+   * the byte threshold.
+   * */
+  bool CanAbsorb(size_t off, size_t size) const {
+    if (size >= max_size_) {
+      return false;
+    }
+    if (IsEmpty()) {
+      return true;
+    }
+    if (off > GetEnd() || off + size < off_) {
+      return false;
+    }
+    size_t start = std::min(off, off_);
+    size_t end = std::max(off + size, GetEnd());
+    return end - start <= max_size_;
+  }
+
+  /** Merge a write into the extent. Requires CanAbsorb. */
+  void Absorb(const char *ptr, size_t off, size_t size) {
+    if (IsEmpty()) {
+      first_dirty_.Now();
+      off_ = off;
+    } else if (off < off_) {
+      data_.insert(data_.begin(), off_ - off, 0);
+      off_ = off;
+    }
+    size_t rel = off - off_;
+    if (rel + size > data_.size()) {
+      data_.resize(rel + size);
+    }
+    memcpy(data_.data() + rel, ptr, size);
+  }
+
+  /** Copy dirty bytes into \a ptr. Requires Contains. */
+  void Read(char *ptr, size_t off, size_t size) const {
+    memcpy(ptr, data_.data() + (off - off_), size);
+  }
+
+  /** Whether the extent should be flushed after a write */
+  bool IsFull() const {
+    return data_.size() >= max_size_ || GetEnd() % page_size_ == 0;
+  }
+
+  /** Whether the extent has been dirty for too long */
+  bool IsExpired() {
+    if (IsEmpty()) {
+      return false;
+    }
+    hshm::Timepoint now;
+    now.Now();
+    return first_dirty_.GetNsecFromStart(now) >= max_age_ns_;
+  }
+
+  /** Forget the extent after it was flushed */
+  void Clear() {
+    data_.clear();
+  }
+};
+
+}  // namespace hermes::adapter
+
+#endif  // HERMES_ADAPTER_FILESYSTEM_WRITE_BUFFER_H_
@@ -0,0 +1,295 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_ADAPTER_MPIIO_MPIIO_COLLECTIVE_H_
+#define HERMES_ADAPTER_MPIIO_MPIIO_COLLECTIVE_H_
+
+#include <mpi.h>
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace hermes::adapter {
+
+/** A contiguous byte range of a file */
+struct CollectiveExtent {
+  size_t off_;   /**< Offset of the extent in the file */
+  size_t size_;  /**< Size of the extent */
+
+  /** Default constructor */
+  CollectiveExtent() : off_(0), size_(0) {}
+
+  /** Emplace constructor */
+  CollectiveExtent(size_t off, size_t size) : off_(off), size_(size) {}
+
+  /** The first byte past the extent */
+  size_t end() const {
+    return off_ + size_;
+  }
+
+  /** Intersect this extent with [lo, hi) */
+  CollectiveExtent Clip(size_t lo, size_t hi) const {
+    size_t s = std::max(off_, lo);
+    size_t e = std::min(end(), hi);
+    if (s >= e) {
+      return CollectiveExtent(s, 0);
+    }
+    return CollectiveExtent(s, e - s);
+  }
+};
+
+/**
+ * State for two-phase collective I/O on a file.
+ *
+ * A subset of the ranks which opened the file are elected as aggregators,
+ * spread evenly across nodes. In a collective call, the global range being
+ * accessed is split into page-aligned file domains, one per aggregator.
+ * Ranks exchange data so that each aggregator holds whole regions of its
+ * domain and only the aggregators touch Hermes. Domains are processed in
+ * rounds of at most cb_buffer_size bytes.
+ *
+ * Recognized MPI info hints:
+ * cb_buffer_size: the size of the aggregation buffer (default 16MB)
+ * cb_nodes: the number of aggregators (default one per node)
+ * romio_cb_write / romio_cb_read: "enable", "disable", or "automatic"
+ * */
+struct CollectiveBuffering {
+  static const size_t kDefaultBufferSize = 16 * 1024 * 1024;
+
+  MPI_Comm comm_;        /**< Duplicate of the file's communicator */
+  int rank_;             /**< The rank of this process in comm_ */
+  int nprocs_;           /**< The number of processes in comm_ */
+  int num_nodes_;        /**< The number of nodes spanned by comm_ */
+  bool write_enabled_;   /**< Whether to aggregate collective writes */
+  bool read_enabled_;    /**< Whether to aggregate collective reads */
+  size_t buffer_size_;   /**< Bytes an aggregator handles per round */
+  std::vector<int> aggregators_;  /**< Ranks of the aggregators */
+  int aggr_idx_;         /**< This rank's index in aggregators_, or -1 */
+
+  /** Default constructor */
+  CollectiveBuffering()
+      : comm_(MPI_COMM_NULL), rank_(0), nprocs_(1), num_nodes_(1),
+        write_enabled_(false), read_enabled_(false),
+        buffer_size_(kDefaultBufferSize), aggr_idx_(-1) {}
+
+  /** Parse the hints and elect aggregators. Collective over \a comm. */
+  void Init(MPI_Comm comm, MPI_Info info) {
+    MPI_Comm_dup(comm, &comm_);
+    MPI_Comm_rank(comm_, &rank_);
+    MPI_Comm_size(comm_, &nprocs_);
+    std::string val;
+    if (GetHint(info, "cb_buffer_size", val)) {
+      buffer_size_ = ParseSize(val, kDefaultBufferSize);
+    }
+    int cb_nodes = 0;
+    if (GetHint(info, "cb_nodes", val)) {
+      cb_nodes = static_cast<int>(ParseSize(val, 0));
+    }
+    bool automatic = nprocs_ > 1;
+    write_enabled_ = automatic;
+    read_enabled_ = automatic;
+    if (GetHint(info, "romio_cb_write", val)) {
+      write_enabled_ = ParseSwitch(val, automatic);
+    }
+    if (GetHint(info, "romio_cb_read", val)) {
+      read_enabled_ = ParseSwitch(val, automatic);
+    }
+    ElectAggregators(cb_nodes);
+  }
+
+  /** Release the duplicated communicator. Collective over comm_. */
+  void Free() {
+    if (comm_ != MPI_COMM_NULL) {
+      MPI_Comm_free(&comm_);
+      comm_ = MPI_COMM_NULL;
+    }
+  }
+
+  /** Whether this rank is an aggregator */
+  bool IsAggregator() const {
+    return aggr_idx_ >= 0;
+  }
+
+  /**
+   * The size of an aggregation round. A multiple of \a page_size so that
+   * windows never split a page between two rounds.
+   * */
+  size_t GetWindowSize(size_t page_size) const {
+    size_t win = std::min(buffer_size_, static_cast<size_t>(INT_MAX));
+    win -= win % page_size;
+    return std::max(win, page_size);
+  }
+
+  /**
+   * Split [lo, hi) into page-aligned domains, one per aggregator.
+   * Domains may be empty when there are fewer pages than aggregators.
+   * */
+  std::vector<CollectiveExtent> GetFileDomains(size_t lo, size_t hi,
+                                               size_t page_size) const {
+    size_t naggr = aggregators_.size();
+    lo -= lo % page_size;
+    size_t num_pages = (hi - lo + page_size - 1) / page_size;
+    size_t pages_per_aggr = (num_pages + naggr - 1) / naggr;
+    std::vector<CollectiveExtent> domains(naggr);
+    for (size_t i = 0; i < naggr; ++i) {
+      size_t d_lo = std::min(lo + i * pages_per_aggr * page_size, hi);
+      size_t d_hi = std::min(d_lo + pages_per_aggr * page_size, hi);
+      domains[i] = CollectiveExtent(d_lo, d_hi - d_lo);
+    }
+    return domains;
+  }
+
+  /**
+   * Gather the extent accessed by each rank. Returns false if any rank's
+   * request cannot be described by int displacements, in which case
+   * every rank falls back to independent I/O.
+   * */
+  bool GatherExtents(size_t off, size_t size,
+                     std::vector<CollectiveExtent> &extents) const {
+    unsigned long long mine[2] = {off, size};
+    std::vector<unsigned long long> all(2 * nprocs_);
+    MPI_Allgather(mine, 2, MPI_UNSIGNED_LONG_LONG,
+                  all.data(), 2, MPI_UNSIGNED_LONG_LONG, comm_);
+    extents.resize(nprocs_);
+    bool ok = true;
+    for (int i = 0; i < nprocs_; ++i) {
+      extents[i] = CollectiveExtent(all[2 * i], all[2 * i + 1]);
+      if (extents[i].size_ > static_cast<size_t>(INT_MAX)) {
+        ok = false;
+      }
+    }
+    return ok;
+  }
+
+  /** Whether any two non-empty extents overlap */
+  static bool AnyOverlap(const std::vector<CollectiveExtent> &extents) {
+    std::vector<CollectiveExtent> sorted;
+    for (const CollectiveExtent &e : extents) {
+      if (e.size_) { sorted.emplace_back(e); }
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const CollectiveExtent &a, const CollectiveExtent &b) {
+                return a.off_ < b.off_;
+              });
+    for (size_t i = 1; i < sorted.size(); ++i) {
+      if (sorted[i].off_ < sorted[i - 1].end()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** Merge extents into the sorted, disjoint set of ranges they cover */
+  static std::vector<CollectiveExtent> Merge(
+      std::vector<CollectiveExtent> extents) {
+    std::sort(extents.begin(), extents.end(),
+              [](const CollectiveExtent &a, const CollectiveExtent &b) {
+                return a.off_ < b.off_;
+              });
+    std::vector<CollectiveExtent> merged;
+    for (const CollectiveExtent &e : extents) {
+      if (e.size_ == 0) { continue; }
+      if (!merged.empty() && e.off_ <= merged.back().end()) {
+        CollectiveExtent &last = merged.back();
+        last.size_ = std::max(last.end(), e.end()) - last.off_;
+      } else {
+        merged.emplace_back(e);
+      }
+    }
+    return merged;
+  }
+
+ private:
+  /**
+   * Choose ceil(cb_nodes / num_nodes) aggregators on each node, preferring
+   * the lowest local ranks, and keep the first cb_nodes of them so that
+   * nodes are filled round-robin.
+   * */
+  void ElectAggregators(int cb_nodes) {
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(comm_, MPI_COMM_TYPE_SHARED, rank_,
+                        MPI_INFO_NULL, &node_comm);
+    int local_rank, leader = rank_;
+    MPI_Comm_rank(node_comm, &local_rank);
+    MPI_Bcast(&leader, 1, MPI_INT, 0, node_comm);
+    MPI_Comm_free(&node_comm);
+    int is_leader = local_rank == 0;
+    MPI_Allreduce(&is_leader, &num_nodes_, 1, MPI_INT, MPI_SUM, comm_);
+    if (cb_nodes <= 0 || cb_nodes > nprocs_) {
+      cb_nodes = std::min(num_nodes_, nprocs_);
+    }
+    int per_node = (cb_nodes + num_nodes_ - 1) / num_nodes_;
+
+    // Gather (local rank, node leader) of every rank
+    int mine[2] = {local_rank, leader};
+    std::vector<int> all(2 * nprocs_);
+    MPI_Allgather(mine, 2, MPI_INT, all.data(), 2, MPI_INT, comm_);
+    std::vector<std::tuple<int, int, int>> candidates;
+    for (int i = 0; i < nprocs_; ++i) {
+      if (all[2 * i] < per_node) {
+        candidates.emplace_back(all[2 * i], all[2 * i + 1], i);
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.resize(std::min(candidates.size(),
+                               static_cast<size_t>(cb_nodes)));
+    aggregators_.clear();
+    for (auto &cand : candidates) {
+      aggregators_.emplace_back(std::get<2>(cand));
+    }
+    std::sort(aggregators_.begin(), aggregators_.end());
+    auto it = std::find(aggregators_.begin(), aggregators_.end(), rank_);
+    aggr_idx_ = it == aggregators_.end() ?
+                -1 : static_cast<int>(it - aggregators_.begin());
+  }
+
+  /** Get the value of \a key from \a info */
+  static bool GetHint(MPI_Info info, const char *key, std::string &val) {
+    if (info == MPI_INFO_NULL) {
+      return false;
+    }
+    char buf[MPI_MAX_INFO_VAL + 1];
+    int flag = 0;
+    MPI_Info_get(info, key, MPI_MAX_INFO_VAL, buf, &flag);
+    if (!flag) {
+      return false;
+    }
+    val = buf;
+    return true;
+  }
+
+  /** Parse a non-negative integer hint */
+  static size_t ParseSize(const std::string &val, size_t def) {
+    try {
+      long long size = std::stoll(val);
+      return size > 0 ? static_cast<size_t>(size) : def;
+    } catch (...) {
+      return def;
+    }
+  }
+
+  /** Parse an enable/disable/automatic hint */
+  static bool ParseSwitch(const std::string &val, bool automatic) {
+    if (val == "enable") {
+      return true;
+    } else if (val == "disable") {
+      return false;
+    }
+    return automatic;
+  }
+};
+
+}  // namespace hermes::adapter
+
+#endif  // HERMES_ADAPTER_MPIIO_MPIIO_COLLECTIVE_H_
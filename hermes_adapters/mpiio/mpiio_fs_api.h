@@ -18,6 +18,7 @@
 #include "hermes_adapters/filesystem/filesystem.h"
 #include "hermes_adapters/filesystem/filesystem_mdm.h"
 #include "mpiio_api.h"
+#include "mpiio_collective.h"
 
 namespace hermes::adapter {
 
@@ -93,8 +94,13 @@ class MpiioFs : public Filesystem {
 
   int ReadAll(File &f, AdapterStat &stat, void *ptr, size_t offset, int count,
               MPI_Datatype datatype, MPI_Status *status, FsIoOptions opts) {
+    int ret;
+    if (CollectiveRead(f, stat, ptr, offset, count, datatype, status,
+                       opts, ret)) {
+      return ret;
+    }
     MPI_Barrier(stat.comm_);
-    size_t ret = Read(f, stat, ptr, offset, count, datatype, status, opts);
+    ret = Read(f, stat, ptr, offset, count, datatype, status, opts);
     MPI_Barrier(stat.comm_);
     return ret;
   }
@@ -138,8 +144,13 @@ class MpiioFs : public Filesystem {
                    int count, MPI_Datatype datatype, MPI_Status *status,
                    MPI_Request *request, FsIoOptions opts) {
     if constexpr(!ASYNC) {
+      int ret;
+      if (CollectiveWrite(f, stat, ptr, offset, count, datatype, status,
+                          opts, ret)) {
+        return ret;
+      }
       MPI_Barrier(stat.comm_);
-      int ret = Write(f, stat, ptr, offset, count, datatype, status, opts);
+      ret = Write(f, stat, ptr, offset, count, datatype, status, opts);
       MPI_Barrier(stat.comm_);
       return ret;
     } else {
@@ -161,6 +172,79 @@ class MpiioFs : public Filesystem {
                               request, opts);
   }
 
+  /**
+   * Two-phase collective write. Returns false if the ranks must fall back
+   * to independent writes. Collective over the file's communicator.
+   * */
+  bool CollectiveWrite(File &f, AdapterStat &stat, const void *ptr,
+                       size_t offset, int count, MPI_Datatype datatype,
+                       MPI_Status *status, FsIoOptions opts, int &ret) {
+    if (!CanAggregate(stat, true)) {
+      return false;
+    }
+    size_t total_size = IoSizeFromCount(count, datatype, opts);
+    CollectiveExtent mine(offset, total_size);
+    std::vector<CollectiveExtent> extents;
+    // Writes to overlapping extents would need overlapping receive buffers
+    if (!stat.coll_->GatherExtents(offset, total_size, extents) ||
+        CollectiveBuffering::AnyOverlap(extents)) {
+      return false;
+    }
+    Flush(stat);
+    TwoPhase<true>(f, stat, (char*)ptr, mine, extents);
+    MPI_Barrier(stat.coll_->comm_);
+    if (total_size) {
+      stat.bkt_id_.UpdateLocalSize(offset + total_size);
+    }
+    if (opts.DoSeek()) {
+      stat.st_ptr_ = offset + total_size;
+    }
+    stat.UpdateTime();
+    IoStatus io_status;
+    io_status.mpi_status_ptr_ = status;
+    io_status.size_ = total_size;
+    UpdateIoStatus(opts, io_status);
+    ret = io_status.mpi_ret_;
+    return true;
+  }
+
+  /**
+   * Two-phase collective read. Returns false if the ranks must fall back
+   * to independent reads. Collective over the file's communicator.
+   * */
+  bool CollectiveRead(File &f, AdapterStat &stat, void *ptr,
+                      size_t offset, int count, MPI_Datatype datatype,
+                      MPI_Status *status, FsIoOptions opts, int &ret) {
+    if (!CanAggregate(stat, false)) {
+      return false;
+    }
+    size_t total_size = IoSizeFromCount(count, datatype, opts);
+    // SEEK_END is not a valid read position
+    bool at_end = offset == std::numeric_limits<size_t>::max();
+    CollectiveExtent mine = at_end ?
+        CollectiveExtent() : CollectiveExtent(offset, total_size);
+    std::vector<CollectiveExtent> extents;
+    if (!stat.coll_->GatherExtents(mine.off_, mine.size_, extents)) {
+      return false;
+    }
+    // Dirty data must reach Hermes before the aggregators read it
+    Flush(stat);
+    MPI_Barrier(stat.coll_->comm_);
+    TwoPhase<false>(f, stat, (char*)ptr, mine, extents);
+    size_t file_size = GetSize(f, stat);
+    size_t read_size = mine.Clip(0, file_size).size_;
+    if (opts.DoSeek() && !at_end) {
+      stat.st_ptr_ = offset + read_size;
+    }
+    stat.UpdateTime();
+    IoStatus io_status;
+    io_status.mpi_status_ptr_ = status;
+    io_status.size_ = read_size;
+    UpdateIoStatus(opts, io_status);
+    ret = io_status.mpi_ret_;
+    return true;
+  }
+
   template<bool ASYNC>
   int BaseWriteOrdered(File &f, AdapterStat &stat, const void *ptr, int count,
                        MPI_Datatype datatype, MPI_Status *status,
@@ -496,6 +580,123 @@ class MpiioFs : public Filesystem {
     return SeekShared(f, *stat, offset, whence);
   }
 
+ private:
+  /**
+   * Whether a collective write (\a write) or read on this file can be
+   * aggregated. The file pointer is rank-local, e.g., after a local
+   * MPI_File_seek to SEEK_END, so the ranks agree with an MPI_Allreduce.
+   * Otherwise some ranks would aggregate while others fall back to
+   * independent I/O, and the job would hang. Collective over the file's
+   * communicator when aggregation is enabled.
+   * */
+  static bool CanAggregate(const AdapterStat &stat, bool write) {
+    // Set when the file is opened, so the same on every rank
+    if (!stat.coll_ || stat.coll_->aggregators_.empty() ||
+        !(write ? stat.coll_->write_enabled_ : stat.coll_->read_enabled_)) {
+      return false;
+    }
+    int local = stat.adapter_mode_ != AdapterMode::kBypass &&
+        stat.st_ptr_ != std::numeric_limits<size_t>::max();
+    int all = 0;
+    MPI_Allreduce(&local, &all, 1, MPI_INT, MPI_LAND, stat.coll_->comm_);
+    return all != 0;
+  }
+
+  /**
+   * Exchange data between the ranks and the aggregators. Each rank
+   * accesses \a mine through \a ptr and \a extents holds the extents of
+   * every rank. For writes, the data is shuffled to the aggregators which
+   * then Put whole regions of their window. For reads, the aggregators Get
+   * whole regions of their window and scatter them back.
+   * */
+  template<bool WRITE>
+  void TwoPhase(File &f, AdapterStat &stat, char *ptr,
+                const CollectiveExtent &mine,
+                const std::vector<CollectiveExtent> &extents) {
+    CollectiveBuffering &cb = *stat.coll_;
+    size_t lo = std::numeric_limits<size_t>::max(), hi = 0;
+    for (const CollectiveExtent &e : extents) {
+      if (e.size_ == 0) { continue; }
+      lo = std::min(lo, e.off_);
+      hi = std::max(hi, e.end());
+    }
+    if (hi == 0) {
+      return;
+    }
+    size_t page_size = stat.page_size_;
+    size_t win_size = cb.GetWindowSize(page_size);
+    std::vector<CollectiveExtent> domains =
+        cb.GetFileDomains(lo, hi, page_size);
+    size_t max_domain = 0;
+    for (const CollectiveExtent &d : domains) {
+      max_domain = std::max(max_domain, d.size_);
+    }
+    size_t num_rounds = (max_domain + win_size - 1) / win_size;
+    std::vector<char> buf;
+    if (cb.IsAggregator()) {
+      buf.resize(std::min(win_size, domains[cb.aggr_idx_].size_));
+    }
+    std::vector<int> my_counts(cb.nprocs_), my_displs(cb.nprocs_);
+    std::vector<int> aggr_counts(cb.nprocs_), aggr_displs(cb.nprocs_);
+    FsIoOptions byte_opts = FsIoOptions::DataType(MPI_BYTE, false);
+
+    for (size_t round = 0; round < num_rounds; ++round) {
+      // The parts of this rank's request within each aggregator's window
+      std::fill(my_counts.begin(), my_counts.end(), 0);
+      std::fill(my_displs.begin(), my_displs.end(), 0);
+      for (size_t i = 0; i < domains.size(); ++i) {
+        CollectiveExtent win = GetWindow(domains[i], round, win_size);
+        CollectiveExtent part = mine.Clip(win.off_, win.end());
+        my_counts[cb.aggregators_[i]] = static_cast<int>(part.size_);
+        my_displs[cb.aggregators_[i]] = part.size_ ?
+            static_cast<int>(part.off_ - mine.off_) : 0;
+      }
+      // The parts of every rank's request within this aggregator's window
+      std::vector<CollectiveExtent> parts;
+      CollectiveExtent win;
+      std::fill(aggr_counts.begin(), aggr_counts.end(), 0);
+      std::fill(aggr_displs.begin(), aggr_displs.end(), 0);
+      if (cb.IsAggregator()) {
+        win = GetWindow(domains[cb.aggr_idx_], round, win_size);
+        for (int rank = 0; rank < cb.nprocs_; ++rank) {
+          CollectiveExtent part = extents[rank].Clip(win.off_, win.end());
+          if (part.size_ == 0) { continue; }
+          aggr_counts[rank] = static_cast<int>(part.size_);
+          aggr_displs[rank] = static_cast<int>(part.off_ - win.off_);
+          parts.emplace_back(part);
+        }
+      }
+      std::vector<CollectiveExtent> regions =
+          CollectiveBuffering::Merge(parts);
+      if constexpr (WRITE) {
+        MPI_Alltoallv(ptr, my_counts.data(), my_displs.data(), MPI_BYTE,
+                      buf.data(), aggr_counts.data(), aggr_displs.data(),
+                      MPI_BYTE, cb.comm_);
+        for (const CollectiveExtent &r : regions) {
+          IoStatus io_status;
+          Filesystem::Write(f, stat, buf.data() + (r.off_ - win.off_),
+                            r.off_, r.size_, io_status, byte_opts);
+        }
+      } else {
+        for (const CollectiveExtent &r : regions) {
+          IoStatus io_status;
+          Filesystem::Read(f, stat, buf.data() + (r.off_ - win.off_),
+                           r.off_, r.size_, io_status, byte_opts);
+        }
+        MPI_Alltoallv(buf.data(), aggr_counts.data(), aggr_displs.data(),
+                      MPI_BYTE, ptr, my_counts.data(), my_displs.data(),
+                      MPI_BYTE, cb.comm_);
+      }
+    }
+  }
+
+  /** The part of \a domain handled in aggregation round \a round */
+  static CollectiveExtent GetWindow(const CollectiveExtent &domain,
+                                    size_t round, size_t win_size) {
+    CollectiveExtent win(domain.off_ + round * win_size, win_size);
+    return win.Clip(domain.off_, domain.end());
+  }
+
  public:
   /** Allocate an fd for the file f */
   void RealOpen(File &f,
@@ -515,7 +716,10 @@ class MpiioFs : public Filesystem {
         stat.comm_, path.c_str(), stat.amode_, stat.info_, &stat.mpi_fh_);
     if (f.mpi_status_ != MPI_SUCCESS) {
       f.status_ = false;
+      return;
     }
+    stat.coll_ = std::make_shared<CollectiveBuffering>();
+    stat.coll_->Init(stat.comm_, stat.info_);
 
     /*if (stat.hflags_.Any(HERMES_FS_CREATE)) {
       if (stat.adapter_mode_ != AdapterMode::kScratch) {
@@ -558,6 +762,10 @@ class MpiioFs : public Filesystem {
   /** Close \a file FILE f */
   int RealClose(const File &f,
                 AdapterStat &stat) override {
+    if (stat.coll_) {
+      stat.coll_->Free();
+      stat.coll_.reset();
+    }
     return real_api_->MPI_File_close(&stat.mpi_fh_);
   }
 
@@ -576,6 +784,11 @@ class MpiioFs : public Filesystem {
     return remove(path.c_str());
   }
 
+  /** Truncate the file at \a path */
+  int RealTruncate(const std::string &path, size_t new_size) override {
+    return truncate(path.c_str(), new_size);
+  }
+
   /** Get initial statistics from the backend */
   size_t GetBackendSize(const hipc::charbuf &bkt_name) override {
     size_t true_size = 0;
@@ -450,6 +450,50 @@ int HERMES_DECL(fsync)(int fd) {
   return real_api->fsync(fd);
 }
 
+int HERMES_DECL(ftruncate)(int fd, off_t length) {
+  bool stat_exists;
+  auto real_api = HERMES_POSIX_API;
+  auto fs_api = HERMES_POSIX_FS;
+  if (fs_api->IsFdTracked(fd)) {
+    File f; f.hermes_fd_ = fd;
+    HILOG(kDebug, "Intercepted ftruncate({}, {}).", fd, length)
+    return fs_api->Truncate(f, stat_exists, length);
+  }
+  return real_api->ftruncate(fd, length);
+}
+
+int HERMES_DECL(ftruncate64)(int fd, off64_t length) {
+  bool stat_exists;
+  auto real_api = HERMES_POSIX_API;
+  auto fs_api = HERMES_POSIX_FS;
+  if (fs_api->IsFdTracked(fd)) {
+    File f; f.hermes_fd_ = fd;
+    HILOG(kDebug, "Intercepted ftruncate64({}, {}).", fd, length)
+    return fs_api->Truncate(f, stat_exists, length);
+  }
+  return real_api->ftruncate64(fd, length);
+}
+
+int HERMES_DECL(truncate)(const char *pathname, off_t length) {
+  auto real_api = HERMES_POSIX_API;
+  auto fs_api = HERMES_POSIX_FS;
+  if (fs_api->IsPathTracked(pathname)) {
+    HILOG(kDebug, "Intercepted truncate({}, {})", pathname, length)
+    return fs_api->Truncate(pathname, length);
+  }
+  return real_api->truncate(pathname, length);
+}
+
+int HERMES_DECL(truncate64)(const char *pathname, off64_t length) {
+  auto real_api = HERMES_POSIX_API;
+  auto fs_api = HERMES_POSIX_FS;
+  if (fs_api->IsPathTracked(pathname)) {
+    HILOG(kDebug, "Intercepted truncate64({}, {})", pathname, length)
+    return fs_api->Truncate(pathname, length);
+  }
+  return real_api->truncate64(pathname, length);
+}
+
 int HERMES_DECL(close)(int fd) {
   bool stat_exists;
   auto real_api = HERMES_POSIX_API;
@@ -495,4 +539,19 @@ int HERMES_DECL(unlink)(const char *pathname) {
   return real_api->unlink(pathname);
 }
 
+int HERMES_DECL(chdir)(const char *path) {
+  auto real_api = HERMES_POSIX_API;
+  int ret = real_api->chdir(path);
+  // Relative paths are canonicalized using a cached working directory
+  HERMES_FS_METADATA_MANAGER->InvalidateCwd();
+  return ret;
+}
+
+int HERMES_DECL(fchdir)(int fd) {
+  auto real_api = HERMES_POSIX_API;
+  int ret = real_api->fchdir(fd);
+  HERMES_FS_METADATA_MANAGER->InvalidateCwd();
+  return ret;
+}
+
 }  // extern C
@@ -19,6 +19,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/uio.h>
 #include "hermes_adapters/real_api.h"
 
 #ifndef O_TMPFILE
@@ -41,6 +42,7 @@ typedef ssize_t (*pread_t)(int fd, void * buf, size_t count, off_t offset);
 typedef ssize_t (*pwrite_t)(int fd, const void * buf, size_t count, off_t offset);
 typedef ssize_t (*pread64_t)(int fd, void * buf, size_t count, off64_t offset);
 typedef ssize_t (*pwrite64_t)(int fd, const void * buf, size_t count, off64_t offset);
+typedef ssize_t (*pwritev_t)(int fd, const struct iovec *iov, int iovcnt, off_t offset);
 typedef off_t (*lseek_t)(int fd, off_t offset, int whence);
 typedef off64_t (*lseek64_t)(int fd, off64_t offset, int whence);
 
@@ -67,6 +69,10 @@ typedef int (*stat64_t)(const char * pathname, struct stat64 * __stat_buf);
 typedef int (*fstat64_t)(int __filedesc, struct stat64 * __stat_buf);
 
 typedef int (*fsync_t)(int fd);
+typedef int (*ftruncate_t)(int fd, off_t length);
+typedef int (*ftruncate64_t)(int fd, off64_t length);
+typedef int (*truncate_t)(const char *path, off_t length);
+typedef int (*truncate64_t)(const char *path, off64_t length);
 typedef int (*close_t)(int fd);
 
 typedef int (*fchdir_t)(int fd);
@@ -87,6 +93,7 @@ typedef int (*posix_fadvise_t)(int fd, off_t offset,
 typedef int (*flock_t)(int fd, int operation);
 typedef int (*remove_t)(const char *pathname);
 typedef int (*unlink_t)(const char *pathname);
+typedef int (*chdir_t)(const char *path);
 }
 
 namespace hermes::adapter {
@@ -122,6 +129,8 @@ class PosixApi : public RealApi {
   pread64_t pread64 = nullptr;
   /** pwrite64 */
   pwrite64_t pwrite64 = nullptr;
+  /** pwritev */
+  pwritev_t pwritev = nullptr;
   /** lseek */
   lseek_t lseek = nullptr;
   /** lseek64 */
@@ -155,6 +164,14 @@ class PosixApi : public RealApi {
 
   /** fsync */
   fsync_t fsync = nullptr;
+  /** ftruncate */
+  ftruncate_t ftruncate = nullptr;
+  /** ftruncate64 */
+  ftruncate64_t ftruncate64 = nullptr;
+  /** truncate */
+  truncate_t truncate = nullptr;
+  /** truncate64 */
+  truncate64_t truncate64 = nullptr;
   /** close */
   close_t close = nullptr;
   /** flock */
@@ -163,6 +180,10 @@ class PosixApi : public RealApi {
   remove_t remove = nullptr;
   /** unlink */
   unlink_t unlink = nullptr;
+  /** chdir */
+  chdir_t chdir = nullptr;
+  /** fchdir */
+  fchdir_t fchdir = nullptr;
 
   PosixApi() : RealApi("open", "posix_intercepted") {
     open = (open_t)dlsym(real_lib_, "open");
@@ -187,6 +208,8 @@ class PosixApi : public RealApi {
     REQUIRE_API(pread64)
     pwrite64 = (pwrite64_t)dlsym(real_lib_, "pwrite64");
     REQUIRE_API(pwrite64)
+    pwritev = (pwritev_t)dlsym(real_lib_, "pwritev");
+    REQUIRE_API(pwritev)
     lseek = (lseek_t)dlsym(real_lib_, "lseek");
     REQUIRE_API(lseek)
     lseek64 = (lseek64_t)dlsym(real_lib_, "lseek64");
@@ -216,6 +239,14 @@ class PosixApi : public RealApi {
 
     fsync = (fsync_t)dlsym(real_lib_, "fsync");
     REQUIRE_API(fsync)
+    ftruncate = (ftruncate_t)dlsym(real_lib_, "ftruncate");
+    REQUIRE_API(ftruncate)
+    ftruncate64 = (ftruncate64_t)dlsym(real_lib_, "ftruncate64");
+    REQUIRE_API(ftruncate64)
+    truncate = (truncate_t)dlsym(real_lib_, "truncate");
+    REQUIRE_API(truncate)
+    truncate64 = (truncate64_t)dlsym(real_lib_, "truncate64");
+    REQUIRE_API(truncate64)
     close = (close_t)dlsym(real_lib_, "close");
     REQUIRE_API(close)
     flock = (flock_t)dlsym(real_lib_, "flock");
@@ -224,6 +255,10 @@ class PosixApi : public RealApi {
     REQUIRE_API(remove)
     unlink = (unlink_t)dlsym(real_lib_, "unlink");
     REQUIRE_API(unlink)
+    chdir = (chdir_t)dlsym(real_lib_, "chdir");
+    REQUIRE_API(chdir)
+    fchdir = (fchdir_t)dlsym(real_lib_, "fchdir");
+    REQUIRE_API(fchdir)
   }
 
   bool IsInterceptorLoaded() {
@@ -29,6 +29,10 @@ class PosixFs : public hermes::adapter::Filesystem {
  public:
   PosixFs() : Filesystem(AdapterType::kPosix) {
     real_api_ = HERMES_POSIX_API;
+    // chdir and fchdir are intercepted, so the cwd can be cached
+    if (real_api_->IsInterceptorLoaded()) {
+      HERMES_FS_METADATA_MANAGER->TrackCwd();
+    }
   }
 
   template<typename StatT>
@@ -184,6 +188,11 @@ class PosixFs : public hermes::adapter::Filesystem {
     return real_api_->remove(path.c_str());
   }
 
+  /** Truncate the file at \a path */
+  int RealTruncate(const std::string &path, size_t new_size) override {
+    return real_api_->truncate(path.c_str(), new_size);
+  }
+
   /** Get initial statistics from the backend */
   size_t GetBackendSize(const hipc::charbuf &bkt_name) override {
     size_t true_size = 0;
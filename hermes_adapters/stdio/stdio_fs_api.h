@@ -176,6 +176,11 @@ class StdioFs : public hermes::adapter::Filesystem {
     return remove(path.c_str());
   }
 
+  /** Truncate the file at \a path */
+  int RealTruncate(const std::string &path, size_t new_size) override {
+    return truncate(path.c_str(), new_size);
+  }
+
   /** Get initial statistics from the backend */
   size_t GetBackendSize(const hipc::charbuf &bkt_name) override {
     size_t true_size = 0;
@@ -40,6 +40,7 @@
 #include "H5FDhermes.h"     /* Hermes file driver     */
 
 #include "hermes_adapters/posix/posix_fs_api.h"
+#include "H5FDhermes_io.h"
 
 /**
  * Make this adapter use Hermes.
@@ -59,9 +60,12 @@ hid_t H5FDhermes_err_class_g = H5I_INVALID_HID;
 #define OP_READ    1
 #define OP_WRITE   2
 
+using hermes::adapter::AdapterMode;
 using hermes::adapter::AdapterStat;
 using hermes::adapter::File;
+using hermes::adapter::FsIoVec;
 using hermes::adapter::IoStatus;
+using hermes::adapter::VfdMetadataCache;
 
 /* POSIX I/O mode used as the third parameter to open/_open
  * when creating a new file (O_CREAT is set). */
@@ -75,6 +79,11 @@ using hermes::adapter::IoStatus;
 #define SUCCEED 0
 #define FAIL    (-1)
 
+/* Push an I/O error of this driver onto HDF5's error stack */
+#define H5FD_HERMES_PUSH_ERROR(min, msg)                                  \
+  H5Epush2(H5E_DEFAULT, __FILE__, __func__, __LINE__, H5E_ERR_CLS,        \
+           H5E_VFL, min, msg)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -90,6 +99,7 @@ typedef struct H5FD_hermes_t {
   int            fd;          /* the filesystem file descriptor        */
   char           *filename_;  /* the name of the file */
   unsigned       flags;       /* The flags passed from H5Fcreate/H5Fopen */
+  VfdMetadataCache *meta;     /* metadata cache, NULL if disabled      */
 } H5FD_hermes_t;
 
 /* Driver-specific file access properties */
@@ -111,6 +121,31 @@ static herr_t H5FD__hermes_read(H5FD_t *_file, H5FD_mem_t type, hid_t fapl_id,
                                 haddr_t addr, size_t size, void *buf);
 static herr_t H5FD__hermes_write(H5FD_t *_file, H5FD_mem_t type, hid_t fapl_id,
                                  haddr_t addr, size_t size, const void *buf);
+static herr_t H5FD__hermes_read_vector(H5FD_t *_file, hid_t dxpl_id,
+                                       uint32_t count, H5FD_mem_t types[],
+                                       haddr_t addrs[], size_t sizes[],
+                                       void *bufs[]);
+static herr_t H5FD__hermes_write_vector(H5FD_t *_file, hid_t dxpl_id,
+                                        uint32_t count, H5FD_mem_t types[],
+                                        haddr_t addrs[], size_t sizes[],
+                                        const void *bufs[]);
+static herr_t H5FD__hermes_read_selection(H5FD_t *_file, H5FD_mem_t type,
+                                          hid_t dxpl_id, size_t count,
+                                          hid_t mem_spaces[],
+                                          hid_t file_spaces[],
+                                          haddr_t offsets[],
+                                          size_t element_sizes[],
+                                          void *bufs[]);
+static herr_t H5FD__hermes_write_selection(H5FD_t *_file, H5FD_mem_t type,
+                                           hid_t dxpl_id, size_t count,
+                                           hid_t mem_spaces[],
+                                           hid_t file_spaces[],
+                                           haddr_t offsets[],
+                                           size_t element_sizes[],
+                                           const void *bufs[]);
+static herr_t H5FD__hermes_flush(H5FD_t *_file, hid_t dxpl_id,
+                                 hbool_t closing);
+static herr_t H5FD__hermes_flush_metadata(H5FD_hermes_t *file);
 
 
 static const H5FD_class_t H5FD_hermes_g = {
@@ -143,11 +178,11 @@ static const H5FD_class_t H5FD_hermes_g = {
   NULL,                      /* get_handle           */
   H5FD__hermes_read,         /* read                 */
   H5FD__hermes_write,        /* write                */
-  NULL,                      /* read_vector          */
-  NULL,                      /* write_vector         */
-  NULL,                      /* read_selection       */
-  NULL,                      /* write_selection      */
-  NULL,                      /* flush                */
+  H5FD__hermes_read_vector,  /* read_vector          */
+  H5FD__hermes_write_vector, /* write_vector         */
+  H5FD__hermes_read_selection,  /* read_selection   */
+  H5FD__hermes_write_selection, /* write_selection  */
+  H5FD__hermes_flush,        /* flush                */
   NULL,                      /* truncate             */
   NULL,                      /* lock                 */
   NULL,                      /* unlock               */
@@ -252,6 +287,7 @@ H5FD__hermes_open(const char *name, unsigned flags, hid_t fapl_id,
   AdapterStat stat;
   stat.flags_ = o_flags;
   stat.st_mode_ = H5FD_HERMES_POSIX_CREATE_MODE_RW;
+  stat.page_size_ = HERMES_CLIENT_CONF.vfd_raw_page_size_;
   File f = fs_api->Open(stat, name);
   fd = f.hermes_fd_;
   HILOG(kDebug, "")
@@ -279,6 +315,11 @@ H5FD__hermes_open(const char *name, unsigned flags, hid_t fapl_id,
 
 #ifdef USE_HERMES
   file->eof = (haddr_t)fs_api->GetSize(f, stat_exists);
+  if (stat.adapter_mode_ != AdapterMode::kBypass &&
+      HERMES_CLIENT_CONF.vfd_meta_page_size_ > 0) {
+    file->meta = new VfdMetadataCache(
+        stat.path_, HERMES_CLIENT_CONF.vfd_meta_page_size_);
+  }
 #else
   file->eof = stdfs::file_size(name);
 #endif
@@ -305,6 +346,11 @@ static herr_t H5FD__hermes_close(H5FD_t *_file) {
   auto fs_api = HERMES_POSIX_FS;
   File f; f.hermes_fd_ = file->fd;
   bool stat_exists;
+  if (file->meta) {
+    H5FD__hermes_flush_metadata(file);
+    file->meta->Destroy();
+    delete file->meta;
+  }
   fs_api->Close(f, stat_exists);
   HILOG(kDebug, "")
 #else
@@ -443,10 +489,7 @@ static haddr_t H5FD__hermes_get_eof(const H5FD_t *_file,
  *
  * Purpose:     Reads SIZE bytes of data from FILE beginning at address ADDR
  *              into buffer BUF according to data transfer properties in
- *              DXPL_ID. Determine the number of file pages affected by this
- *              call from ADDR and SIZE. Utilize transfer buffer PAGE_BUF to
- *              read the data from Blobs. Exercise care for the first and last
- *              pages to prevent overwriting existing data.
+ *              DXPL_ID. A vector read of a single extent.
  *
  * Return:      Success:    SUCCEED. Result is stored in caller-supplied
  *                          buffer BUF.
@@ -457,60 +500,330 @@ static haddr_t H5FD__hermes_get_eof(const H5FD_t *_file,
 static herr_t H5FD__hermes_read(H5FD_t *_file, H5FD_mem_t type,
                                 hid_t dxpl_id, haddr_t addr,
                                 size_t size, void *buf) {
-  (void) dxpl_id; (void) type;
+  return H5FD__hermes_read_vector(_file, dxpl_id, 1, &type,
+                                  &addr, &size, &buf);
+} /* end H5FD__hermes_read() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5FD__hermes_write
+ *
+ * Purpose:     Writes SIZE bytes of data contained in buffer BUF to Hermes
+ *              buffering system according to data transfer properties in
+ *              DXPL_ID. A vector write of a single extent.
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t H5FD__hermes_write(H5FD_t *_file, H5FD_mem_t type,
+                                 hid_t dxpl_id, haddr_t addr,
+                                 size_t size, const void *buf) {
+  return H5FD__hermes_write_vector(_file, dxpl_id, 1, &type,
+                                   &addr, &size, &buf);
+} /* end H5FD__hermes_write() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5FD__hermes_is_metadata
+ *
+ * Purpose:     Whether I/O of memory type TYPE is file metadata. Raw data
+ *              and the global heap (variable-length data) are bulk data;
+ *              everything else is cached in the metadata bucket.
+ *
+ *-------------------------------------------------------------------------
+ */
+static inline bool H5FD__hermes_is_metadata(H5FD_mem_t type) {
+  return type != H5FD_MEM_DRAW && type != H5FD_MEM_GHEAP;
+}
+
+/*-------------------------------------------------------------------------
+ * Function:    H5FD__hermes_read_vector
+ *
+ * Purpose:     Reads COUNT extents of FILE. Metadata extents held by the
+ *              metadata cache are read from it. All other extents are read
+ *              from the file's bucket as a single batch of Gets. Bytes past
+ *              the end of the file are zero-filled. A size of 0 or a type of
+ *              H5FD_MEM_NOLIST repeats the previous entry for the remainder
+ *              of the vector.
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t H5FD__hermes_read_vector(H5FD_t *_file, hid_t dxpl_id,
+                                       uint32_t count, H5FD_mem_t types[],
+                                       haddr_t addrs[], size_t sizes[],
+                                       void *bufs[]) {
+  (void) dxpl_id;
   H5FD_hermes_t *file = (H5FD_hermes_t *)_file;
-  herr_t ret_value = SUCCEED;
+  H5FD_mem_t type = H5FD_MEM_DEFAULT;
+  size_t size = 0;
+  bool fixed_type = false, fixed_size = false;
 
 #ifdef USE_HERMES
-  bool stat_exists;
   auto fs_api = HERMES_POSIX_FS;
+  auto mdm = HERMES_FS_METADATA_MANAGER;
   File f; f.hermes_fd_ = file->fd; IoStatus io_status;
-  size_t count = fs_api->Read(f, stat_exists, buf, addr, size, io_status);
+  std::shared_ptr<AdapterStat> stat = mdm->Find(f);
+  if (!stat) {
+    return FAIL;
+  }
+  std::vector<FsIoVec> iov;
+  std::vector<size_t> want;
+  std::vector<bool> fill;
+  for (uint32_t i = 0; i < count; ++i) {
+    fixed_type |= types[i] == H5FD_MEM_NOLIST;
+    fixed_size |= sizes[i] == 0;
+    if (!fixed_type) { type = types[i]; }
+    if (!fixed_size) { size = sizes[i]; }
+    char *buf = (char*)bufs[i];
+    bool is_meta = file->meta && H5FD__hermes_is_metadata(type);
+    if (is_meta && file->meta->Contains(addrs[i], size)) {
+      file->meta->Read(addrs[i], size, buf);
+      continue;
+    }
+    iov.emplace_back(FsIoVec{addrs[i], size, buf});
+    want.emplace_back(size);
+    fill.emplace_back(is_meta);
+  }
+  if (iov.empty()) {
+    return SUCCEED;
+  }
+  fs_api->ReadVector(f, *stat, iov, io_status);
+  if (!io_status.success_) {
+    H5FD_HERMES_PUSH_ERROR(H5E_READERROR, "Hermes vector read failed");
+    return FAIL;
+  }
+  for (size_t i = 0; i < iov.size(); ++i) {
+    FsIoVec &v = iov[i];
+    if (v.size_ < want[i]) {
+      memset(v.buf_ + v.size_, 0, want[i] - v.size_);
+    }
+    if (file->meta) {
+      file->meta->Overlay(v.off_, want[i], v.buf_);
+      if (fill[i]) {
+        file->meta->Fill(v.off_, want[i], v.buf_);
+      }
+    }
+  }
   HILOG(kDebug, "")
 #else
-  size_t count = read(file->fd, (char*)buf + addr, size);
-#endif
-
-  if (count < size) {
-    // TODO(llogan)
+  for (uint32_t i = 0; i < count; ++i) {
+    fixed_type |= types[i] == H5FD_MEM_NOLIST;
+    fixed_size |= sizes[i] == 0;
+    if (!fixed_type) { type = types[i]; }
+    if (!fixed_size) { size = sizes[i]; }
+    ssize_t ret = pread(file->fd, bufs[i], size, addrs[i]);
+    if (ret < 0) {
+      H5FD_HERMES_PUSH_ERROR(H5E_READERROR, "pread failed");
+      return FAIL;
+    }
+    if ((size_t)ret < size) {
+      memset((char*)bufs[i] + ret, 0, size - ret);
+    }
   }
-  return ret_value;
-} /* end H5FD__hermes_read() */
+#endif
+  return SUCCEED;
+} /* end H5FD__hermes_read_vector() */
 
 /*-------------------------------------------------------------------------
- * Function:    H5FD__hermes_write
+ * Function:    H5FD__hermes_write_vector
  *
- * Purpose:     Writes SIZE bytes of data contained in buffer BUF to Hermes
- *              buffering system according to data transfer properties in
- *              DXPL_ID. Determine the number of file pages affected by this
- *              call from ADDR and SIZE. Utilize transfer buffer PAGE_BUF to
- *              put the data into Blobs. Exercise care for the first and last
- *              pages to prevent overwriting existing data.
+ * Purpose:     Writes COUNT extents of FILE. Metadata extents go to the
+ *              metadata cache and reach the file's bucket on flush. All
+ *              other extents are written to the file's bucket as a single
+ *              batch of Puts. A size of 0 or a type of H5FD_MEM_NOLIST
+ *              repeats the previous entry for the remainder of the vector.
  *
  * Return:      SUCCEED/FAIL
  *
  *-------------------------------------------------------------------------
  */
-static herr_t H5FD__hermes_write(H5FD_t *_file, H5FD_mem_t type,
-                                 hid_t dxpl_id, haddr_t addr,
-                                 size_t size, const void *buf) {
-  (void) dxpl_id; (void) type;
+static herr_t H5FD__hermes_write_vector(H5FD_t *_file, hid_t dxpl_id,
+                                        uint32_t count, H5FD_mem_t types[],
+                                        haddr_t addrs[], size_t sizes[],
+                                        const void *bufs[]) {
+  (void) dxpl_id;
   H5FD_hermes_t *file = (H5FD_hermes_t *)_file;
-  herr_t ret_value = SUCCEED;
+  H5FD_mem_t type = H5FD_MEM_DEFAULT;
+  size_t size = 0;
+  bool fixed_type = false, fixed_size = false;
+
 #ifdef USE_HERMES
-  bool stat_exists;
   auto fs_api = HERMES_POSIX_FS;
+  auto mdm = HERMES_FS_METADATA_MANAGER;
   File f; f.hermes_fd_ = file->fd; IoStatus io_status;
-  size_t count = fs_api->Write(f, stat_exists, buf, addr, size, io_status);
+  std::shared_ptr<AdapterStat> stat = mdm->Find(f);
+  if (!stat) {
+    return FAIL;
+  }
+  std::vector<FsIoVec> iov;
+  size_t total_size = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    fixed_type |= types[i] == H5FD_MEM_NOLIST;
+    fixed_size |= sizes[i] == 0;
+    if (!fixed_type) { type = types[i]; }
+    if (!fixed_size) { size = sizes[i]; }
+    char *buf = (char*)bufs[i];
+    if (file->meta && H5FD__hermes_is_metadata(type)) {
+      file->meta->Write(addrs[i], size, buf);
+    } else {
+      if (file->meta) {
+        file->meta->Invalidate(addrs[i], size);
+      }
+      iov.emplace_back(FsIoVec{addrs[i], size, buf});
+      total_size += size;
+    }
+    file->eof = std::max(file->eof, (haddr_t)(addrs[i] + size));
+  }
+  if (!iov.empty() &&
+      (fs_api->WriteVector(f, *stat, iov, io_status) < total_size ||
+       !io_status.success_)) {
+    H5FD_HERMES_PUSH_ERROR(H5E_WRITEERROR, "Hermes vector write failed");
+    return FAIL;
+  }
   HILOG(kDebug, "")
 #else
-  size_t count = write(file->fd, (char*)buf + addr, size);
+  for (uint32_t i = 0; i < count; ++i) {
+    fixed_type |= types[i] == H5FD_MEM_NOLIST;
+    fixed_size |= sizes[i] == 0;
+    if (!fixed_type) { type = types[i]; }
+    if (!fixed_size) { size = sizes[i]; }
+    if (pwrite(file->fd, bufs[i], size, addrs[i]) < (ssize_t)size) {
+      H5FD_HERMES_PUSH_ERROR(H5E_WRITEERROR, "pwrite failed");
+      return FAIL;
+    }
+    file->eof = std::max(file->eof, (haddr_t)(addrs[i] + size));
+  }
 #endif
-  if (count < size) {
-    // TODO(llogan)
+  return SUCCEED;
+} /* end H5FD__hermes_write_vector() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5FD__hermes_read_selection
+ *
+ * Purpose:     Reads the selections of COUNT dataspaces as one vector read.
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t H5FD__hermes_read_selection(H5FD_t *_file, H5FD_mem_t type,
+                                          hid_t dxpl_id, size_t count,
+                                          hid_t mem_spaces[],
+                                          hid_t file_spaces[],
+                                          haddr_t offsets[],
+                                          size_t element_sizes[],
+                                          void *bufs[]) {
+  std::vector<haddr_t> addrs;
+  std::vector<size_t> sizes;
+  std::vector<char*> vbufs;
+  if (!hermes::adapter::VfdSelectionToVector(
+      count, mem_spaces, file_spaces, offsets, element_sizes,
+      (char**)bufs, addrs, sizes, vbufs)) {
+    return FAIL;
   }
-  return ret_value;
-} /* end H5FD__hermes_write() */
+  if (addrs.empty()) {
+    return SUCCEED;
+  }
+  std::vector<H5FD_mem_t> types(addrs.size(), type);
+  std::vector<void*> ptrs(vbufs.begin(), vbufs.end());
+  return H5FD__hermes_read_vector(_file, dxpl_id, (uint32_t)addrs.size(),
+                                  types.data(), addrs.data(), sizes.data(),
+                                  ptrs.data());
+} /* end H5FD__hermes_read_selection() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5FD__hermes_write_selection
+ *
+ * Purpose:     Writes the selections of COUNT dataspaces as one vector
+ *              write.
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t H5FD__hermes_write_selection(H5FD_t *_file, H5FD_mem_t type,
+                                           hid_t dxpl_id, size_t count,
+                                           hid_t mem_spaces[],
+                                           hid_t file_spaces[],
+                                           haddr_t offsets[],
+                                           size_t element_sizes[],
+                                           const void *bufs[]) {
+  std::vector<haddr_t> addrs;
+  std::vector<size_t> sizes;
+  std::vector<char*> vbufs;
+  if (!hermes::adapter::VfdSelectionToVector(
+      count, mem_spaces, file_spaces, offsets, element_sizes,
+      (char**)bufs, addrs, sizes, vbufs)) {
+    return FAIL;
+  }
+  if (addrs.empty()) {
+    return SUCCEED;
+  }
+  std::vector<H5FD_mem_t> types(addrs.size(), type);
+  std::vector<const void*> ptrs(vbufs.begin(), vbufs.end());
+  return H5FD__hermes_write_vector(_file, dxpl_id, (uint32_t)addrs.size(),
+                                   types.data(), addrs.data(), sizes.data(),
+                                   ptrs.data());
+} /* end H5FD__hermes_write_selection() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5FD__hermes_flush
+ *
+ * Purpose:     Writes dirty metadata into the file's bucket.
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t H5FD__hermes_flush(H5FD_t *_file, hid_t dxpl_id,
+                                 hbool_t closing) {
+  (void) dxpl_id; (void) closing;
+  return H5FD__hermes_flush_metadata((H5FD_hermes_t *)_file);
+} /* end H5FD__hermes_flush() */
+
+/*-------------------------------------------------------------------------
+ * Function:    H5FD__hermes_flush_metadata
+ *
+ * Purpose:     Writes the dirty extents of the metadata cache into the
+ *              file's bucket as a single vector write.
+ *
+ * Return:      SUCCEED/FAIL
+ *
+ *-------------------------------------------------------------------------
+ */
+static herr_t H5FD__hermes_flush_metadata(H5FD_hermes_t *file) {
+#ifdef USE_HERMES
+  if (!file->meta) {
+    return SUCCEED;
+  }
+  auto fs_api = HERMES_POSIX_FS;
+  auto mdm = HERMES_FS_METADATA_MANAGER;
+  File f; f.hermes_fd_ = file->fd; IoStatus io_status;
+  std::shared_ptr<AdapterStat> stat = mdm->Find(f);
+  if (!stat) {
+    return FAIL;
+  }
+  std::vector<char> data;
+  std::vector<FsIoVec> iov;
+  file->meta->TakeDirty(data, iov);
+  if (iov.empty()) {
+    return SUCCEED;
+  }
+  size_t total_size = 0;
+  for (const FsIoVec &v : iov) {
+    total_size += v.size_;
+  }
+  if (fs_api->WriteVector(f, *stat, iov, io_status) < total_size ||
+      !io_status.success_) {
+    H5FD_HERMES_PUSH_ERROR(H5E_WRITEERROR, "Hermes metadata flush failed");
+    return FAIL;
+  }
+#else
+  (void) file;
+#endif
+  return SUCCEED;
+} /* end H5FD__hermes_flush_metadata() */
 
 /*
  * Stub routines for dynamic plugin loading
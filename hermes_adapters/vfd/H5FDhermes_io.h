@@ -0,0 +1,339 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_ADAPTER_VFD_H5FDHERMES_IO_H_
+#define HERMES_ADAPTER_VFD_H5FDHERMES_IO_H_
+
+#include <unistd.h>
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <hdf5.h>
+#include "hermes_adapters/posix/posix_fs_api.h"
+
+namespace hermes::adapter {
+
+/** A set of disjoint byte ranges [off, end) of a file */
+class ExtentSet {
+ public:
+  typedef std::pair<size_t, size_t> RANGE_T;
+  std::map<size_t, size_t> extents_;  /**< Offset -> end */
+
+ public:
+  /** Add [off, end), merging with adjacent ranges */
+  void Add(size_t off, size_t end) {
+    if (off >= end) {
+      return;
+    }
+    auto it = extents_.upper_bound(off);
+    if (it != extents_.begin()) {
+      auto prev = std::prev(it);
+      if (prev->second >= off) {
+        off = prev->first;
+        end = std::max(end, prev->second);
+        it = extents_.erase(prev);
+      }
+    }
+    while (it != extents_.end() && it->first <= end) {
+      end = std::max(end, it->second);
+      it = extents_.erase(it);
+    }
+    extents_.emplace(off, end);
+  }
+
+  /** Remove [off, end), splitting ranges which overlap it */
+  void Remove(size_t off, size_t end) {
+    if (off >= end) {
+      return;
+    }
+    auto it = First(off);
+    while (it != extents_.end() && it->first < end) {
+      size_t e_off = it->first, e_end = it->second;
+      it = extents_.erase(it);
+      if (e_off < off) {
+        extents_.emplace(e_off, off);
+      }
+      if (e_end > end) {
+        extents_.emplace(end, e_end);
+        break;
+      }
+    }
+  }
+
+  /** Whether [off, end) is entirely in the set */
+  bool Contains(size_t off, size_t end) const {
+    auto it = extents_.upper_bound(off);
+    if (it == extents_.begin()) {
+      return false;
+    }
+    --it;
+    return it->first <= off && it->second >= end;
+  }
+
+  /** The parts of [off, end) which are in the set */
+  std::vector<RANGE_T> Intersect(size_t off, size_t end) const {
+    std::vector<RANGE_T> ranges;
+    for (auto it = First(off); it != extents_.end() && it->first < end; ++it) {
+      ranges.emplace_back(std::max(it->first, off), std::min(it->second, end));
+    }
+    return ranges;
+  }
+
+  /** Whether the set is empty */
+  bool empty() const {
+    return extents_.empty();
+  }
+
+  /** Remove all ranges */
+  void clear() {
+    extents_.clear();
+  }
+
+ private:
+  /** The first range ending after \a off */
+  std::map<size_t, size_t>::const_iterator First(size_t off) const {
+    auto it = extents_.upper_bound(off);
+    if (it != extents_.begin() && std::prev(it)->second > off) {
+      --it;
+    }
+    return it;
+  }
+
+  /** The first range ending after \a off */
+  std::map<size_t, size_t>::iterator First(size_t off) {
+    auto it = extents_.upper_bound(off);
+    if (it != extents_.begin() && std::prev(it)->second > off) {
+      --it;
+    }
+    return it;
+  }
+};
+
+/**
+ * Write-back cache for the metadata of an HDF5 file.
+ *
+ * HDF5 metadata (superblock, object headers, B-tree nodes, heaps) is small
+ * and read far more often than raw data. It is kept in a bucket of its own
+ * with small pages and a stationary, maximal score so that bulk raw data
+ * cannot push it out of the fastest tier. The file's bucket remains the
+ * only one staged to the backend: dirty metadata is written into it on
+ * flush and close.
+ *
+ * The bucket is private to the opening process, since the cache tracks
+ * which byte ranges it holds.
+ * */
+class VfdMetadataCache {
+ public:
+  hapi::Bucket bkt_;   /**< The metadata bucket */
+  Context ctx_;        /**< Puts pin the blobs with a maximal score */
+  size_t page_size_;   /**< Page size of the metadata bucket */
+  ExtentSet valid_;    /**< Bytes held by the bucket */
+  ExtentSet dirty_;    /**< Bytes not yet written to the file's bucket */
+
+ public:
+  /** Create the metadata bucket for the file \a path */
+  VfdMetadataCache(const std::string &path, size_t page_size)
+      : page_size_(page_size) {
+    static std::atomic<size_t> count(0);
+    std::string name = path + "#h5meta." + std::to_string(getpid()) +
+        "." + std::to_string(count.fetch_add(1));
+    bkt_ = HERMES->GetBucket(name);
+    ctx_.blob_score_ = 1;
+    ctx_.flags_.SetBits(HERMES_USER_SCORE_STATIONARY);
+  }
+
+  /** Whether [off, off + size) can be read from the cache */
+  bool Contains(size_t off, size_t size) const {
+    return valid_.Contains(off, off + size);
+  }
+
+  /** Read [off, off + size), which must be cached */
+  void Read(size_t off, size_t size, char *buf) {
+    GetRange(off, size, buf);
+  }
+
+  /** Write metadata. It reaches the file's bucket on the next Flush. */
+  void Write(size_t off, size_t size, const char *buf) {
+    PutRange(off, size, buf);
+    valid_.Add(off, off + size);
+    dirty_.Add(off, off + size);
+  }
+
+  /** Cache clean data which was read from the file's bucket */
+  void Fill(size_t off, size_t size, const char *buf) {
+    std::vector<ExtentSet::RANGE_T> dirty = dirty_.Intersect(off, off + size);
+    size_t cur = off;
+    for (const ExtentSet::RANGE_T &range : dirty) {
+      PutRange(cur, range.first - cur, buf + (cur - off));
+      cur = range.second;
+    }
+    PutRange(cur, off + size - cur, buf + (cur - off));
+    valid_.Add(off, off + size);
+  }
+
+  /** Copy dirty metadata within [off, off + size) over \a buf */
+  void Overlay(size_t off, size_t size, char *buf) {
+    for (const ExtentSet::RANGE_T &range : dirty_.Intersect(off, off + size)) {
+      GetRange(range.first, range.second - range.first,
+               buf + (range.first - off));
+    }
+  }
+
+  /** Forget [off, off + size) after it was overwritten in the file */
+  void Invalidate(size_t off, size_t size) {
+    valid_.Remove(off, off + size);
+    dirty_.Remove(off, off + size);
+  }
+
+  /**
+   * Collect the dirty metadata for a vectored write to the file's bucket.
+   * \a iov points into \a data. The cache is clean afterwards.
+   * */
+  void TakeDirty(std::vector<char> &data, std::vector<FsIoVec> &iov) {
+    size_t total = 0;
+    for (auto &extent : dirty_.extents_) {
+      total += extent.second - extent.first;
+    }
+    data.resize(total);
+    iov.clear();
+    size_t data_off = 0;
+    for (auto &extent : dirty_.extents_) {
+      size_t size = extent.second - extent.first;
+      GetRange(extent.first, size, data.data() + data_off);
+      iov.emplace_back(FsIoVec{extent.first, size, data.data() + data_off});
+      data_off += size;
+    }
+    dirty_.clear();
+  }
+
+  /** Destroy the metadata bucket */
+  void Destroy() {
+    bkt_.Destroy();
+    valid_.clear();
+    dirty_.clear();
+  }
+
+ private:
+  /** Put [off, off + size) into the pages of the metadata bucket */
+  void PutRange(size_t off, size_t size, const char *buf) {
+    if (size == 0) {
+      return;
+    }
+    BlobPlacements mapping;
+    auto mapper = MapperFactory::Get(MapperType::kBalancedMapper);
+    mapper->map(off, size, page_size_, mapping);
+    size_t data_offset = 0;
+    TaskBatch batch;
+    for (const BlobPlacement &p : mapping) {
+      const Blob page(buf + data_offset, p.blob_size_);
+      std::string blob_name(p.CreateBlobName().str());
+      bkt_.AsyncPartialPut(batch, blob_name, page, p.blob_off_, ctx_);
+      data_offset += p.blob_size_;
+    }
+    batch.Submit();
+  }
+
+  /** Get [off, off + size) from the pages of the metadata bucket */
+  void GetRange(size_t off, size_t size, char *buf) {
+    BlobPlacements mapping;
+    auto mapper = MapperFactory::Get(MapperType::kBalancedMapper);
+    mapper->map(off, size, page_size_, mapping);
+    size_t data_offset = 0;
+    for (const BlobPlacement &p : mapping) {
+      Blob page(buf + data_offset, p.blob_size_);
+      std::string blob_name(p.CreateBlobName().str());
+      bkt_.PartialGet(blob_name, page, p.blob_off_, ctx_);
+      data_offset += p.blob_size_;
+    }
+  }
+};
+
+/**
+ * Flatten the selections of an HDF5 selection I/O request into the file
+ * addresses, sizes and buffers of a vector I/O request. Follows the
+ * HDF5 convention that a zero element size repeats the previous one.
+ * */
+static inline bool VfdSelectionToVector(size_t count,
+                                        hid_t mem_spaces[],
+                                        hid_t file_spaces[],
+                                        haddr_t offsets[],
+                                        size_t element_sizes[],
+                                        char *bufs[],
+                                        std::vector<haddr_t> &addrs,
+                                        std::vector<size_t> &sizes,
+                                        std::vector<char*> &vbufs) {
+  static const size_t kMaxSeq = 64;
+  size_t elmt_size = 0;
+  std::vector<hsize_t> file_off, mem_off;
+  std::vector<size_t> file_len, mem_len;
+  for (size_t i = 0; i < count; ++i) {
+    if (element_sizes[i] != 0) {
+      elmt_size = element_sizes[i];
+    }
+    // Get the byte sequences of both selections
+    hssize_t npoints = H5Sget_select_npoints(file_spaces[i]);
+    if (npoints < 0) {
+      return false;
+    }
+    std::vector<hsize_t> *seq_off[2] = {&file_off, &mem_off};
+    std::vector<size_t> *seq_len[2] = {&file_len, &mem_len};
+    hid_t spaces[2] = {file_spaces[i], mem_spaces[i]};
+    for (int s = 0; s < 2; ++s) {
+      seq_off[s]->clear();
+      seq_len[s]->clear();
+#ifdef H5S_BLOCK
+      if (spaces[s] == H5S_BLOCK) {
+        seq_off[s]->emplace_back(0);
+        seq_len[s]->emplace_back(npoints * elmt_size);
+        continue;
+      }
+#endif
+      hid_t iter = H5Ssel_iter_create(spaces[s], elmt_size, 0);
+      if (iter < 0) {
+        return false;
+      }
+      size_t nseq = 0, nbytes = 0;
+      do {
+        size_t base = seq_off[s]->size();
+        seq_off[s]->resize(base + kMaxSeq);
+        seq_len[s]->resize(base + kMaxSeq);
+        H5Ssel_iter_get_seq_list(iter, kMaxSeq, SIZE_MAX, &nseq, &nbytes,
+                                 seq_off[s]->data() + base,
+                                 seq_len[s]->data() + base);
+        seq_off[s]->resize(base + nseq);
+        seq_len[s]->resize(base + nseq);
+      } while (nseq == kMaxSeq);
+      H5Ssel_iter_close(iter);
+    }
+    // Pair up the file and memory sequences
+    size_t f = 0, m = 0, f_used = 0, m_used = 0;
+    while (f < file_off.size() && m < mem_off.size()) {
+      size_t len = std::min(file_len[f] - f_used, mem_len[m] - m_used);
+      addrs.emplace_back(offsets[i] + file_off[f] + f_used);
+      sizes.emplace_back(len);
+      vbufs.emplace_back(bufs[i] + mem_off[m] + m_used);
+      f_used += len;
+      m_used += len;
+      if (f_used == file_len[f]) { ++f; f_used = 0; }
+      if (m_used == mem_len[m]) { ++m; m_used = 0; }
+    }
+  }
+  return true;
+}
+
+}  // namespace hermes::adapter
+
+#endif  // HERMES_ADAPTER_VFD_H5FDHERMES_IO_H_
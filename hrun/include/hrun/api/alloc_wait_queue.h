@@ -0,0 +1,267 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HRUN_INCLUDE_HRUN_API_ALLOC_WAIT_QUEUE_H_
+#define HRUN_INCLUDE_HRUN_API_ALLOC_WAIT_QUEUE_H_
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <signal.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <ctime>
+#include <limits>
+#include <list>
+#include <mutex>
+#include "hrun/hrun_types.h"
+
+namespace hrun {
+
+/** Sleep on \a addr while it equals \a val, for at most \a timeout_us */
+static inline void FutexWait(std::atomic<u32> *addr, u32 val,
+                             size_t timeout_us) {
+  struct timespec ts;
+  ts.tv_sec = (time_t)(timeout_us / 1000000);
+  ts.tv_nsec = (long)((timeout_us % 1000000) * 1000);
+  syscall(SYS_futex, reinterpret_cast<u32*>(addr), FUTEX_WAIT, val,
+          &ts, nullptr, 0);
+}
+
+/** Wake all threads, in any process, sleeping on \a addr */
+static inline void FutexWake(std::atomic<u32> *addr) {
+  syscall(SYS_futex, reinterpret_cast<u32*>(addr), FUTEX_WAKE, INT_MAX,
+          nullptr, nullptr, 0);
+}
+
+/**
+ * A FIFO of processes waiting on an exhausted shared-memory allocator.
+ * Stored in shared memory.
+ *
+ * Waiters take a ticket and sleep until it is served. The served ticket
+ * retries the allocation and sleeps until frees release at least the
+ * amount of memory it requested. A waiter that times out marks its slot
+ * cancelled, and the ticket is skipped. A ticket served for longer than
+ * kReapUs whose process has exited is skipped by the waiters behind it.
+ * */
+struct AllocWaitQueue {
+  static const u32 kNumSlots = 1024;   /**< Max tickets outstanding */
+  static const u32 kSlotFree = 0;      /**< Slot is unused or served */
+  static const u32 kSlotWaiting = 1;   /**< Ticket is queued */
+  static const u32 kSlotCancelled = 2; /**< Ticket timed out */
+  static const size_t kMaxSleepUs = 10000;  /**< Bounds lost wakeups */
+  static const size_t kReapUs = 100000;     /**< Head age to check for exit */
+
+  std::atomic<u32> next_ticket_;     /**< The next ticket to hand out */
+  std::atomic<u32> serving_;         /**< The ticket allowed to allocate */
+  std::atomic<u32> free_seq_;        /**< Incremented to wake the head */
+  std::atomic<u32> waiters_;         /**< Number of queued tickets */
+  std::atomic<size_t> head_size_;    /**< Size the head waits for */
+  std::atomic<size_t> head_alloc_size_;  /**< Allocated bytes at last try */
+  std::atomic<u32> slots_[kNumSlots];    /**< State of each ticket */
+  std::atomic<pid_t> owners_[kNumSlots]; /**< Process of each ticket */
+
+  /** Initialize the queue. Called by the runtime. */
+  void Init() {
+    next_ticket_ = 0;
+    serving_ = 0;
+    free_seq_ = 0;
+    waiters_ = 0;
+    head_size_ = 0;
+    head_alloc_size_ = 0;
+    for (u32 i = 0; i < kNumSlots; ++i) {
+      slots_[i] = kSlotFree;
+      owners_[i] = 0;
+    }
+  }
+
+  /** Whether anyone is waiting for memory */
+  bool HasWaiters() {
+    return waiters_.load() > 0;
+  }
+
+  /** Take a ticket */
+  u32 Enqueue() {
+    waiters_.fetch_add(1);
+    u32 ticket = next_ticket_.fetch_add(1);
+    owners_[ticket % kNumSlots].store(getpid());
+    slots_[ticket % kNumSlots].store(kSlotWaiting);
+    return ticket;
+  }
+
+  /**
+   * Sleep until \a ticket is served. Cancels the ticket and returns false
+   * if that takes longer than \a timeout_us since \a start.
+   * */
+  bool WaitTurn(u32 ticket, hshm::Timepoint &start, size_t timeout_us) {
+    u32 last_serving = serving_.load();
+    hshm::Timepoint served_at;
+    served_at.Now();
+    while (true) {
+      u32 serving = serving_.load();
+      if (serving == ticket) {
+        return true;
+      }
+      if (serving != last_serving) {
+        last_serving = serving;
+        served_at.Now();
+      } else if (served_at.GetUsecFromStart() >= kReapUs) {
+        Reap(serving);
+        served_at.Now();
+      }
+      size_t elapsed = start.GetUsecFromStart();
+      if (elapsed >= timeout_us) {
+        Cancel(ticket);
+        return false;
+      }
+      FutexWait(&serving_, serving,
+                std::min(timeout_us - elapsed, kMaxSleepUs));
+    }
+  }
+
+  /** Sleep until frees may satisfy the head, at most \a timeout_us */
+  void WaitFree(u32 free_seq, size_t timeout_us) {
+    FutexWait(&free_seq_, free_seq, std::min(timeout_us, kMaxSleepUs));
+  }
+
+  /**
+   * Record that the head needs \a size bytes while the allocator
+   * has \a alloc_size bytes allocated
+   * */
+  void SetHead(size_t size, size_t alloc_size) {
+    head_alloc_size_.store(alloc_size);
+    head_size_.store(size);
+  }
+
+  /** Called after a free, when \a alloc_size bytes remain allocated */
+  void NotifyFree(size_t alloc_size) {
+    if (!HasWaiters()) {
+      return;
+    }
+    size_t head_alloc_size = head_alloc_size_.load();
+    size_t head_size = head_size_.load();
+    if (head_alloc_size > alloc_size &&
+        head_alloc_size - alloc_size >= head_size) {
+      // Wake the head once per retry
+      head_size_.store(std::numeric_limits<size_t>::max());
+      free_seq_.fetch_add(1);
+      FutexWake(&free_seq_);
+    }
+  }
+
+  /** The served \a ticket leaves the queue */
+  void Dequeue(u32 ticket) {
+    slots_[ticket % kNumSlots].store(kSlotFree);
+    waiters_.fetch_sub(1);
+    Advance(ticket);
+  }
+
+  /** Leave the queue before \a ticket was served */
+  void Cancel(u32 ticket) {
+    std::atomic<u32> &slot = slots_[ticket % kNumSlots];
+    slot.store(kSlotCancelled);
+    waiters_.fetch_sub(1);
+    if (serving_.load() == ticket) {
+      // Advance raced with us and did not see the cancellation
+      u32 expected = kSlotCancelled;
+      if (slot.compare_exchange_strong(expected, kSlotFree)) {
+        Advance(ticket);
+      }
+    }
+  }
+
+ private:
+  /**
+   * Skip the served \a ticket if its process exited without leaving the
+   * queue. Otherwise the tickets behind it would never be served.
+   * */
+  void Reap(u32 ticket) {
+    pid_t pid = owners_[ticket % kNumSlots].load();
+    if (pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH) {
+      return;
+    }
+    std::atomic<u32> &slot = slots_[ticket % kNumSlots];
+    u32 expected = kSlotWaiting;
+    if (serving_.load() == ticket &&
+        slot.compare_exchange_strong(expected, kSlotFree)) {
+      HILOG(kInfo, "Skipping allocation ticket {} of exited process {}",
+            ticket, pid);
+      waiters_.fetch_sub(1);
+      Advance(ticket);
+    }
+  }
+
+  /** Serve the next ticket after \a ticket, skipping cancelled ones */
+  void Advance(u32 ticket) {
+    u32 next = ticket + 1;
+    while (true) {
+      serving_.store(next);
+      std::atomic<u32> &slot = slots_[next % kNumSlots];
+      u32 expected = kSlotCancelled;
+      if (!slot.compare_exchange_strong(expected, kSlotFree)) {
+        break;
+      }
+      next += 1;
+    }
+    FutexWake(&serving_);
+  }
+};
+
+/**
+ * Orders the threads of one process waiting on an allocator.
+ *
+ * Only the thread at the front enters the shared AllocWaitQueue, so a
+ * process with many threads occupies one ticket at a time and cannot
+ * starve other processes.
+ * */
+class LocalAllocQueue {
+ public:
+  std::mutex lock_;              /**< Protects queue_ */
+  std::condition_variable cv_;   /**< Signaled when the front changes */
+  std::list<u64> queue_;         /**< Ids of the waiting threads */
+  u64 next_id_ = 0;              /**< The next id to hand out */
+
+ public:
+  /**
+   * Wait to become the front of the queue. Returns false if that takes
+   * longer than \a timeout_us since \a start.
+   * */
+  bool Enter(hshm::Timepoint &start, size_t timeout_us, u64 &id) {
+    std::unique_lock<std::mutex> lock(lock_);
+    id = next_id_++;
+    queue_.emplace_back(id);
+    while (queue_.front() != id) {
+      size_t elapsed = start.GetUsecFromStart();
+      if (elapsed >= timeout_us) {
+        queue_.remove(id);
+        return false;
+      }
+      cv_.wait_for(lock, std::chrono::microseconds(
+          std::min(timeout_us - elapsed, AllocWaitQueue::kMaxSleepUs)));
+    }
+    return true;
+  }
+
+  /** The front of the queue leaves */
+  void Leave() {
+    std::unique_lock<std::mutex> lock(lock_);
+    queue_.pop_front();
+    cv_.notify_all();
+  }
+};
+
+}  // namespace hrun
+
+#endif  // HRUN_INCLUDE_HRUN_API_ALLOC_WAIT_QUEUE_H_
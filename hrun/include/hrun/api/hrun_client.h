@@ -15,7 +15,9 @@
 
 #include <string>
 #include "manager.h"
+#include "task_cache.h"
 #include "hrun/queue_manager/queue_manager_client.h"
+#include "hrun/queue_manager/task_batch.h"
 
 // Singleton macros
 #define HRUN_CLIENT hshm::Singleton<hrun::Client>::GetInstance()
@@ -29,6 +31,9 @@ class Client : public ConfigurationManager {
   QueueManagerClient queue_manager_;
   std::atomic<u64> *unique_;
   u32 node_id_;
+  LocalAllocQueue data_localq_;  /**< Threads waiting on data_alloc_ */
+  /** Timeout meaning an allocation waits until it succeeds */
+  static const size_t kWaitForever = std::numeric_limits<size_t>::max();
 
  public:
   /** Default constructor */
@@ -105,23 +110,26 @@ class Client : public ConfigurationManager {
   template<typename TaskT, typename ...Args>
   HSHM_ALWAYS_INLINE
   TaskT* NewEmptyTask(hipc::Pointer &p) {
-    TaskT *task = main_alloc_->NewObj<TaskT>(p, main_alloc_);
-    if (task == nullptr) {
+    LPointer<TaskT> task = AllocateTaskMemory<TaskT>();
+    if (task.shm_.IsNull()) {
       // throw std::runtime_error("Could not allocate buffer");
       HELOG(kFatal, "Could not allocate buffer (1)");
     }
-    return task;
+    ConstructTask<TaskT>(task.ptr_);
+    p = task.shm_;
+    return task.ptr_;
   }
 
   /** Create a default-constructed task */
   template<typename TaskT, typename ...Args>
   HSHM_ALWAYS_INLINE
   LPointer<TaskT> NewEmptyTask() {
-    LPointer<TaskT> task = main_alloc_->NewObjLocal<TaskT>(main_alloc_);
+    LPointer<TaskT> task = AllocateTaskMemory<TaskT>();
     if (task.shm_.IsNull()) {
       // throw std::runtime_error("Could not allocate buffer");
       HELOG(kFatal, "Could not allocate buffer (2)");
     }
+    ConstructTask<TaskT>(task.ptr_);
     return task;
   }
 
@@ -129,7 +137,7 @@ class Client : public ConfigurationManager {
   template<typename TaskT, typename ...Args>
   HSHM_ALWAYS_INLINE
   hipc::LPointer<TaskT> AllocateTask() {
-    hipc::LPointer<TaskT> task = main_alloc_->AllocateLocalPtr<TaskT>(sizeof(TaskT));
+    hipc::LPointer<TaskT> task = AllocateTaskMemory<TaskT>();
     if (task.shm_.IsNull()) {
       // throw std::runtime_error("Could not allocate buffer");
       HELOG(kFatal, "Could not allocate buffer (3)");
@@ -149,12 +157,12 @@ class Client : public ConfigurationManager {
   template<typename TaskT, typename ...Args>
   HSHM_ALWAYS_INLINE
   LPointer<TaskT> NewTask(const TaskNode &task_node, Args&& ...args) {
-    LPointer<TaskT> ptr = main_alloc_->NewObjLocal<TaskT>(
-        main_alloc_, task_node, std::forward<Args>(args)...);
+    LPointer<TaskT> ptr = AllocateTaskMemory<TaskT>();
     if (ptr.shm_.IsNull()) {
       // throw std::runtime_error("Could not allocate buffer");
       HELOG(kFatal, "Could not allocate buffer (4)");
     }
+    ConstructTask<TaskT>(ptr.ptr_, task_node, std::forward<Args>(args)...);
     return ptr;
   }
 
@@ -163,12 +171,12 @@ class Client : public ConfigurationManager {
   HSHM_ALWAYS_INLINE
   LPointer<TaskT> NewTaskRoot(Args&& ...args) {
     TaskNode task_node = MakeTaskNodeId();
-    LPointer<TaskT> ptr = main_alloc_->NewObjLocal<TaskT>(
-        main_alloc_, task_node, std::forward<Args>(args)...);
+    LPointer<TaskT> ptr = AllocateTaskMemory<TaskT>();
     if (ptr.shm_.IsNull()) {
       // throw std::runtime_error("Could not allocate buffer");
       HELOG(kFatal, "Could not allocate buffer (5)");
     }
+    ConstructTask<TaskT>(ptr.ptr_, task_node, std::forward<Args>(args)...);
     return ptr;
   }
 
@@ -184,7 +192,9 @@ class Client : public ConfigurationManager {
             task->delcnt_.load(), task->task_node_, task->task_state_, task->method_)
     }
 #endif
-    main_alloc_->DelObj<TaskT>(task);
+    task->~TaskT();
+    FreeTaskMemory<TaskT>(
+        task, main_alloc_->template Convert<TaskT, hipc::Pointer>(task));
   }
 
   /** Destroy a task */
@@ -198,7 +208,8 @@ class Client : public ConfigurationManager {
             task->delcnt_.load(), task->task_node_, task->task_state_, task->method_)
     }
 #endif
-    main_alloc_->DelObjLocal<TaskT>(task);
+    task->~TaskT();
+    FreeTaskMemory<TaskT>(task.ptr_, task.shm_);
   }
 
   /** Destroy a task */
@@ -215,6 +226,60 @@ class Client : public ConfigurationManager {
     exec->Del(task->method_, task);
   }
 
+  /** The task cache of the calling thread */
+  HSHM_ALWAYS_INLINE
+  static TaskCache& GetTaskCache() {
+    static thread_local TaskCache cache;
+    return cache;
+  }
+
+  /** Allocate uninitialized memory for a task */
+  template<typename TaskT>
+  HSHM_ALWAYS_INLINE
+  LPointer<TaskT> AllocateTaskMemory() {
+    LPointer<char> p;
+    if (TaskCache::IsCached(sizeof(TaskT))) {
+      p = GetTaskCache().Allocate(main_alloc_, sizeof(TaskT));
+    } else {
+      try {
+        p = main_alloc_->AllocateLocalPtr<char>(sizeof(TaskT));
+      } catch (hshm::Error &e) {
+        p.shm_.SetNull();
+      }
+    }
+    LPointer<TaskT> task;
+    task.ptr_ = reinterpret_cast<TaskT*>(p.ptr_);
+    task.shm_ = p.shm_;
+    return task;
+  }
+
+  /** Free the memory of a destroyed task */
+  template<typename TaskT>
+  HSHM_ALWAYS_INLINE
+  void FreeTaskMemory(TaskT *task, const hipc::Pointer &shm) {
+    LPointer<char> p;
+    p.ptr_ = reinterpret_cast<char*>(task);
+    p.shm_ = shm;
+    if (TaskCache::IsCached(sizeof(TaskT))) {
+      GetTaskCache().Free(main_alloc_, sizeof(TaskT), p);
+    } else {
+      main_alloc_->FreeLocalPtr(p);
+    }
+  }
+
+  /** Return the task cache of the calling thread to main_alloc_ */
+  void FlushTaskCache() {
+    GetTaskCache().Flush();
+  }
+
+  /** Wake clients waiting on \a alloc after a free */
+  HSHM_ALWAYS_INLINE
+  void NotifyFree(Allocator *alloc) {
+    if (alloc == data_alloc_) {
+      header_->data_waitq_.NotifyFree(alloc->GetCurrentlyAllocatedSize());
+    }
+  }
+
   /** Convert pointer to char* */
   template<typename T = char>
   HSHM_ALWAYS_INLINE
@@ -240,10 +305,65 @@ class Client : public ConfigurationManager {
     yield_task->Yield<THREAD_MODEL>();
   }
 
-  /** Allocate a buffer */
+  /**
+   * Allocate a buffer in the client data segment. Sleeps in FIFO order
+   * behind other waiters while the segment is exhausted.
+   * */
   HSHM_ALWAYS_INLINE
   LPointer<char> AllocateBufferClient(size_t size) {
-    return AllocateBufferSafe<TASK_YIELD_STD>(data_alloc_, size);
+    return AllocateBufferClient(size, kWaitForever);
+  }
+
+  /**
+   * Allocate a buffer in the client data segment, waiting at most
+   * \a timeout_us. The returned pointer is null on timeout, e.g., so
+   * that the caller can fall back to direct I/O.
+   * */
+  LPointer<char> AllocateBufferClient(size_t size, size_t timeout_us) {
+    LPointer<char> p = TryAllocateBuffer(data_alloc_, size);
+    if (!p.shm_.IsNull() || timeout_us == 0) {
+      return p;
+    }
+    AllocWaitQueue &waitq = header_->data_waitq_;
+    hshm::Timepoint start;
+    start.Now();
+    // Queue behind the other threads of this process
+    u64 local_id;
+    if (!data_localq_.Enter(start, timeout_us, local_id)) {
+      return p;
+    }
+    // Queue behind the other processes
+    u32 ticket = waitq.Enqueue();
+    if (waitq.WaitTurn(ticket, start, timeout_us)) {
+      while (true) {
+        u32 free_seq = waitq.free_seq_.load();
+        waitq.SetHead(size, data_alloc_->GetCurrentlyAllocatedSize());
+        // The served ticket is itself a waiter, so it bypasses the gate
+        p = RawAllocateBuffer(data_alloc_, size);
+        if (!p.shm_.IsNull()) {
+          break;
+        }
+        size_t elapsed = start.GetUsecFromStart();
+        if (elapsed >= timeout_us) {
+          break;
+        }
+        HILOG(kDebug, "Waiting to allocate buffer of size {}", size);
+        waitq.WaitFree(free_seq, timeout_us - elapsed);
+      }
+      waitq.Dequeue(ticket);
+    }
+    data_localq_.Leave();
+    return p;
+  }
+
+  /**
+   * Allocate a buffer in the client data segment without waiting.
+   * The returned pointer is null if the segment is exhausted or
+   * other clients are already waiting for memory.
+   * */
+  HSHM_ALWAYS_INLINE
+  LPointer<char> TryAllocateBufferClient(size_t size) {
+    return AllocateBufferClient(size, 0);
   }
 
   /** Allocate a buffer */
@@ -262,6 +382,32 @@ class Client : public ConfigurationManager {
   }
 
  private:
+  /**
+   * Allocate a buffer unless the allocator is exhausted or others are
+   * waiting on it, in which case the pointer is null
+   * */
+  HSHM_ALWAYS_INLINE
+  LPointer<char> TryAllocateBuffer(Allocator *alloc, size_t size) {
+    if (alloc == data_alloc_ && header_->data_waitq_.HasWaiters()) {
+      LPointer<char> p;
+      p.shm_.SetNull();
+      return p;
+    }
+    return RawAllocateBuffer(alloc, size);
+  }
+
+  /** Allocate a buffer, or return null if the allocator is exhausted */
+  HSHM_ALWAYS_INLINE
+  LPointer<char> RawAllocateBuffer(Allocator *alloc, size_t size) {
+    LPointer<char> p;
+    try {
+      p = alloc->AllocateLocalPtr<char>(size);
+    } catch (hshm::Error &e) {
+      p.shm_.SetNull();
+    }
+    return p;
+  }
+
   /** Allocate a buffer */
   template<int THREAD_MODEL>
   HSHM_ALWAYS_INLINE
@@ -319,6 +465,7 @@ class Client : public ConfigurationManager {
   void FreeBuffer(hipc::Pointer &p) {
     auto alloc = HERMES_MEMORY_MANAGER->GetAllocator(p.allocator_id_);
     alloc->Free(p);
+    NotifyFree(alloc);
     HILOG(kDebug, "Heap size for {}/{}: {}",
           alloc->GetId().bits_.major_,
           alloc->GetId().bits_.minor_,
@@ -330,6 +477,7 @@ class Client : public ConfigurationManager {
   void FreeBuffer(LPointer<char> &p) {
     auto alloc = HERMES_MEMORY_MANAGER->GetAllocator(p.shm_.allocator_id_);
     alloc->FreeLocalPtr(p);
+    NotifyFree(alloc);
     HILOG(kDebug, "Heap size for {}/{}: {}",
           alloc->GetId().bits_.major_,
           alloc->GetId().bits_.minor_,
@@ -374,6 +522,22 @@ class Client : public ConfigurationManager {
   }
 };
 
+/**
+ * Task caches and the depot may outlive the client, whose allocators are
+ * gone once it terminates
+ * */
+inline TaskCache::~TaskCache() {
+  if (HRUN_CLIENT->IsInitialized() && !HRUN_CLIENT->IsTerminated()) {
+    Flush();
+  }
+}
+
+inline TaskCache::Depot::~Depot() {
+  if (HRUN_CLIENT->IsInitialized() && !HRUN_CLIENT->IsTerminated()) {
+    Flush();
+  }
+}
+
 /** A function which creates a new TaskNode value */
 #define HRUN_TASK_NODE_ROOT(CUSTOM)\
   template<typename ...Args>\
@@ -448,6 +612,18 @@ class Client : public ConfigurationManager {
                                                      DomainId::GetLocal(),\
                                                      task);\
       return push_task;\
+  }\
+  template<typename ...Args>\
+  hipc::LPointer<hrunpq::TypedPushTask<CUSTOM##Task>> Async##CUSTOM##RootBatch(hrun::TaskBatch &batch,\
+                                                                          Args&& ...args) {\
+    TaskNode task_node = HRUN_CLIENT->MakeTaskNodeId();\
+    hipc::LPointer<CUSTOM##Task> task = Async##CUSTOM##Alloc(task_node + 1, std::forward<Args>(args)...);\
+    hipc::LPointer<hrunpq::TypedPushTask<CUSTOM##Task>> push_task =\
+      HRUN_PROCESS_QUEUE->AsyncPush<CUSTOM##Task>(batch,\
+                                                     task_node,\
+                                                     DomainId::GetLocal(),\
+                                                     task);\
+      return push_task;\
   }
 
 /** Call duplicate if applicable */
@@ -18,6 +18,7 @@
 #include "hrun/config/config_client.h"
 #include "hrun/config/config_server.h"
 #include "hrun/queue_manager/queue_manager.h"
+#include "hrun/api/alloc_wait_queue.h"
 
 namespace hrun {
 
@@ -27,6 +28,7 @@ struct HrunShm {
   QueueManagerShm queue_manager_;
   std::atomic<u64> unique_;
   u64 num_nodes_;
+  AllocWaitQueue data_waitq_;  /**< Clients waiting on data_alloc_ */
 };
 
 /** The configuration used inherited by runtime + client */
@@ -0,0 +1,257 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HRUN_INCLUDE_HRUN_API_TASK_CACHE_H_
+#define HRUN_INCLUDE_HRUN_API_TASK_CACHE_H_
+
+#include <algorithm>
+#include <vector>
+#include "hrun/hrun_types.h"
+
+namespace hrun {
+
+/**
+ * A per-thread cache of free task objects.
+ *
+ * Every task used to be allocated and freed through main_alloc_, whose
+ * atomics dominate at high task rates. Freed tasks are instead kept on
+ * per-thread free lists segregated by size class. A list refills with a
+ * whole batch when empty and gives up a batch when full. Batches are
+ * exchanged with a per-process Depot under one lock, so tasks freed by
+ * one thread are reused by others, and main_alloc_ is only touched when
+ * the depot is empty or full. The cache is flushed back to main_alloc_
+ * when the thread exits.
+ *
+ * Every cached object is at least as large as its size class, so a
+ * task freed through a base type simply lands in a smaller class.
+ * */
+class TaskCache {
+ public:
+  static const size_t kClassSize = 64;       /**< Size class granularity */
+  static const size_t kMaxCachedSize = 4096;  /**< Larger tasks bypass */
+  static const size_t kNumClasses = kMaxCachedSize / kClassSize;
+  static const size_t kClassBytes = 64 * 1024;  /**< Max bytes per class */
+  static const size_t kMinDepth = 8;     /**< Min objects per class */
+  static const size_t kMaxDepth = 256;   /**< Max objects per class */
+  static const size_t kBatchSize = 16;   /**< Objects per refill */
+  typedef std::vector<LPointer<char>> BATCH_T;
+
+  /** Batches of free objects shared by the threads of a process */
+  class Depot {
+   public:
+    static const size_t kMaxBatches = 64;  /**< Max batches per class */
+    Mutex lock_;               /**< Protects the depot */
+    Allocator *alloc_;         /**< The allocator of every batch */
+    std::vector<BATCH_T> batches_[kNumClasses];  /**< Batches per class */
+
+   public:
+    /** Default constructor */
+    Depot() : alloc_(nullptr) {}
+
+    /** Return all batches on process exit */
+    ~Depot();
+
+    /** Move a batch of \a cls into the empty \a list */
+    bool Pop(Allocator *alloc, size_t cls, BATCH_T &list) {
+      hshm::ScopedMutex lock(lock_, 0);
+      std::vector<BATCH_T> &batches = batches_[cls];
+      if (alloc != alloc_ || batches.empty()) {
+        return false;
+      }
+      list.swap(batches.back());
+      batches.pop_back();
+      return true;
+    }
+
+    /** Keep \a batch of \a cls, unless the depot is full */
+    bool Push(Allocator *alloc, size_t cls, BATCH_T &batch) {
+      hshm::ScopedMutex lock(lock_, 0);
+      if (alloc != alloc_) {
+        if (!IsEmpty()) {
+          return false;
+        }
+        alloc_ = alloc;
+      }
+      std::vector<BATCH_T> &batches = batches_[cls];
+      if (batches.size() >= kMaxBatches) {
+        return false;
+      }
+      batches.emplace_back(std::move(batch));
+      return true;
+    }
+
+    /** Return all batches to the allocator */
+    void Flush() {
+      hshm::ScopedMutex lock(lock_, 0);
+      for (std::vector<BATCH_T> &batches : batches_) {
+        for (BATCH_T &batch : batches) {
+          for (LPointer<char> &p : batch) {
+            alloc_->FreeLocalPtr(p);
+          }
+        }
+        batches.clear();
+      }
+    }
+
+   private:
+    /** Whether the depot holds no batches */
+    bool IsEmpty() {
+      for (std::vector<BATCH_T> &batches : batches_) {
+        if (!batches.empty()) {
+          return false;
+        }
+      }
+      return true;
+    }
+  };
+
+ public:
+  Allocator *alloc_;  /**< The allocator objects are returned to */
+  BATCH_T free_[kNumClasses];  /**< Free lists */
+
+ public:
+  /** Default constructor */
+  TaskCache() : alloc_(nullptr) {}
+
+  /** Return all cached objects on thread exit */
+  ~TaskCache();
+
+  /** The depot of the calling process */
+  static Depot& GetDepot() {
+    static Depot depot;
+    return depot;
+  }
+
+  /** Whether tasks of \a size are cached */
+  HSHM_ALWAYS_INLINE
+  static bool IsCached(size_t size) {
+    return size <= kMaxCachedSize;
+  }
+
+  /** The size class of a task of \a size */
+  HSHM_ALWAYS_INLINE
+  static size_t GetClass(size_t size) {
+    return size ? (size - 1) / kClassSize : 0;
+  }
+
+  /** The number of bytes allocated for objects in \a cls */
+  HSHM_ALWAYS_INLINE
+  static size_t GetClassSize(size_t cls) {
+    return (cls + 1) * kClassSize;
+  }
+
+  /** The max number of objects cached in \a cls */
+  HSHM_ALWAYS_INLINE
+  static size_t GetDepth(size_t cls) {
+    size_t depth = kClassBytes / GetClassSize(cls);
+    return std::min(std::max(depth, kMinDepth), kMaxDepth);
+  }
+
+  /** The number of objects in a batch of \a cls */
+  HSHM_ALWAYS_INLINE
+  static size_t GetBatchSize(size_t cls) {
+    return std::min(kBatchSize, GetDepth(cls) / 2);
+  }
+
+  /** Get an object of at least \a size bytes, or null on failure */
+  HSHM_ALWAYS_INLINE
+  LPointer<char> Allocate(Allocator *alloc, size_t size) {
+    size_t cls = GetClass(size);
+    if (alloc != alloc_) {
+      Flush();
+      alloc_ = alloc;
+    }
+    BATCH_T &list = free_[cls];
+    if (list.empty()) {
+      Refill(cls);
+    }
+    if (list.empty()) {
+      LPointer<char> p;
+      p.ptr_ = nullptr;
+      p.shm_.SetNull();
+      return p;
+    }
+    LPointer<char> p = list.back();
+    list.pop_back();
+    return p;
+  }
+
+  /** Cache an object of at least \a size bytes */
+  HSHM_ALWAYS_INLINE
+  void Free(Allocator *alloc, size_t size, const LPointer<char> &p) {
+    size_t cls = GetClass(size);
+    if (alloc != alloc_) {
+      Flush();
+      alloc_ = alloc;
+    }
+    BATCH_T &list = free_[cls];
+    if (list.size() >= GetDepth(cls)) {
+      Drain(cls);
+    }
+    list.emplace_back(p);
+  }
+
+  /** Return all cached objects to the allocator */
+  void Flush() {
+    for (BATCH_T &list : free_) {
+      for (LPointer<char> &p : list) {
+        alloc_->FreeLocalPtr(p);
+      }
+      list.clear();
+    }
+  }
+
+ private:
+  /** Take a batch of \a cls from the depot, or allocate one */
+  void Refill(size_t cls) {
+    BATCH_T &list = free_[cls];
+    if (GetDepot().Pop(alloc_, cls, list)) {
+      return;
+    }
+    size_t size = GetClassSize(cls);
+    size_t count = GetBatchSize(cls);
+    list.reserve(GetDepth(cls));
+    for (size_t i = 0; i < count; ++i) {
+      LPointer<char> p;
+      try {
+        p = alloc_->AllocateLocalPtr<char>(size);
+      } catch (hshm::Error &e) {
+        p.shm_.SetNull();
+      }
+      if (p.shm_.IsNull()) {
+        break;
+      }
+      list.emplace_back(p);
+    }
+  }
+
+  /**
+   * Give the oldest batch of \a cls to the depot. If the depot is full,
+   * the batch is returned to the allocator.
+   * */
+  void Drain(size_t cls) {
+    BATCH_T &list = free_[cls];
+    size_t count = std::min(GetBatchSize(cls), list.size());
+    BATCH_T batch(list.begin(), list.begin() + count);
+    list.erase(list.begin(), list.begin() + count);
+    if (GetDepot().Push(alloc_, cls, batch)) {
+      return;
+    }
+    for (LPointer<char> &p : batch) {
+      alloc_->FreeLocalPtr(p);
+    }
+  }
+};
+
+}  // namespace hrun
+
+#endif  // HRUN_INCLUDE_HRUN_API_TASK_CACHE_H_
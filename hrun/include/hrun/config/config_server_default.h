@@ -65,6 +65,7 @@ const inline char* kHrunServerDefaultConfigStr =
 "  \'hermes_data_op\',\n"
 "  \'data_stager\',\n"
 "  \'posix_bdev\',\n"
-"  \'ram_bdev\'\n"
+"  \'ram_bdev\',\n"
+"  \'mmap_bdev\'\n"
 "]\n";
 #endif  // HRUN_SRC_CONFIG_HRUN_SERVER_DEFAULT_H_
\ No newline at end of file
@@ -22,6 +22,7 @@ using hrun::BinaryInputArchive;
 using hrun::Task;
 using hrun::TaskPointer;
 using hrun::MultiQueue;
+using hrun::TaskBatch;
 using hrun::PriorityInfo;
 using hrun::TaskNode;
 using hrun::DomainId;
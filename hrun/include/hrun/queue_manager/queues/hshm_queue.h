@@ -28,10 +28,14 @@ typedef hrun::mpsc_queue<LaneData> Lane;
 
 /** Prioritization of different lanes in the queue */
 struct LaneGroup : public PriorityInfo {
+  static const u32 kMaxDepthScale = 16;  /**< Max growth of lane depth */
+  static const u32 kRetiredDepth = 16;   /**< Depth of lanes not in use */
+
   u32 prio_;            /**< The priority of the lane group */
   u32 num_scheduled_;   /**< The number of lanes currently scheduled on workers */
   hipc::ShmArchive<hipc::vector<Lane>> lanes_;  /**< The lanes of the queue */
   u32 tether_;       /**< Lanes should be pinned to the same workers as the tether's prio group */
+  u32 max_depth_;    /**< The depth lanes may grow to under load */
 
   /** Default constructor */
   HSHM_ALWAYS_INLINE
@@ -47,6 +51,7 @@ struct LaneGroup : public PriorityInfo {
     depth_ = priority.depth_;
     flags_ = priority.flags_;
     tether_ = priority.tether_;
+    max_depth_ = priority.depth_ * kMaxDepthScale;
   }
 
   /** Copy constructor. Should never actually be called. */
@@ -59,6 +64,7 @@ struct LaneGroup : public PriorityInfo {
     depth_ = priority.depth_;
     flags_ = priority.flags_;
     tether_ = priority.tether_;
+    max_depth_ = priority.max_depth_;
   }
 
   /** Move constructor. Should never actually be called. */
@@ -71,6 +77,7 @@ struct LaneGroup : public PriorityInfo {
     depth_ = priority.depth_;
     flags_ = priority.flags_;
     tether_ = priority.tether_;
+    max_depth_ = priority.max_depth_;
   }
 
   /** Check if this group is tethered */
@@ -95,6 +102,30 @@ struct LaneGroup : public PriorityInfo {
   Lane& GetLane(u32 lane_id) {
     return (*lanes_)[lane_id];
   }
+
+  /** Get the lane a lane hash maps to */
+  HSHM_ALWAYS_INLINE
+  u32 GetLaneId(u32 lane_hash) {
+    return lane_hash % num_lanes_;
+  }
+
+  /** Emplace \a count entries into the lane \a lane_id */
+  HSHM_ALWAYS_INLINE
+  bool EmplaceN(u32 lane_id, const LaneData *data, size_t count) {
+    return !GetLane(lane_id).emplace_n(data, count).IsNull();
+  }
+
+  /** Pop up to \a count entries from the lane \a lane_id */
+  HSHM_ALWAYS_INLINE
+  size_t PopN(u32 lane_id, LaneData *data, size_t count) {
+    return GetLane(lane_id).pop_n(data, count);
+  }
+
+  /** Check if a lane was removed by a resize and is only being drained */
+  HSHM_ALWAYS_INLINE
+  bool IsRetired(u32 lane_id) {
+    return lane_id >= num_lanes_;
+  }
 };
 
 /** Represents the HSHM queue type */
@@ -102,6 +133,14 @@ class Hshm {};
 
 /**
  * The shared-memory representation of a Queue
+ *
+ * The number of lanes in a group and the depth of each lane can change
+ * online. Lanes are reserved up to max_lanes_ and are never destroyed,
+ * so the lane references held by workers and producers stay valid.
+ * Removing lanes retires them: new tasks hash to the remaining lanes,
+ * the worker of a retired lane migrates its unstarted tasks, and its
+ * ring shrinks to kRetiredDepth once drained. Lane depth is changed by
+ * the worker polling the lane (see mpsc_queue::Resize).
  * */
 template<>
 struct MultiQueueT<Hshm> : public hipc::ShmContainer {
@@ -109,6 +148,7 @@ struct MultiQueueT<Hshm> : public hipc::ShmContainer {
   QueueId id_;          /**< Globally unique ID of this queue */
   hipc::ShmArchive<hipc::vector<LaneGroup>> groups_;  /**< Divide the lanes into groups */
   bitfield32_t flags_;  /**< Flags for the queue */
+  hshm::Mutex resize_lock_;  /**< Serializes changes to the lane count */
 
  public:
   /**====================================
@@ -253,6 +293,47 @@ struct MultiQueueT<Hshm> : public hipc::ShmContainer {
     return EmplaceFrac(prio, lane_hash, LaneData(p, complete));
   }
 
+  /**
+   * Emplace \a count SHM pointers to tasks into the lane of \a lane_hash.
+   * The lane slots are reserved with a single atomic.
+   * */
+  bool EmplaceN(u32 prio, u32 lane_hash, const LaneData *data, size_t count) {
+    if (IsEmplacePlugged()) {
+      WaitForEmplacePlug();
+    }
+    LaneGroup &lane_group = GetGroup(prio);
+    u32 lane_id = lane_group.GetLaneId(lane_hash);
+    Lane &lane = GetLane(lane_group, lane_id);
+    hshm::qtok_t ret = lane.emplace_n(data, count);
+    return !ret.IsNull();
+  }
+
+  /**
+   * Emplace \a count SHM pointers to tasks into the lane \a lane_id,
+   * which the caller resolved with LaneGroup::GetLaneId.
+   * */
+  bool EmplaceLaneN(u32 prio, u32 lane_id,
+                    const LaneData *data, size_t count) {
+    if (IsEmplacePlugged()) {
+      WaitForEmplacePlug();
+    }
+    Lane &lane = GetLane(prio, lane_id);
+    hshm::qtok_t ret = lane.emplace_n(data, count);
+    return !ret.IsNull();
+  }
+
+  /**
+   * Emplace a SHM pointer to a task only if its lane has space.
+   * Used by workers, which must never wait on a full lane.
+   * */
+  bool TryEmplace(u32 prio, u32 lane_hash, const LaneData &data) {
+    LaneGroup &lane_group = GetGroup(prio);
+    u32 lane_id = lane_hash % lane_group.num_lanes_;
+    Lane &lane = GetLane(lane_group, lane_id);
+    hshm::qtok_t ret = lane.try_emplace(data);
+    return !ret.IsNull();
+  }
+
   /** Emplace a SHM pointer to a task */
   bool Emplace(u32 prio, u32 lane_hash, const LaneData &data) {
     if (IsEmplacePlugged()) {
@@ -283,14 +364,87 @@ struct MultiQueueT<Hshm> : public hipc::ShmContainer {
   }
 
   /**
-   * Change the number of active lanes
-   * This assumes that PlugForResize and UnplugForResize are called externally.
+   * Change the number of active lanes in a group. Groups tethered to
+   * this group follow its lane count. New lanes are picked up by the
+   * work orchestrator's queue scheduler.
    * */
-  void Resize(u32 num_lanes) {
+  void Resize(u32 prio, u32 num_lanes) {
+    hshm::ScopedMutex lock(resize_lock_, 0);
+    LaneGroup &lane_group = GetGroup(prio);
+    num_lanes = std::max<u32>(1, std::min(num_lanes, lane_group.max_lanes_));
+    if (num_lanes == lane_group.num_lanes_) {
+      return;
+    }
+    HILOG(kInfo, "Resizing queue {} (prio {}) from {} to {} lanes",
+          id_, prio, lane_group.num_lanes_, num_lanes);
+    PlugForResize();
+    ResizeLanes(lane_group, num_lanes);
+    for (LaneGroup &tethered : *groups_) {
+      if (tethered.IsTethered() && tethered.tether_ == prio) {
+        ResizeLanes(tethered, std::min(num_lanes, tethered.max_lanes_));
+      }
+    }
+    UnplugForResize();
   }
 
+  /**
+   * Change the depth of the active lanes in a group. Each lane is
+   * resized by its worker once it holds no more than \a depth entries.
+   * */
+  void ResizeDepth(u32 prio, u32 depth) {
+    hshm::ScopedMutex lock(resize_lock_, 0);
+    LaneGroup &lane_group = GetGroup(prio);
+    depth = std::max(depth, LaneGroup::kRetiredDepth);
+    lane_group.depth_ = depth;
+    lane_group.max_depth_ = std::max(lane_group.max_depth_, depth);
+    for (u32 lane_id = 0; lane_id < lane_group.num_lanes_; ++lane_id) {
+      GetLane(lane_group, lane_id).RequestResize(depth);
+    }
+  }
+
+  /**
+   * Grow a lane which has been full for a sustained period. Doubles its
+   * depth up to max_depth_, and then adds a lane to the group. Must be
+   * called by the worker polling the lane.
+   * */
+  void Grow(u32 prio, u32 lane_id) {
+    LaneGroup &lane_group = GetGroup(prio);
+    Lane &lane = GetLane(lane_group, lane_id);
+    size_t depth = lane.GetDepth();
+    if (depth < lane_group.max_depth_) {
+      lane.Resize(std::min<size_t>(depth * 2, lane_group.max_depth_));
+    } else if (!lane_group.IsTethered() &&
+               lane_group.num_lanes_ < lane_group.max_lanes_) {
+      Resize(prio, lane_group.num_lanes_ + 1);
+    }
+  }
+
+ private:
+  /** Add, retire, or restore lanes so \a num_lanes are active */
+  void ResizeLanes(LaneGroup &lane_group, u32 num_lanes) {
+    // Never exceeds the reserved capacity, so existing lanes do not move
+    while (lane_group.lanes_->size() < num_lanes) {
+      lane_group.lanes_->emplace_back(lane_group.depth_, id_);
+      Lane &lane = lane_group.lanes_->back();
+      lane.flags_ = lane_group.flags_;
+    }
+    for (u32 lane_id = 0; lane_id < lane_group.lanes_->size(); ++lane_id) {
+      Lane &lane = GetLane(lane_group, lane_id);
+      bool retired = lane_group.IsRetired(lane_id);
+      if (lane_id < num_lanes && retired) {
+        lane.RequestResize(lane_group.depth_);
+      } else if (lane_id >= num_lanes && !retired) {
+        lane.RequestResize(LaneGroup::kRetiredDepth);
+      }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    lane_group.num_lanes_ = num_lanes;
+  }
+
+ public:
   /** Begin plugging the queue for resize */
   HSHM_ALWAYS_INLINE bool PlugForResize() {
+    flags_.SetBits(QUEUE_RESIZE);
     return true;
   }
 
@@ -312,7 +466,7 @@ struct MultiQueueT<Hshm> : public hipc::ShmContainer {
   /** Wait for emplace plug to complete */
   void WaitForEmplacePlug() {
     // NOTE(llogan): will this infinite loop due to CPU caching?
-    while (flags_.Any(QUEUE_UPDATE)) {
+    while (flags_.Any(QUEUE_RESIZE)) {
       HERMES_THREAD_MODEL->Yield();
     }
   }
@@ -13,6 +13,7 @@
 #ifndef HRUN_INCLUDE_HRUN_DATA_STRUCTURES_IPC_mpsc_queue_H_
 #define HRUN_INCLUDE_HRUN_DATA_STRUCTURES_IPC_mpsc_queue_H_
 
+#include <algorithm>
 #include "hermes_shm/data_structures/ipc/internal/shm_internal.h"
 #include "hermes_shm/thread/lock.h"
 #include "hermes_shm/data_structures/ipc/vector.h"
@@ -47,6 +48,11 @@ using hshm::make_argpack;
 /**
  * A queue optimized for multiple producers (emplace) with a single
  * consumer (pop).
+ *
+ * The depth of the queue can be changed online by the consumer. Producers
+ * register in emplacers_ while writing to the ring, and the consumer
+ * plugs new writers and waits for registered ones to leave before
+ * replacing the ring.
  * */
 template<typename T>
 class mpsc_queue : public ShmContainer {
@@ -58,6 +64,10 @@ class mpsc_queue : public ShmContainer {
   bitfield32_t flags_;
   QueueId id_;
   u32 worker_id_;
+  std::atomic<u32> plug_;          /**< Producers wait while set */
+  std::atomic<u32> emplacers_;     /**< Producers writing to the ring */
+  std::atomic<u32> resize_depth_;  /**< Depth requested of the consumer */
+  u32 busy_polls_;                 /**< Consecutive polls with high occupancy */
 
  public:
   /**====================================
@@ -100,6 +110,8 @@ class mpsc_queue : public ShmContainer {
   void shm_strong_copy_construct_and_op(const mpsc_queue &other) {
     head_ = other.head_.load();
     tail_ = other.tail_.load();
+    flags_ = other.flags_;
+    id_ = other.id_;
     (*queue_) = (*other.queue_);
   }
 
@@ -111,6 +123,7 @@ class mpsc_queue : public ShmContainer {
   mpsc_queue(Allocator *alloc,
              mpsc_queue &&other) noexcept {
     shm_init_container(alloc);
+    SetNull();
     if (GetAllocator() == other.GetAllocator()) {
       head_ = other.head_.load();
       tail_ = other.tail_.load();
@@ -157,6 +170,10 @@ class mpsc_queue : public ShmContainer {
   void SetNull() {
     head_ = 0;
     tail_ = 0;
+    plug_ = 0;
+    emplacers_ = 0;
+    resize_depth_ = 0;
+    busy_polls_ = 0;
   }
 
   /**====================================
@@ -168,20 +185,26 @@ class mpsc_queue : public ShmContainer {
   qtok_t emplace(Args&&... args) {
     // Allocate a slot in the queue
     // The slot is marked NULL, so pop won't do anything if context switch
+    BeginEmplace();
     _qtok_t head = head_.load();
     _qtok_t tail = tail_.fetch_add(1);
     size_t size = tail - head + 1;
-    vector<pair<bitfield32_t, T>> &queue = (*queue_);
 
     // Check if there's space in the queue.
-    if (size > queue.size()) {
+    if (size > (*queue_).size()) {
       HILOG(kDebug, "Queue {}/{} is full, waiting for space",
             id_, queue_->size());
+      // The ring may be replaced by a resize while we wait
+      EndEmplace();
       while (true) {
         head = head_.load();
         size = tail - head + 1;
         if (size <= (*queue_).size()) {
-          break;
+          BeginEmplace();
+          if (size <= (*queue_).size()) {
+            break;
+          }
+          EndEmplace();
         }
         HERMES_THREAD_MODEL->Yield();
       }
@@ -189,17 +212,118 @@ class mpsc_queue : public ShmContainer {
     }
 
     // Emplace into queue at our slot
+    Store(tail, std::forward<Args>(args)...);
+    EndEmplace();
+    return qtok_t(tail);
+  }
+
+  /**
+   * Construct \a count elements in consecutive slots. The slots are
+   * reserved with a single atomic. Returns the token of the first slot.
+   * */
+  qtok_t emplace_n(const T *vals, size_t count) {
+    if (count == 0) {
+      return qtok_t::GetNull();
+    }
+    // Batches larger than the queue are split. The depth is read while
+    // registered, so a resize cannot shrink the ring below the batch.
+    BeginEmplace();
+    size_t depth = (*queue_).size();
+    if (count > depth) {
+      EndEmplace();
+      qtok_t first = emplace_n(vals, depth);
+      emplace_n(vals + depth, count - depth);
+      return first;
+    }
+    _qtok_t head = head_.load();
+    _qtok_t tail = tail_.fetch_add(count);
+    size_t size = tail - head + count;
+
+    // Check if there's space in the queue for the entire batch
+    if (size > (*queue_).size()) {
+      HILOG(kDebug, "Queue {}/{} is full, waiting for space",
+            id_, queue_->size());
+      EndEmplace();
+      while (true) {
+        head = head_.load();
+        size = tail - head + count;
+        if (size <= (*queue_).size()) {
+          BeginEmplace();
+          if (size <= (*queue_).size()) {
+            break;
+          }
+          EndEmplace();
+        }
+        HERMES_THREAD_MODEL->Yield();
+      }
+      HILOG(kDebug, "Queue {}/{} got scheduled", id_, queue_->size());
+    }
+
+    // Emplace into queue at our slots
+    for (size_t i = 0; i < count; ++i) {
+      Store(tail + i, vals[i]);
+    }
+    EndEmplace();
+    return qtok_t(tail);
+  }
+
+  /** Construct an element only if there is space, without waiting */
+  template<typename ...Args>
+  qtok_t try_emplace(Args&&... args) {
+    BeginEmplace();
+    _qtok_t tail = tail_.load();
+    while (true) {
+      _qtok_t head = head_.load();
+      if (tail - head + 1 > (*queue_).size()) {
+        EndEmplace();
+        return qtok_t::GetNull();
+      }
+      if (tail_.compare_exchange_weak(tail, tail + 1)) {
+        break;
+      }
+    }
+    Store(tail, std::forward<Args>(args)...);
+    EndEmplace();
+    return qtok_t(tail);
+  }
+
+ private:
+  /** Register as a producer, waiting while the queue is plugged */
+  HSHM_ALWAYS_INLINE
+  void BeginEmplace() {
+    while (true) {
+      emplacers_.fetch_add(1);
+      if (!plug_.load()) {
+        return;
+      }
+      emplacers_.fetch_sub(1);
+      while (plug_.load()) {
+        HERMES_THREAD_MODEL->Yield();
+      }
+    }
+  }
+
+  /** Unregister as a producer */
+  HSHM_ALWAYS_INLINE
+  void EndEmplace() {
+    emplacers_.fetch_sub(1);
+  }
+
+  /** Construct the element of the reserved slot \a tail */
+  template<typename ...Args>
+  HSHM_ALWAYS_INLINE
+  void Store(_qtok_t tail, Args&&... args) {
+    vector<pair<bitfield32_t, T>> &queue = (*queue_);
     uint32_t idx = tail % queue.size();
     auto iter = queue.begin() + idx;
     queue.replace(iter,
-                      hshm::PiecewiseConstruct(),
-                      make_argpack(),
-                      make_argpack(std::forward<Args>(args)...));
+                  hshm::PiecewiseConstruct(),
+                  make_argpack(),
+                  make_argpack(std::forward<Args>(args)...));
 
     // Let pop know that the data is fully prepared
     pair<bitfield32_t, T> &entry = (*iter);
     entry.GetFirst().SetBits(1);
-    return qtok_t(tail);
   }
 
  public:
@@ -246,6 +370,42 @@ class mpsc_queue : public ShmContainer {
     }
   }
 
+  /**
+   * Consumer pops up to \a count objects from the head. Stops at the
+   * first slot which is not yet written. The head is advanced with a
+   * single atomic. Returns the number of objects popped.
+   * */
+  size_t pop_n(T *vals, size_t count) {
+    _qtok_t head = head_.load();
+    _qtok_t tail = tail_.load();
+    if (head >= tail) {
+      return 0;
+    }
+    count = std::min<size_t>(count, tail - head);
+    vector<pair<bitfield32_t, T>> &queue = (*queue_);
+    size_t depth = queue.size();
+    size_t i;
+    for (i = 0; i < count; ++i) {
+      hipc::pair<bitfield32_t, T> &entry = queue[(head + i) % depth];
+      if (!entry.GetFirst().Any(1)) {
+        break;
+      }
+      if (vals) {
+        vals[i] = std::move(entry.GetSecond());
+      }
+      entry.GetFirst().Clear();
+    }
+    if (i > 0) {
+      head_.fetch_add(i);
+    }
+    return i;
+  }
+
+  /** Consumer pops up to \a count objects, discarding them */
+  size_t pop_n(size_t count) {
+    return pop_n(nullptr, count);
+  }
+
   /** Consumer peeks an object */
   qtok_t peek(T *&val, int off = 0) {
     // Don't pop if there's no entries
@@ -301,6 +461,65 @@ class mpsc_queue : public ShmContainer {
   size_t GetDepth() {
     return (*queue_).size();
   }
+
+  /**====================================
+   * Resize Methods
+   * ===================================*/
+
+  /** Ask the consumer to change the depth of the queue */
+  void RequestResize(size_t depth) {
+    resize_depth_.store(depth);
+  }
+
+  /** Whether the consumer has a pending resize request */
+  HSHM_ALWAYS_INLINE
+  bool IsResizeRequested() {
+    return resize_depth_.load(std::memory_order_relaxed) != 0;
+  }
+
+  /**
+   * Change the depth of the queue. Must be called by the consumer.
+   * Entries keep their positions, including slots reserved by producers
+   * that have not been written yet. Returns false if the queue holds
+   * more entries than \a depth, in which case nothing changes.
+   * */
+  bool Resize(size_t depth) {
+    if (depth == 0 || depth == (*queue_).size()) {
+      return true;
+    }
+    // Plug producers and wait for writers to leave the ring
+    plug_.store(1);
+    while (emplacers_.load()) {
+      HERMES_THREAD_MODEL->Yield();
+    }
+    _qtok_t head = head_.load();
+    _qtok_t tail = tail_.load();
+    if (tail - head > depth) {
+      plug_.store(0);
+      return false;
+    }
+    // Save the entries which were written
+    vector<pair<bitfield32_t, T>> &old_queue = (*queue_);
+    size_t old_depth = old_queue.size();
+    std::vector<std::pair<_qtok_t, T>> entries;
+    entries.reserve(tail - head);
+    for (_qtok_t i = head; i < tail && i < head + old_depth; ++i) {
+      pair<bitfield32_t, T> &entry = old_queue[i % old_depth];
+      if (entry.GetFirst().Any(1)) {
+        entries.emplace_back(i, entry.GetSecond());
+      }
+    }
+    // Replace the ring
+    (*queue_).shm_destroy();
+    HSHM_MAKE_AR(queue_, GetAllocator(), depth);
+    for (std::pair<_qtok_t, T> &entry : entries) {
+      Store(entry.first, std::move(entry.second));
+    }
+    HILOG(kDebug, "Resized queue {} from {} to {} entries",
+          id_, old_depth, depth);
+    plug_.store(0);
+    return true;
+  }
 };
 
 }  // namespace hshm::ipc
@@ -0,0 +1,116 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HRUN_INCLUDE_HRUN_QUEUE_MANAGER_TASK_BATCH_H_
+#define HRUN_INCLUDE_HRUN_QUEUE_MANAGER_TASK_BATCH_H_
+
+#include <algorithm>
+#include <vector>
+#include "queue_factory.h"
+
+namespace hrun {
+
+/**
+ * Collects tasks bound for one queue and submits them together.
+ *
+ * Tasks are grouped by lane, and each lane's tasks are emplaced with
+ * a single EmplaceN. The order of tasks within a lane is preserved.
+ * The batch is submitted once it holds kMaxTasks tasks, on Submit,
+ * and on destruction.
+ * */
+class TaskBatch {
+ public:
+  static const size_t kMaxTasks = 64;  /**< Tasks held before submitting */
+
+ private:
+  /** A task waiting for submission */
+  struct Entry {
+    u32 prio_;
+    u32 lane_hash_;
+    u32 lane_id_;  /**< Resolved on submission */
+    LaneData data_;
+  };
+
+  MultiQueue *queue_;          /**< The queue tasks are submitted to */
+  std::vector<Entry> entries_;  /**< Tasks not yet submitted */
+  std::vector<LaneData> run_;   /**< Tasks of a single lane */
+
+ public:
+  /** Default constructor */
+  TaskBatch() : queue_(nullptr) {
+    entries_.reserve(kMaxTasks);
+    run_.reserve(kMaxTasks);
+  }
+
+  /** Tasks would be submitted twice */
+  TaskBatch(const TaskBatch &other) = delete;
+
+  /** Submit remaining tasks */
+  ~TaskBatch() {
+    Submit();
+  }
+
+  /** Number of tasks waiting for submission */
+  size_t size() const {
+    return entries_.size();
+  }
+
+  /** Add a task to the batch */
+  void Add(MultiQueue *queue, u32 prio, u32 lane_hash, hipc::Pointer &p) {
+    if (queue != queue_) {
+      Submit();
+      queue_ = queue;
+    }
+    entries_.emplace_back(Entry{prio, lane_hash, 0, LaneData(p, false)});
+    if (entries_.size() >= kMaxTasks) {
+      Submit();
+    }
+  }
+
+  /** Emplace all tasks in the batch */
+  void Submit() {
+    if (entries_.empty()) {
+      return;
+    }
+    // Resolve lanes against the current lane count of each group
+    for (Entry &entry : entries_) {
+      LaneGroup &lane_group = queue_->GetGroup(entry.prio_);
+      entry.lane_id_ = lane_group.GetLaneId(entry.lane_hash_);
+    }
+    std::stable_sort(entries_.begin(), entries_.end(),
+                     [](const Entry &a, const Entry &b) {
+      if (a.prio_ != b.prio_) {
+        return a.prio_ < b.prio_;
+      }
+      return a.lane_id_ < b.lane_id_;
+    });
+    size_t i = 0;
+    while (i < entries_.size()) {
+      Entry &first = entries_[i];
+      run_.clear();
+      for (; i < entries_.size(); ++i) {
+        Entry &entry = entries_[i];
+        if (entry.prio_ != first.prio_ || entry.lane_id_ != first.lane_id_) {
+          break;
+        }
+        run_.emplace_back(entry.data_);
+      }
+      queue_->EmplaceLaneN(first.prio_, first.lane_id_,
+                           run_.data(), run_.size());
+    }
+    entries_.clear();
+  }
+};
+
+}  // namespace hrun
+
+#endif  // HRUN_INCLUDE_HRUN_QUEUE_MANAGER_TASK_BATCH_H_
@@ -61,6 +61,12 @@ class TaskLib;
 #define TASK_FLUSH BIT_OPT(u32, 20)
 /** This task is considered a root task */
 #define TASK_IS_ROOT BIT_OPT(u32, 21)
+/** A worker recorded when this task arrived, for QoS delay metrics */
+#define TASK_QOS_ARRIVED BIT_OPT(u32, 22)
+/** This task was charged to its QoS tenant and may start */
+#define TASK_QOS_ADMITTED BIT_OPT(u32, 23)
+/** This task holds its task group while QoS holds it back */
+#define TASK_QOS_GROUPED BIT_OPT(u32, 24)
 /** This task is apart of remote debugging */
 #define TASK_REMOTE_DEBUG_MARK BIT_OPT(u32, 31)
 
@@ -278,6 +284,9 @@ struct Task : public hipc::ShmContainer {
   bitfield32_t task_flags_;    /**< Properties of the task */
   double period_ns_;           /**< The period of the task */
   hshm::Timepoint start_;      /**< The time the task started */
+  u32 qos_tenant_;             /**< The QoS tenant charged, 0 if none */
+  size_t qos_cost_;            /**< Bytes charged to the QoS tenant */
+  hshm::Timepoint qos_arrival_;  /**< When a worker first saw the task */
   RunContext ctx_;
 #ifdef TASK_DEBUG
   std::atomic<int> delcnt_ = 0;    /**< # of times deltask called */
@@ -322,6 +331,12 @@ struct Task : public hipc::ShmContainer {
     return task_flags_.Any(TASK_UNORDERED);
   }
 
+  /** Charge the task to QoS \a tenant for \a cost bytes */
+  HSHM_ALWAYS_INLINE void SetQos(u32 tenant, size_t cost) {
+    qos_tenant_ = tenant;
+    qos_cost_ = cost;
+  }
+
   /** Set task as complete */
   HSHM_ALWAYS_INLINE void SetComplete() {
     task_flags_.SetBits(TASK_MODULE_COMPLETE | TASK_COMPLETE);
@@ -496,6 +511,8 @@ struct Task : public hipc::ShmContainer {
   HSHM_ALWAYS_INLINE explicit
   Task(hipc::Allocator *alloc) {
     shm_init_container(alloc);
+    qos_tenant_ = 0;
+    qos_cost_ = 0;
   }
 
   /** SHM constructor */
@@ -504,6 +521,8 @@ struct Task : public hipc::ShmContainer {
        const TaskNode &task_node) {
     shm_init_container(alloc);
     task_node_ = task_node;
+    qos_tenant_ = 0;
+    qos_cost_ = 0;
   }
 
   /** Emplace constructor */
@@ -523,6 +542,8 @@ struct Task : public hipc::ShmContainer {
     method_ = method;
     domain_id_ = domain_id;
     task_flags_ = task_flags;
+    qos_tenant_ = 0;
+    qos_cost_ = 0;
   }
 
   /**====================================
@@ -569,7 +590,7 @@ struct Task : public hipc::ShmContainer {
   void task_serialize(Ar &ar) {
     // NOTE(llogan): don't serialize start_ because of clock drift
     ar(task_state_, task_node_, domain_id_, lane_hash_, prio_, method_,
-       task_flags_, period_ns_);
+       task_flags_, period_ns_, qos_tenant_, qos_cost_);
   }
 
   template<typename TaskT>
@@ -583,6 +604,8 @@ struct Task : public hipc::ShmContainer {
     task_flags_ = other.task_flags_;
     period_ns_ = other.period_ns_;
     start_ = other.start_;
+    qos_tenant_ = other.qos_tenant_;
+    qos_cost_ = other.qos_cost_;
   }
 
   /**====================================
@@ -0,0 +1,246 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HRUN_INCLUDE_HRUN_WORK_ORCHESTRATOR_QOS_H_
+#define HRUN_INCLUDE_HRUN_WORK_ORCHESTRATOR_QOS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "hrun/hrun_types.h"
+
+namespace hrun {
+
+/** The id of a QoS tenant from a hash. 0 is reserved for untracked tasks. */
+static inline u32 QosTenantId(u32 hash) {
+  return hash ? hash : 1;
+}
+
+/**
+ * The id of the QoS tenant named \a name. Matches the hash of a bucket's
+ * TagId, so buckets are tenants named after themselves.
+ * */
+static inline u32 HashQosTenant(const hshm::charbuf &name) {
+  return QosTenantId((u32)std::hash<hshm::charbuf>{}(name));
+}
+
+/** The share and rate limits of a QoS tenant */
+struct QosPolicy {
+  float weight_;     /**< Share of each scheduling round, relative to others */
+  size_t max_bw_;    /**< Bytes started per second, 0 for unlimited */
+  size_t max_ops_;   /**< Tasks started per second, 0 for unlimited */
+
+  /** Default constructor. Weight 1 and no limits. */
+  QosPolicy() : weight_(1), max_bw_(0), max_ops_(0) {}
+};
+
+/** The queueing statistics of a tenant on one node */
+struct QosTenantStats {
+  u32 node_id_;          /**< The node of the workers */
+  u32 tenant_;           /**< The tenant id */
+  std::string name_;     /**< The configured name, if any */
+  size_t tasks_;         /**< Tasks started */
+  size_t bytes_;         /**< Bytes charged */
+  size_t deferrals_;     /**< Times a task was held back by share or limit */
+  double avg_delay_us_;  /**< Mean time from arrival to start */
+  double max_delay_us_;  /**< Longest time from arrival to start */
+
+  /** Serialize */
+  template<typename Ar>
+  void serialize(Ar &ar) {
+    ar(node_id_, tenant_, name_, tasks_, bytes_, deferrals_,
+       avg_delay_us_, max_delay_us_);
+  }
+};
+
+/** The node-wide state of a tenant, shared by all workers */
+class QosTenant {
+ public:
+  /** Rate limits admit up to this many seconds of burst */
+  static constexpr double kBurstSec = .1;
+
+  u32 id_;                         /**< The tenant id */
+  std::string name_;               /**< The configured name, if any */
+  std::atomic<float> weight_;      /**< QosPolicy::weight_ */
+  std::atomic<size_t> max_bw_;     /**< QosPolicy::max_bw_ */
+  std::atomic<size_t> max_ops_;    /**< QosPolicy::max_ops_ */
+  Mutex lock_;                     /**< Protects the token buckets */
+  double bw_tokens_;               /**< Bytes which may start now */
+  double op_tokens_;               /**< Tasks which may start now */
+  hshm::Timepoint last_refill_;    /**< When tokens were last added */
+  std::atomic<size_t> tasks_;
+  std::atomic<size_t> bytes_;
+  std::atomic<size_t> deferrals_;
+  std::atomic<size_t> delay_ns_;
+  std::atomic<size_t> max_delay_ns_;
+
+ public:
+  /** Emplace constructor */
+  QosTenant(u32 id, const QosPolicy &policy)
+      : id_(id), bw_tokens_(0), op_tokens_(0),
+        tasks_(0), bytes_(0), deferrals_(0), delay_ns_(0), max_delay_ns_(0) {
+    SetPolicy(policy);
+  }
+
+  /** Change the share and limits */
+  void SetPolicy(const QosPolicy &policy) {
+    hshm::ScopedMutex lock(lock_, 0);
+    weight_ = policy.weight_ > 0 ? policy.weight_ : 1;
+    max_bw_ = policy.max_bw_;
+    max_ops_ = policy.max_ops_;
+    bw_tokens_ = policy.max_bw_ * kBurstSec;
+    op_tokens_ = policy.max_ops_ * kBurstSec;
+    last_refill_.Now();
+  }
+
+  /**
+   * Take tokens for a task of \a cost bytes. A task may start while any
+   * tokens remain, so tasks larger than the burst are not starved; the
+   * debt delays the tasks after it.
+   * */
+  bool TryAcquire(size_t cost) {
+    size_t max_bw = max_bw_.load(std::memory_order_relaxed);
+    size_t max_ops = max_ops_.load(std::memory_order_relaxed);
+    if (max_bw == 0 && max_ops == 0) {
+      return true;
+    }
+    hshm::ScopedMutex lock(lock_, 0);
+    double sec = last_refill_.GetNsecFromStart() / 1e9;
+    last_refill_.Now();
+    bw_tokens_ = std::min(bw_tokens_ + max_bw * sec, max_bw * kBurstSec);
+    op_tokens_ = std::min(op_tokens_ + max_ops * sec,
+                          std::max(max_ops * kBurstSec, 1.0));
+    if ((max_bw && bw_tokens_ <= 0) || (max_ops && op_tokens_ < 1)) {
+      return false;
+    }
+    bw_tokens_ -= cost;
+    op_tokens_ -= 1;
+    return true;
+  }
+
+  /** Record a task which started after waiting \a delay_ns */
+  void RecordStart(size_t cost, size_t delay_ns) {
+    tasks_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(cost, std::memory_order_relaxed);
+    delay_ns_.fetch_add(delay_ns, std::memory_order_relaxed);
+    size_t max_delay = max_delay_ns_.load(std::memory_order_relaxed);
+    while (delay_ns > max_delay &&
+           !max_delay_ns_.compare_exchange_weak(max_delay, delay_ns)) {}
+  }
+
+  /** Get the statistics of this tenant */
+  QosTenantStats GetStats() const {
+    QosTenantStats stats;
+    stats.node_id_ = 0;
+    stats.tenant_ = id_;
+    stats.name_ = name_;
+    stats.tasks_ = tasks_.load();
+    stats.bytes_ = bytes_.load();
+    stats.deferrals_ = deferrals_.load();
+    stats.avg_delay_us_ = stats.tasks_ ?
+        delay_ns_.load() / 1000.0 / stats.tasks_ : 0;
+    stats.max_delay_us_ = max_delay_ns_.load() / 1000.0;
+    return stats;
+  }
+};
+
+/**
+ * Weighted shares and rate limits between tenants of the runtime.
+ *
+ * A tenant is a set of tasks labeled with the same Task::qos_tenant_,
+ * e.g., the I/O of one bucket or one job. Workers schedule the unstarted
+ * tasks of tenants with deficit round robin: each poll of a worker's
+ * lanes is a round, and in each round a backlogged tenant may start
+ * quantum_ * weight bytes of tasks. Unused credit is dropped once a tenant
+ * has nothing waiting. A tenant's tasks are started in order within a
+ * lane. Tasks with tenant 0 are never held back.
+ *
+ * Policies are node-wide and the round robin state is per worker.
+ * */
+class QosManager {
+ public:
+  /** Every task is charged this many bytes on top of its data */
+  static const size_t kOpCost = 4096;
+
+  std::atomic<bool> enabled_;     /**< Whether workers apply QoS */
+  std::atomic<size_t> quantum_;   /**< Bytes per round at weight 1 */
+  QosPolicy default_policy_;      /**< Policy of tenants not configured */
+  Mutex lock_;                    /**< Protects tenants_ */
+  std::unordered_map<u32, std::unique_ptr<QosTenant>> tenants_;
+
+ public:
+  /** Default constructor. Disabled. */
+  QosManager() : enabled_(false), quantum_(MEGABYTES(1)) {}
+
+  /** Begin scheduling tenants, starting \a quantum bytes per round */
+  void Enable(size_t quantum) {
+    quantum_ = quantum ? quantum : MEGABYTES(1);
+    enabled_ = true;
+  }
+
+  /** Whether workers apply QoS */
+  HSHM_ALWAYS_INLINE
+  bool IsEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /** Set the share and limits of tenant \a id */
+  void SetPolicy(u32 id, const std::string &name, const QosPolicy &policy) {
+    QosTenant *tenant = GetTenant(id);
+    hshm::ScopedMutex lock(lock_, 0);
+    tenant->name_ = name;
+    tenant->SetPolicy(policy);
+  }
+
+  /** Get the state of tenant \a id, creating it with the default policy */
+  QosTenant* GetTenant(u32 id) {
+    hshm::ScopedMutex lock(lock_, 0);
+    auto it = tenants_.find(id);
+    if (it == tenants_.end()) {
+      it = tenants_.emplace(
+          id, std::make_unique<QosTenant>(id, default_policy_)).first;
+    }
+    return it->second.get();
+  }
+
+  /** Get the statistics of every tenant seen by this node */
+  std::vector<QosTenantStats> GetStats() {
+    hshm::ScopedMutex lock(lock_, 0);
+    std::vector<QosTenantStats> stats;
+    stats.reserve(tenants_.size());
+    for (auto &it : tenants_) {
+      stats.emplace_back(it.second->GetStats());
+    }
+    return stats;
+  }
+};
+
+/** The deficit round robin state of a tenant in one worker */
+struct QosDeficit {
+  QosTenant *tenant_;     /**< The node-wide tenant */
+  double deficit_;        /**< Bytes the tenant may still start */
+  size_t round_;          /**< The last round the tenant was credited */
+  size_t blocked_round_;  /**< The last round the tenant was held back */
+  size_t blocked_pass_;   /**< The last lane pass the tenant was held back */
+
+  /** Emplace constructor */
+  explicit QosDeficit(QosTenant *tenant)
+      : tenant_(tenant), deficit_(0), round_(0),
+        blocked_round_(0), blocked_pass_(0) {}
+};
+
+}  // namespace hrun
+
+#endif  // HRUN_INCLUDE_HRUN_WORK_ORCHESTRATOR_QOS_H_
@@ -16,6 +16,7 @@
 #include "hrun/hrun_types.h"
 #include "hrun/queue_manager/queue_manager_runtime.h"
 #include "hrun/network/rpc_thallium.h"
+#include "hrun/work_orchestrator/qos.h"
 #include <thread>
 
 namespace hrun {
@@ -32,6 +33,7 @@ class WorkOrchestrator {
   std::atomic<bool> stop_runtime_;  /**< Begin killing the runtime */
   std::atomic<bool> kill_requested_;  /**< Kill flushing threads eventually */
   ABT_xstream xstream_;
+  QosManager qos_;  /**< Shares and rate limits of tenants */
 
  public:
   /** Default constructor */
@@ -21,6 +21,7 @@
 #include <thread>
 #include <queue>
 #include "affinity.h"
+#include "qos.h"
 #include "hrun/network/rpc_thallium.h"
 
 static inline pid_t GetLinuxTid() {
@@ -33,6 +34,13 @@ namespace hrun {
 
 #define WORKER_CONTINUOUS_POLLING BIT_OPT(u32, 0)
 
+/** Occupancy of a lane, used to decide when to resize it */
+enum class LaneLoad {
+  kNormal,  /**< Neither busy nor idle */
+  kBusy,    /**< At least 3/4 full */
+  kIdle     /**< At most 1/8 full and grown beyond the group depth */
+};
+
 /** Uniquely identify a queue lane */
 struct WorkEntry {
   u32 prio_;
@@ -44,6 +52,8 @@ struct WorkEntry {
   hshm::Timepoint last_monitor_;
   hshm::Timepoint cur_time_;
   double sample_epoch_;
+  LaneLoad load_;               /**< The current occupancy of the lane */
+  hshm::Timepoint load_start_;  /**< When the lane entered load_ */
 
   /** Default constructor */
   HSHM_ALWAYS_INLINE
@@ -56,6 +66,7 @@ struct WorkEntry {
     group_ = &queue->GetGroup(prio);
     lane_ = &queue->GetLane(*group_, lane_id);
     count_ = 0;
+    load_ = LaneLoad::kNormal;
     cur_time_.Now();
   }
 
@@ -67,6 +78,7 @@ struct WorkEntry {
     lane_ = other.lane_;
     group_ = other.group_;
     queue_ = other.queue_;
+    load_ = LaneLoad::kNormal;
     cur_time_.Now();
   }
 
@@ -79,6 +91,7 @@ struct WorkEntry {
       lane_ = other.lane_;
       group_ = other.group_;
       queue_ = other.queue_;
+      load_ = LaneLoad::kNormal;
       cur_time_.Now();
     }
     return *this;
@@ -92,6 +105,7 @@ struct WorkEntry {
     lane_ = other.lane_;
     group_ = other.group_;
     queue_ = other.queue_;
+    load_ = LaneLoad::kNormal;
     cur_time_.Now();
   }
 
@@ -104,6 +118,7 @@ struct WorkEntry {
       lane_ = other.lane_;
       group_ = other.group_;
       queue_ = other.queue_;
+      load_ = LaneLoad::kNormal;
       cur_time_.Now();
     }
     return *this;
@@ -166,6 +181,16 @@ class Worker {
   hshm::spsc_queue<void*> stacks_;  /**< Cache of stacks for tasks */
   int num_stacks_ = 256;  /**< Number of stacks */
   int stack_size_ = KILOBYTES(64);
+  QosManager *qos_ = nullptr;  /**< Node-wide QoS policies */
+  std::unordered_map<u32, QosDeficit> qos_deficits_;  /**< Tenant -> DRR */
+  size_t qos_round_ = 1;  /**< Incremented on every Run */
+  size_t qos_pass_ = 1;   /**< Incremented on every lane poll */
+  /** Max completed entries popped at once */
+  static const size_t kMaxPopBatch = 64;
+  /** Time a lane must stay busy before it grows */
+  static const size_t kLaneBusyUs = 10000;
+  /** Time a lane must stay idle before it shrinks */
+  static const size_t kLaneIdleUs = 1000000;
 
  public:
   /**===============================================================
@@ -331,6 +356,7 @@ class Worker {
       MakeDedicated();
     }
     WorkOrchestrator *orchestrator = HRUN_WORK_ORCHESTRATOR;
+    qos_ = &orchestrator->qos_;
     now_.Now();
     while (orchestrator->IsAlive()) {
       try {
@@ -361,6 +387,7 @@ class Worker {
     if (relinquish_queues_.size() > 0) {
       _RelinquishQueues();
     }
+    ++qos_round_;
     if (!IsContinuousPolling()) {
       now_.Now();
       for (WorkEntry &work_entry : work_queue_) {
@@ -381,13 +408,23 @@ class Worker {
     Lane *&lane = work_entry.lane_;
     Task *task;
     LaneData *entry;
+    MonitorLane(work_entry);
+    bool retired = work_entry.group_->IsRetired(work_entry.lane_id_);
+    bool qos = !flushing && qos_ && qos_->IsEnabled();
+    ++qos_pass_;
     while (!lane->peek(entry, off).IsNull()) {
       // Get the task message
       if (entry->complete_) {
-        PopTask(lane, off);
+        PopCompleted(lane, off);
         continue;
       }
       task = HRUN_CLIENT->GetMainPointer<Task>(entry->p_);
+      // Move unstarted tasks out of lanes removed by a resize
+      if (retired && MigrateTask(work_entry, entry, task)) {
+        entry->complete_ = true;
+        PopTask(lane, off);
+        continue;
+      }
       RunContext &rctx = task->ctx_;
       rctx.lane_id_ = work_entry.lane_id_;
       rctx.flush_ = &flush_;
@@ -416,7 +453,20 @@ class Worker {
         is_remote = true;
       }
 #endif
-      bool group_avail = CheckTaskGroup(task, exec, work_entry.lane_id_, task->task_node_, is_remote);
+      // Hold back tasks of tenants which used their share or rate. The
+      // task keeps its group, so later tasks of the same group (e.g., a
+      // GetBlobSize after a Put of the blob) do not overtake it.
+      bool grouped = task->task_flags_.Any(TASK_QOS_GROUPED);
+      if (qos && task->qos_tenant_ && !is_remote && !QosAdmit(task)) {
+        if (!grouped && CheckTaskGroup(task, exec, work_entry.lane_id_,
+                                       task->task_node_, is_remote)) {
+          task->task_flags_.SetBits(TASK_QOS_GROUPED);
+        }
+        off += 1;
+        continue;
+      }
+      bool group_avail = grouped ||
+          CheckTaskGroup(task, exec, work_entry.lane_id_, task->task_node_, is_remote);
       bool should_run = task->ShouldRun(work_entry.cur_time_, flushing);
       // Verify tasks
       if (flushing && !task->IsFlush()) {
@@ -475,6 +525,117 @@ class Worker {
     }
   }
 
+  /**===============================================================
+   * Quality of Service
+   * =============================================================== */
+
+  /**
+   * Decide whether an unstarted task of a QoS tenant may start in this
+   * round. Charges the tenant's deficit and rate limits if so.
+   * */
+  bool QosAdmit(Task *task) {
+    if (task->IsStarted() || task->IsRunDisabled() ||
+        task->IsLongRunning() || task->IsLaneAll() ||
+        task->task_flags_.Any(TASK_QOS_ADMITTED)) {
+      return true;
+    }
+    if (!task->task_flags_.Any(TASK_QOS_ARRIVED)) {
+      task->qos_arrival_.Now();
+      task->task_flags_.SetBits(TASK_QOS_ARRIVED);
+    }
+    auto it = qos_deficits_.find(task->qos_tenant_);
+    if (it == qos_deficits_.end()) {
+      it = qos_deficits_.emplace(
+          task->qos_tenant_,
+          QosDeficit(qos_->GetTenant(task->qos_tenant_))).first;
+    }
+    QosDeficit &drr = it->second;
+    QosTenant *tenant = drr.tenant_;
+    // Later tasks of a held back tenant wait too, to keep them in order
+    if (drr.blocked_pass_ == qos_pass_) {
+      return false;
+    }
+    // Credit the tenant once per round. Credit is only carried over
+    // while the tenant has tasks waiting.
+    if (drr.round_ != qos_round_) {
+      double quantum = qos_->quantum_.load(std::memory_order_relaxed) *
+          tenant->weight_.load(std::memory_order_relaxed);
+      drr.deficit_ = drr.blocked_round_ + 1 == qos_round_ ?
+          drr.deficit_ + quantum : quantum;
+      drr.round_ = qos_round_;
+    }
+    size_t cost = task->qos_cost_ + QosManager::kOpCost;
+    if (drr.deficit_ < cost || !tenant->TryAcquire(cost)) {
+      drr.blocked_pass_ = qos_pass_;
+      drr.blocked_round_ = qos_round_;
+      tenant->deferrals_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    drr.deficit_ -= cost;
+    task->task_flags_.SetBits(TASK_QOS_ADMITTED);
+    tenant->RecordStart(task->qos_cost_,
+                        (size_t)task->qos_arrival_.GetNsecFromStart());
+    return true;
+  }
+
+  /**===============================================================
+   * Lane Resizing
+   * =============================================================== */
+
+  /** Apply requested resizes and grow or shrink a lane based on its load */
+  HSHM_ALWAYS_INLINE
+  void MonitorLane(WorkEntry &work_entry) {
+    Lane *lane = work_entry.lane_;
+    if (lane->IsResizeRequested()) {
+      u32 depth = lane->resize_depth_.exchange(0);
+      if (!lane->Resize(depth)) {
+        // Too many entries for now, retry on a later poll
+        u32 none = 0;
+        lane->resize_depth_.compare_exchange_strong(none, depth);
+      }
+    }
+    size_t size = lane->GetSize();
+    size_t depth = lane->GetDepth();
+    LaneLoad load = LaneLoad::kNormal;
+    if (size * 4 >= depth * 3) {
+      load = LaneLoad::kBusy;
+    } else if (size * 8 <= depth && depth > work_entry.group_->depth_ &&
+               !work_entry.group_->IsRetired(work_entry.lane_id_)) {
+      load = LaneLoad::kIdle;
+    }
+    if (load != work_entry.load_) {
+      work_entry.load_ = load;
+      work_entry.load_start_.Now();
+      return;
+    }
+    if (load == LaneLoad::kNormal) {
+      return;
+    }
+    size_t elapsed = work_entry.load_start_.GetUsecFromStart();
+    if (load == LaneLoad::kBusy && elapsed >= kLaneBusyUs) {
+      work_entry.queue_->Grow(work_entry.prio_, work_entry.lane_id_);
+      work_entry.load_ = LaneLoad::kNormal;
+    } else if (load == LaneLoad::kIdle && elapsed >= kLaneIdleUs) {
+      lane->Resize(std::max<size_t>(depth / 2, work_entry.group_->depth_));
+      work_entry.load_ = LaneLoad::kNormal;
+    }
+  }
+
+  /**
+   * Re-emplace a task of a retired lane into an active lane. Only tasks
+   * which have not begun executing on this worker, and hold no task group
+   * of this lane, can move.
+   * */
+  bool MigrateTask(WorkEntry &work_entry, LaneData *entry, Task *task) {
+    if (task->IsStarted() || task->IsRunDisabled() ||
+        task->IsLongRunning() || task->IsLaneAll() ||
+        task->task_flags_.Any(TASK_QOS_GROUPED)) {
+      return false;
+    }
+    return work_entry.queue_->TryEmplace(
+        work_entry.prio_, task->lane_hash_, LaneData(entry->p_, false));
+  }
+
   /** Run a coroutine */
   static void RunCoroutine(bctx::transfer_t t) {
     Task *task = reinterpret_cast<Task*>(t.data);
@@ -579,6 +740,25 @@ class Worker {
     }
   }
 
+  /**
+   * Pop the run of completed entries at the head of the lane with a
+   * single PopN. Entries past the head are skipped instead.
+   * */
+  HSHM_ALWAYS_INLINE
+  void PopCompleted(Lane *lane, int &off) {
+    if (off != 0) {
+      off += 1;
+      return;
+    }
+    LaneData *entry;
+    size_t count = 1;
+    while (count < kMaxPopBatch &&
+           !lane->peek(entry, (int)count).IsNull() && entry->complete_) {
+      ++count;
+    }
+    lane->pop_n(count);
+  }
+
   /** Print all queues */
   void PrintQueues(bool no_long_run = false) {
     for (std::unique_ptr<Worker> &worker : HRUN_WORK_ORCHESTRATOR->workers_) {
@@ -42,6 +42,7 @@ void Runtime::ServerInit(std::string server_config_path) {
   header_->node_id_ = rpc_.node_id_;
   header_->unique_ = 0;
   header_->num_nodes_ = server_config_.rpc_.host_names_.size();
+  header_->data_waitq_.Init();
   task_registry_.ServerInit(&server_config_, rpc_.node_id_, header_->unique_);
   // Queue manager + client must be initialized before Work Orchestrator
   queue_manager_.ServerInit(main_alloc_,
@@ -236,6 +236,33 @@ class Client : public TaskLibClient {
     HRUN_CLIENT->DelTask(task);
   }
   HRUN_TASK_NODE_ADMIN_ROOT(Flush);
+
+  /**
+   * Change the number of lanes and lane depth of a queue's priority group.
+   * A value of 0 leaves the corresponding property unchanged.
+   * */
+  void AsyncResizeQueueConstruct(ResizeQueueTask *task,
+                                 const TaskNode &task_node,
+                                 const DomainId &domain_id,
+                                 const QueueId &queue_id,
+                                 u32 queue_prio,
+                                 u32 num_lanes,
+                                 u32 depth) {
+    HRUN_CLIENT->ConstructTask<ResizeQueueTask>(
+        task, task_node, domain_id, queue_id, queue_prio, num_lanes, depth);
+  }
+  void ResizeQueueRoot(const DomainId &domain_id,
+                       const QueueId &queue_id,
+                       u32 queue_prio,
+                       u32 num_lanes,
+                       u32 depth) {
+    LPointer<ResizeQueueTask> task =
+        AsyncResizeQueueRoot(domain_id, queue_id, queue_prio,
+                             num_lanes, depth);
+    task->Wait();
+    HRUN_CLIENT->DelTask(task);
+  }
+  HRUN_TASK_NODE_ADMIN_ROOT(ResizeQueue);
 };
 
 }  // namespace hrun::Admin
@@ -44,6 +44,10 @@ void Run(u32 method, Task *task, RunContext &rctx) override {
       Flush(reinterpret_cast<FlushTask *>(task), rctx);
       break;
     }
+    case Method::kResizeQueue: {
+      ResizeQueue(reinterpret_cast<ResizeQueueTask *>(task), rctx);
+      break;
+    }
   }
 }
 /** Execute a task */
@@ -89,6 +93,10 @@ void Monitor(u32 mode, Task *task, RunContext &rctx) override {
       MonitorFlush(mode, reinterpret_cast<FlushTask *>(task), rctx);
       break;
     }
+    case Method::kResizeQueue: {
+      MonitorResizeQueue(mode, reinterpret_cast<ResizeQueueTask *>(task), rctx);
+      break;
+    }
   }
 }
 /** Delete a task */
@@ -134,6 +142,10 @@ void Del(u32 method, Task *task) override {
       HRUN_CLIENT->DelTask<FlushTask>(reinterpret_cast<FlushTask *>(task));
       break;
     }
+    case Method::kResizeQueue: {
+      HRUN_CLIENT->DelTask<ResizeQueueTask>(reinterpret_cast<ResizeQueueTask *>(task));
+      break;
+    }
   }
 }
 /** Duplicate a task */
@@ -179,6 +191,10 @@ void Dup(u32 method, Task *orig_task, std::vector<LPointer<Task>> &dups) overrid
       hrun::CALL_DUPLICATE(reinterpret_cast<FlushTask*>(orig_task), dups);
       break;
     }
+    case Method::kResizeQueue: {
+      hrun::CALL_DUPLICATE(reinterpret_cast<ResizeQueueTask*>(orig_task), dups);
+      break;
+    }
   }
 }
 /** Register the duplicate output with the origin task */
@@ -224,6 +240,10 @@ void DupEnd(u32 method, u32 replica, Task *orig_task, Task *dup_task) override {
       hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<FlushTask*>(orig_task), reinterpret_cast<FlushTask*>(dup_task));
       break;
     }
+    case Method::kResizeQueue: {
+      hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<ResizeQueueTask*>(orig_task), reinterpret_cast<ResizeQueueTask*>(dup_task));
+      break;
+    }
   }
 }
 /** Ensure there is space to store replicated outputs */
@@ -269,6 +289,10 @@ void ReplicateStart(u32 method, u32 count, Task *task) override {
       hrun::CALL_REPLICA_START(count, reinterpret_cast<FlushTask*>(task));
       break;
     }
+    case Method::kResizeQueue: {
+      hrun::CALL_REPLICA_START(count, reinterpret_cast<ResizeQueueTask*>(task));
+      break;
+    }
   }
 }
 /** Determine success and handle failures */
@@ -314,6 +338,10 @@ void ReplicateEnd(u32 method, Task *task) override {
       hrun::CALL_REPLICA_END(reinterpret_cast<FlushTask*>(task));
       break;
     }
+    case Method::kResizeQueue: {
+      hrun::CALL_REPLICA_END(reinterpret_cast<ResizeQueueTask*>(task));
+      break;
+    }
   }
 }
 /** Serialize a task when initially pushing into remote */
@@ -359,6 +387,10 @@ std::vector<DataTransfer> SaveStart(u32 method, BinaryOutputArchive<true> &ar, T
       ar << *reinterpret_cast<FlushTask*>(task);
       break;
     }
+    case Method::kResizeQueue: {
+      ar << *reinterpret_cast<ResizeQueueTask*>(task);
+      break;
+    }
   }
   return ar.Get();
 }
@@ -416,6 +448,11 @@ TaskPointer LoadStart(u32 method, BinaryInputArchive<true> &ar) override {
       ar >> *reinterpret_cast<FlushTask*>(task_ptr.ptr_);
       break;
     }
+    case Method::kResizeQueue: {
+      task_ptr.ptr_ = HRUN_CLIENT->NewEmptyTask<ResizeQueueTask>(task_ptr.shm_);
+      ar >> *reinterpret_cast<ResizeQueueTask*>(task_ptr.ptr_);
+      break;
+    }
   }
   return task_ptr;
 }
@@ -462,6 +499,10 @@ std::vector<DataTransfer> SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Ta
       ar << *reinterpret_cast<FlushTask*>(task);
       break;
     }
+    case Method::kResizeQueue: {
+      ar << *reinterpret_cast<ResizeQueueTask*>(task);
+      break;
+    }
   }
   return ar.Get();
 }
@@ -508,6 +549,10 @@ void LoadEnd(u32 replica, u32 method, BinaryInputArchive<false> &ar, Task *task)
       ar.Deserialize(replica, *reinterpret_cast<FlushTask*>(task));
       break;
     }
+    case Method::kResizeQueue: {
+      ar.Deserialize(replica, *reinterpret_cast<ResizeQueueTask*>(task));
+      break;
+    }
   }
 }
 /** Get the grouping of the task */
@@ -543,6 +588,9 @@ u32 GetGroup(u32 method, Task *task, hshm::charbuf &group) override {
     case Method::kFlush: {
       return reinterpret_cast<FlushTask*>(task)->GetGroup(group);
     }
+    case Method::kResizeQueue: {
+      return reinterpret_cast<ResizeQueueTask*>(task)->GetGroup(group);
+    }
   }
   return -1;
 }
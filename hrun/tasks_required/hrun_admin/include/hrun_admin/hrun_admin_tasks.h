@@ -470,6 +470,61 @@ struct FlushTask : public Task, TaskFlags<TF_SRL_SYM | TF_REPLICA> {
   }
 };
 
+/** A task to change the number of lanes or lane depth of a queue */
+struct ResizeQueueTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN QueueId queue_id_;
+  IN u32 queue_prio_;
+  IN u32 num_lanes_;
+  IN u32 depth_;
+
+  /** SHM default constructor */
+  HSHM_ALWAYS_INLINE explicit
+  ResizeQueueTask(hipc::Allocator *alloc) : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_ALWAYS_INLINE explicit
+  ResizeQueueTask(hipc::Allocator *alloc,
+                  const TaskNode &task_node,
+                  const DomainId &domain_id,
+                  const QueueId &queue_id,
+                  u32 queue_prio,
+                  u32 num_lanes,
+                  u32 depth) : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    lane_hash_ = 0;
+    prio_ = TaskPrio::kAdmin;
+    task_state_ = HRUN_QM_CLIENT->admin_task_state_;
+    method_ = Method::kResizeQueue;
+    task_flags_.SetBits(0);
+    domain_id_ = domain_id;
+
+    // Initialize
+    queue_id_ = queue_id;
+    queue_prio_ = queue_prio;
+    num_lanes_ = num_lanes;
+    depth_ = depth;
+  }
+
+  /** (De)serialize message call */
+  template<typename Ar>
+  void SerializeStart(Ar &ar) {
+    task_serialize<Ar>(ar);
+    ar(queue_id_, queue_prio_, num_lanes_, depth_);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void SerializeEnd(u32 replica, Ar &ar) {
+  }
+
+  /** Create group */
+  HSHM_ALWAYS_INLINE
+  u32 GetGroup(hshm::charbuf &group) {
+    return TASK_UNORDERED;
+  }
+};
+
 
 }  // namespace hrun::Admin
 
@@ -195,6 +195,27 @@ class Server : public TaskLib {
   void MonitorFlush(u32 mode, FlushTask *task, RunContext &rctx) {
   }
 
+  /** Resize the lanes of a queue */
+  void ResizeQueue(ResizeQueueTask *task, RunContext &rctx) {
+    MultiQueue *queue = HRUN_CLIENT->GetQueue(task->queue_id_);
+    if (queue == nullptr || queue->id_.IsNull() ||
+        task->queue_prio_ >= queue->groups_->size()) {
+      HELOG(kError, "(node {}) Cannot resize queue {} (prio {})",
+            HRUN_CLIENT->node_id_, task->queue_id_, task->queue_prio_);
+      task->SetModuleComplete();
+      return;
+    }
+    if (task->num_lanes_) {
+      queue->Resize(task->queue_prio_, task->num_lanes_);
+    }
+    if (task->depth_) {
+      queue->ResizeDepth(task->queue_prio_, task->depth_);
+    }
+    task->SetModuleComplete();
+  }
+  void MonitorResizeQueue(u32 mode, ResizeQueueTask *task, RunContext &rctx) {
+  }
+
  public:
 #include "hrun_admin/hrun_admin_lib_exec.h"
 };
@@ -81,6 +81,22 @@ class Client : public TaskLibClient {
     return push_task;
   }
   HRUN_TASK_NODE_ROOT(AsyncPush);
+
+  /** Push a task as part of a batch, which is emplaced on submission */
+  template<typename TaskT>
+  HSHM_ALWAYS_INLINE
+  LPointer<hrunpq::TypedPushTask<TaskT>>
+  AsyncPush(TaskBatch &batch,
+            const TaskNode &task_node,
+            const DomainId &domain_id,
+            const hipc::LPointer<TaskT> &subtask) {
+    LPointer<hrunpq::TypedPushTask<TaskT>> push_task =
+        HRUN_CLIENT->AllocateTask<hrunpq::TypedPushTask<TaskT>>();
+    AsyncPushConstruct(push_task.ptr_, task_node, domain_id, subtask);
+    MultiQueue *queue = HRUN_CLIENT->GetQueue(queue_id_);
+    batch.Add(queue, push_task->prio_, push_task->lane_hash_, push_task.shm_);
+    return push_task;
+  }
 };
 
 }  // namespace hrun
@@ -79,7 +79,9 @@ class Server : public TaskLib {
             lane.worker_id_ = worker.id_;
           }
         }
-        lane_group.num_scheduled_ = num_lanes;
+        // Lanes retired by a resize keep their worker until restored
+        lane_group.num_scheduled_ = std::max(lane_group.num_scheduled_,
+                                             num_lanes);
       }
     }
   }
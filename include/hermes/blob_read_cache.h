@@ -0,0 +1,342 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_BLOB_READ_CACHE_H_
+#define HERMES_INCLUDE_HERMES_BLOB_READ_CACHE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <new>
+#include "hermes/hermes_types.h"
+
+namespace hermes {
+
+/** A cached blob */
+struct ReadCacheEntry {
+  std::atomic<u64> unique_;     /**< BlobId::unique_, 0 if the way is empty */
+  std::atomic<u32> node_id_;    /**< BlobId::node_id_ */
+  std::atomic<u32> ref_;        /**< CLOCK reference bit */
+  std::atomic<size_t> mod_count_;  /**< BlobInfo::mod_count_ when cached */
+  std::atomic<size_t> size_;    /**< The size of the blob */
+
+  /** Whether this entry holds \a blob_id */
+  bool Matches(const BlobId &blob_id) const {
+    return unique_.load(std::memory_order_relaxed) == blob_id.unique_ &&
+        node_id_.load(std::memory_order_relaxed) == blob_id.node_id_;
+  }
+};
+
+/** The ways of one hash bucket, guarded by a sequence lock */
+struct ReadCacheSet {
+  std::atomic<u64> seq_;      /**< Odd while the set is being modified */
+  std::atomic<u32> pending_;  /**< Client puts in flight to blobs of the set */
+  std::atomic<u32> hand_;     /**< CLOCK hand */
+};
+
+/** Hit statistics of a BlobReadCache */
+struct ReadCacheStats {
+  size_t hits_ = 0;         /**< Reads served by the cache */
+  size_t misses_ = 0;       /**< Reads which went to the targets */
+  size_t inserts_ = 0;      /**< Blobs added to the cache */
+  size_t evictions_ = 0;    /**< Blobs replaced by CLOCK */
+  size_t invalidations_ = 0;  /**< Blobs dropped because they changed */
+};
+
+/**
+ * A node-local cache of small, recently read blobs in the data segment.
+ *
+ * The blob_mdm fills the cache when a GetBlob reads a whole blob and
+ * invalidates entries when blobs are modified. Clients on the node probe it
+ * directly, without submitting a task. The cache is set-associative: a blob
+ * hashes to one set of ways, and a set is replaced with CLOCK.
+ *
+ * Readers never lock. A set's seq_ is odd while the blob_mdm modifies it,
+ * and a read is discarded if seq_ changed while it copied. Entries record
+ * the mod_count_ of the blob, so the blob_mdm only serves hits of the
+ * current version. A client which puts to a blob raises the pending_ count
+ * of its set before submitting the put, and the blob_mdm drops it after
+ * the put completed. Sets with puts in flight neither hit nor fill, so a
+ * process always reads its own writes.
+ *
+ * Every offset is relative to the cache, since clients map the data
+ * segment at a different address.
+ * */
+class BlobReadCache {
+ public:
+  static const size_t kAnyVersion = (size_t)-1;
+
+  u32 num_sets_;         /**< The number of sets */
+  u32 ways_;             /**< The number of blobs per set */
+  size_t slot_size_;     /**< The largest blob which is cached */
+  size_t sets_off_;      /**< Offset of the sets */
+  size_t entries_off_;   /**< Offset of the entries */
+  size_t data_off_;      /**< Offset of the slots */
+  std::atomic<size_t> hits_;
+  std::atomic<size_t> misses_;
+  std::atomic<size_t> inserts_;
+  std::atomic<size_t> evictions_;
+  std::atomic<size_t> invalidations_;
+
+ public:
+  /** The number of sets for a cache of \a capacity bytes */
+  static u32 GetNumSets(size_t capacity, size_t slot_size, u32 ways) {
+    size_t num_sets = capacity / (slot_size * ways);
+    return num_sets ? (u32)num_sets : 1;
+  }
+
+  /** The bytes needed for a cache of \a capacity bytes of blobs */
+  static size_t GetAllocSize(size_t capacity, size_t slot_size, u32 ways) {
+    size_t num_slots = (size_t)GetNumSets(capacity, slot_size, ways) * ways;
+    return sizeof(BlobReadCache) +
+        GetNumSets(capacity, slot_size, ways) * sizeof(ReadCacheSet) +
+        num_slots * (sizeof(ReadCacheEntry) + slot_size);
+  }
+
+  /** Initialize the cache in memory of GetAllocSize bytes */
+  void Init(size_t capacity, size_t slot_size, u32 ways) {
+    num_sets_ = GetNumSets(capacity, slot_size, ways);
+    ways_ = ways;
+    slot_size_ = slot_size;
+    sets_off_ = sizeof(BlobReadCache);
+    entries_off_ = sets_off_ + num_sets_ * sizeof(ReadCacheSet);
+    data_off_ = entries_off_ +
+        (size_t)num_sets_ * ways_ * sizeof(ReadCacheEntry);
+    for (u32 i = 0; i < num_sets_; ++i) {
+      ReadCacheSet *set = new (GetSet(i)) ReadCacheSet();
+      set->seq_.store(0);
+      set->pending_.store(0);
+      set->hand_.store(0);
+    }
+    for (size_t i = 0; i < (size_t)num_sets_ * ways_; ++i) {
+      ReadCacheEntry *entry = new (GetEntries() + i) ReadCacheEntry();
+      entry->unique_.store(0);
+      entry->node_id_.store(0);
+      entry->ref_.store(0);
+      entry->mod_count_.store(0);
+      entry->size_.store(0);
+    }
+    hits_.store(0);
+    misses_.store(0);
+    inserts_.store(0);
+    evictions_.store(0);
+    invalidations_.store(0);
+  }
+
+  /**
+   * Copy up to \a buf_size bytes of \a blob_id starting at \a off into
+   * \a buf. On a hit, \a size is the number of bytes copied. Only the
+   * version \a mod_count hits, unless it is kAnyVersion.
+   * */
+  bool Read(const BlobId &blob_id, size_t off, char *buf, size_t buf_size,
+            size_t &size, size_t mod_count = kAnyVersion) {
+    u32 set_idx = GetSetIdx(blob_id);
+    ReadCacheSet &set = *GetSet(set_idx);
+    u64 seq = set.seq_.load(std::memory_order_acquire);
+    if ((seq & 1) || set.pending_.load(std::memory_order_acquire)) {
+      return Miss();
+    }
+    u32 way = Find(set_idx, blob_id);
+    if (way == ways_) {
+      return Miss();
+    }
+    ReadCacheEntry &entry = GetEntry(set_idx, way);
+    size_t blob_size = entry.size_.load(std::memory_order_relaxed);
+    if (mod_count != kAnyVersion &&
+        entry.mod_count_.load(std::memory_order_relaxed) != mod_count) {
+      return Miss();
+    }
+    size = 0;
+    if (off < blob_size) {
+      size = std::min(buf_size, blob_size - off);
+      memcpy(buf, GetSlot(set_idx, way) + off, size);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (set.seq_.load(std::memory_order_relaxed) != seq) {
+      return Miss();
+    }
+    entry.ref_.store(1, std::memory_order_relaxed);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /** Get the size of \a blob_id if it is cached */
+  bool GetBlobSize(const BlobId &blob_id, size_t &size) {
+    u32 set_idx = GetSetIdx(blob_id);
+    ReadCacheSet &set = *GetSet(set_idx);
+    u64 seq = set.seq_.load(std::memory_order_acquire);
+    if ((seq & 1) || set.pending_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    u32 way = Find(set_idx, blob_id);
+    if (way == ways_) {
+      return false;
+    }
+    size = GetEntry(set_idx, way).size_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return set.seq_.load(std::memory_order_relaxed) == seq;
+  }
+
+  /**
+   * Cache version \a mod_count of \a blob_id. Called by the blob_mdm
+   * after reading the whole blob.
+   * */
+  void Insert(const BlobId &blob_id, size_t mod_count,
+              const char *data, size_t size) {
+    if (size > slot_size_) {
+      return;
+    }
+    u32 set_idx = GetSetIdx(blob_id);
+    ReadCacheSet &set = *GetSet(set_idx);
+    if (set.pending_.load(std::memory_order_acquire)) {
+      return;
+    }
+    Lock(set);
+    if (set.pending_.load(std::memory_order_acquire)) {
+      Unlock(set);
+      return;
+    }
+    u32 way = Find(set_idx, blob_id);
+    if (way == ways_) {
+      way = Evict(set_idx);
+    }
+    ReadCacheEntry &entry = GetEntry(set_idx, way);
+    memcpy(GetSlot(set_idx, way), data, size);
+    entry.unique_.store(blob_id.unique_, std::memory_order_relaxed);
+    entry.node_id_.store(blob_id.node_id_, std::memory_order_relaxed);
+    entry.mod_count_.store(mod_count, std::memory_order_relaxed);
+    entry.size_.store(size, std::memory_order_relaxed);
+    entry.ref_.store(1, std::memory_order_relaxed);
+    Unlock(set);
+    inserts_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Drop \a blob_id from the cache. Called by the blob_mdm. */
+  void Invalidate(const BlobId &blob_id) {
+    u32 set_idx = GetSetIdx(blob_id);
+    ReadCacheSet &set = *GetSet(set_idx);
+    Lock(set);
+    u32 way = Find(set_idx, blob_id);
+    if (way != ways_) {
+      ReadCacheEntry &entry = GetEntry(set_idx, way);
+      entry.unique_.store(0, std::memory_order_relaxed);
+      entry.node_id_.store(0, std::memory_order_relaxed);
+      invalidations_.fetch_add(1, std::memory_order_relaxed);
+    }
+    Unlock(set);
+  }
+
+  /** A client is about to submit a put to \a blob_id */
+  void BeginPut(const BlobId &blob_id) {
+    GetSet(GetSetIdx(blob_id))->pending_.fetch_add(1);
+  }
+
+  /** The blob_mdm completed a put begun with BeginPut */
+  void EndPut(const BlobId &blob_id) {
+    GetSet(GetSetIdx(blob_id))->pending_.fetch_sub(1);
+  }
+
+  /** Get the hit statistics */
+  ReadCacheStats GetStats() const {
+    ReadCacheStats stats;
+    stats.hits_ = hits_.load();
+    stats.misses_ = misses_.load();
+    stats.inserts_ = inserts_.load();
+    stats.evictions_ = evictions_.load();
+    stats.invalidations_ = invalidations_.load();
+    return stats;
+  }
+
+ private:
+  /** Count a miss */
+  bool Miss() {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  /** The set \a blob_id hashes to */
+  u32 GetSetIdx(const BlobId &blob_id) const {
+    return (u32)(std::hash<BlobId>{}(blob_id) % num_sets_);
+  }
+
+  /** The way of \a set_idx holding \a blob_id, or ways_ */
+  u32 Find(u32 set_idx, const BlobId &blob_id) {
+    for (u32 way = 0; way < ways_; ++way) {
+      if (GetEntry(set_idx, way).Matches(blob_id)) {
+        return way;
+      }
+    }
+    return ways_;
+  }
+
+  /** Choose a way to replace with CLOCK. Requires the set lock. */
+  u32 Evict(u32 set_idx) {
+    ReadCacheSet &set = *GetSet(set_idx);
+    u32 hand = set.hand_.load(std::memory_order_relaxed);
+    for (u32 i = 0; i < 2 * ways_; ++i, hand = (hand + 1) % ways_) {
+      ReadCacheEntry &entry = GetEntry(set_idx, hand);
+      if (entry.unique_.load(std::memory_order_relaxed) == 0) {
+        break;
+      }
+      if (entry.ref_.exchange(0, std::memory_order_relaxed) == 0) {
+        evictions_.fetch_add(1, std::memory_order_relaxed);
+        break;
+      }
+    }
+    set.hand_.store((hand + 1) % ways_, std::memory_order_relaxed);
+    return hand;
+  }
+
+  /** Begin modifying a set */
+  void Lock(ReadCacheSet &set) {
+    u64 seq = set.seq_.load(std::memory_order_relaxed);
+    while ((seq & 1) ||
+           !set.seq_.compare_exchange_weak(seq, seq + 1,
+                                           std::memory_order_acquire)) {
+      seq = set.seq_.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /** Finish modifying a set */
+  void Unlock(ReadCacheSet &set) {
+    set.seq_.fetch_add(1, std::memory_order_release);
+  }
+
+  /** Get a set */
+  ReadCacheSet* GetSet(u32 set_idx) {
+    return reinterpret_cast<ReadCacheSet*>(
+        reinterpret_cast<char*>(this) + sets_off_) + set_idx;
+  }
+
+  /** Get the entry array */
+  ReadCacheEntry* GetEntries() {
+    return reinterpret_cast<ReadCacheEntry*>(
+        reinterpret_cast<char*>(this) + entries_off_);
+  }
+
+  /** Get an entry */
+  ReadCacheEntry& GetEntry(u32 set_idx, u32 way) {
+    return GetEntries()[(size_t)set_idx * ways_ + way];
+  }
+
+  /** Get the data of an entry */
+  char* GetSlot(u32 set_idx, u32 way) {
+    return reinterpret_cast<char*>(this) + data_off_ +
+        ((size_t)set_idx * ways_ + way) * slot_size_;
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_BLOB_READ_CACHE_H_
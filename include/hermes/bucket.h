@@ -13,7 +13,14 @@
 #ifndef HRUN_TASKS_HERMES_CONF_INCLUDE_HERMES_CONF_BUCKET_H_
 #define HRUN_TASKS_HERMES_CONF_INCLUDE_HERMES_CONF_BUCKET_H_
 
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <map>
+#include <unordered_map>
 #include "hermes/hermes_types.h"
+#include "hermes/erasure_code.h"
 #include "hermes_mdm/hermes_mdm.h"
 #include "hermes/config_manager.h"
 
@@ -22,6 +29,291 @@ namespace hermes {
 #include "hrun/hrun_namespace.h"
 using hermes::blob_mdm::PutBlobTask;
 using hermes::blob_mdm::GetBlobTask;
+using hermes::blob_mdm::GetBlobSizeTask;
+
+/**
+ * A client-side cache of the size of a bucket.
+ *
+ * Buckets owned by this node are read from the TagShm slot that the
+ * bucket_mdm publishes. The size of buckets owned by other nodes is
+ * leased for bucket_size_lease_us. Since the bucket_mdm learns of writes
+ * asynchronously, writes made through this cache raise the size
+ * immediately. Those are dropped once the bucket shrinks.
+ *
+ * The cache holds a reference to the slot, so it stays readable after
+ * the bucket is destroyed until the cache is.
+ * */
+class BucketSizeCache {
+ public:
+  Mutex lock_;                   /**< Protects the cache */
+  TagShm *shm_ = nullptr;        /**< Slot of a node-local bucket */
+  hipc::Pointer shm_p_;          /**< Shared-memory pointer to shm_ */
+  size_t lease_size_ = 0;        /**< Size of a remote bucket */
+  u64 lease_shrink_count_ = 0;   /**< Shrink count of a remote bucket */
+  hshm::Timepoint lease_start_;  /**< When the lease was granted */
+  bool is_leased_ = false;       /**< Whether lease_size_ is set */
+  bool is_queried_ = false;      /**< Whether GetSize was ever sent */
+  size_t local_size_ = 0;        /**< Largest end written locally */
+  u64 shrink_count_ = 0;         /**< Shrink count local_size_ relies on */
+  bool has_shrink_count_ = false;  /**< Whether shrink_count_ is set */
+
+ public:
+  /** Default constructor */
+  BucketSizeCache() = default;
+
+  /** The slot reference cannot be shared by two caches */
+  BucketSizeCache(const BucketSizeCache &other) = delete;
+
+  /** Destructor. Releases the slot. */
+  ~BucketSizeCache() {
+    if (shm_ && HRUN_CLIENT->IsInitialized() &&
+        !HRUN_CLIENT->IsTerminated()) {
+      bucket_mdm::Client::ReleaseTagShm(shm_p_);
+    }
+  }
+
+  /** Get the size of the bucket \a tag_id */
+  size_t GetSize(bucket_mdm::Client *bkt_mdm, const TagId &tag_id) {
+    hshm::ScopedMutex lock(lock_, 0);
+    size_t size;
+    u64 shrink_count;
+    if (shm_ && shm_->valid_.load()) {
+      shrink_count = shm_->shrink_count_.load();
+      size = shm_->size_.load();
+    } else if (is_leased_ &&
+               lease_start_.GetUsecFromStart() <
+               HERMES_CLIENT_CONF.bucket_size_lease_us_) {
+      shrink_count = lease_shrink_count_;
+      size = lease_size_;
+    } else {
+      size = Query(bkt_mdm, tag_id, shrink_count);
+    }
+    if (!has_shrink_count_) {
+      shrink_count_ = shrink_count;
+      has_shrink_count_ = true;
+    } else if (shrink_count != shrink_count_) {
+      // Someone truncated the bucket, so local writes may be stale
+      shrink_count_ = shrink_count;
+      local_size_ = 0;
+    }
+    return std::max(size, local_size_);
+  }
+
+  /** A local write extended the bucket to at least \a size bytes */
+  void UpdateLocalSize(size_t size) {
+    hshm::ScopedMutex lock(lock_, 0);
+    local_size_ = std::max(local_size_, size);
+    if (is_leased_) {
+      lease_size_ = std::max(lease_size_, size);
+    }
+  }
+
+  /**
+   * Get the shared-memory slot of the bucket \a tag_id.
+   * Null if the bucket is owned by another node or was destroyed.
+   * */
+  TagShm* GetShm(bucket_mdm::Client *bkt_mdm, const TagId &tag_id) {
+    hshm::ScopedMutex lock(lock_, 0);
+    if (!is_queried_) {
+      u64 shrink_count;
+      Query(bkt_mdm, tag_id, shrink_count);
+    }
+    if (shm_ && shm_->valid_.load()) {
+      return shm_;
+    }
+    return nullptr;
+  }
+
+  /** The bucket was truncated or cleared locally */
+  void Invalidate() {
+    hshm::ScopedMutex lock(lock_, 0);
+    local_size_ = 0;
+    is_leased_ = false;
+    has_shrink_count_ = false;
+  }
+
+ private:
+  /** Get the size from the bucket_mdm. Requires the lock. */
+  size_t Query(bucket_mdm::Client *bkt_mdm, const TagId &tag_id,
+               u64 &shrink_count) {
+    hipc::Pointer p;
+    size_t size = bkt_mdm->GetSizeRoot(tag_id, shrink_count, p);
+    is_queried_ = true;
+    if (!p.IsNull()) {
+      if (shm_) {
+        // Already attached. Keep the slot others may be reading.
+        bucket_mdm::Client::ReleaseTagShm(p);
+      } else {
+        shm_p_ = p;
+        shm_ = HRUN_CLIENT->GetMainPointer<TagShm>(p);
+      }
+    } else {
+      lease_size_ = size;
+      lease_shrink_count_ = shrink_count;
+      lease_start_.Now();
+      is_leased_ = true;
+    }
+    return size;
+  }
+};
+
+/** Hit statistics of a BlobIdCache */
+struct BlobIdCacheStats {
+  size_t hits_ = 0;    /**< Names resolved from the cache */
+  size_t misses_ = 0;  /**< Names resolved by the blob_mdm */
+
+  /** The fraction of lookups served by the cache */
+  float GetHitRate() const {
+    size_t total = hits_ + misses_;
+    return total ? (float)hits_ / (float)total : 0;
+  }
+};
+
+/**
+ * A per-process cache of blob name -> BlobId for one bucket.
+ *
+ * Entries are valid as long as the blob epoch of the bucket's TagShm
+ * is unchanged. The bucket_mdm bumps the epoch when a blob in the bucket
+ * is destroyed or renamed, or when the bucket is cleared or truncated.
+ * Only buckets owned by this node are cached, since the epoch cannot be
+ * read without a task otherwise.
+ * */
+class BlobIdCache {
+ public:
+  static const size_t kMaxEntries = 1 << 16;  /**< Cleared when exceeded */
+  Mutex lock_;                                /**< Protects the cache */
+  std::unordered_map<std::string, BlobId> ids_;  /**< Name -> BlobId */
+  u64 epoch_ = 0;            /**< The blob epoch ids_ is valid for */
+  BlobIdCacheStats stats_;   /**< Hit statistics */
+
+ public:
+  /** Find the id of \a name. Returns false on a miss. */
+  bool Find(TagShm *shm, const std::string &name, BlobId &blob_id) {
+    hshm::ScopedMutex lock(lock_, 0);
+    Validate(shm);
+    auto it = ids_.find(name);
+    if (it == ids_.end()) {
+      stats_.misses_ += 1;
+      return false;
+    }
+    stats_.hits_ += 1;
+    blob_id = it->second;
+    return true;
+  }
+
+  /**
+   * Cache the id of \a name. Dropped if the epoch changed since the
+   * preceding Find, since the id may have been resolved before the change.
+   * */
+  void Emplace(TagShm *shm, const std::string &name, const BlobId &blob_id) {
+    if (blob_id.IsNull()) {
+      return;
+    }
+    hshm::ScopedMutex lock(lock_, 0);
+    if (shm->blob_epoch_.load() != epoch_) {
+      return;
+    }
+    if (ids_.size() >= kMaxEntries) {
+      ids_.clear();
+    }
+    ids_[name] = blob_id;
+  }
+
+  /** Drop all cached ids */
+  void Clear() {
+    hshm::ScopedMutex lock(lock_, 0);
+    ids_.clear();
+  }
+
+  /** Get the hit statistics */
+  BlobIdCacheStats GetStats() {
+    hshm::ScopedMutex lock(lock_, 0);
+    return stats_;
+  }
+
+ private:
+  /** Drop the cache if the epoch changed. Requires the lock. */
+  void Validate(TagShm *shm) {
+    u64 epoch = shm->blob_epoch_.load();
+    if (epoch != epoch_) {
+      ids_.clear();
+      epoch_ = epoch;
+    }
+  }
+};
+
+/**
+ * Fragment requests which an erasure-coded get or put stopped waiting
+ * for, since k other fragments answered first. Their node may be slow or
+ * down. They are freed once they complete.
+ * */
+class EcStragglers {
+ public:
+  typedef LPointer<hrunpq::TypedPushTask<GetBlobTask>> GET_T;
+  typedef LPointer<hrunpq::TypedPushTask<GetBlobSizeTask>> SIZE_T;
+  typedef LPointer<hrunpq::TypedPushTask<PutBlobTask>> PUT_T;
+
+ public:
+  Mutex lock_;                 /**< Protects the lists */
+  std::list<GET_T> gets_;      /**< Outstanding fragment reads */
+  std::list<SIZE_T> sizes_;    /**< Outstanding fragment size probes */
+  std::list<PUT_T> puts_;      /**< Outstanding fragment writes */
+
+ public:
+  /** The stragglers of this process */
+  static EcStragglers& Get() {
+    static EcStragglers stragglers;
+    return stragglers;
+  }
+
+  /** Free \a task and its buffer once it completes */
+  void Add(GET_T &task) {
+    hshm::ScopedMutex lock(lock_, 0);
+    gets_.emplace_back(task);
+  }
+
+  /** Free \a task once it completes */
+  void Add(SIZE_T &task) {
+    hshm::ScopedMutex lock(lock_, 0);
+    sizes_.emplace_back(task);
+  }
+
+  /** Free \a task and its data once it completes */
+  void Add(PUT_T &task) {
+    hshm::ScopedMutex lock(lock_, 0);
+    puts_.emplace_back(task);
+  }
+
+  /** Free the requests which completed */
+  void Reap() {
+    hshm::ScopedMutex lock(lock_, 0);
+    for (auto it = gets_.begin(); it != gets_.end();) {
+      if (!(*it)->IsComplete()) {
+        ++it;
+        continue;
+      }
+      HRUN_CLIENT->FreeBuffer((*it)->get()->data_);
+      HRUN_CLIENT->DelTask(*it);
+      it = gets_.erase(it);
+    }
+    for (auto it = sizes_.begin(); it != sizes_.end();) {
+      if (!(*it)->IsComplete()) {
+        ++it;
+        continue;
+      }
+      HRUN_CLIENT->DelTask(*it);
+      it = sizes_.erase(it);
+    }
+    for (auto it = puts_.begin(); it != puts_.end();) {
+      if (!(*it)->IsComplete()) {
+        ++it;
+        continue;
+      }
+      HRUN_CLIENT->DelTask(*it);
+      it = puts_.erase(it);
+    }
+  }
+};
 
 class Bucket {
  public:
@@ -32,6 +324,9 @@ class Bucket {
   std::string name_;
   Context ctx_;
   bitfield32_t flags_;
+  std::shared_ptr<BucketSizeCache> size_cache_;
+  std::shared_ptr<BlobIdCache> blob_id_cache_;
+  std::shared_ptr<ReedSolomon> ec_;  /**< Null unless erasure-coded */
 
  public:
   /**====================================
@@ -52,8 +347,12 @@ class Bucket {
     bkt_mdm_ = &HERMES_CONF->bkt_mdm_;
     id_ = bkt_mdm_->GetOrCreateTagRoot(
         hshm::charbuf(bkt_name), true,
-        std::vector<TraitId>(), backend_size, flags);
+        std::vector<TraitId>(), backend_size, flags, ctx_,
+        ctx_.ec_data_, ctx_.ec_parity_);
     name_ = bkt_name;
+    size_cache_ = std::make_shared<BucketSizeCache>();
+    blob_id_cache_ = std::make_shared<BlobIdCache>();
+    InitErasureCode();
   }
 
   /**
@@ -69,25 +368,46 @@ class Bucket {
     mdm_ = &HERMES_CONF->mdm_;
     blob_mdm_ = &HERMES_CONF->blob_mdm_;
     bkt_mdm_ = &HERMES_CONF->bkt_mdm_;
+    if (ctx.ec_data_ + ctx.ec_parity_ > ReedSolomon::kMaxFragments) {
+      HELOG(kError, "Bucket {} cannot have more than {} fragments per blob",
+            bkt_name, ReedSolomon::kMaxFragments);
+      ctx.ec_data_ = 0;
+      ctx.ec_parity_ = 0;
+    }
     id_ = bkt_mdm_->GetOrCreateTagRoot(
         hshm::charbuf(bkt_name), true,
-        std::vector<TraitId>(), backend_size, flags, ctx);
+        std::vector<TraitId>(), backend_size, flags, ctx,
+        ctx.ec_data_, ctx.ec_parity_);
     name_ = bkt_name;
+    ctx_ = ctx;
+    size_cache_ = std::make_shared<BucketSizeCache>();
+    blob_id_cache_ = std::make_shared<BlobIdCache>();
+    InitErasureCode();
   }
 
   /**
-   * Get an existing bucket.
+   * Get an existing bucket. The erasure code of the bucket is not
+   * known, so get erasure-coded buckets by name.
    * */
   explicit Bucket(TagId tag_id) {
     id_ = tag_id;
     mdm_ = &HERMES_CONF->mdm_;
     blob_mdm_ = &HERMES_CONF->blob_mdm_;
     bkt_mdm_ = &HERMES_CONF->bkt_mdm_;
+    size_cache_ = std::make_shared<BucketSizeCache>();
+    blob_id_cache_ = std::make_shared<BlobIdCache>();
   }
 
   /** Default constructor */
   Bucket() = default;
 
+  /** Use the erasure code the bucket was created with, if any */
+  void InitErasureCode() {
+    if (ctx_.ec_data_ > 0) {
+      ec_ = std::make_shared<ReedSolomon>(ctx_.ec_data_, ctx_.ec_parity_);
+    }
+  }
+
   /** Default copy constructor */
   Bucket(const Bucket &other) = default;
 
@@ -131,10 +451,33 @@ class Bucket {
   }
 
   /**
-   * Get the current size of the bucket
+   * Get the current size of the bucket. Avoids the RPC when possible;
+   * see BucketSizeCache. The size of an erasure-coded bucket is the sum
+   * of its blobs' sizes, not of their fragments, so it is computed from
+   * the blobs.
    * */
   size_t GetSize() {
-    return bkt_mdm_->GetSizeRoot(id_);
+    if (ec_) {
+      size_t size = 0;
+      for (auto &blob : EcListBlobs()) {
+        size += EcGetBlobSize(blob.first);
+      }
+      return size;
+    }
+    if (!size_cache_) {
+      return bkt_mdm_->GetSizeRoot(id_);
+    }
+    return size_cache_->GetSize(bkt_mdm_, id_);
+  }
+
+  /**
+   * Inform the size cache that a write by this process extends the
+   * bucket to at least \a size bytes.
+   * */
+  void UpdateLocalSize(size_t size) {
+    if (size_cache_) {
+      size_cache_->UpdateLocalSize(size);
+    }
   }
 
   /**
@@ -149,6 +492,26 @@ class Bucket {
    * */
   void Clear() {
     bkt_mdm_->TagClearBlobsRoot(id_);
+    if (size_cache_) {
+      size_cache_->Invalidate();
+    }
+    if (blob_id_cache_) {
+      blob_id_cache_->Clear();
+    }
+  }
+
+  /**
+   * Truncate the bucket to \a new_size bytes. Assumes the blobs are
+   * pages of \a page_size bytes named 0 ... N, as in Append.
+   * */
+  void Truncate(size_t new_size, size_t page_size) {
+    bkt_mdm_->TruncateTagRoot(id_, new_size, page_size);
+    if (size_cache_) {
+      size_cache_->Invalidate();
+    }
+    if (blob_id_cache_) {
+      blob_id_cache_->Clear();
+    }
   }
 
   /**
@@ -156,6 +519,12 @@ class Bucket {
    * */
   void Destroy() {
     bkt_mdm_->DestroyTagRoot(id_);
+    if (size_cache_) {
+      size_cache_->Invalidate();
+    }
+    if (blob_id_cache_) {
+      blob_id_cache_->Clear();
+    }
   }
 
   /**
@@ -178,7 +547,50 @@ class Bucket {
    * @return
    * */
   BlobId GetBlobId(const std::string &blob_name) {
-    return blob_mdm_->GetBlobIdRoot(id_, hshm::to_charbuf(blob_name));
+    if (ec_) {
+      return EcGetBlobId(blob_name);
+    }
+    TagShm *shm;
+    BlobId blob_id = FindCachedBlobId(blob_name, shm);
+    if (!blob_id.IsNull()) {
+      return blob_id;
+    }
+    blob_id = blob_mdm_->GetBlobIdRoot(id_, hshm::to_charbuf(blob_name));
+    CacheBlobId(shm, blob_name, blob_id);
+    return blob_id;
+  }
+
+  /**
+   * Get the cached id of \a blob_name, or null on a miss. \a shm is
+   * set if this bucket's blob ids can be cached, for use in CacheBlobId.
+   * */
+  BlobId FindCachedBlobId(const std::string &blob_name, TagShm *&shm) {
+    BlobId blob_id = BlobId::GetNull();
+    shm = nullptr;
+    if (!blob_id_cache_ || blob_name.empty()) {
+      return blob_id;
+    }
+    shm = size_cache_->GetShm(bkt_mdm_, id_);
+    if (shm) {
+      blob_id_cache_->Find(shm, blob_name, blob_id);
+    }
+    return blob_id;
+  }
+
+  /** Cache the id of \a blob_name after a miss in FindCachedBlobId */
+  void CacheBlobId(TagShm *shm, const std::string &blob_name,
+                   const BlobId &blob_id) {
+    if (shm) {
+      blob_id_cache_->Emplace(shm, blob_name, blob_id);
+    }
+  }
+
+  /** Get the hit statistics of the blob id cache */
+  BlobIdCacheStats GetBlobIdCacheStats() {
+    if (!blob_id_cache_) {
+      return BlobIdCacheStats();
+    }
+    return blob_id_cache_->GetStats();
   }
 
   /**
@@ -189,6 +601,9 @@ class Bucket {
    * @return The Status of the operation
    * */
   std::string GetBlobName(const BlobId &blob_id) {
+    if (ec_) {
+      return EcGetBlobName(blob_id);
+    }
     return blob_mdm_->GetBlobNameRoot(id_, blob_id);
   }
 
@@ -212,8 +627,30 @@ class Bucket {
     return Status();
   }
 
+  /** Get the read cache of this node, or null if it is disabled */
+  BlobReadCache* GetReadCache() {
+    static BlobReadCache *read_cache = blob_mdm_->GetReadCacheRoot();
+    return read_cache;
+  }
+
   /**
-   * Put \a blob_name Blob into the bucket
+   * Get the read cache which holds \a blob_id, if any.
+   * Only blobs owned by this node are cached.
+   * */
+  BlobReadCache* GetReadCache(const BlobId &blob_id) {
+    BlobReadCache *read_cache = GetReadCache();
+    if (read_cache == nullptr || blob_id.IsNull() ||
+        blob_id.node_id_ != HRUN_CLIENT->node_id_) {
+      return nullptr;
+    }
+    return read_cache;
+  }
+
+  /**
+   * Put \a blob_name Blob into the bucket. Asynchronous puts given a
+   * \a batch are submitted along with the rest of the batch. Synchronous
+   * puts return a null id if the put could not be fully applied, e.g.,
+   * BLOB_NO_SPACE.
    * */
   template<bool PARTIAL, bool ASYNC>
   HSHM_ALWAYS_INLINE
@@ -221,12 +658,43 @@ class Bucket {
                  const BlobId &orig_blob_id,
                  const Blob &blob,
                  size_t blob_off,
-                 Context &ctx) {
+                 Context &ctx,
+                 TaskBatch *batch = nullptr) {
+    if (ec_) {
+      return EcPut<PARTIAL, ASYNC>(
+          orig_blob_id.IsNull() ? blob_name : EcGetBlobName(orig_blob_id),
+          blob, blob_off, ctx);
+    }
     BlobId blob_id = orig_blob_id;
+    TagShm *shm = nullptr;
+    if (blob_id.IsNull()) {
+      blob_id = FindCachedBlobId(blob_name, shm);
+    }
+    if constexpr (ASYNC) {
+      // The read cache can only hold back reads of a blob whose id is
+      // known, so resolve the id of a local blob before putting to it
+      if (blob_id.IsNull() && GetReadCache() &&
+          HASH_TO_NODE_ID(blob_mdm::HashBlobName(
+              id_, hshm::to_charbuf(blob_name))) == HRUN_CLIENT->node_id_) {
+        blob_id = blob_mdm_->GetOrCreateBlobIdRoot(
+            id_, hshm::to_charbuf(blob_name));
+        CacheBlobId(shm, blob_name, blob_id);
+      }
+    }
     bitfield32_t flags, task_flags(
         TASK_FIRE_AND_FORGET | TASK_DATA_OWNER | TASK_LOW_LATENCY);
     // Copy data to shared memory
-    LPointer<char> p = HRUN_CLIENT->AllocateBufferClient(blob.size());
+    LPointer<char> p;
+    if (batch && batch->size()) {
+      // Don't wait for memory held by our own unsubmitted puts
+      p = HRUN_CLIENT->TryAllocateBufferClient(blob.size());
+      if (p.shm_.IsNull()) {
+        batch->Submit();
+      }
+    }
+    if (p.shm_.IsNull()) {
+      p = HRUN_CLIENT->AllocateBufferClient(blob.size());
+    }
     char *data = p.ptr_;
     memcpy(data, blob.data(), blob.size());
     // Put to shared memory
@@ -240,17 +708,64 @@ class Bucket {
     if constexpr(!PARTIAL) {
       flags.SetBits(HERMES_BLOB_REPLACE);
     }
+    BlobReadCache *read_cache = GetReadCache(blob_id);
+    if (read_cache) {
+      // Keep our own reads off the cache until the blob_mdm has the put
+      read_cache->BeginPut(blob_id);
+      flags.SetBits(HERMES_READ_CACHE_PENDING);
+    }
+    // Puts which do not choose an eviction policy use the bucket's
+    Context *put_ctx = &ctx;
+    Context bkt_ctx;
+    if (ctx.evict_policy_ == EvictionPolicy::kNone &&
+        ctx_.evict_policy_ != EvictionPolicy::kNone) {
+      bkt_ctx = ctx;
+      bkt_ctx.evict_policy_ = ctx_.evict_policy_;
+      bkt_ctx.evict_ttl_ = ctx_.evict_ttl_;
+      put_ctx = &bkt_ctx;
+    }
+    if (ctx_.dedup_) {
+      flags.SetBits(HERMES_BLOB_DEDUP);
+    }
+    if (ctx_.checksum_) {
+      flags.SetBits(HERMES_BLOB_CHECKSUM);
+    }
+    if constexpr (!ASYNC) {
+      // Overwriting a deduplicated buffer needs space for a private copy,
+      // so wait to learn whether the put was applied
+      if (flags.Any(HERMES_BLOB_DEDUP) || ctx.dedup_) {
+        task_flags.UnsetBits(TASK_FIRE_AND_FORGET);
+      }
+    }
     LPointer<hrunpq::TypedPushTask<PutBlobTask>> push_task;
+    if (ASYNC && batch) {
+      blob_mdm_->AsyncPutBlobRootBatch(*batch, id_, blob_name_buf,
+                                       blob_id, blob_off, blob.size(),
+                                       p.shm_, ctx.blob_score_,
+                                       flags.bits_, *put_ctx,
+                                       task_flags.bits_);
+      return blob_id;
+    }
     push_task = blob_mdm_->AsyncPutBlobRoot(id_, blob_name_buf,
                                             blob_id, blob_off, blob.size(),
                                             p.shm_, ctx.blob_score_,
-                                            flags.bits_, ctx, task_flags.bits_);
+                                            flags.bits_, *put_ctx,
+                                            task_flags.bits_);
     if constexpr (!ASYNC) {
-      if (flags.Any(HERMES_GET_BLOB_ID)) {
+      if (!task_flags.Any(TASK_FIRE_AND_FORGET)) {
         push_task->Wait();
         PutBlobTask *task = push_task->get();
-        blob_id = task->blob_id_;
+        if (flags.Any(HERMES_GET_BLOB_ID)) {
+          blob_id = task->blob_id_;
+          CacheBlobId(shm, blob_name, blob_id);
+        }
+        int rc = task->rc_;
         HRUN_CLIENT->DelTask(push_task);
+        if (rc != 0) {
+          HELOG(kError, "Put of {} failed: {}",
+                blob_name, BLOB_NO_SPACE.Msg());
+          return BlobId::GetNull();
+        }
       }
     }
     return blob_id;
@@ -317,6 +832,17 @@ class Bucket {
     }
   }
 
+  /**
+   * AsyncPut \a blob_name Blob into the bucket as part of \a batch.
+   * The put is sent when the batch is submitted.
+   * */
+  void AsyncPut(TaskBatch &batch,
+                const std::string &blob_name,
+                const Blob &blob,
+                Context &ctx) {
+    BasePut<false, true>(blob_name, BlobId::GetNull(), blob, 0, ctx, &batch);
+  }
+
   /**
    * Put \a blob_id Blob into the bucket
    * */
@@ -374,6 +900,19 @@ class Bucket {
     BasePut<true, true>("", blob_id, blob, blob_off, ctx);
   }
 
+  /**
+   * AsyncPartialPut \a blob_name Blob into the bucket as part of \a batch.
+   * The put is sent when the batch is submitted.
+   * */
+  void AsyncPartialPut(TaskBatch &batch,
+                       const std::string &blob_name,
+                       const Blob &blob,
+                       size_t blob_off,
+                       Context &ctx) {
+    BasePut<true, true>(blob_name, BlobId::GetNull(), blob, blob_off, ctx,
+                        &batch);
+  }
+
   /**
    * Append \a blob_name Blob into the bucket (fully asynchronous)
    * */
@@ -424,6 +963,9 @@ class Bucket {
    * Get the current size of the blob in the bucket
    * */
   size_t GetBlobSize(const BlobId &blob_id) {
+    if (ec_) {
+      return EcGetBlobSize(EcGetBlobName(blob_id));
+    }
     return blob_mdm_->GetBlobSizeRoot(id_, hshm::charbuf(""), blob_id);
   }
 
@@ -431,6 +973,9 @@ class Bucket {
    * Get the current size of the blob in the bucket
    * */
   size_t GetBlobSize(const std::string &name) {
+    if (ec_) {
+      return EcGetBlobSize(name);
+    }
     return blob_mdm_->GetBlobSizeRoot(
         id_, hshm::charbuf(name), BlobId::GetNull());
   }
@@ -441,12 +986,17 @@ class Bucket {
   LPointer<hrunpq::TypedPushTask<GetBlobTask>>
   HSHM_ALWAYS_INLINE
   AsyncBaseGet(const std::string &blob_name,
-               const BlobId &blob_id,
+               const BlobId &orig_blob_id,
                Blob &blob,
                size_t blob_off,
                Context &ctx) {
     bitfield32_t flags;
     // Get the blob ID
+    BlobId blob_id = orig_blob_id;
+    if (blob_id.IsNull()) {
+      TagShm *shm;
+      blob_id = FindCachedBlobId(blob_name, shm);
+    }
     if (blob_id.IsNull()) {
       flags.SetBits(HERMES_GET_BLOB_ID);
     }
@@ -462,7 +1012,8 @@ class Bucket {
   }
 
   /**
-   * Get \a blob_id Blob from the bucket (sync)
+   * Get \a blob_id Blob from the bucket (sync). Returns a null id and an
+   * empty blob if the data failed checksum verification.
    * */
   BlobId BaseGet(const std::string &blob_name,
                  const BlobId &orig_blob_id,
@@ -470,19 +1021,52 @@ class Bucket {
                  size_t blob_off,
                  Context &ctx) {
     // TODO(llogan): intercept mmap to avoid copy
+    if (ec_) {
+      EcGet(orig_blob_id.IsNull() ? blob_name : EcGetBlobName(orig_blob_id),
+            blob, blob_off);
+      return BlobId::GetNull();
+    }
+    BlobId blob_id = orig_blob_id;
+    TagShm *shm = nullptr;
+    if (blob_id.IsNull()) {
+      blob_id = FindCachedBlobId(blob_name, shm);
+    }
+    BlobReadCache *read_cache = GetReadCache(blob_id);
+    if (read_cache) {
+      size_t cached_size;
+      if (blob.size() == 0 && read_cache->GetBlobSize(blob_id, cached_size)) {
+        blob.resize(cached_size > blob_off ? cached_size - blob_off : 0);
+      }
+      if (blob.size() > 0 &&
+          read_cache->Read(blob_id, blob_off, blob.data(), blob.size(),
+                           cached_size)) {
+        blob.resize(cached_size);
+        return blob_id;
+      }
+    }
     size_t data_size = blob.size();
     if (blob.size() == 0) {
       data_size = blob_mdm_->GetBlobSizeRoot(
-          id_, hshm::charbuf(blob_name), orig_blob_id);
+          id_, hshm::charbuf(blob_name), blob_id);
       blob.resize(data_size);
     }
     HILOG(kDebug, "Getting blob of size {}", data_size);
-    BlobId blob_id;
     LPointer<hrunpq::TypedPushTask<GetBlobTask>> push_task;
-    push_task = AsyncBaseGet(blob_name, orig_blob_id, blob, blob_off, ctx);
+    push_task = AsyncBaseGet(blob_name, blob_id, blob, blob_off, ctx);
     push_task->Wait();
     GetBlobTask *task = push_task->get();
-    blob_id = task->blob_id_;
+    if (blob_id.IsNull()) {
+      blob_id = task->blob_id_;
+      CacheBlobId(shm, blob_name, blob_id);
+    }
+    if (task->rc_ != 0) {
+      HELOG(kError, "Get of {} failed: {}",
+            blob_name, BLOB_CHECKSUM_MISMATCH.Msg());
+      blob.resize(0);
+      HRUN_CLIENT->FreeBuffer(task->data_);
+      HRUN_CLIENT->DelTask(push_task);
+      return BlobId::GetNull();
+    }
     char *data = HRUN_CLIENT->GetDataPointer(task->data_);
     memcpy(blob.data(), data, task->data_size_);
     blob.resize(task->data_size_);
@@ -491,6 +1075,419 @@ class Bucket {
     return blob_id;
   }
 
+  /**====================================
+   * Erasure Coding
+   * ===================================*/
+
+  /**
+   * The name of fragment \a idx of \a blob_name. Fragment i is placed on
+   * the i'th node after the node which owns \a blob_name, so a blob
+   * survives the loss of ec_parity_ nodes when there are at least
+   * ec_data_ + ec_parity_ nodes. Blob names are hashed to nodes, so a
+   * suffix is searched for which hashes to the desired node.
+   * */
+  std::string GetFragmentName(const std::string &blob_name, size_t idx) {
+    static const u32 kMaxSaltPerNode = 64;
+    u32 num_nodes = HRUN_CLIENT->GetNumNodes();
+    u32 home = HASH_TO_NODE_ID(
+        blob_mdm::HashBlobName(id_, hshm::to_charbuf(blob_name)));
+    u32 node_id = 1 + (home - 1 + idx) % num_nodes;
+    std::string base = blob_name + "#ec" + std::to_string(idx);
+    for (u32 salt = 0; salt < kMaxSaltPerNode * num_nodes; ++salt) {
+      std::string name = salt ? base + "." + std::to_string(salt) : base;
+      u32 hash = blob_mdm::HashBlobName(id_, hshm::to_charbuf(name));
+      if (HASH_TO_NODE_ID(hash) == node_id) {
+        return name;
+      }
+    }
+    return base;
+  }
+
+  /**
+   * Encode \a blob_name into fragments and put them to their nodes in
+   * parallel. Synchronous puts return the id of the blob once k
+   * fragments are stored; asynchronous puts return a null id.
+   *
+   * A partial put re-encodes the whole blob. It holds the blob's lock
+   * from the read until every fragment is stored, so partial puts to
+   * other ranges of the blob are not lost. It is synchronous even if
+   * \a ASYNC is set.
+   * */
+  template<bool PARTIAL, bool ASYNC>
+  BlobId EcPut(const std::string &blob_name,
+               const Blob &blob,
+               size_t blob_off,
+               Context &ctx) {
+    if constexpr (PARTIAL) {
+      hshm::charbuf lock_name = hshm::to_charbuf(blob_name);
+      blob_mdm_->LockBlobRoot(id_, lock_name);
+      Blob old_blob;
+      EcGet(blob_name, old_blob, 0);
+      Blob new_blob(std::max(old_blob.size(), blob_off + blob.size()));
+      memset(new_blob.data(), 0, new_blob.size());
+      memcpy(new_blob.data(), old_blob.data(), old_blob.size());
+      memcpy(new_blob.data() + blob_off, blob.data(), blob.size());
+      BlobId blob_id = EcPutStripe<false>(blob_name, new_blob, ctx,
+                                          ec_->GetNumFragments());
+      blob_mdm_->UnlockBlobRoot(id_, lock_name);
+      return blob_id;
+    } else {
+      return EcPutStripe<ASYNC>(blob_name, blob, ctx, ec_->k_);
+    }
+  }
+
+  /**
+   * Encode \a blob and put its fragments. Synchronous puts wait for
+   * \a needed fragments to be stored. The rest are left to EcStragglers.
+   * */
+  template<bool ASYNC>
+  BlobId EcPutStripe(const std::string &blob_name,
+                     const Blob &blob,
+                     Context &ctx,
+                     size_t needed) {
+    static std::atomic<u64> count(0);
+    const ReedSolomon &rs = *ec_;
+    size_t k = rs.k_, n = rs.GetNumFragments();
+    size_t frag_size = rs.GetFragmentSize(blob.size());
+    size_t frag_bytes = sizeof(ErasureFragmentHeader) + frag_size;
+    u64 stripe_id = ((u64)getpid() << 40) ^
+        (u64)std::chrono::steady_clock::now().time_since_epoch().count() ^
+        (count.fetch_add(1) << 20);
+    // Encode directly into shared memory
+    std::vector<LPointer<char>> bufs(n);
+    std::vector<const char*> data(k);
+    std::vector<char*> parity(n - k);
+    for (size_t i = 0; i < n; ++i) {
+      bufs[i] = HRUN_CLIENT->AllocateBufferClient(frag_bytes);
+      auto *hdr = reinterpret_cast<ErasureFragmentHeader*>(bufs[i].ptr_);
+      hdr->magic_ = ErasureFragmentHeader::kMagic;
+      hdr->k_ = (u16)k;
+      hdr->m_ = (u16)(n - k);
+      hdr->idx_ = (u32)i;
+      hdr->reserved_ = 0;
+      hdr->stripe_id_ = stripe_id;
+      hdr->blob_size_ = blob.size();
+      char *frag = bufs[i].ptr_ + sizeof(ErasureFragmentHeader);
+      if (i < k) {
+        size_t off = i * frag_size;
+        size_t size = off < blob.size() ?
+                      std::min(frag_size, blob.size() - off) : 0;
+        memcpy(frag, blob.data() + off, size);
+        memset(frag + size, 0, frag_size - size);
+        data[i] = frag;
+      } else {
+        parity[i - k] = frag;
+      }
+    }
+    rs.Encode(data, parity, frag_size);
+    // Put the fragments in parallel
+    bitfield32_t flags(HERMES_BLOB_REPLACE);
+    bitfield32_t task_flags(TASK_DATA_OWNER | TASK_LOW_LATENCY);
+    if constexpr (ASYNC) {
+      task_flags.SetBits(TASK_FIRE_AND_FORGET);
+    } else {
+      flags.SetBits(HERMES_GET_BLOB_ID);
+    }
+    std::vector<EcStragglers::PUT_T> tasks(n);
+    for (size_t i = 0; i < n; ++i) {
+      hshm::charbuf name = hshm::to_charbuf(GetFragmentName(blob_name, i));
+      tasks[i] = blob_mdm_->AsyncPutBlobRoot(
+          id_, name, BlobId::GetNull(), 0, frag_bytes, bufs[i].shm_,
+          ctx.blob_score_, flags.bits_, ctx, task_flags.bits_);
+    }
+    if constexpr (ASYNC) {
+      return BlobId::GetNull();
+    }
+    // Wait for the first fragments to be stored
+    EcStragglers::Get().Reap();
+    std::vector<bool> done(n, false);
+    size_t num_done = 0;
+    while (num_done < needed) {
+      for (size_t i = 0; i < n && num_done < needed; ++i) {
+        if (!done[i] && tasks[i]->IsComplete()) {
+          done[i] = true;
+          ++num_done;
+        }
+      }
+      if (num_done < needed) {
+        HERMES_THREAD_MODEL->Yield();
+      }
+    }
+    // The lowest fragment stored so far names the blob
+    BlobId blob_id = BlobId::GetNull();
+    for (size_t i = 0; i < n; ++i) {
+      if (!done[i]) {
+        EcStragglers::Get().Add(tasks[i]);
+        continue;
+      }
+      if (blob_id.IsNull()) {
+        blob_id = tasks[i]->get()->blob_id_;
+      }
+      HRUN_CLIENT->DelTask(tasks[i]);
+    }
+    return blob_id;
+  }
+
+  /**
+   * Probe the size of each fragment of \a blob_name. Returns the first
+   * non-zero size to arrive, or 0 if no fragment exists.
+   * */
+  size_t EcGetFragmentBytes(const std::vector<std::string> &names) {
+    size_t n = names.size();
+    std::vector<EcStragglers::SIZE_T> tasks(n);
+    for (size_t i = 0; i < n; ++i) {
+      tasks[i] = blob_mdm_->AsyncGetBlobSizeRoot(
+          id_, hshm::to_charbuf(names[i]), BlobId::GetNull());
+    }
+    std::vector<bool> done(n, false);
+    size_t num_done = 0, frag_bytes = 0;
+    while (frag_bytes == 0 && num_done < n) {
+      for (size_t i = 0; i < n && frag_bytes == 0; ++i) {
+        if (done[i] || !tasks[i]->IsComplete()) {
+          continue;
+        }
+        done[i] = true;
+        ++num_done;
+        frag_bytes = tasks[i]->get()->size_;
+      }
+      if (frag_bytes == 0 && num_done < n) {
+        HERMES_THREAD_MODEL->Yield();
+      }
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (done[i]) {
+        HRUN_CLIENT->DelTask(tasks[i]);
+      } else {
+        EcStragglers::Get().Add(tasks[i]);
+      }
+    }
+    return frag_bytes;
+  }
+
+  /**
+   * Read the fragments of \a blob_name which are \a frag_bytes long and
+   * decode them into \a full. Only the first k consistent fragments to
+   * arrive are used, and missing data fragments are rebuilt from parity.
+   * \a needed is set to the size of fragments written by a put of a
+   * different size, if one was seen, so the caller can retry.
+   * */
+  bool EcReadStripe(const std::vector<std::string> &names,
+                    size_t frag_bytes,
+                    std::vector<char> &full,
+                    size_t &needed) {
+    const ReedSolomon &rs = *ec_;
+    size_t k = rs.k_, n = rs.GetNumFragments();
+    size_t hdr_size = sizeof(ErasureFragmentHeader);
+    std::vector<EcStragglers::GET_T> tasks(n);
+    for (size_t i = 0; i < n; ++i) {
+      LPointer<char> p = HRUN_CLIENT->AllocateBufferClient(frag_bytes);
+      tasks[i] = blob_mdm_->AsyncGetBlobRoot(
+          id_, hshm::to_charbuf(names[i]), BlobId::GetNull(), 0,
+          frag_bytes, p.shm_, ctx_, HERMES_GET_BLOB_ID);
+    }
+    // Wait for k fragments of the same put
+    std::vector<const ErasureFragmentHeader*> hdrs(n, nullptr);
+    std::vector<bool> done(n, false);
+    std::unordered_map<u64, size_t> votes;
+    const ErasureFragmentHeader *winner = nullptr;
+    size_t num_done = 0;
+    needed = 0;
+    while (!winner && num_done < n) {
+      for (size_t i = 0; i < n && !winner; ++i) {
+        if (done[i] || !tasks[i]->IsComplete()) {
+          continue;
+        }
+        done[i] = true;
+        ++num_done;
+        GetBlobTask *task = tasks[i]->get();
+        auto *hdr = reinterpret_cast<const ErasureFragmentHeader*>(
+            HRUN_CLIENT->GetDataPointer(task->data_));
+        if (task->data_size_ < hdr_size || !hdr->Matches(k, n - k, i)) {
+          continue;
+        }
+        size_t hdr_bytes = hdr_size + rs.GetFragmentSize(hdr->blob_size_);
+        if (hdr_bytes != frag_bytes) {
+          needed = std::max(needed, hdr_bytes);
+          continue;
+        }
+        hdrs[i] = hdr;
+        if (++votes[hdr->stripe_id_] == k) {
+          winner = hdr;
+        }
+      }
+      if (!winner && num_done < n) {
+        HERMES_THREAD_MODEL->Yield();
+      }
+    }
+    // Decode the data fragments
+    if (winner) {
+      size_t frag_size = frag_bytes - hdr_size;
+      std::vector<const char*> frags(n, nullptr);
+      for (size_t i = 0; i < n; ++i) {
+        if (hdrs[i] && hdrs[i]->stripe_id_ == winner->stripe_id_) {
+          frags[i] = reinterpret_cast<const char*>(hdrs[i]) + hdr_size;
+        }
+      }
+      full.resize(k * frag_size);
+      std::vector<char*> out(k);
+      for (size_t j = 0; j < k; ++j) {
+        out[j] = full.data() + j * frag_size;
+      }
+      rs.Decode(frags, out, frag_size);
+      for (size_t j = 0; j < k; ++j) {
+        if (frags[j]) {
+          memcpy(out[j], frags[j], frag_size);
+        }
+      }
+      full.resize(winner->blob_size_);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (done[i]) {
+        HRUN_CLIENT->FreeBuffer(tasks[i]->get()->data_);
+        HRUN_CLIENT->DelTask(tasks[i]);
+      } else {
+        EcStragglers::Get().Add(tasks[i]);
+      }
+    }
+    return winner != nullptr;
+  }
+
+  /**
+   * Get \a blob_name from its fragments. Reads past the end of the blob
+   * are truncated, like BaseGet.
+   * */
+  void EcGet(const std::string &blob_name, Blob &blob, size_t blob_off) {
+    EcStragglers::Get().Reap();
+    std::vector<std::string> names(ec_->GetNumFragments());
+    for (size_t i = 0; i < names.size(); ++i) {
+      names[i] = GetFragmentName(blob_name, i);
+    }
+    // A put of a different size may race the probe, so retry once
+    std::vector<char> full;
+    size_t frag_bytes = EcGetFragmentBytes(names);
+    for (int attempt = 0; attempt < 2 && frag_bytes > 0; ++attempt) {
+      size_t needed;
+      if (EcReadStripe(names, frag_bytes, full, needed)) {
+        break;
+      }
+      if (needed == 0 || attempt == 1) {
+        HELOG(kError, "Fewer than {} fragments of {} could be read",
+              ec_->k_, blob_name);
+      }
+      frag_bytes = needed;
+    }
+    size_t size = full.size() > blob_off ? full.size() - blob_off : 0;
+    if (blob.size() > 0) {
+      size = std::min(size, blob.size());
+    } else {
+      blob.resize(size);
+    }
+    if (size) {
+      memcpy(blob.data(), full.data() + blob_off, size);
+    }
+    blob.resize(size);
+  }
+
+  /**
+   * Get the size of \a blob_name from the fragment headers. Like EcGet,
+   * the size is taken from the first k fragments of the same put to
+   * arrive. If no put has k fragments left, any readable header is used.
+   * */
+  size_t EcGetBlobSize(const std::string &blob_name) {
+    EcStragglers::Get().Reap();
+    const ReedSolomon &rs = *ec_;
+    size_t k = rs.k_, n = rs.GetNumFragments();
+    size_t hdr_size = sizeof(ErasureFragmentHeader);
+    std::vector<EcStragglers::GET_T> tasks(n);
+    for (size_t i = 0; i < n; ++i) {
+      LPointer<char> p = HRUN_CLIENT->AllocateBufferClient(hdr_size);
+      tasks[i] = blob_mdm_->AsyncGetBlobRoot(
+          id_, hshm::to_charbuf(GetFragmentName(blob_name, i)),
+          BlobId::GetNull(), 0, hdr_size, p.shm_, ctx_, HERMES_GET_BLOB_ID);
+    }
+    std::vector<bool> done(n, false);
+    std::unordered_map<u64, size_t> votes;
+    bool found = false, agreed = false;
+    size_t blob_size = 0, num_done = 0;
+    while (!agreed && num_done < n) {
+      for (size_t i = 0; i < n && !agreed; ++i) {
+        if (done[i] || !tasks[i]->IsComplete()) {
+          continue;
+        }
+        done[i] = true;
+        ++num_done;
+        GetBlobTask *task = tasks[i]->get();
+        auto *hdr = reinterpret_cast<const ErasureFragmentHeader*>(
+            HRUN_CLIENT->GetDataPointer(task->data_));
+        if (task->data_size_ != hdr_size || !hdr->Matches(k, n - k, i)) {
+          continue;
+        }
+        if (!found) {
+          found = true;
+          blob_size = hdr->blob_size_;
+        }
+        if (++votes[hdr->stripe_id_] == k) {
+          agreed = true;
+          blob_size = hdr->blob_size_;
+        }
+      }
+      if (!agreed && num_done < n) {
+        HERMES_THREAD_MODEL->Yield();
+      }
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (done[i]) {
+        HRUN_CLIENT->FreeBuffer(tasks[i]->get()->data_);
+        HRUN_CLIENT->DelTask(tasks[i]);
+      } else {
+        EcStragglers::Get().Add(tasks[i]);
+      }
+    }
+    return blob_size;
+  }
+
+  /** The id of the first fragment of \a blob_name which exists */
+  BlobId EcGetBlobId(const std::string &blob_name) {
+    for (size_t i = 0; i < ec_->GetNumFragments(); ++i) {
+      BlobId blob_id = blob_mdm_->GetBlobIdRoot(
+          id_, hshm::to_charbuf(GetFragmentName(blob_name, i)));
+      if (!blob_id.IsNull()) {
+        return blob_id;
+      }
+    }
+    return BlobId::GetNull();
+  }
+
+  /**
+   * The blobs of an erasure-coded bucket. Maps each blob name to its
+   * lowest stored fragment index and that fragment's id.
+   * */
+  std::map<std::string, std::pair<size_t, BlobId>> EcListBlobs() {
+    std::map<std::string, std::pair<size_t, BlobId>> blobs;
+    for (BlobId &frag_id : bkt_mdm_->GetContainedBlobIdsRoot(id_)) {
+      std::string name = blob_mdm_->GetBlobNameRoot(id_, frag_id);
+      size_t pos = name.rfind("#ec");
+      if (pos == std::string::npos) {
+        continue;
+      }
+      size_t idx = std::strtoul(name.c_str() + pos + 3, nullptr, 10);
+      auto it = blobs.find(name.substr(0, pos));
+      if (it == blobs.end()) {
+        blobs.emplace(name.substr(0, pos), std::make_pair(idx, frag_id));
+      } else if (idx < it->second.first) {
+        it->second = std::make_pair(idx, frag_id);
+      }
+    }
+    return blobs;
+  }
+
+  /** The name of the blob which \a blob_id is a fragment of */
+  std::string EcGetBlobName(const BlobId &blob_id) {
+    std::string name = blob_mdm_->GetBlobNameRoot(id_, blob_id);
+    size_t pos = name.rfind("#ec");
+    return pos == std::string::npos ? name : name.substr(0, pos);
+  }
+
   /**
    * Get \a blob_id Blob from the bucket (sync)
    * */
@@ -604,8 +1601,7 @@ class Bucket {
    * Determine if the bucket contains \a blob_id BLOB
    * */
   bool ContainsBlob(const std::string &blob_name) {
-    BlobId new_blob_id = blob_mdm_->GetBlobIdRoot(
-        id_, hshm::to_charbuf(blob_name));
+    BlobId new_blob_id = GetBlobId(blob_name);
     return !new_blob_id.IsNull();
   }
 
@@ -615,20 +1611,70 @@ class Bucket {
   void RenameBlob(const BlobId &blob_id,
                   std::string new_blob_name,
                   Context &ctx) {
+    if (ec_) {
+      // Fragments are placed by name, so they are encoded again
+      std::string blob_name = EcGetBlobName(blob_id);
+      Blob blob;
+      EcGet(blob_name, blob, 0);
+      EcPut<false, false>(new_blob_name, blob, 0, ctx);
+      DestroyBlob(blob_name, ctx);
+      return;
+    }
     blob_mdm_->RenameBlobRoot(id_, blob_id, hshm::to_charbuf(new_blob_name));
+    if (blob_id_cache_) {
+      blob_id_cache_->Clear();
+    }
   }
 
   /**
    * Delete \a blob_id blob
    * */
   void DestroyBlob(const BlobId &blob_id, Context &ctx) {
+    if (ec_) {
+      DestroyBlob(EcGetBlobName(blob_id), ctx);
+      return;
+    }
     blob_mdm_->DestroyBlobRoot(id_, blob_id);
+    if (blob_id_cache_) {
+      blob_id_cache_->Clear();
+    }
+  }
+
+  /**
+   * Delete \a blob_name blob
+   * */
+  void DestroyBlob(const std::string &blob_name, Context &ctx) {
+    if (!ec_) {
+      BlobId blob_id = GetBlobId(blob_name);
+      if (!blob_id.IsNull()) {
+        DestroyBlob(blob_id, ctx);
+      }
+      return;
+    }
+    for (size_t i = 0; i < ec_->GetNumFragments(); ++i) {
+      BlobId blob_id = blob_mdm_->GetBlobIdRoot(
+          id_, hshm::to_charbuf(GetFragmentName(blob_name, i)));
+      if (!blob_id.IsNull()) {
+        blob_mdm_->DestroyBlobRoot(id_, blob_id);
+      }
+    }
+    if (blob_id_cache_) {
+      blob_id_cache_->Clear();
+    }
   }
 
   /**
-   * Get the set of blob IDs contained in the bucket
+   * Get the set of blob IDs contained in the bucket. An erasure-coded
+   * blob is listed once, by the id GetBlobId returns for it.
    * */
   std::vector<BlobId> GetContainedBlobIds() {
+    if (ec_) {
+      std::vector<BlobId> blob_ids;
+      for (auto &blob : EcListBlobs()) {
+        blob_ids.emplace_back(blob.second.second);
+      }
+      return blob_ids;
+    }
     return bkt_mdm_->GetContainedBlobIdsRoot(id_);
   }
 };
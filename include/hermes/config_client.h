@@ -75,6 +75,66 @@ struct UserPathInfo {
   }
 };
 
+/**
+ * A prefix trie over the literal prefix (up to the first wildcard) of
+ * each tracked path. Finding the patterns which may match a path costs
+ * O(path length) instead of a regex per pattern.
+ * */
+class PathTrie {
+ public:
+  /** A node of the trie */
+  struct Node {
+    std::unordered_map<char, size_t> children_;  /**< Next char -> node */
+    std::vector<size_t> paths_;  /**< Patterns whose prefix ends here */
+  };
+  std::vector<Node> nodes_;  /**< The nodes, root at 0 */
+
+ public:
+  /** Default constructor */
+  PathTrie() : nodes_(1) {}
+
+  /** Index the literal prefixes of \a paths */
+  void Build(const std::vector<UserPathInfo> &paths) {
+    nodes_.clear();
+    nodes_.emplace_back();
+    for (size_t i = 0; i < paths.size(); ++i) {
+      const std::string &path = paths[i].path_;
+      size_t node_id = 0;
+      for (char c : path) {
+        if (c == '*') {
+          break;
+        }
+        auto iter = nodes_[node_id].children_.find(c);
+        if (iter == nodes_[node_id].children_.end()) {
+          nodes_[node_id].children_.emplace(c, nodes_.size());
+          node_id = nodes_.size();
+          nodes_.emplace_back();
+        } else {
+          node_id = iter->second;
+        }
+      }
+      nodes_[node_id].paths_.emplace_back(i);
+    }
+  }
+
+  /** Collect the patterns whose literal prefix is a prefix of \a path */
+  void Find(const std::string &path, std::vector<size_t> &matches) const {
+    size_t node_id = 0;
+    for (size_t i = 0; ; ++i) {
+      const Node &node = nodes_[node_id];
+      matches.insert(matches.end(), node.paths_.begin(), node.paths_.end());
+      if (i == path.size()) {
+        break;
+      }
+      auto iter = node.children_.find(path[i]);
+      if (iter == node.children_.end()) {
+        break;
+      }
+      node_id = iter->second;
+    }
+  }
+};
+
 /**
  * Configuration used to intialize client
  * */
@@ -84,8 +144,16 @@ class ClientConfig : public BaseConfig {
   bool stop_daemon_;
   /** The flushing mode to use */
   FlushingMode flushing_mode_;
+  /** How long a remote bucket's size may be cached (us) */
+  size_t bucket_size_lease_us_ = 0;
+  /** Page size of the HDF5 VFD's metadata bucket */
+  size_t vfd_meta_page_size_ = KILOBYTES(4);
+  /** Page size of HDF5 raw data, 0 uses the adapter page size */
+  size_t vfd_raw_page_size_ = 0;
   /** The set of paths to monitor or exclude, ordered by length */
   std::vector<UserPathInfo> path_list_;
+  /** Index over the prefixes of path_list_ */
+  PathTrie path_trie_;
   /** The default adapter config */
   AdapterObjectConfig base_adapter_config_;
   /** Per-object (e.g., file) adapter configuration */
@@ -128,6 +196,7 @@ class ClientConfig : public BaseConfig {
                    const UserPathInfo &b) {
                   return a.path_.size() > b.path_.size();
                 });
+      path_trie_.Build(path_list_);
     } catch (const std::exception &e) {
       HELOG(kError, "Error checking path: {}", e.what())
     }
@@ -153,6 +222,37 @@ class ClientConfig : public BaseConfig {
     return false;
   }
 
+  /**
+   * Whether the absolute path \a abs_path is tracked.
+   * The longest matching path in path_list_ decides.
+   * */
+  bool IsPathTracked(const std::string &abs_path) {
+    std::vector<size_t> matches;
+    path_trie_.Find(abs_path, matches);
+    // path_list_ is ordered by length, so lower indices take precedence
+    std::sort(matches.begin(), matches.end());
+    for (size_t idx : matches) {
+      UserPathInfo &pth = path_list_[idx];
+      bool is_match;
+      if (pth.path_.find('*') != std::string::npos) {
+        is_match = std::regex_match(abs_path, pth.regex_);
+      } else {
+        // The trie already verified that pth.path_ prefixes abs_path
+        is_match = pth.is_directory_ || abs_path.size() == pth.path_.size();
+      }
+      if (!is_match) {
+        continue;
+      }
+      if (abs_path == pth.path_ && pth.is_directory_) {
+        // Do not include if path is a tracked directory
+        return false;
+      }
+      return pth.include_;
+    }
+    // Assume it is excluded
+    return false;
+  }
+
  private:
   void ParseYAML(YAML::Node &yaml_conf) override {
     if (yaml_conf["stop_daemon"]) {
@@ -183,6 +283,32 @@ class ClientConfig : public BaseConfig {
             hshm::ConfigParse::ParseSize(page_size_env);
       }
     }
+    if (yaml_conf["file_write_buffer_size"]) {
+      std::string wbuf_env = GetEnvSafe(Constant::kHermesWriteBufferSize);
+      if (wbuf_env.size() == 0) {
+        base_adapter_config_.write_buffer_size_ =
+            hshm::ConfigParse::ParseSize(
+                yaml_conf["file_write_buffer_size"].as<std::string>());
+      } else {
+        base_adapter_config_.write_buffer_size_ =
+            hshm::ConfigParse::ParseSize(wbuf_env);
+      }
+    }
+    if (yaml_conf["file_write_buffer_flush_ms"]) {
+      base_adapter_config_.write_buffer_flush_ms_ =
+          yaml_conf["file_write_buffer_flush_ms"].as<size_t>();
+    }
+    if (yaml_conf["bucket_size_lease_us"]) {
+      bucket_size_lease_us_ = yaml_conf["bucket_size_lease_us"].as<size_t>();
+    }
+    if (yaml_conf["vfd_meta_page_size"]) {
+      vfd_meta_page_size_ = hshm::ConfigParse::ParseSize(
+          yaml_conf["vfd_meta_page_size"].as<std::string>());
+    }
+    if (yaml_conf["vfd_raw_page_size"]) {
+      vfd_raw_page_size_ = hshm::ConfigParse::ParseSize(
+          yaml_conf["vfd_raw_page_size"].as<std::string>());
+    }
     if (yaml_conf["path_inclusions"]) {
       std::vector<std::string> inclusions;
       ParseVector<std::string>(yaml_conf["path_inclusions"], inclusions);
@@ -230,6 +356,14 @@ class ClientConfig : public BaseConfig {
         conf.page_size_ = hshm::ConfigParse::ParseSize(
             yaml_conf["page_size"].as<std::string>());
       }
+      if (yaml_conf["write_buffer_size"]) {
+        conf.write_buffer_size_ = hshm::ConfigParse::ParseSize(
+            yaml_conf["write_buffer_size"].as<std::string>());
+      }
+      if (yaml_conf["write_buffer_flush_ms"]) {
+        conf.write_buffer_flush_ms_ =
+            yaml_conf["write_buffer_flush_ms"].as<size_t>();
+      }
       SetAdapterConfig(path, conf);
     } catch (const std::exception &e) {
       HELOG(kError, "Error checking path: {}", e.what())
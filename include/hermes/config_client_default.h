@@ -5,6 +5,19 @@ const inline char* kHermesClientDefaultConfigStr =
 "path_inclusions: [\"/tmp/test_hermes/*\"]\n"
 "path_exclusions: [\"/*\"]\n"
 "file_page_size: 1024KB\n"
+"# Coalesce small writes to an open file before sending them to Hermes.\n"
+"# 0 disables the buffer. Dirty data older than the flush interval is\n"
+"# flushed on the next I/O to the file.\n"
+"file_write_buffer_size: 0\n"
+"file_write_buffer_flush_ms: 100\n"
+"# Buckets owned by another node cache their size for this long (us).\n"
+"# Buckets on this node always read the size from shared memory.\n"
+"bucket_size_lease_us: 1000\n"
+"# The HDF5 VFD keeps file metadata (superblock, object headers, B-trees)\n"
+"# in a separate bucket with small pages and a pinned score. Raw dataset\n"
+"# data uses vfd_raw_page_size pages (0 uses the file's page size).\n"
+"vfd_meta_page_size: 4KB\n"
+"vfd_raw_page_size: 4MB\n"
 "base_adapter_mode: kDefault\n"
 "flushing_mode: kAsync\n"
 "file_adapter_configs:\n"
@@ -25,7 +25,17 @@ struct DeviceInfo; /** Forward declaration of DeviceInfo */
  * */
 enum class IoInterface {
   kRam,
-  kPosix
+  kPosix,
+  kMmap
+};
+
+/**
+ * How writes to a memory-mapped device are made durable
+ * */
+enum class MmapDurability {
+  kNone,   /**< Left to the kernel's write back */
+  kMsync,  /**< msync after each write */
+  kClwb    /**< Write back the CPU caches, for DAX mappings */
 };
 
 /**
@@ -54,6 +64,8 @@ struct DeviceInfo {
   bool is_shared_;
   /** BORG's minimum and maximum capacity threshold for device */
   f32 borg_min_thresh_, borg_max_thresh_;
+  /** How writes are made durable, for the mmap interface */
+  MmapDurability durability_;
 };
 
 /**
@@ -105,6 +117,80 @@ struct BorgInfo {
   float freq_min_;
 };
 
+/**
+ * Data stager information defined in server config
+ * */
+struct StagerInfo {
+  /** The maximum number of open backend files per node */
+  size_t max_open_fds_;
+  /** The maximum number of stage-outs coalesced into one write */
+  size_t max_batch_size_;
+};
+
+/**
+ * Node-local blob read cache information in server config
+ * */
+struct ReadCacheInfo {
+  /** Whether the blob_mdm keeps a read cache in shared memory */
+  bool enabled_ = false;
+  /** The bytes of blob data the cache holds */
+  size_t capacity_ = MEGABYTES(64);
+  /** The largest blob which is cached */
+  size_t max_blob_size_ = KILOBYTES(64);
+  /** The number of blobs per hash set */
+  u32 ways_ = 8;
+};
+
+/**
+ * The share and rate limits of one QoS tenant in server config
+ * */
+struct QosTenantInfo {
+  /** A bucket name, or a name given in Context::qos_tenant_ */
+  std::string name_;
+  /** Share of each scheduling round, relative to other tenants */
+  float weight_ = 1;
+  /** Bytes started per second, 0 for unlimited */
+  size_t max_bw_ = 0;
+  /** Tasks started per second, 0 for unlimited */
+  size_t max_ops_ = 0;
+};
+
+/**
+ * Quality of service between tenants in server config
+ * */
+struct QosInfo {
+  /** Whether workers schedule tenants with deficit round robin */
+  bool enabled_ = false;
+  /** Bytes a tenant of weight 1 may start per scheduling round */
+  size_t quantum_ = MEGABYTES(1);
+  /** Tenants with a non-default share or limits */
+  std::vector<QosTenantInfo> tenants_;
+};
+
+/**
+ * Eviction information in server config
+ * */
+struct EvictionInfo {
+  /** The policy of buckets which do not choose one */
+  EvictionPolicy default_policy_ = EvictionPolicy::kNone;
+  /** Interval (ms) where targets are checked for eviction */
+  size_t period_ms_ = 100;
+  /** Evict once used space passes this fraction of a target's max thresh */
+  float high_watermark_ = .95;
+  /** Evict until used space is under this fraction of its max thresh */
+  float low_watermark_ = .85;
+};
+
+/**
+ * Deduplication information in server config
+ * */
+struct DedupInfo {
+  /** Buffers smaller than this are never shared */
+  size_t min_size_ = KILOBYTES(4);
+  /** Compare the bytes of buffers with matching fingerprints */
+  bool verify_ = false;
+};
+
 /**
  * Prefetcher information in server config
  * */
@@ -153,6 +239,21 @@ class ServerConfig : public BaseConfig {
   /** Buffer organizer (BORG) information */
   BorgInfo borg_;
 
+  /** Data stager information */
+  StagerInfo stager_;
+
+  /** Blob read cache information */
+  ReadCacheInfo read_cache_;
+
+  /** Quality of service information */
+  QosInfo qos_;
+
+  /** Eviction information */
+  EvictionInfo eviction_;
+
+  /** Deduplication information */
+  DedupInfo dedup_;
+
   /** Tracing information */
   TracingInfo tracing_;
 
@@ -189,6 +290,21 @@ class ServerConfig : public BaseConfig {
     if (yaml_conf["buffer_organizer"]) {
       ParseBorgInfo(yaml_conf["buffer_organizer"]);
     }
+    if (yaml_conf["data_stager"]) {
+      ParseStagerInfo(yaml_conf["data_stager"]);
+    }
+    if (yaml_conf["read_cache"]) {
+      ParseReadCacheInfo(yaml_conf["read_cache"]);
+    }
+    if (yaml_conf["qos"]) {
+      ParseQosInfo(yaml_conf["qos"]);
+    }
+    if (yaml_conf["eviction"]) {
+      ParseEvictionInfo(yaml_conf["eviction"]);
+    }
+    if (yaml_conf["dedup"]) {
+      ParseDedupInfo(yaml_conf["dedup"]);
+    }
     if (yaml_conf["tracing"]) {
       ParseTracingInfo(yaml_conf["tracing"]);
     }
@@ -218,6 +334,33 @@ class ServerConfig : public BaseConfig {
       dev.dev_name_ = device.first.as<std::string>();
       dev.mount_dir_ = hshm::ConfigParse::ExpandPath(
           dev_info["mount_point"].as<std::string>());
+      dev.io_api_ = dev.mount_dir_.empty() ?
+          IoInterface::kRam : IoInterface::kPosix;
+      if (dev_info["io_api"]) {
+        std::string io_api = dev_info["io_api"].as<std::string>();
+        if (io_api == "ram") {
+          dev.io_api_ = IoInterface::kRam;
+        } else if (io_api == "posix") {
+          dev.io_api_ = IoInterface::kPosix;
+        } else if (io_api == "mmap") {
+          dev.io_api_ = IoInterface::kMmap;
+        } else {
+          HELOG(kFatal, "Unknown io_api {} for device {}",
+                io_api, dev.dev_name_);
+        }
+      }
+      dev.durability_ = MmapDurability::kNone;
+      if (dev_info["durability"]) {
+        std::string durability = dev_info["durability"].as<std::string>();
+        if (durability == "msync") {
+          dev.durability_ = MmapDurability::kMsync;
+        } else if (durability == "clwb") {
+          dev.durability_ = MmapDurability::kClwb;
+        } else if (durability != "none") {
+          HELOG(kFatal, "Unknown durability {} for device {}",
+                durability, dev.dev_name_);
+        }
+      }
       dev.borg_min_thresh_ =
           dev_info["borg_capacity_thresh"][0].as<float>();
       dev.borg_max_thresh_ =
@@ -281,6 +424,89 @@ class ServerConfig : public BaseConfig {
     }
   }
 
+  /** parse data stager information from YAML config */
+  void ParseStagerInfo(YAML::Node yaml_conf) {
+    if (yaml_conf["max_open_fds"]) {
+      stager_.max_open_fds_ = yaml_conf["max_open_fds"].as<size_t>();
+    }
+    if (yaml_conf["max_batch_size"]) {
+      stager_.max_batch_size_ = yaml_conf["max_batch_size"].as<size_t>();
+    }
+  }
+
+  /** parse blob read cache information from YAML config */
+  void ParseReadCacheInfo(YAML::Node yaml_conf) {
+    if (yaml_conf["enabled"]) {
+      read_cache_.enabled_ = yaml_conf["enabled"].as<bool>();
+    }
+    if (yaml_conf["capacity"]) {
+      read_cache_.capacity_ = hshm::ConfigParse::ParseSize(
+          yaml_conf["capacity"].as<std::string>());
+    }
+    if (yaml_conf["max_blob_size"]) {
+      read_cache_.max_blob_size_ = hshm::ConfigParse::ParseSize(
+          yaml_conf["max_blob_size"].as<std::string>());
+    }
+    if (yaml_conf["ways"]) {
+      read_cache_.ways_ = yaml_conf["ways"].as<u32>();
+    }
+  }
+
+  /** parse eviction information from YAML config */
+  void ParseEvictionInfo(YAML::Node yaml_conf) {
+    if (yaml_conf["default_policy"]) {
+      eviction_.default_policy_ = EvictionPolicyConv::to_enum(
+          yaml_conf["default_policy"].as<std::string>());
+    }
+    if (yaml_conf["period"]) {
+      eviction_.period_ms_ = yaml_conf["period"].as<size_t>();
+    }
+    if (yaml_conf["watermarks"]) {
+      eviction_.low_watermark_ = yaml_conf["watermarks"][0].as<float>();
+      eviction_.high_watermark_ = yaml_conf["watermarks"][1].as<float>();
+    }
+  }
+
+  /** parse deduplication information from YAML config */
+  void ParseDedupInfo(YAML::Node yaml_conf) {
+    if (yaml_conf["min_size"]) {
+      dedup_.min_size_ = hshm::ConfigParse::ParseSize(
+          yaml_conf["min_size"].as<std::string>());
+    }
+    if (yaml_conf["verify"]) {
+      dedup_.verify_ = yaml_conf["verify"].as<bool>();
+    }
+  }
+
+  /** parse QoS information from YAML config */
+  void ParseQosInfo(YAML::Node yaml_conf) {
+    if (yaml_conf["enabled"]) {
+      qos_.enabled_ = yaml_conf["enabled"].as<bool>();
+    }
+    if (yaml_conf["quantum"]) {
+      qos_.quantum_ = hshm::ConfigParse::ParseSize(
+          yaml_conf["quantum"].as<std::string>());
+    }
+    if (yaml_conf["tenants"]) {
+      qos_.tenants_.clear();
+      for (YAML::Node tenant_conf : yaml_conf["tenants"]) {
+        QosTenantInfo tenant;
+        tenant.name_ = tenant_conf["name"].as<std::string>();
+        if (tenant_conf["weight"]) {
+          tenant.weight_ = tenant_conf["weight"].as<float>();
+        }
+        if (tenant_conf["max_bandwidth"]) {
+          tenant.max_bw_ = hshm::ConfigParse::ParseSize(
+              tenant_conf["max_bandwidth"].as<std::string>());
+        }
+        if (tenant_conf["max_ops"]) {
+          tenant.max_ops_ = tenant_conf["max_ops"].as<size_t>();
+        }
+        qos_.tenants_.emplace_back(tenant);
+      }
+    }
+  }
+
   /** parse I/O tracing information from YAML config */
   void ParsePrefetchInfo(YAML::Node yaml_conf) {
     if (yaml_conf["enabled"]) {
@@ -339,6 +565,8 @@ class ServerConfig : public BaseConfig {
 namespace hermes {
 using config::ServerConfig;
 using config::DeviceInfo;
+using config::IoInterface;
+using config::MmapDurability;
 }  // namespace hermes
 
 #endif  // HERMES_SRC_CONFIG_SERVER_H_
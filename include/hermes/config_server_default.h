@@ -49,6 +49,16 @@ const inline char* kHermesServerDefaultConfigStr =
 "    # that the device is always at least 30% occupied.\n"
 "    borg_capacity_thresh: [0.0, 1.0]\n"
 "\n"
+"    # The I/O interface of the device: ram, posix or mmap. Defaults to ram if\n"
+"    # the mount point is empty and posix otherwise. mmap maps a file in the\n"
+"    # mount point, e.g., on a DAX file system for persistent memory, or on\n"
+"    # tmpfs or hugetlbfs. Its slab layout is kept across restarts.\n"
+"    # io_api: mmap\n"
+"\n"
+"    # How writes to an mmap device are made durable: none, msync, or clwb to\n"
+"    # write back the CPU caches, for persistent memory mapped with DAX.\n"
+"    # durability: none\n"
+"\n"
 "  nvme:\n"
 "    mount_point: \"./\"\n"
 "    capacity: 100MB\n"
@@ -102,6 +112,75 @@ const inline char* kHermesServerDefaultConfigStr =
 "  # Number of accesses for score to be equal to 0 (count)\n"
 "  freq_min: 0\n"
 "\n"
+"### Define properties of the data stager\n"
+"data_stager:\n"
+"  # The maximum number of backend files kept open by the stagers of a node.\n"
+"  # Files beyond this limit are closed in least-recently-used order.\n"
+"  max_open_fds: 256\n"
+"\n"
+"  # The maximum number of stage-outs to the same file which are coalesced\n"
+"  # into a single offset-sorted vectored write.\n"
+"  max_batch_size: 64\n"
+"\n"
+"### Define the node-local blob read cache\n"
+"read_cache:\n"
+"  # Keep small, recently read blobs in shared memory, where clients on the\n"
+"  # node can read them without submitting a task.\n"
+"  enabled: false\n"
+"\n"
+"  # The amount of blob data the cache holds per node.\n"
+"  capacity: 64MB\n"
+"\n"
+"  # Blobs larger than this are never cached.\n"
+"  max_blob_size: 64KB\n"
+"\n"
+"  # The number of blobs in each hash set. Sets are replaced with CLOCK.\n"
+"  ways: 8\n"
+"\n"
+"### Define quality of service between tenants\n"
+"qos:\n"
+"  # Schedule tasks with deficit round robin across tenants. The tasks of a\n"
+"  # bucket are charged to the bucket, unless the client names a tenant in\n"
+"  # Context::qos_tenant_.\n"
+"  enabled: false\n"
+"\n"
+"  # The bytes of tasks a tenant of weight 1 may start per scheduling round.\n"
+"  quantum: 1MB\n"
+"\n"
+"  # Shares and rate limits by bucket or tenant name. Tenants which are not\n"
+"  # listed have weight 1 and no limits. For example:\n"
+"  # - name: \"checkpoint\"\n"
+"  #   weight: 1\n"
+"  #   max_bandwidth: 1GB\n"
+"  #   max_ops: 0\n"
+"  tenants: []\n"
+"\n"
+"### Define how blobs are evicted from full targets\n"
+"eviction:\n"
+"  # The policy of buckets which do not choose one in their Context.\n"
+"  # Choose LRU, LFU, ARC, TTL, or None to never evict.\n"
+"  default_policy: \"None\"\n"
+"\n"
+"  # Interval (ms) where targets are checked for eviction\n"
+"  period: 100\n"
+"\n"
+"  # The [low, high] watermarks of each target, as fractions of the maximum\n"
+"  # of its borg_capacity_thresh. Once the used space of a target passes the\n"
+"  # high watermark, its coldest blobs are demoted to a slower target, or\n"
+"  # dropped from the slowest target if they can be flushed to a backend,\n"
+"  # until the used space is under the low watermark.\n"
+"  watermarks: [0.85, 0.95]\n"
+"\n"
+"### Define content-addressed deduplication for buckets which enable it\n"
+"dedup:\n"
+"  # Buffers smaller than this are never shared, since their index entry\n"
+"  # would cost more memory than sharing saves.\n"
+"  min_size: 4KB\n"
+"\n"
+"  # Compare the bytes of a buffer with a matching fingerprint before\n"
+"  # sharing it, rather than trusting the 128-bit fingerprint.\n"
+"  verify: false\n"
+"\n"
 "### Define the default data placement policy\n"
 "dpe:\n"
 "  # Choose Random, RoundRobin, or MinimizeIoTime\n"
@@ -195,6 +274,7 @@ const inline char* kHermesServerDefaultConfigStr =
 "  \'hermes_data_op\',\n"
 "  \'data_stager\',\n"
 "  \'posix_bdev\',\n"
-"  \'ram_bdev\'\n"
+"  \'ram_bdev\',\n"
+"  \'mmap_bdev\'\n"
 "]\n";
 #endif  // HRUN_SRC_CONFIG_HERMES_SERVER_DEFAULT_H_
\ No newline at end of file
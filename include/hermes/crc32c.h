@@ -0,0 +1,336 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef HERMES_INCLUDE_HERMES_CRC32C_H_
+#define HERMES_INCLUDE_HERMES_CRC32C_H_
+
+#include <cstdint>
+#include <cstring>
+#include "hermes/hermes_types.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define HERMES_CRC32C_X86
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define HERMES_CRC32C_ARM
+#endif
+
+namespace hermes {
+
+/**
+ * CRC32C (Castagnoli), as used by iSCSI, ext4 and NVMe.
+ *
+ * Uses the SSE4.2 crc32 instruction when the CPU has it, and the ARMv8
+ * CRC instructions when compiled for them. Otherwise, tables are used
+ * eight bytes at a time. The instruction has a latency of three cycles,
+ * so long inputs are split into three streams which are checksummed in
+ * parallel and combined, as described by Mark Adler at
+ * https://stackoverflow.com/a/17646775.
+ *
+ * Copy() checksums the data while copying it, so a buffer is only read
+ * once.
+ * */
+class Crc32c {
+ public:
+  static const u32 kPoly = 0x82f63b78;       /**< Reflected polynomial */
+  static const size_t kLong = 8192;          /**< Bytes per long stream */
+  static const size_t kShort = 256;          /**< Bytes per short stream */
+
+  u32 table_[8][256];        /**< Slicing-by-8 tables */
+  u32 long_[4][256];         /**< Shift a CRC by kLong zero bytes */
+  u32 short_[4][256];        /**< Shift a CRC by kShort zero bytes */
+  bool hw_;                  /**< Whether the CPU has crc instructions */
+
+ public:
+  /** The tables are built once per process */
+  static const Crc32c& Get() {
+    static Crc32c crc;
+    return crc;
+  }
+
+  /** Extend \a crc with \a size bytes of \a data */
+  static u32 Compute(const char *data, size_t size, u32 crc = 0) {
+    return Get().Run<false>(nullptr, data, size, crc);
+  }
+
+  /** Copy \a size bytes from \a src to \a dst and extend \a crc with them */
+  static u32 Copy(char *dst, const char *src, size_t size, u32 crc = 0) {
+    return Get().Run<true>(dst, src, size, crc);
+  }
+
+  /**
+   * The CRC of A followed by B, given the CRCs of A and B and the
+   * length of B.
+   * */
+  static u32 Combine(u32 crc_a, u32 crc_b, size_t size_b) {
+    if (size_b == 0) {
+      return crc_a;
+    }
+    // Apply size_b zero bytes to crc_a by squaring the zero-bit operator
+    u32 even[32], odd[32];
+    odd[0] = kPoly;
+    u32 row = 1;
+    for (int n = 1; n < 32; ++n) {
+      odd[n] = row;
+      row <<= 1;
+    }
+    MatrixSquare(even, odd);   // 2 zero bits
+    MatrixSquare(odd, even);   // 4 zero bits
+    do {
+      MatrixSquare(even, odd);
+      if (size_b & 1) {
+        crc_a = MatrixTimes(even, crc_a);
+      }
+      size_b >>= 1;
+      if (size_b == 0) {
+        break;
+      }
+      MatrixSquare(odd, even);
+      if (size_b & 1) {
+        crc_a = MatrixTimes(odd, crc_a);
+      }
+      size_b >>= 1;
+    } while (size_b);
+    return crc_a ^ crc_b;
+  }
+
+  /** Whether the crc instructions are used */
+  static bool IsHardware() {
+    return Get().hw_;
+  }
+
+  /** Checksum, and copy to \a dst if COPY */
+  template<bool COPY>
+  u32 Run(char *dst, const char *src, size_t size, u32 crc) const {
+#if defined(HERMES_CRC32C_X86) || defined(HERMES_CRC32C_ARM)
+    if (hw_) {
+      return RunHw<COPY>(dst, src, size, crc);
+    }
+#endif
+    return RunSw<COPY>(dst, src, size, crc);
+  }
+
+  /** Checksum with the slicing-by-8 tables */
+  template<bool COPY>
+  u32 RunSw(char *dst, const char *src, size_t size, u32 crc) const {
+    u64 crc0 = crc ^ 0xffffffff;
+    const char *end = src + size;
+    while (src + 8 <= end) {
+      u64 word = Load(src);
+      if constexpr (COPY) {
+        Store(dst, word);
+        dst += 8;
+      }
+      word ^= crc0;
+      crc0 = table_[7][word & 0xff] ^
+             table_[6][(word >> 8) & 0xff] ^
+             table_[5][(word >> 16) & 0xff] ^
+             table_[4][(word >> 24) & 0xff] ^
+             table_[3][(word >> 32) & 0xff] ^
+             table_[2][(word >> 40) & 0xff] ^
+             table_[1][(word >> 48) & 0xff] ^
+             table_[0][word >> 56];
+      src += 8;
+    }
+    for (; src < end; ++src) {
+      if constexpr (COPY) {
+        *(dst++) = *src;
+      }
+      crc0 = table_[0][(crc0 ^ (u8)*src) & 0xff] ^ (crc0 >> 8);
+    }
+    return (u32)crc0 ^ 0xffffffff;
+  }
+
+ private:
+  /** Build the tables */
+  Crc32c() {
+    for (u32 n = 0; n < 256; ++n) {
+      u32 crc = n;
+      for (int k = 0; k < 8; ++k) {
+        crc = (crc & 1) ? (crc >> 1) ^ kPoly : crc >> 1;
+      }
+      table_[0][n] = crc;
+    }
+    for (u32 n = 0; n < 256; ++n) {
+      u32 crc = table_[0][n];
+      for (int k = 1; k < 8; ++k) {
+        crc = table_[0][crc & 0xff] ^ (crc >> 8);
+        table_[k][n] = crc;
+      }
+    }
+    ShiftTables(long_, kLong);
+    ShiftTables(short_, kShort);
+#if defined(HERMES_CRC32C_X86)
+    __builtin_cpu_init();
+    hw_ = __builtin_cpu_supports("sse4.2");
+#elif defined(HERMES_CRC32C_ARM)
+    hw_ = true;
+#else
+    hw_ = false;
+#endif
+  }
+
+#if defined(HERMES_CRC32C_X86) || defined(HERMES_CRC32C_ARM)
+  /** Checksum with the crc instructions, in three streams */
+  template<bool COPY>
+#if defined(HERMES_CRC32C_X86)
+  __attribute__((target("sse4.2")))
+#endif
+  u32 RunHw(char *dst, const char *src, size_t size, u32 crc) const {
+    u64 crc0 = crc ^ 0xffffffff;
+    const char *end = src + size;
+    const size_t kStreams[2] = {kLong, kShort};
+    const u32 (*kShifts[2])[256] = {long_, short_};
+    for (int s = 0; s < 2; ++s) {
+      size_t len = kStreams[s];
+      while (src + 3 * len <= end) {
+        u64 crc1 = 0, crc2 = 0;
+        const char *stream_end = src + len;
+        do {
+          // Copy with wide stores, which are cheaper than one per word
+          if constexpr (COPY) {
+            memcpy(dst, src, 32);
+            memcpy(dst + len, src + len, 32);
+            memcpy(dst + 2 * len, src + 2 * len, 32);
+            dst += 32;
+          }
+          for (int i = 0; i < 32; i += 8) {
+            crc0 = HwWord(crc0, Load(src + i));
+            crc1 = HwWord(crc1, Load(src + len + i));
+            crc2 = HwWord(crc2, Load(src + 2 * len + i));
+          }
+          src += 32;
+        } while (src < stream_end);
+        crc0 = Shift(kShifts[s], (u32)crc0) ^ crc1;
+        crc0 = Shift(kShifts[s], (u32)crc0) ^ crc2;
+        src += 2 * len;
+        if constexpr (COPY) {
+          dst += 2 * len;
+        }
+      }
+    }
+    while (src + 8 <= end) {
+      u64 word = Load(src);
+      if constexpr (COPY) {
+        Store(dst, word);
+        dst += 8;
+      }
+      crc0 = HwWord(crc0, word);
+      src += 8;
+    }
+    for (; src < end; ++src) {
+      if constexpr (COPY) {
+        *(dst++) = *src;
+      }
+      crc0 = HwByte(crc0, (u8)*src);
+    }
+    return (u32)crc0 ^ 0xffffffff;
+  }
+
+  /** One crc instruction on eight bytes */
+#if defined(HERMES_CRC32C_X86)
+  __attribute__((target("sse4.2")))
+  static u64 HwWord(u64 crc, u64 word) {
+    return _mm_crc32_u64(crc, word);
+  }
+  __attribute__((target("sse4.2")))
+  static u64 HwByte(u64 crc, u8 byte) {
+    return _mm_crc32_u8((u32)crc, byte);
+  }
+#else
+  static u64 HwWord(u64 crc, u64 word) {
+    return __crc32cd((u32)crc, word);
+  }
+  static u64 HwByte(u64 crc, u8 byte) {
+    return __crc32cb((u32)crc, byte);
+  }
+#endif
+#endif
+
+  /** Apply the zeros operator of \a zeros to \a crc */
+  static u32 Shift(const u32 zeros[][256], u32 crc) {
+    return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^
+           zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+  }
+
+  /** Build the tables which apply \a len zero bytes to a CRC */
+  static void ShiftTables(u32 zeros[][256], size_t len) {
+    u32 op[32];
+    ZerosOperator(op, len);
+    for (u32 n = 0; n < 256; ++n) {
+      zeros[0][n] = MatrixTimes(op, n);
+      zeros[1][n] = MatrixTimes(op, n << 8);
+      zeros[2][n] = MatrixTimes(op, n << 16);
+      zeros[3][n] = MatrixTimes(op, n << 24);
+    }
+  }
+
+  /** The operator which applies \a len zero bytes, a power of two */
+  static void ZerosOperator(u32 *even, size_t len) {
+    u32 odd[32];
+    odd[0] = kPoly;
+    u32 row = 1;
+    for (int n = 1; n < 32; ++n) {
+      odd[n] = row;
+      row <<= 1;
+    }
+    MatrixSquare(even, odd);   // 2 zero bits
+    MatrixSquare(odd, even);   // 4 zero bits
+    // The first square gives one zero byte
+    do {
+      MatrixSquare(even, odd);
+      len >>= 1;
+      if (len == 0) {
+        return;
+      }
+      MatrixSquare(odd, even);
+      len >>= 1;
+    } while (len);
+    memcpy(even, odd, sizeof(odd));
+  }
+
+  /** Multiply a 32x32 matrix over GF(2) by a vector */
+  static u32 MatrixTimes(const u32 *mat, u32 vec) {
+    u32 sum = 0;
+    while (vec) {
+      if (vec & 1) {
+        sum ^= *mat;
+      }
+      vec >>= 1;
+      ++mat;
+    }
+    return sum;
+  }
+
+  /** square = mat * mat */
+  static void MatrixSquare(u32 *square, const u32 *mat) {
+    for (int n = 0; n < 32; ++n) {
+      square[n] = MatrixTimes(mat, mat[n]);
+    }
+  }
+
+  static u64 Load(const char *p) {
+    u64 x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+  }
+
+  static void Store(char *p, u64 x) {
+    memcpy(p, &x, sizeof(x));
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_CRC32C_H_
@@ -0,0 +1,297 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef HERMES_INCLUDE_HERMES_DEDUP_INDEX_H_
+#define HERMES_INCLUDE_HERMES_DEDUP_INDEX_H_
+
+#include <cstring>
+#include <unordered_map>
+#include "hermes/hermes_types.h"
+
+namespace hermes {
+
+/**
+ * XXH64 (https://github.com/Cyan4973/xxHash), which is fast enough to run
+ * on every buffer of a put.
+ * */
+class Xxh64 {
+ public:
+  static const u64 kPrime1 = 0x9E3779B185EBCA87ULL;
+  static const u64 kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+  static const u64 kPrime3 = 0x165667B19E3779F9ULL;
+  static const u64 kPrime4 = 0x85EBCA77C2B2AE63ULL;
+  static const u64 kPrime5 = 0x27D4EB2F165667C5ULL;
+
+ public:
+  /** Hash \a size bytes of \a data */
+  static u64 Hash(const char *data, size_t size, u64 seed) {
+    const char *p = data;
+    const char *end = data + size;
+    u64 h;
+    if (size >= 32) {
+      u64 v1 = seed + kPrime1 + kPrime2;
+      u64 v2 = seed + kPrime2;
+      u64 v3 = seed;
+      u64 v4 = seed - kPrime1;
+      do {
+        v1 = Round(v1, Read64(p));
+        v2 = Round(v2, Read64(p + 8));
+        v3 = Round(v3, Read64(p + 16));
+        v4 = Round(v4, Read64(p + 24));
+        p += 32;
+      } while (p + 32 <= end);
+      h = Rotl(v1, 1) + Rotl(v2, 7) + Rotl(v3, 12) + Rotl(v4, 18);
+      h = Merge(h, v1);
+      h = Merge(h, v2);
+      h = Merge(h, v3);
+      h = Merge(h, v4);
+    } else {
+      h = seed + kPrime5;
+    }
+    h += size;
+    for (; p + 8 <= end; p += 8) {
+      h ^= Round(0, Read64(p));
+      h = Rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+      h ^= (u64)Read32(p) * kPrime1;
+      h = Rotl(h, 23) * kPrime2 + kPrime3;
+      p += 4;
+    }
+    for (; p < end; ++p) {
+      h ^= (u64)(u8)(*p) * kPrime5;
+      h = Rotl(h, 11) * kPrime1;
+    }
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+  }
+
+ private:
+  static u64 Rotl(u64 x, int r) {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  static u64 Round(u64 acc, u64 input) {
+    acc += input * kPrime2;
+    acc = Rotl(acc, 31);
+    return acc * kPrime1;
+  }
+
+  static u64 Merge(u64 acc, u64 val) {
+    acc ^= Round(0, val);
+    return acc * kPrime1 + kPrime4;
+  }
+
+  static u64 Read64(const char *p) {
+    u64 x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+  }
+
+  static u32 Read32(const char *p) {
+    u32 x;
+    memcpy(&x, p, sizeof(x));
+    return x;
+  }
+};
+
+/**
+ * The fingerprint of \a size bytes of buffer contents. Two XXH64 hashes
+ * with independent seeds, so accidental matches need a 128-bit collision.
+ * Never null.
+ * */
+static inline BufferFingerprint FingerprintBuffer(const char *data,
+                                                  size_t size) {
+  BufferFingerprint fp(Xxh64::Hash(data, size, size),
+                       Xxh64::Hash(data, size, ~size));
+  if (fp.IsNull()) {
+    fp.lo_ = 1;
+  }
+  return fp;
+}
+
+/** The deduplication statistics of a target */
+struct DedupStats {
+  size_t entries_ = 0;     /**< Distinct buffers in the index */
+  size_t physical_ = 0;    /**< Bytes of the buffers in the index */
+  size_t logical_ = 0;     /**< Bytes of blobs stored in those buffers */
+};
+
+/**
+ * The fingerprints of the shared buffers of the targets of a node.
+ *
+ * Each entry is a buffer and the number of blob buffers which reference
+ * it. A buffer is only shared with puts to the same target and with the
+ * same slab size, so deduplication never moves data between tiers or
+ * changes the layout of a blob. Shared buffers are never written: a put
+ * to a shared buffer first takes a private copy (copy-on-write).
+ *
+ * The index is shared by the lanes of the blob_mdm and locks each call.
+ * */
+class DedupIndex {
+ public:
+  /** A fingerprint on a target */
+  struct Key {
+    TargetId tid_;
+    BufferFingerprint fp_;
+
+    bool operator==(const Key &other) const {
+      return tid_ == other.tid_ && fp_ == other.fp_;
+    }
+  };
+
+  /** Hash of a key */
+  struct KeyHash {
+    size_t operator()(const Key &key) const {
+      return std::hash<TargetId>{}(key.tid_) ^ key.fp_.lo_;
+    }
+  };
+
+  /** A shared buffer */
+  struct Entry {
+    BufferInfo buf_;   /**< The buffer, with its fingerprint */
+    size_t len_;       /**< Bytes of the buffer which were fingerprinted */
+    size_t refcnt_;    /**< Blob buffers which reference it */
+  };
+
+  /** Approximate bytes of memory per entry */
+  static const size_t kEntryBytes =
+      sizeof(std::pair<const Key, Entry>) + 2 * sizeof(void*);
+
+  Mutex lock_;
+  std::unordered_map<Key, Entry, KeyHash> map_;
+  std::unordered_map<TargetId, DedupStats> stats_;
+
+ public:
+  /**
+   * Find a shared buffer on target \a tid with the fingerprint \a fp of
+   * \a len bytes and of \a t_size bytes. On success, the buffer is
+   * referenced by the caller and copied to \a buf.
+   * */
+  bool Find(const TargetId &tid, const BufferFingerprint &fp,
+            size_t t_size, size_t len, BufferInfo &buf) {
+    hshm::ScopedMutex lock(lock_, 0);
+    auto it = map_.find(Key{tid, fp});
+    if (it == map_.end()) {
+      return false;
+    }
+    Entry &entry = it->second;
+    if (entry.buf_.t_size_ != t_size || entry.len_ != len) {
+      return false;
+    }
+    entry.refcnt_ += 1;
+    stats_[tid].logical_ += t_size;
+    buf = entry.buf_;
+    return true;
+  }
+
+  /**
+   * Share \a buf, which holds \a len bytes fingerprinted as buf.fp_ and
+   * is referenced by the caller. Returns false if another buffer is
+   * already shared with that fingerprint.
+   * */
+  bool Insert(const BufferInfo &buf, size_t len) {
+    hshm::ScopedMutex lock(lock_, 0);
+    auto ret = map_.emplace(Key{buf.tid_, buf.fp_}, Entry{buf, len, 1});
+    if (!ret.second) {
+      return false;
+    }
+    DedupStats &stats = stats_[buf.tid_];
+    stats.entries_ += 1;
+    stats.physical_ += buf.t_size_;
+    stats.logical_ += buf.t_size_;
+    return true;
+  }
+
+  /**
+   * Drop the caller's reference to \a buf. Returns true if the caller
+   * should free the buffer: it was not shared, or this was the last
+   * reference.
+   * */
+  bool Release(const BufferInfo &buf) {
+    if (buf.fp_.IsNull()) {
+      return true;
+    }
+    hshm::ScopedMutex lock(lock_, 0);
+    auto it = map_.find(Key{buf.tid_, buf.fp_});
+    if (it == map_.end() || it->second.buf_.t_off_ != buf.t_off_) {
+      return true;
+    }
+    DedupStats &stats = stats_[buf.tid_];
+    stats.logical_ -= buf.t_size_;
+    if (--it->second.refcnt_ > 0) {
+      return false;
+    }
+    stats.entries_ -= 1;
+    stats.physical_ -= buf.t_size_;
+    map_.erase(it);
+    return true;
+  }
+
+  /**
+   * Whether blob buffers other than the caller's reference \a buf, so
+   * dropping the caller's reference would not free it.
+   * */
+  bool IsShared(const BufferInfo &buf) {
+    if (buf.fp_.IsNull()) {
+      return false;
+    }
+    hshm::ScopedMutex lock(lock_, 0);
+    auto it = map_.find(Key{buf.tid_, buf.fp_});
+    return it != map_.end() && it->second.buf_.t_off_ == buf.t_off_ &&
+        it->second.refcnt_ > 1;
+  }
+
+  /**
+   * Make \a buf private to the caller if it holds the only reference.
+   * Returns false if other blobs still reference the buffer, in which
+   * case it must be copied before it is modified.
+   * */
+  bool TryUnshare(BufferInfo &buf) {
+    if (buf.fp_.IsNull()) {
+      return true;
+    }
+    hshm::ScopedMutex lock(lock_, 0);
+    auto it = map_.find(Key{buf.tid_, buf.fp_});
+    if (it != map_.end() && it->second.buf_.t_off_ == buf.t_off_) {
+      if (it->second.refcnt_ > 1) {
+        return false;
+      }
+      DedupStats &stats = stats_[buf.tid_];
+      stats.entries_ -= 1;
+      stats.physical_ -= buf.t_size_;
+      stats.logical_ -= buf.t_size_;
+      map_.erase(it);
+    }
+    buf.fp_.SetNull();
+    return true;
+  }
+
+  /** The statistics of target \a tid */
+  DedupStats GetStats(const TargetId &tid) {
+    hshm::ScopedMutex lock(lock_, 0);
+    auto it = stats_.find(tid);
+    if (it == stats_.end()) {
+      return DedupStats();
+    }
+    return it->second;
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_DEDUP_INDEX_H_
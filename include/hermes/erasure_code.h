@@ -0,0 +1,260 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_ERASURE_CODE_H_
+#define HERMES_INCLUDE_HERMES_ERASURE_CODE_H_
+
+#include <cstring>
+#include <vector>
+#include "hermes/hermes_types.h"
+
+namespace hermes {
+
+/** Arithmetic in GF(2^8) with the polynomial x^8 + x^4 + x^3 + x^2 + 1 */
+class GaloisField {
+ public:
+  u8 exp_[512];         /**< 2^i, doubled so products need no modulo */
+  u8 log_[256];         /**< log_2(x) for x != 0 */
+  u8 mul_[256][256];    /**< Full multiplication table */
+
+ public:
+  /** The tables are built once per process */
+  static const GaloisField& Get() {
+    static GaloisField gf;
+    return gf;
+  }
+
+  /** a * b */
+  u8 Mul(u8 a, u8 b) const {
+    return mul_[a][b];
+  }
+
+  /** 1 / a, for a != 0 */
+  u8 Inv(u8 a) const {
+    return exp_[255 - log_[a]];
+  }
+
+ private:
+  /** Build the tables */
+  GaloisField() {
+    u32 x = 1;
+    for (int i = 0; i < 255; ++i) {
+      exp_[i] = (u8)x;
+      exp_[i + 255] = (u8)x;
+      log_[x] = (u8)i;
+      x <<= 1;
+      if (x & 0x100) {
+        x ^= 0x11d;
+      }
+    }
+    exp_[510] = exp_[0];
+    exp_[511] = exp_[1];
+    log_[0] = 0;
+    for (int a = 0; a < 256; ++a) {
+      for (int b = 0; b < 256; ++b) {
+        mul_[a][b] = (a && b) ? exp_[log_[a] + log_[b]] : 0;
+      }
+    }
+  }
+};
+
+/**
+ * A systematic Reed-Solomon code with k data and m parity fragments.
+ *
+ * The encode matrix is the k x k identity stacked on an m x k Cauchy
+ * matrix, so every k x k submatrix is invertible: any k of the k + m
+ * fragments recover the data. Fragments are the k equal slices of the
+ * input, padded with zeros.
+ * */
+class ReedSolomon {
+ public:
+  static const size_t kMaxFragments = 256;
+
+  size_t k_;                 /**< Number of data fragments */
+  size_t m_;                 /**< Number of parity fragments */
+  std::vector<u8> matrix_;   /**< (k + m) x k encode matrix, row-major */
+
+ public:
+  /** Construct a k + m code. Requires k >= 1 and k + m <= 256. */
+  ReedSolomon(size_t k, size_t m) : k_(k), m_(m), matrix_((k + m) * k, 0) {
+    const GaloisField &gf = GaloisField::Get();
+    for (size_t i = 0; i < k_; ++i) {
+      matrix_[i * k_ + i] = 1;
+    }
+    for (size_t i = 0; i < m_; ++i) {
+      for (size_t j = 0; j < k_; ++j) {
+        matrix_[(k_ + i) * k_ + j] = gf.Inv((u8)((k_ + i) ^ j));
+      }
+    }
+  }
+
+  /** The total number of fragments */
+  size_t GetNumFragments() const {
+    return k_ + m_;
+  }
+
+  /** The size of each fragment of a \a size byte buffer */
+  size_t GetFragmentSize(size_t size) const {
+    return (size + k_ - 1) / k_;
+  }
+
+  /**
+   * Compute the m parity fragments from the k data fragments.
+   * Every fragment is \a frag_size bytes.
+   * */
+  void Encode(const std::vector<const char*> &data,
+              const std::vector<char*> &parity,
+              size_t frag_size) const {
+    for (size_t i = 0; i < m_; ++i) {
+      memset(parity[i], 0, frag_size);
+      for (size_t j = 0; j < k_; ++j) {
+        MulAdd(matrix_[(k_ + i) * k_ + j], data[j], parity[i], frag_size);
+      }
+    }
+  }
+
+  /**
+   * Rebuild the data fragments which are missing. \a frags holds the
+   * k + m fragments, where missing ones are null, and \a out holds a buffer
+   * of \a frag_size bytes for each missing data fragment. Data fragments
+   * which are present are left alone. Returns false if fewer than k
+   * fragments are present.
+   * */
+  bool Decode(const std::vector<const char*> &frags,
+              const std::vector<char*> &out,
+              size_t frag_size) const {
+    // Select the first k fragments which are present
+    std::vector<size_t> rows;
+    for (size_t i = 0; i < k_ + m_ && rows.size() < k_; ++i) {
+      if (frags[i]) {
+        rows.emplace_back(i);
+      }
+    }
+    if (rows.size() < k_) {
+      return false;
+    }
+    bool all_data = true;
+    for (size_t j = 0; j < k_; ++j) {
+      all_data &= frags[j] != nullptr;
+    }
+    if (all_data) {
+      return true;
+    }
+    // Invert the rows of the encode matrix for the selected fragments
+    std::vector<u8> sub(k_ * k_);
+    for (size_t r = 0; r < k_; ++r) {
+      memcpy(&sub[r * k_], &matrix_[rows[r] * k_], k_);
+    }
+    std::vector<u8> inv;
+    if (!Invert(sub, inv)) {
+      return false;
+    }
+    // Data fragment j is row j of the inverse times the selected fragments
+    for (size_t j = 0; j < k_; ++j) {
+      if (frags[j]) {
+        continue;
+      }
+      char *dst = out[j];
+      memset(dst, 0, frag_size);
+      for (size_t r = 0; r < k_; ++r) {
+        MulAdd(inv[j * k_ + r], frags[rows[r]], dst, frag_size);
+      }
+    }
+    return true;
+  }
+
+ private:
+  /** dst ^= c * src */
+  static void MulAdd(u8 c, const char *src, char *dst, size_t size) {
+    if (c == 0) {
+      return;
+    }
+    const u8 *s = reinterpret_cast<const u8*>(src);
+    u8 *d = reinterpret_cast<u8*>(dst);
+    if (c == 1) {
+      for (size_t i = 0; i < size; ++i) {
+        d[i] ^= s[i];
+      }
+      return;
+    }
+    const u8 *row = GaloisField::Get().mul_[c];
+    for (size_t i = 0; i < size; ++i) {
+      d[i] ^= row[s[i]];
+    }
+  }
+
+  /** Invert the k x k matrix \a a with Gauss-Jordan elimination */
+  bool Invert(std::vector<u8> a, std::vector<u8> &inv) const {
+    const GaloisField &gf = GaloisField::Get();
+    size_t n = k_;
+    inv.assign(n * n, 0);
+    for (size_t i = 0; i < n; ++i) {
+      inv[i * n + i] = 1;
+    }
+    for (size_t col = 0; col < n; ++col) {
+      size_t pivot = col;
+      while (pivot < n && a[pivot * n + col] == 0) {
+        ++pivot;
+      }
+      if (pivot == n) {
+        return false;
+      }
+      if (pivot != col) {
+        for (size_t j = 0; j < n; ++j) {
+          std::swap(a[pivot * n + j], a[col * n + j]);
+          std::swap(inv[pivot * n + j], inv[col * n + j]);
+        }
+      }
+      u8 scale = gf.Inv(a[col * n + col]);
+      for (size_t j = 0; j < n; ++j) {
+        a[col * n + j] = gf.Mul(a[col * n + j], scale);
+        inv[col * n + j] = gf.Mul(inv[col * n + j], scale);
+      }
+      for (size_t r = 0; r < n; ++r) {
+        u8 f = a[r * n + col];
+        if (r == col || f == 0) {
+          continue;
+        }
+        for (size_t j = 0; j < n; ++j) {
+          a[r * n + j] ^= gf.Mul(f, a[col * n + j]);
+          inv[r * n + j] ^= gf.Mul(f, inv[col * n + j]);
+        }
+      }
+    }
+    return true;
+  }
+};
+
+/**
+ * The header at the start of each fragment blob of an erasure-coded blob.
+ * Fragments are only combined if they come from the same put.
+ * */
+struct ErasureFragmentHeader {
+  static const u32 kMagic = 0x45435246;  /**< "ECRF" */
+
+  u32 magic_;       /**< kMagic */
+  u16 k_;           /**< Number of data fragments */
+  u16 m_;           /**< Number of parity fragments */
+  u32 idx_;         /**< Index of this fragment */
+  u32 reserved_;    /**< Padding */
+  u64 stripe_id_;   /**< Unique to the put which wrote the fragment */
+  u64 blob_size_;   /**< Size of the encoded blob */
+
+  /** Whether this header is fragment \a idx of a k + m code */
+  bool Matches(size_t k, size_t m, size_t idx) const {
+    return magic_ == kMagic && k_ == k && m_ == m && idx_ == idx;
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_ERASURE_CODE_H_
@@ -0,0 +1,179 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_EVICTION_ARC_H_
+#define HERMES_INCLUDE_HERMES_EVICTION_ARC_H_
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+
+#include "evictor.h"
+
+namespace hermes {
+
+/**
+ A class to represent an adaptive replacement (ARC) eviction policy.
+
+ Resident blobs seen once are in T1 and blobs seen again are in T2. Evicted
+ blobs are remembered in the ghost lists B1 and B2. An access to a ghost
+ moves the target size of T1, p, towards the list which would have kept it,
+ so the policy adapts between recency and frequency. The cache size of ARC
+ is the number of resident blobs.
+
+ An evicted blob gets a new BlobId when it is put or staged in again, so
+ entries are keyed by a hash of the blob's tag and name.
+*/
+class Arc : public Evictor {
+ public:
+  /** The lists of ARC */
+  enum {
+    kT1 = 0,  /**< Resident, accessed once */
+    kT2 = 1,  /**< Resident, accessed more than once */
+    kB1 = 2,  /**< Evicted from T1 */
+    kB2 = 3,  /**< Evicted from T2 */
+    kNumLists
+  };
+
+  /** A blob in one of the lists */
+  struct Node {
+    size_t key_;       /**< Hash of the tag and name */
+    BlobId blob_id_;   /**< The id while resident */
+  };
+
+  /** The list of a blob and its place in it */
+  struct Entry {
+    int list_;
+    std::list<Node>::iterator it_;
+  };
+
+  std::list<Node> lists_[kNumLists];           /**< LRU at front */
+  std::unordered_map<size_t, Entry> index_;    /**< Key -> entry */
+  std::unordered_map<BlobId, size_t> keys_;    /**< Resident blob -> key */
+  double p_ = 0;                               /**< Target size of T1 */
+
+ public:
+  /** Move the blob to T2, or insert it in T1 */
+  void Touch(const BlobInfo &blob_info, bool write) override {
+    const BlobId &blob_id = blob_info.blob_id_;
+    size_t key = GetKey(blob_info);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      Insert(key, blob_id, kT1);
+      return;
+    }
+    Entry &entry = it->second;
+    double b1 = (double)lists_[kB1].size();
+    double b2 = (double)lists_[kB2].size();
+    if (entry.list_ == kB1) {
+      p_ = std::min(p_ + std::max(b2 / b1, 1.0), (double)GetCacheSize());
+    } else if (entry.list_ == kB2) {
+      p_ = std::max(p_ - std::max(b1 / b2, 1.0), 0.0);
+    }
+    entry.it_->blob_id_ = blob_id;
+    keys_[blob_id] = key;
+    Move(entry, kT2);
+  }
+
+  /** Remove the blob and its ghost */
+  void Erase(const BlobId &blob_id) override {
+    auto key_it = keys_.find(blob_id);
+    if (key_it == keys_.end()) {
+      return;
+    }
+    auto it = index_.find(key_it->second);
+    lists_[it->second.list_].erase(it->second.it_);
+    index_.erase(it);
+    keys_.erase(key_it);
+  }
+
+  /** Remember the evicted blob in a ghost list */
+  void Evict(const BlobId &blob_id) override {
+    auto key_it = keys_.find(blob_id);
+    if (key_it == keys_.end()) {
+      return;
+    }
+    Entry &entry = index_[key_it->second];
+    keys_.erase(key_it);
+    if (entry.list_ == kT1) {
+      Move(entry, kB1);
+    } else if (entry.list_ == kT2) {
+      Move(entry, kB2);
+    }
+    // Ghosts are bounded by the cache size
+    size_t max_ghosts = std::max(GetCacheSize(), (size_t)1);
+    for (int list : {kB1, kB2}) {
+      while (lists_[list].size() > max_ghosts) {
+        index_.erase(lists_[list].front().key_);
+        lists_[list].pop_front();
+      }
+    }
+  }
+
+  /** The blobs ARC would replace next, in order */
+  void GetVictims(size_t count, std::vector<BlobId> &victims) override {
+    auto t1 = lists_[kT1].begin();
+    auto t2 = lists_[kT2].begin();
+    size_t t1_size = lists_[kT1].size();
+    while (count) {
+      if (t1_size > 0 &&
+          (t1_size > p_ || t2 == lists_[kT2].end())) {
+        victims.emplace_back(t1->blob_id_);
+        ++t1;
+        --t1_size;
+      } else if (t2 != lists_[kT2].end()) {
+        victims.emplace_back(t2->blob_id_);
+        ++t2;
+      } else {
+        break;
+      }
+      --count;
+    }
+  }
+
+  /** The number of resident blobs tracked */
+  size_t size() const override {
+    return GetCacheSize();
+  }
+
+ private:
+  /** The number of resident blobs */
+  size_t GetCacheSize() const {
+    return lists_[kT1].size() + lists_[kT2].size();
+  }
+
+  /** The key of a blob, which outlives its BlobId */
+  static size_t GetKey(const BlobInfo &blob_info) {
+    size_t h1 = std::hash<TagId>{}(blob_info.tag_id_);
+    size_t h2 = std::hash<hshm::charbuf>{}(blob_info.name_);
+    return h1 ^ (h2 + 0x9e3779b97f4a7c15ULL + (h1 << 6) + (h1 >> 2));
+  }
+
+  /** Add a blob at the back of \a list */
+  void Insert(size_t key, const BlobId &blob_id, int list) {
+    Entry entry;
+    entry.list_ = list;
+    entry.it_ = lists_[list].insert(lists_[list].end(), Node{key, blob_id});
+    index_.emplace(key, entry);
+    keys_.emplace(blob_id, key);
+  }
+
+  /** Move a blob to the back of \a list */
+  void Move(Entry &entry, int list) {
+    lists_[list].splice(lists_[list].end(), lists_[entry.list_], entry.it_);
+    entry.list_ = list;
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_EVICTION_ARC_H_
@@ -0,0 +1,63 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_EVICTION_EVICTOR_H_
+#define HERMES_INCLUDE_HERMES_EVICTION_EVICTOR_H_
+
+#include <vector>
+
+#include "hermes/hermes_types.h"
+
+namespace hermes {
+
+/**
+ A class to represent an eviction policy.
+
+ An evictor tracks the blobs of one blob_mdm lane which use its policy and
+ orders them from coldest to hottest. It only orders blobs: the blob_mdm
+ decides whether a victim is demoted or dropped.
+*/
+class Evictor {
+ public:
+  /** Constructor. */
+  Evictor() = default;
+
+  /** Destructor. */
+  virtual ~Evictor() = default;
+
+  /** Record an access to a blob. \a write is true for puts. */
+  virtual void Touch(const BlobInfo &blob_info, bool write) = 0;
+
+  /** Stop tracking \a blob_id because it was destroyed */
+  virtual void Erase(const BlobId &blob_id) = 0;
+
+  /** Stop tracking \a blob_id because it was evicted */
+  virtual void Evict(const BlobId &blob_id) {
+    Erase(blob_id);
+  }
+
+  /** Append up to \a count tracked blobs to \a victims, coldest first */
+  virtual void GetVictims(size_t count, std::vector<BlobId> &victims) = 0;
+
+  /** Append the blobs which must be dropped regardless of capacity */
+  virtual void GetExpired(std::vector<BlobId> &expired) {}
+
+  /** Stop reporting \a blob_id as expired until its next put */
+  virtual void Retain(const BlobId &blob_id) {}
+
+  /** The number of blobs tracked */
+  virtual size_t size() const = 0;
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_EVICTION_EVICTOR_H_
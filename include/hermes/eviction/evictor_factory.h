@@ -0,0 +1,161 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_EVICTION_EVICTOR_FACTORY_H_
+#define HERMES_INCLUDE_HERMES_EVICTION_EVICTOR_FACTORY_H_
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+#include "arc.h"
+#include "evictor.h"
+#include "lfu.h"
+#include "lru.h"
+#include "ttl.h"
+
+namespace hermes {
+
+/**
+ A class to represent Evictor Factory
+*/
+class EvictorFactory {
+ public:
+  /**
+   * Create an evictor for \a type eviction policy.
+   * Returns null for EvictionPolicy::kNone.
+   * */
+  static std::unique_ptr<Evictor> Create(EvictionPolicy type) {
+    switch (type) {
+      case EvictionPolicy::kLru: {
+        return std::make_unique<Lru>();
+      }
+      case EvictionPolicy::kLfu: {
+        return std::make_unique<Lfu>();
+      }
+      case EvictionPolicy::kArc: {
+        return std::make_unique<Arc>();
+      }
+      case EvictionPolicy::kTtl: {
+        return std::make_unique<Ttl>();
+      }
+      default: {
+        return nullptr;
+      }
+    }
+  }
+};
+
+/**
+ The eviction order of the blobs of one blob_mdm lane. Each blob is tracked
+ by the evictor of its policy, and victims are taken from every policy in
+ turn.
+*/
+class EvictionIndex {
+ public:
+  static const int kNumPolicies = (int)EvictionPolicy::kNone;
+  std::unique_ptr<Evictor> evictors_[kNumPolicies];  /**< Created on use */
+  std::unordered_map<BlobId, EvictionPolicy> policies_;  /**< Blob -> policy */
+
+ public:
+  /** Record an access to a blob under its current policy */
+  void Touch(const BlobInfo &blob_info, bool write) {
+    const BlobId &blob_id = blob_info.blob_id_;
+    EvictionPolicy policy = blob_info.evict_policy_;
+    auto it = policies_.find(blob_id);
+    if (it != policies_.end() && it->second != policy) {
+      evictors_[(int)it->second]->Erase(blob_id);
+      policies_.erase(it);
+    }
+    if (policy == EvictionPolicy::kNone) {
+      return;
+    }
+    std::unique_ptr<Evictor> &evictor = evictors_[(int)policy];
+    if (!evictor) {
+      evictor = EvictorFactory::Create(policy);
+    }
+    policies_[blob_id] = policy;
+    evictor->Touch(blob_info, write);
+  }
+
+  /** Stop tracking a blob which was destroyed */
+  void Erase(const BlobId &blob_id) {
+    auto it = policies_.find(blob_id);
+    if (it == policies_.end()) {
+      return;
+    }
+    evictors_[(int)it->second]->Erase(blob_id);
+    policies_.erase(it);
+  }
+
+  /** Stop tracking a blob which was evicted */
+  void Evict(const BlobId &blob_id) {
+    auto it = policies_.find(blob_id);
+    if (it == policies_.end()) {
+      return;
+    }
+    evictors_[(int)it->second]->Evict(blob_id);
+    policies_.erase(it);
+  }
+
+  /** The blobs which must be dropped regardless of capacity */
+  void GetExpired(std::vector<BlobId> &expired) {
+    for (std::unique_ptr<Evictor> &evictor : evictors_) {
+      if (evictor) {
+        evictor->GetExpired(expired);
+      }
+    }
+  }
+
+  /** Stop reporting an expired blob which cannot be dropped */
+  void Retain(const BlobId &blob_id) {
+    auto it = policies_.find(blob_id);
+    if (it == policies_.end()) {
+      return;
+    }
+    evictors_[(int)it->second]->Retain(blob_id);
+  }
+
+  /**
+   * Up to \a count blobs in eviction order, interleaving the coldest
+   * blobs of each policy
+   * */
+  void GetVictims(size_t count, std::vector<BlobId> &victims) {
+    std::vector<BlobId> per_policy[kNumPolicies];
+    size_t total = 0;
+    for (int i = 0; i < kNumPolicies; ++i) {
+      if (evictors_[i]) {
+        evictors_[i]->GetVictims(count, per_policy[i]);
+        total += per_policy[i].size();
+      }
+    }
+    total = std::min(total, count);
+    victims.reserve(victims.size() + total);
+    for (size_t off = 0; total; ++off) {
+      for (int i = 0; i < kNumPolicies && total; ++i) {
+        if (off < per_policy[i].size()) {
+          victims.emplace_back(per_policy[i][off]);
+          --total;
+        }
+      }
+    }
+  }
+
+  /** The number of blobs tracked */
+  size_t size() const {
+    return policies_.size();
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_EVICTION_EVICTOR_FACTORY_H_
@@ -0,0 +1,77 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_EVICTION_LFU_H_
+#define HERMES_INCLUDE_HERMES_EVICTION_LFU_H_
+
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "evictor.h"
+
+namespace hermes {
+
+/**
+ A class to represent an eviction policy which evicts the least frequently
+ used blob first. Blobs with equal counts are evicted least recently used
+ first.
+*/
+class Lfu : public Evictor {
+ public:
+  /** (access count, access sequence number) */
+  typedef std::pair<u64, u64> KEY_T;
+  std::map<KEY_T, BlobId> order_;             /**< Coldest first */
+  std::unordered_map<BlobId, KEY_T> index_;   /**< Blob -> key in order_ */
+  u64 seq_ = 0;                               /**< Sequence of accesses */
+
+ public:
+  /** Increment the blob's count */
+  void Touch(const BlobInfo &blob_info, bool write) override {
+    KEY_T key(1, ++seq_);
+    auto it = index_.find(blob_info.blob_id_);
+    if (it != index_.end()) {
+      key.first = it->second.first + 1;
+      order_.erase(it->second);
+      it->second = key;
+    } else {
+      index_.emplace(blob_info.blob_id_, key);
+    }
+    order_.emplace(key, blob_info.blob_id_);
+  }
+
+  /** Remove the blob */
+  void Erase(const BlobId &blob_id) override {
+    auto it = index_.find(blob_id);
+    if (it == index_.end()) {
+      return;
+    }
+    order_.erase(it->second);
+    index_.erase(it);
+  }
+
+  /** The blobs with the lowest counts */
+  void GetVictims(size_t count, std::vector<BlobId> &victims) override {
+    for (auto it = order_.begin(); it != order_.end() && count; ++it, --count) {
+      victims.emplace_back(it->second);
+    }
+  }
+
+  /** The number of blobs tracked */
+  size_t size() const override {
+    return index_.size();
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_EVICTION_LFU_H_
@@ -0,0 +1,70 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_EVICTION_LRU_H_
+#define HERMES_INCLUDE_HERMES_EVICTION_LRU_H_
+
+#include <list>
+#include <unordered_map>
+
+#include "evictor.h"
+
+namespace hermes {
+
+/**
+ A class to represent an eviction policy which evicts the least recently
+ used blob first.
+*/
+class Lru : public Evictor {
+ public:
+  typedef std::list<BlobId>::iterator ITER_T;
+  std::list<BlobId> order_;                   /**< LRU at front, MRU at back */
+  std::unordered_map<BlobId, ITER_T> index_;  /**< Blob -> place in order_ */
+
+ public:
+  /** Move the blob to the back */
+  void Touch(const BlobInfo &blob_info, bool write) override {
+    auto it = index_.find(blob_info.blob_id_);
+    if (it != index_.end()) {
+      order_.splice(order_.end(), order_, it->second);
+      return;
+    }
+    index_.emplace(blob_info.blob_id_,
+                   order_.insert(order_.end(), blob_info.blob_id_));
+  }
+
+  /** Remove the blob */
+  void Erase(const BlobId &blob_id) override {
+    auto it = index_.find(blob_id);
+    if (it == index_.end()) {
+      return;
+    }
+    order_.erase(it->second);
+    index_.erase(it);
+  }
+
+  /** The blobs at the front */
+  void GetVictims(size_t count, std::vector<BlobId> &victims) override {
+    for (auto it = order_.begin(); it != order_.end() && count; ++it, --count) {
+      victims.emplace_back(*it);
+    }
+  }
+
+  /** The number of blobs tracked */
+  size_t size() const override {
+    return index_.size();
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_EVICTION_LRU_H_
@@ -0,0 +1,110 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_EVICTION_TTL_H_
+#define HERMES_INCLUDE_HERMES_EVICTION_TTL_H_
+
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "evictor.h"
+
+namespace hermes {
+
+/**
+ A class to represent an eviction policy for scratch data. A blob expires
+ evict_ttl_ seconds after its last put, and expired blobs are dropped even
+ if their target has space. Under pressure, the blobs which expire soonest
+ are evicted first. Blobs with no TTL never expire and are evicted last.
+*/
+class Ttl : public Evictor {
+ public:
+  /** (expiry in seconds since epoch_, sequence number) */
+  typedef std::pair<double, u64> KEY_T;
+  hshm::Timepoint epoch_;                     /**< The start of the clock */
+  std::map<KEY_T, BlobId> order_;             /**< Soonest to expire first */
+  std::unordered_map<BlobId, KEY_T> index_;   /**< Blob -> key in order_ */
+  u64 seq_ = 0;                               /**< Sequence of puts */
+
+ public:
+  /** Constructor. */
+  Ttl() {
+    epoch_.Now();
+  }
+
+  /** Restart the blob's TTL on put */
+  void Touch(const BlobInfo &blob_info, bool write) override {
+    auto it = index_.find(blob_info.blob_id_);
+    if (it != index_.end()) {
+      if (!write) {
+        return;
+      }
+      order_.erase(it->second);
+      index_.erase(it);
+    }
+    double expiry = std::numeric_limits<double>::infinity();
+    if (blob_info.evict_ttl_ > 0) {
+      expiry = epoch_.GetSecFromStart() + blob_info.evict_ttl_;
+    }
+    KEY_T key(expiry, ++seq_);
+    index_.emplace(blob_info.blob_id_, key);
+    order_.emplace(key, blob_info.blob_id_);
+  }
+
+  /** Remove the blob */
+  void Erase(const BlobId &blob_id) override {
+    auto it = index_.find(blob_id);
+    if (it == index_.end()) {
+      return;
+    }
+    order_.erase(it->second);
+    index_.erase(it);
+  }
+
+  /** The blobs which expire soonest */
+  void GetVictims(size_t count, std::vector<BlobId> &victims) override {
+    for (auto it = order_.begin(); it != order_.end() && count; ++it, --count) {
+      victims.emplace_back(it->second);
+    }
+  }
+
+  /** The blobs which have expired */
+  void GetExpired(std::vector<BlobId> &expired) override {
+    double now = epoch_.GetSecFromStart();
+    for (auto it = order_.begin();
+         it != order_.end() && it->first.first <= now; ++it) {
+      expired.emplace_back(it->second);
+    }
+  }
+
+  /** Keep an expired blob which cannot be dropped, evicting it last */
+  void Retain(const BlobId &blob_id) override {
+    auto it = index_.find(blob_id);
+    if (it == index_.end()) {
+      return;
+    }
+    order_.erase(it->second);
+    it->second = KEY_T(std::numeric_limits<double>::infinity(), ++seq_);
+    order_.emplace(it->second, blob_id);
+  }
+
+  /** The number of blobs tracked */
+  size_t size() const override {
+    return index_.size();
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_EVICTION_TTL_H_
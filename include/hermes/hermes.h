@@ -67,6 +67,16 @@ class Hermes {
     HERMES_CONF->op_mdm_.RegisterOpRoot(op_graph);
   }
 
+  /** Get the throughput and backlog of each registered operator */
+  std::vector<hermes::data_op::OpStats> PollOpStats() {
+    return HERMES_CONF->op_mdm_.PollOpStatsRoot();
+  }
+
+  /** Get the QoS share, throughput and queueing delay of each tenant */
+  std::vector<QosTenantStats> PollQosStats() {
+    return HERMES_CONF->blob_mdm_.PollQosStatsRoot();
+  }
+
   /** Clear all data from hermes */
   void Clear() {
     // TODO(llogan)
@@ -16,8 +16,10 @@
 #include "hrun/hrun_types.h"
 #include "hrun/task_registry/task_registry.h"
 #include "hrun/api/hrun_client.h"
+#include "hrun/work_orchestrator/qos.h"
 #include "status.h"
 #include "statuses.h"
+#include "tag_blob_set.h"
 
 namespace hapi = hermes;
 
@@ -35,6 +37,7 @@ using hshm::bitfield32_t;
 
 /** Queue id */
 using hrun::QueueId;
+using hrun::QosTenantStats;
 
 /** Queue for interprocess-communication */
 using hrun::MultiQueue;
@@ -111,6 +114,57 @@ class PlacementPolicyConv {
   }
 };
 
+/** The policies which choose the blobs to evict from a full target */
+enum class EvictionPolicy {
+  kLru,   /**< Least recently used */
+  kLfu,   /**< Least frequently used */
+  kArc,   /**< Adaptive replacement between recency and frequency */
+  kTtl,   /**< Soonest to expire. Expired blobs are always dropped. */
+  kNone,  /**< Use the bucket's or the server's default */
+  kCount
+};
+
+/** A class to convert eviction policy enum value to string */
+class EvictionPolicyConv {
+ public:
+  /** A function to return string representation of \a policy */
+  static std::string to_str(EvictionPolicy policy) {
+    switch (policy) {
+      case EvictionPolicy::kLru: {
+        return "EvictionPolicy::kLru";
+      }
+      case EvictionPolicy::kLfu: {
+        return "EvictionPolicy::kLfu";
+      }
+      case EvictionPolicy::kArc: {
+        return "EvictionPolicy::kArc";
+      }
+      case EvictionPolicy::kTtl: {
+        return "EvictionPolicy::kTtl";
+      }
+      case EvictionPolicy::kNone:
+      case EvictionPolicy::kCount: {
+        return "EvictionPolicy::kNone";
+      }
+    }
+    return "EvictionPolicy::Invalid";
+  }
+
+  /** return enum value of \a policy  */
+  static EvictionPolicy to_enum(const std::string &policy) {
+    if (policy.find("LRU") != std::string::npos) {
+      return EvictionPolicy::kLru;
+    } else if (policy.find("LFU") != std::string::npos) {
+      return EvictionPolicy::kLfu;
+    } else if (policy.find("ARC") != std::string::npos) {
+      return EvictionPolicy::kArc;
+    } else if (policy.find("TTL") != std::string::npos) {
+      return EvictionPolicy::kTtl;
+    }
+    return EvictionPolicy::kNone;
+  }
+};
+
 /** Hermes API call context */
 struct Context {
   /** Data placement engine */
@@ -128,12 +182,59 @@ struct Context {
   /** The node id the blob will be accessed from */
   u32 node_id_;
 
+  /**
+   * Erasure-code the blobs of a bucket into ec_data_ data and ec_parity_
+   * parity fragments on distinct nodes. Only used when the bucket is
+   * created. Getting an existing bucket sets these to the bucket's code.
+   * 0 data fragments disables erasure coding.
+   * */
+  u32 ec_data_;
+  u32 ec_parity_;   /**< Number of parity fragments */
+
+  /** QoS tenant charged for the tasks. Empty charges the bucket. */
+  std::string qos_tenant_;
+
+  /**
+   * How blobs are chosen for eviction when their target fills.
+   * Given when getting the bucket, or per put.
+   * */
+  EvictionPolicy evict_policy_;
+
+  /** Seconds after its last put that a blob is dropped, for kTtl */
+  float evict_ttl_;
+
+  /**
+   * Share buffers whose contents are already stored on the target,
+   * instead of writing duplicates. Given when getting the bucket, or per put.
+   * */
+  bool dedup_;
+
+  /**
+   * Checksum each buffer with CRC32C, and verify it on every read and
+   * stage-out. Given when getting the bucket, or per put.
+   * */
+  bool checksum_;
+
   Context()
   : dpe_(PlacementPolicy::kNone),
     blob_score_(1),
-    node_id_(0) {}
+    node_id_(0),
+    ec_data_(0),
+    ec_parity_(0),
+    evict_policy_(EvictionPolicy::kNone),
+    evict_ttl_(0),
+    dedup_(false),
+    checksum_(false) {}
 };
 
+/** The QoS tenant charged for the I/O of bucket \a tag_id under \a ctx */
+static inline u32 GetQosTenant(const TagId &tag_id, const Context &ctx) {
+  if (ctx.qos_tenant_.empty()) {
+    return hrun::QosTenantId(tag_id.hash_);
+  }
+  return hrun::HashQosTenant(hshm::charbuf(ctx.qos_tenant_));
+}
+
 /**
  * Represents the fraction of a blob to place
  * on a particular target during data placement
@@ -209,6 +310,9 @@ class Constant {
   /** Filesystem page size environment variable */
   CONST_T char* kHermesPageSize = "HERMES_PAGE_SIZE";
 
+  /** Filesystem write-back buffer size environment variable */
+  CONST_T char* kHermesWriteBufferSize = "HERMES_WRITE_BUFFER_SIZE";
+
   /** Stop daemon environment variable */
   CONST_T char* kHermesStopDaemon = "HERMES_STOP_DAEMON";
 
@@ -216,17 +320,59 @@ class Constant {
   CONST_T size_t kMaxPathLength = 4096;
 };
 
+/** A 128-bit fingerprint of the contents of a buffer */
+struct BufferFingerprint {
+  u64 lo_;
+  u64 hi_;
+
+  /** Default constructor. Null. */
+  BufferFingerprint() : lo_(0), hi_(0) {}
+
+  /** Emplace constructor */
+  BufferFingerprint(u64 lo, u64 hi) : lo_(lo), hi_(hi) {}
+
+  /** Whether this is the null fingerprint */
+  bool IsNull() const {
+    return lo_ == 0 && hi_ == 0;
+  }
+
+  /** Set to the null fingerprint */
+  void SetNull() {
+    lo_ = 0;
+    hi_ = 0;
+  }
+
+  /** Equality */
+  bool operator==(const BufferFingerprint &other) const {
+    return lo_ == other.lo_ && hi_ == other.hi_;
+  }
+
+  /** Inequality */
+  bool operator!=(const BufferFingerprint &other) const {
+    return !(*this == other);
+  }
+
+  /** Serialization */
+  template<typename Ar>
+  void serialize(Ar &ar) {
+    ar(lo_, hi_);
+  }
+};
+
 /** Represents an allocated fraction of a target */
 struct BufferInfo {
   TargetId tid_;        /**< The destination target */
   size_t t_slab_;       /**< The index of the slab in the target */
   size_t t_off_;        /**< Offset in the target */
   size_t t_size_;       /**< Size in the target */
+  BufferFingerprint fp_;  /**< Non-null if shared through the DedupIndex */
+  u32 crc_ = 0;           /**< CRC32C of the first crc_size_ bytes */
+  size_t crc_size_ = 0;   /**< Bytes covered by crc_, 0 if unchecked */
 
   /** Serialization */
   template<typename Ar>
   void serialize(Ar &ar) {
-    ar(tid_, t_slab_, t_off_, t_size_);
+    ar(tid_, t_slab_, t_off_, t_size_, fp_, crc_, crc_size_);
   }
 
   /** Default constructor */
@@ -265,6 +411,9 @@ struct BufferInfo {
     t_slab_ = other.t_slab_;
     t_off_ = other.t_off_;
     t_size_ = other.t_size_;
+    fp_ = other.fp_;
+    crc_ = other.crc_;
+    crc_size_ = other.crc_size_;
   }
 };
 
@@ -284,6 +433,8 @@ struct BlobInfo {
   std::atomic<size_t> mod_count_;   /**< The number of times blob modified */
   std::atomic<size_t> last_flush_;  /**< The last mod that was flushed */
   bitfield32_t flags_;  /**< Flags */
+  EvictionPolicy evict_policy_;  /**< How the blob is chosen for eviction */
+  float evict_ttl_;  /**< Seconds the blob lives after a put, for kTtl */
 
   /** Serialization */
   template<typename Ar>
@@ -310,6 +461,9 @@ struct BlobInfo {
     last_access_ = other.last_access_;
     mod_count_ = other.mod_count_.load();
     last_flush_ = other.last_flush_.load();
+    flags_ = other.flags_;
+    evict_policy_ = other.evict_policy_;
+    evict_ttl_ = other.evict_ttl_;
   }
 
   /** Update modify stats */
@@ -332,21 +486,63 @@ struct BlobInfo {
   }
 };
 
+/**
+ * Tag state published in shared memory by the bucket_mdm, so that
+ * clients on the same node can read it without a task round trip.
+ * */
+struct TagShm {
+  std::atomic<size_t> size_;       /**< The internal size of the tag */
+  std::atomic<u64> shrink_count_;  /**< Incremented when the size drops */
+  std::atomic<bool> valid_;        /**< False once the tag is destroyed */
+  std::atomic<u64> blob_epoch_;    /**< Incremented when blob IDs change */
+  std::atomic<u32> ref_count_;     /**< The bucket_mdm + attached clients */
+
+  /** Default constructor */
+  TagShm() : size_(0), shrink_count_(0), valid_(true), blob_epoch_(0),
+             ref_count_(1) {}
+};
+
 /** Data structure used to store Bucket information */
 struct TagInfo {
   TagId tag_id_;
   hshm::charbuf name_;
-  std::list<BlobId> blobs_;
+  TagBlobSet<BlobId> blobs_;  /**< The blobs in the tag */
   std::list<Task*> traits_;
   size_t internal_size_;
   size_t page_size_;
   bitfield32_t flags_;
   bool owner_;
+  hipc::Pointer shm_p_;     /**< Shared-memory pointer to shm_ */
+  TagShm *shm_ = nullptr;   /**< Size published to local clients */
+  u64 shrink_count_ = 0;    /**< Number of times the size dropped */
+  u32 ec_data_ = 0;         /**< Data fragments per blob, 0 if not coded */
+  u32 ec_parity_ = 0;       /**< Parity fragments per blob */
+
+  /** Set the size of the tag and publish it to clients */
+  void SetSize(size_t size) {
+    if (size < internal_size_) {
+      ++shrink_count_;
+    }
+    internal_size_ = size;
+    if (shm_) {
+      // Publish the shrink first so clients drop stale local sizes
+      shm_->shrink_count_.store(shrink_count_);
+      shm_->size_.store(size);
+    }
+  }
+
+  /** Invalidate the blob IDs clients cached for this tag */
+  void InvalidateBlobIds() {
+    if (shm_) {
+      shm_->blob_epoch_.fetch_add(1);
+    }
+  }
 
   /** Serialization */
   template<typename Ar>
   void serialize(Ar &ar) {
-    ar(tag_id_, name_, internal_size_, page_size_, owner_, flags_);
+    ar(tag_id_, name_, internal_size_, page_size_, owner_, flags_,
+       ec_data_, ec_parity_);
   }
 
   /** Get std::string of name */
@@ -0,0 +1,183 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef HERMES_INCLUDE_HERMES_PMEM_COPY_H_
+#define HERMES_INCLUDE_HERMES_PMEM_COPY_H_
+
+#include <cstdint>
+#include <cstring>
+#include "hermes/hermes_types.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <immintrin.h>
+#define HERMES_PMEM_X86
+#endif
+
+namespace hermes {
+
+/**
+ * Copies and cache flushes for memory-mapped persistent memory.
+ *
+ * Large copies use non-temporal stores, which bypass the CPU caches. This
+ * avoids evicting the working set and reading each destination line
+ * before it is overwritten. Ordinary stores reach persistent memory once
+ * their cache lines are written back with clwb, or clflushopt and clflush
+ * on CPUs without it. On other architectures, copies are plain memcpy and
+ * HasFlush() is false.
+ * */
+class PmemCopy {
+ public:
+  static const size_t kCacheLine = 64;
+
+  /** The instruction which writes back a cache line */
+  enum class FlushOp {
+    kNone,
+    kClflush,
+    kClflushOpt,
+    kClwb
+  };
+
+  FlushOp flush_op_;  /**< The best instruction this CPU supports */
+
+ public:
+  /** The CPU features are detected once per process */
+  static const PmemCopy& Get() {
+    static PmemCopy pmem;
+    return pmem;
+  }
+
+  /** Whether cache lines can be written back from user space */
+  static bool HasFlush() {
+    return Get().flush_op_ != FlushOp::kNone;
+  }
+
+  /**
+   * Copy \a size bytes from \a src to \a dst, bypassing the caches. The
+   * unaligned head and tail are copied with ordinary stores and written
+   * back, so the whole range is durable once this returns.
+   * */
+  static void CopyNt(char *dst, const char *src, size_t size) {
+#ifdef HERMES_PMEM_X86
+    size_t head = (kCacheLine - ((uintptr_t)dst & (kCacheLine - 1))) &
+        (kCacheLine - 1);
+    if (head > size) {
+      head = size;
+    }
+    memcpy(dst, src, head);
+    Flush(dst, head);
+    dst += head;
+    src += head;
+    size -= head;
+    size_t body = size & ~(kCacheLine - 1);
+    for (size_t off = 0; off < body; off += kCacheLine) {
+      const __m128i *s = reinterpret_cast<const __m128i*>(src + off);
+      __m128i *d = reinterpret_cast<__m128i*>(dst + off);
+      __m128i x0 = _mm_loadu_si128(s);
+      __m128i x1 = _mm_loadu_si128(s + 1);
+      __m128i x2 = _mm_loadu_si128(s + 2);
+      __m128i x3 = _mm_loadu_si128(s + 3);
+      _mm_stream_si128(d, x0);
+      _mm_stream_si128(d + 1, x1);
+      _mm_stream_si128(d + 2, x2);
+      _mm_stream_si128(d + 3, x3);
+    }
+    memcpy(dst + body, src + body, size - body);
+    Flush(dst + body, size - body);
+    Fence();
+#else
+    memcpy(dst, src, size);
+#endif
+  }
+
+  /**
+   * Write back the cache lines of [addr, addr + size). Call Fence() to
+   * wait for them to complete.
+   * */
+  static void Flush(const void *addr, size_t size) {
+#ifdef HERMES_PMEM_X86
+    if (size == 0) {
+      return;
+    }
+    uintptr_t line = (uintptr_t)addr & ~(uintptr_t)(kCacheLine - 1);
+    uintptr_t end = (uintptr_t)addr + size;
+    switch (Get().flush_op_) {
+      case FlushOp::kClwb: {
+        for (; line < end; line += kCacheLine) {
+          Clwb((void*)line);
+        }
+        break;
+      }
+      case FlushOp::kClflushOpt: {
+        for (; line < end; line += kCacheLine) {
+          ClflushOpt((void*)line);
+        }
+        break;
+      }
+      case FlushOp::kClflush: {
+        for (; line < end; line += kCacheLine) {
+          _mm_clflush((void*)line);
+        }
+        break;
+      }
+      case FlushOp::kNone: {
+        break;
+      }
+    }
+#endif
+  }
+
+  /** Order the preceding non-temporal stores and write backs */
+  static void Fence() {
+#ifdef HERMES_PMEM_X86
+    _mm_sfence();
+#endif
+  }
+
+ private:
+  /** Detect the CPU features */
+  PmemCopy() : flush_op_(FlushOp::kNone) {
+#ifdef HERMES_PMEM_X86
+    unsigned eax, ebx, ecx, edx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+      if (ebx & (1u << 24)) {
+        flush_op_ = FlushOp::kClwb;
+      } else if (ebx & (1u << 23)) {
+        flush_op_ = FlushOp::kClflushOpt;
+      }
+    }
+    if (flush_op_ == FlushOp::kNone &&
+        __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & (1u << 19))) {
+      flush_op_ = FlushOp::kClflush;
+    }
+#endif
+  }
+
+#ifdef HERMES_PMEM_X86
+  /** Write back a line, keeping it cached */
+  __attribute__((target("clwb")))
+  static void Clwb(void *line) {
+    _mm_clwb(line);
+  }
+
+  /** Write back and evict a line, without ordering against other flushes */
+  __attribute__((target("clflushopt")))
+  static void ClflushOpt(void *line) {
+    _mm_clflushopt(line);
+  }
+#endif
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_PMEM_COPY_H_
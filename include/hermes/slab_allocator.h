@@ -36,6 +36,8 @@ class SlabAllocator {
   std::atomic<size_t> heap_;
   size_t dev_size_;
   TargetId target_id_;
+  u8 *slab_map_ = nullptr;  /**< Slab of the buffer carved at each granule */
+  size_t granule_ = 0;      /**< Bytes of the device per slab_map_ entry */
 
  public:
   /** Default constructor */
@@ -59,6 +61,49 @@ class SlabAllocator {
     }
   }
 
+  /**
+   * Record the slab index + 1 of each buffer carved from the heap in
+   * \a slab_map, at its offset divided by \a granule. The map has one
+   * entry per \a granule bytes of the device, and \a granule must divide
+   * every slab size. Used by targets whose layout outlives the runtime.
+   * */
+  void SetSlabMap(u8 *slab_map, size_t granule) {
+    slab_map_ = slab_map;
+    granule_ = granule;
+  }
+
+  /**
+   * Rebuild the heap from the slab map of a previous run. No blob survives
+   * a restart, so every recovered buffer is free. Returns the number of
+   * recovered bytes.
+   * */
+  size_t Recover() {
+    size_t off = 0;
+    while (off < dev_size_) {
+      u8 entry = slab_map_[off / granule_];
+      if (entry == 0 || entry > slab_lists_.size()) {
+        break;
+      }
+      Slab &slab = slab_lists_[entry - 1];
+      if (off + slab.slab_size_ > dev_size_) {
+        break;
+      }
+      slab.buffers_.emplace_back();
+      BufferInfo &buf = slab.buffers_.back();
+      buf.tid_ = target_id_;
+      buf.t_off_ = off;
+      buf.t_size_ = slab.slab_size_;
+      buf.t_slab_ = entry - 1;
+      off += slab.slab_size_;
+    }
+    heap_ = off;
+    // Drop the entries of buffers carved after an unfinished one
+    size_t first = off / granule_;
+    size_t count = (dev_size_ + granule_ - 1) / granule_;
+    memset(slab_map_ + first, 0, count - first);
+    return off;
+  }
+
   /**
    * Allocate enough slabs to ideally fit the size
    * It can allocate less than or more than the requested size
@@ -140,6 +185,9 @@ class SlabAllocator {
         buf.t_off_ = heap_.fetch_add(slab_size);
         buf.t_size_ = slab_size;
         buf.t_slab_ = slab_idx;
+        if (slab_map_) {
+          slab_map_[buf.t_off_ / granule_] = (u8)(slab_idx + 1);
+        }
       }
       total_size += slab_size;
     }
@@ -152,6 +200,8 @@ class SlabAllocator {
     for (const auto &buffer : buffers) {
       auto &slab = slab_lists_[buffer.t_slab_];
       slab.buffers_.push_back(buffer);
+      slab.buffers_.back().fp_.SetNull();
+      slab.buffers_.back().crc_size_ = 0;
       total_size += slab.slab_size_;
     }
     return total_size;
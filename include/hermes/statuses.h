@@ -24,6 +24,10 @@ STATUS_T DPE_PLACEMENT_SCHEMA_EMPTY(1, "DPE placement schema is empty");
 STATUS_T DPE_NO_SPACE(1, "Placement failed. Non-fatal.");
 STATUS_T DPE_MIN_IO_TIME_NO_SOLUTION(
     1, "DPE could not find solution for the minimize I/O time DPE");
+STATUS_T BLOB_NO_SPACE(
+    2, "No space to give the blob a private copy of a shared buffer");
+STATUS_T BLOB_CHECKSUM_MISMATCH(
+    3, "The blob's data failed checksum verification");
 
 }  // namespace hermes
 
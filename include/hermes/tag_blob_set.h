@@ -0,0 +1,187 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_INCLUDE_HERMES_TAG_BLOB_SET_H_
+#define HERMES_INCLUDE_HERMES_TAG_BLOB_SET_H_
+
+#include <cstddef>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+namespace hermes {
+
+/**
+ * A set of IDs with O(1) insert, erase and lookup, iterated in insertion
+ * order.
+ *
+ * IDs are stored contiguously in a vector, and a hash map gives each ID's
+ * slot. Erasing an ID nulls its slot rather than shifting the vector.
+ * The vector is compacted once more than half of it is holes, so erases
+ * are amortized O(1) and iteration is O(size). Null IDs cannot be members.
+ *
+ * Erasing may compact the vector, so the set must not be modified while
+ * it is iterated.
+ * */
+template<typename IdT>
+class TagBlobSet {
+ public:
+  /** Holes are only compacted past this many slots */
+  static const size_t kMinCompact = 64;
+
+  std::vector<IdT> ids_;                     /**< Members and holes */
+  std::unordered_map<IdT, size_t> index_;    /**< ID -> slot in ids_ */
+
+ public:
+  /** Iterates over the members, skipping holes */
+  class const_iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef IdT value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const IdT* pointer;
+    typedef const IdT& reference;
+
+   public:
+    const IdT *cur_;  /**< The current slot */
+    const IdT *end_;  /**< One past the last slot */
+
+   public:
+    /** Emplace constructor */
+    const_iterator(const IdT *cur, const IdT *end) : cur_(cur), end_(end) {
+      SkipHoles();
+    }
+
+    /** The current ID */
+    const IdT& operator*() const {
+      return *cur_;
+    }
+
+    /** Pointer to the current ID */
+    const IdT* operator->() const {
+      return cur_;
+    }
+
+    /** Advance to the next member */
+    const_iterator& operator++() {
+      ++cur_;
+      SkipHoles();
+      return *this;
+    }
+
+    /** Whether two iterators point to the same slot */
+    bool operator==(const const_iterator &other) const {
+      return cur_ == other.cur_;
+    }
+
+    /** Whether two iterators point to different slots */
+    bool operator!=(const const_iterator &other) const {
+      return cur_ != other.cur_;
+    }
+
+   private:
+    /** Advance past null slots */
+    void SkipHoles() {
+      while (cur_ != end_ && cur_->IsNull()) {
+        ++cur_;
+      }
+    }
+  };
+
+ public:
+  /** Add \a id. Returns false if it was already a member. */
+  bool insert(const IdT &id) {
+    auto ret = index_.emplace(id, ids_.size());
+    if (!ret.second) {
+      return false;
+    }
+    ids_.emplace_back(id);
+    return true;
+  }
+
+  /** Remove \a id. Returns false if it was not a member. */
+  bool erase(const IdT &id) {
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+      return false;
+    }
+    ids_[it->second].SetNull();
+    index_.erase(it);
+    // Holes at the end are free to drop
+    while (!ids_.empty() && ids_.back().IsNull()) {
+      ids_.pop_back();
+    }
+    if (ids_.size() > kMinCompact && 2 * index_.size() < ids_.size()) {
+      Compact();
+    }
+    return true;
+  }
+
+  /** Whether \a id is a member */
+  bool contains(const IdT &id) const {
+    return index_.find(id) != index_.end();
+  }
+
+  /** The number of members */
+  size_t size() const {
+    return index_.size();
+  }
+
+  /** Whether there are no members */
+  bool empty() const {
+    return index_.empty();
+  }
+
+  /** Reserve space for \a count members */
+  void reserve(size_t count) {
+    ids_.reserve(count);
+    index_.reserve(count);
+  }
+
+  /** Remove all members */
+  void clear() {
+    ids_.clear();
+    index_.clear();
+  }
+
+  /** The first member */
+  const_iterator begin() const {
+    return const_iterator(ids_.data(), ids_.data() + ids_.size());
+  }
+
+  /** One past the last member */
+  const_iterator end() const {
+    const IdT *end = ids_.data() + ids_.size();
+    return const_iterator(end, end);
+  }
+
+ private:
+  /** Remove the holes from ids_, preserving order */
+  void Compact() {
+    size_t dst = 0;
+    for (size_t src = 0; src < ids_.size(); ++src) {
+      if (ids_[src].IsNull()) {
+        continue;
+      }
+      if (dst != src) {
+        ids_[dst] = ids_[src];
+        index_[ids_[dst]] = dst;
+      }
+      ++dst;
+    }
+    ids_.resize(dst);
+  }
+};
+
+}  // namespace hermes
+
+#endif  // HERMES_INCLUDE_HERMES_TAG_BLOB_SET_H_
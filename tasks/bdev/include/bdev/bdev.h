@@ -119,23 +119,31 @@ class Client : public TaskLibClient {
   }
   HRUN_TASK_NODE_PUSH_ROOT(Free);
 
-  /** Allocate buffers from the bdev */
+  /**
+   * Write to the bdev. The CRC32C of the first \a crc_size bytes is
+   * computed while copying them.
+   * */
   HSHM_ALWAYS_INLINE
   void AsyncWriteConstruct(WriteTask *task,
                            const TaskNode &task_node,
-                           const char *data, size_t off, size_t size) {
+                           const char *data, size_t off, size_t size,
+                           size_t crc_size = 0) {
     HRUN_CLIENT->ConstructTask<WriteTask>(
-        task, task_node, domain_id_, id_, data, off, size);
+        task, task_node, domain_id_, id_, data, off, size, crc_size);
   }
   HRUN_TASK_NODE_PUSH_ROOT(Write);
 
-  /** Allocate buffers from the bdev */
+  /**
+   * Read from the bdev. The CRC32C of the first \a crc_size bytes is
+   * computed while copying them.
+   * */
   HSHM_ALWAYS_INLINE
   void AsyncReadConstruct(ReadTask *task,
                           const TaskNode &task_node,
-                          char *data, size_t off, size_t size) {
+                          char *data, size_t off, size_t size,
+                          size_t crc_size = 0) {
     HRUN_CLIENT->ConstructTask<ReadTask>(
-        task, task_node, domain_id_, id_, data, off, size);
+        task, task_node, domain_id_, id_, data, off, size, crc_size);
   }
   HRUN_TASK_NODE_PUSH_ROOT(Read);
 
@@ -190,13 +198,26 @@ struct TargetStats {
   double bandwidth_;    /**< the bandwidth of the device */
   double latency_;      /**< the latency of the device */
   float score_;         /**< Relative importance of this tier */
+  size_t dedup_logical_;     /**< Blob bytes stored in shared buffers */
+  size_t dedup_physical_;    /**< Bytes of the shared buffers */
+  size_t dedup_index_size_;  /**< Approximate memory of the dedup index */
+  size_t crc_errors_;        /**< Reads which failed checksum verification */
 
  public:
+  /** The bytes saved by deduplication, as logical / physical */
+  double GetDedupRatio() const {
+    if (dedup_physical_ == 0) {
+      return 1;
+    }
+    return (double)dedup_logical_ / dedup_physical_;
+  }
+
   /** Serialize */
   template<typename Ar>
   void serialize(Ar &ar) {
     ar(tgt_id_, node_id_, max_cap_, bandwidth_,
-       latency_, score_, rem_cap_);
+       latency_, score_, rem_cap_,
+       dedup_logical_, dedup_physical_, dedup_index_size_, crc_errors_);
   }
 };
 }  // namespace hermes
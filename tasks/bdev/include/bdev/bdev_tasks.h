@@ -120,6 +120,7 @@ struct AllocateTask : public Task, TaskFlags<TF_LOCAL> {
 struct FreeTask : public Task, TaskFlags<TF_LOCAL> {
   IN std::vector<BufferInfo> buffers_;
   IN float score_;
+  OUT size_t rem_cap_;  /**< Remaining capacity after the free */
 
   /** SHM default constructor */
   HSHM_ALWAYS_INLINE explicit
@@ -149,6 +150,7 @@ struct FreeTask : public Task, TaskFlags<TF_LOCAL> {
     // Free params
     buffers_ = buffers;
     score_ = score;
+    rem_cap_ = 0;
   }
 
   /** Create group */
@@ -165,6 +167,8 @@ struct WriteTask : public Task, TaskFlags<TF_LOCAL> {
   IN const char *buf_;    /**< Data in memory */
   IN size_t disk_off_;    /**< Offset on disk */
   IN size_t size_;        /**< Size in buf */
+  IN size_t crc_size_;    /**< Checksum the first crc_size_ bytes */
+  OUT u32 crc_;           /**< CRC32C of those bytes */
   TEMP int phase_ = 0;
   // TEMP io_context_t ctx_ = 0;
 
@@ -180,7 +184,8 @@ struct WriteTask : public Task, TaskFlags<TF_LOCAL> {
             const TaskStateId &state_id,
             const char *buf,
             size_t disk_off,
-            size_t size) : Task(alloc) {
+            size_t size,
+            size_t crc_size) : Task(alloc) {
     // Initialize task
     static int counter = 0;
     task_node_ = task_node;
@@ -200,6 +205,8 @@ struct WriteTask : public Task, TaskFlags<TF_LOCAL> {
     buf_ = buf;
     disk_off_ = disk_off;
     size_ = size;
+    crc_size_ = crc_size;
+    crc_ = 0;
   }
 
   /** Create group */
@@ -216,6 +223,8 @@ struct ReadTask : public Task, TaskFlags<TF_LOCAL> {
   IN char *buf_;         /**< Data in memory */
   IN size_t disk_off_;   /**< Offset on disk */
   IN size_t size_;       /**< Size in disk buf */
+  IN size_t crc_size_;   /**< Checksum the first crc_size_ bytes */
+  OUT u32 crc_;          /**< CRC32C of those bytes */
   TEMP int phase_ = 0;
   // TEMP io_context_t ctx_ = 0;
 
@@ -231,7 +240,8 @@ struct ReadTask : public Task, TaskFlags<TF_LOCAL> {
            const TaskStateId &state_id,
            char *buf,
            size_t disk_off,
-           size_t size) : Task(alloc) {
+           size_t size,
+           size_t crc_size) : Task(alloc) {
     static int counter = 0;
     // Initialize task
     task_node_ = task_node;
@@ -251,6 +261,8 @@ struct ReadTask : public Task, TaskFlags<TF_LOCAL> {
     buf_ = buf;
     disk_off_ = disk_off;
     size_ = size;
+    crc_size_ = crc_size;
+    crc_ = 0;
   }
 
   /** Create group */
@@ -262,7 +274,7 @@ struct ReadTask : public Task, TaskFlags<TF_LOCAL> {
 
 /** A task to monitor bdev statistics */
 struct StatBdevTask : public Task, TaskFlags<TF_LOCAL> {
-  OUT size_t rem_cap_;  /**< Remaining capacity of the target */
+  OUT std::atomic<size_t> rem_cap_;  /**< Remaining capacity of the target */
   OUT Histogram score_hist_;  /**< Score distribution */
 
   /** SHM default constructor */
@@ -7,6 +7,7 @@
 
 #include "../data_stager.h"
 #include "hermes_bucket_mdm/hermes_bucket_mdm.h"
+#include "fd_cache.h"
 
 namespace hermes::data_stager {
 
@@ -14,9 +15,11 @@ class AbstractStager {
  public:
   std::string path_;
   std::string params_;
+  FdCache *fd_cache_ = nullptr;  /**< Open backend files of this lane */
+  size_t max_batch_size_ = 1;    /**< Max stage-outs coalesced per write */
 
   AbstractStager() = default;
-  ~AbstractStager() = default;
+  virtual ~AbstractStager() = default;
 
   virtual void RegisterStager(RegisterStagerTask *task, RunContext &rctx) = 0;
   virtual void StageIn(blob_mdm::Client &blob_mdm, StageInTask *task, RunContext &rctx) = 0;
@@ -5,16 +5,26 @@
 #ifndef HERMES_TASKS_DATA_STAGER_SRC_BINARY_STAGER_H_
 #define HERMES_TASKS_DATA_STAGER_SRC_BINARY_STAGER_H_
 
+#include <climits>
 #include "abstract_stager.h"
 #include "hermes_adapters/mapper/abstract_mapper.h"
 
 namespace hermes::data_stager {
 
 class BinaryFileStager : public AbstractStager {
+ public:
+  /** A stage-out waiting to be written by the leader of its batch */
+  struct PendingStageOut {
+    char *data_;    /**< The data to write */
+    size_t off_;    /**< Offset in the backend file */
+    size_t size_;   /**< Size of the data */
+    bool done_;     /**< Whether the leader wrote this stage-out */
+  };
+
  public:
   size_t page_size_;
-  std::string path_;
   bitfield32_t flags_;
+  std::vector<PendingStageOut*> pending_;  /**< The batch being formed */
 
  public:
   /** Default constructor */
@@ -67,7 +77,7 @@ class BinaryFileStager : public AbstractStager {
     HILOG(kDebug, "Attempting to stage {} bytes from the backend file {} at offset {}",
           page_size_, path_, plcmnt.bucket_off_);
     LPointer<char> blob = HRUN_CLIENT->AllocateBufferServer<TASK_YIELD_STD>(page_size_);
-    int fd = HERMES_POSIX_API->open(path_.c_str(), O_CREAT | O_RDWR, 0666);
+    int fd = fd_cache_->Open(path_);
     if (fd < 0) {
       HELOG(kError, "Failed to open file {}", path_);
       HRUN_CLIENT->FreeBuffer(blob);
@@ -77,7 +87,6 @@ class BinaryFileStager : public AbstractStager {
                                                 blob.ptr_,
                                                 page_size_,
                                                 (off_t)plcmnt.bucket_off_);
-    HERMES_POSIX_API->close(fd);
     if (real_size < 0) {
 //      HELOG(kError, "Failed to stage in {} bytes from {}",
 //            page_size_, path_);
@@ -104,7 +113,14 @@ class BinaryFileStager : public AbstractStager {
     HRUN_CLIENT->DelTask(put_task);
   }
 
-  /** Stage data out to remote source */
+  /**
+   * Stage data out to remote source
+   *
+   * Stage-outs to the same file are coalesced. The first stage-out to
+   * arrive leads the batch: it yields so that the other stage-outs in
+   * this lane can enqueue themselves, and then writes the entire batch
+   * using offset-sorted vectored writes. The others wait for the leader.
+   * */
   void StageOut(blob_mdm::Client &blob_mdm, StageOutTask *task, RunContext &rctx) override {
     if (flags_.Any(HERMES_STAGE_NO_WRITE)) {
       return;
@@ -113,25 +129,95 @@ class BinaryFileStager : public AbstractStager {
     plcmnt.DecodeBlobName(*task->blob_name_, page_size_);
     HILOG(kDebug, "Attempting to stage {} bytes to the backend file {} at offset {}",
           page_size_, path_, plcmnt.bucket_off_);
-    char *data = HRUN_CLIENT->GetDataPointer(task->data_);
-    int fd = HERMES_POSIX_API->open(path_.c_str(), O_CREAT | O_RDWR, 0666);
+    PendingStageOut stage_out;
+    stage_out.data_ = HRUN_CLIENT->GetDataPointer(task->data_);
+    stage_out.off_ = plcmnt.bucket_off_;
+    stage_out.size_ = task->data_size_;
+    stage_out.done_ = false;
+    pending_.emplace_back(&stage_out);
+    if (pending_.size() > 1) {
+      while (!stage_out.done_) {
+        task->Yield<TASK_YIELD_CO>();
+      }
+      return;
+    }
+    // Wait until the batch is full or stops growing
+    size_t last_size = 0;
+    while (pending_.size() < max_batch_size_ &&
+           pending_.size() != last_size) {
+      last_size = pending_.size();
+      task->Yield<TASK_YIELD_CO>();
+    }
+    std::vector<PendingStageOut*> batch;
+    batch.swap(pending_);
+    WriteBatch(batch);
+  }
+
+ private:
+  /** Write a set of stage-outs using as few syscalls as possible */
+  void WriteBatch(std::vector<PendingStageOut*> &batch) {
+    // Later stage-outs to the same offset must be written last
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const PendingStageOut *a, const PendingStageOut *b) {
+                       return a->off_ < b->off_;
+                     });
+    int fd = fd_cache_->Open(path_);
     if (fd < 0) {
       HELOG(kError, "Failed to open file {}", path_);
-      return;
     }
-    ssize_t real_size = HERMES_POSIX_API->pwrite(fd,
-                                                 data,
-                                                 task->data_size_,
-                                                 (off_t)plcmnt.bucket_off_);
-    HERMES_POSIX_API->close(fd);
-    if (real_size < 0) {
-      HELOG(kError, "Failed to stage out {} bytes from {}",
-            task->data_size_, path_);
+    std::vector<struct iovec> iov;
+    iov.reserve(std::min<size_t>(batch.size(), IOV_MAX));
+    size_t i = 0;
+    while (fd >= 0 && i < batch.size()) {
+      // Gather a run of contiguous stage-outs
+      size_t run_off = batch[i]->off_;
+      size_t run_size = 0;
+      iov.clear();
+      while (i < batch.size() && iov.size() < IOV_MAX &&
+             batch[i]->off_ == run_off + run_size) {
+        iov.push_back({batch[i]->data_, batch[i]->size_});
+        run_size += batch[i]->size_;
+        ++i;
+      }
+      ssize_t real_size = WriteRun(fd, iov, run_off);
+      if (real_size < 0) {
+        HELOG(kError, "Failed to stage out {} bytes to {} at offset {}",
+              run_size, path_, run_off);
+      }
+      HILOG(kDebug, "Staged out {} bytes ({} pages) to the backend file {}",
+            real_size, iov.size(), path_);
+    }
+    for (PendingStageOut *stage_out : batch) {
+      stage_out->done_ = true;
     }
-    HILOG(kDebug, "Staged out {} bytes to the backend file {}",
-          real_size, path_);
   }
 
+  /** Write a contiguous run of buffers, resuming after short writes */
+  static ssize_t WriteRun(int fd, std::vector<struct iovec> &iov, size_t off) {
+    struct iovec *cur = iov.data();
+    int count = static_cast<int>(iov.size());
+    ssize_t total = 0;
+    while (count > 0) {
+      ssize_t ret = HERMES_POSIX_API->pwritev(fd, cur, count,
+                                              (off_t)(off + total));
+      if (ret <= 0) {
+        return ret < 0 ? ret : total;
+      }
+      total += ret;
+      while (count > 0 && (size_t)ret >= cur->iov_len) {
+        ret -= cur->iov_len;
+        ++cur;
+        --count;
+      }
+      if (count > 0) {
+        cur->iov_base = (char*)cur->iov_base + ret;
+        cur->iov_len -= ret;
+      }
+    }
+    return total;
+  }
+
+ public:
   void UpdateSize(bucket_mdm::Client &bkt_mdm, UpdateSizeTask *task, RunContext &rctx) override {
     adapter::BlobPlacement p;
     std::string blob_name_str = task->blob_name_->str();
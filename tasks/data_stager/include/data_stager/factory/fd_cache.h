@@ -0,0 +1,113 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_TASKS_DATA_STAGER_SRC_FD_CACHE_H_
+#define HERMES_TASKS_DATA_STAGER_SRC_FD_CACHE_H_
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include "hermes_adapters/posix/posix_api.h"
+
+namespace hermes::data_stager {
+
+/**
+ * An LRU cache of open backend file descriptors.
+ *
+ * Stagers used to open and close the backend file for every page,
+ * which floods the metadata server of a PFS. Instead, files stay open
+ * until the cache exceeds its capacity or the stager is unregistered.
+ * There is one cache per lane, so no locking is required.
+ * */
+class FdCache {
+ public:
+  typedef std::pair<std::string, int> FD_ENTRY_T;
+  typedef std::list<FD_ENTRY_T>::iterator FD_ITER_T;
+
+ public:
+  size_t max_fds_;                  /**< Maximum number of open fds */
+  std::list<FD_ENTRY_T> lru_;       /**< Most recently used at front */
+  std::unordered_map<std::string, FD_ITER_T> fds_;  /**< Path -> lru entry */
+
+ public:
+  /** Default constructor */
+  FdCache() : max_fds_(1) {}
+
+  /** Fds cannot be shared by two caches */
+  FdCache(const FdCache &other) = delete;
+
+  /** Move constructor */
+  FdCache(FdCache &&other) = default;
+
+  /** Destructor */
+  ~FdCache() {
+    CloseAll();
+  }
+
+  /** Set the maximum number of cached file descriptors */
+  void Init(size_t max_fds) {
+    max_fds_ = max_fds > 0 ? max_fds : 1;
+  }
+
+  /** Get the fd of a path, opening the file if it is not cached */
+  int Open(const std::string &path) {
+    auto it = fds_.find(path);
+    if (it != fds_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return it->second->second;
+    }
+    int fd = HERMES_POSIX_API->open(path.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0) {
+      return fd;
+    }
+    while (fds_.size() >= max_fds_) {
+      Evict();
+    }
+    lru_.emplace_front(path, fd);
+    fds_.emplace(path, lru_.begin());
+    return fd;
+  }
+
+  /** Close the fd of a path if it is cached */
+  void Close(const std::string &path) {
+    auto it = fds_.find(path);
+    if (it == fds_.end()) {
+      return;
+    }
+    HERMES_POSIX_API->close(it->second->second);
+    lru_.erase(it->second);
+    fds_.erase(it);
+  }
+
+  /** Close all cached fds */
+  void CloseAll() {
+    for (FD_ENTRY_T &entry : lru_) {
+      HERMES_POSIX_API->close(entry.second);
+    }
+    lru_.clear();
+    fds_.clear();
+  }
+
+ private:
+  /** Close the least-recently used fd */
+  void Evict() {
+    FD_ENTRY_T &entry = lru_.back();
+    HILOG(kDebug, "Evicting cached fd {} for {}", entry.second, entry.first);
+    HERMES_POSIX_API->close(entry.second);
+    fds_.erase(entry.first);
+    lru_.pop_back();
+  }
+};
+
+}  // namespace hermes::data_stager
+
+#endif  // HERMES_TASKS_DATA_STAGER_SRC_FD_CACHE_H_
@@ -0,0 +1,390 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_TASKS_DATA_STAGER_SRC_HDF5_STAGER_H_
+#define HERMES_TASKS_DATA_STAGER_SRC_HDF5_STAGER_H_
+
+#include <hdf5.h>
+#include "abstract_stager.h"
+
+namespace hermes::data_stager {
+
+/**
+ * Stages blobs to and from the datasets of an HDF5 file.
+ *
+ * Each blob is one chunk of a dataset. Blobs are named by the dataset
+ * path and the coordinates of the chunk in the chunk grid. Contiguous
+ * datasets are tiled into hyperslabs of whole rows which are at most
+ * one page in size.
+ *
+ * When HERMES_STAGE_RAW_CHUNKS is set, chunks are transferred exactly as
+ * they are stored in the file (i.e., still compressed). This is meant for
+ * the VFD, which sits below the HDF5 filter pipeline.
+ * */
+class Hdf5Stager : public AbstractStager {
+ public:
+  /** An open dataset and its chunk geometry */
+  struct Dataset {
+    hid_t id_ = H5I_INVALID_HID;    /**< The dataset */
+    hid_t type_ = H5I_INVALID_HID;  /**< Native memory type of elements */
+    size_t elmt_size_ = 0;          /**< Size of an element in memory */
+    bool chunked_ = false;          /**< Whether the layout is chunked */
+    std::vector<hsize_t> dims_;     /**< Current extent of the dataset */
+    std::vector<hsize_t> chunk_;    /**< Shape of a chunk (or tile) */
+  };
+
+ public:
+  size_t page_size_;
+  bitfield32_t flags_;
+  hid_t file_ = H5I_INVALID_HID;
+  std::unordered_map<std::string, Dataset> dsets_;
+  std::unordered_map<std::string, u32> filter_masks_;  /**< Raw chunk filters */
+
+ public:
+  /** Default constructor */
+  Hdf5Stager() = default;
+
+  /** Destructor */
+  ~Hdf5Stager() override {
+    hshm::ScopedMutex lock(GetHdf5Lock(), 0);
+    for (auto &it : dsets_) {
+      H5Tclose(it.second.type_);
+      H5Dclose(it.second.id_);
+    }
+    if (file_ >= 0) {
+      H5Fclose(file_);
+    }
+  }
+
+  /** Build context for staging */
+  static Context BuildContext(size_t page_size, u32 flags = 0) {
+    Context ctx;
+    ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
+    ctx.bkt_params_ = BuildFileParams(page_size, flags);
+    return ctx;
+  }
+
+  /** Build serialized file parameter pack */
+  static std::string BuildFileParams(size_t page_size, u32 flags = 0) {
+    hshm::charbuf params(32);
+    hrun::LocalSerialize srl(params);
+    srl << std::string("hdf5");
+    srl << flags;
+    srl << page_size;
+    return params.str();
+  }
+
+  /** Create the name of the blob holding a chunk of a dataset */
+  static hshm::charbuf CreateBlobName(const std::string &dset_name,
+                                      const std::vector<hsize_t> &chunk_idx) {
+    hshm::charbuf buf(dset_name.size() + 32);
+    hrun::LocalSerialize srl(buf);
+    srl << dset_name;
+    srl << (u32)chunk_idx.size();
+    for (hsize_t idx : chunk_idx) {
+      srl << (u64)idx;
+    }
+    return buf;
+  }
+
+  /** Decode the dataset and chunk coordinates from a blob name */
+  template<typename StringT>
+  static void DecodeBlobName(const StringT &blob_name,
+                             std::string &dset_name,
+                             std::vector<hsize_t> &chunk_idx) {
+    hrun::LocalDeserialize srl(blob_name);
+    u32 ndims;
+    srl >> dset_name;
+    srl >> ndims;
+    chunk_idx.resize(ndims);
+    for (u32 i = 0; i < ndims; ++i) {
+      u64 idx;
+      srl >> idx;
+      chunk_idx[i] = idx;
+    }
+  }
+
+  /** Create the data stager payload */
+  void RegisterStager(RegisterStagerTask *task, RunContext &rctx) override {
+    std::string params = task->params_->str();
+    std::string protocol;
+    hrun::LocalDeserialize srl(params);
+    srl >> protocol;
+    srl >> flags_.bits_;
+    srl >> page_size_;
+    path_ = task->tag_name_->str();
+  }
+
+  /** Stage a chunk in from the HDF5 file */
+  void StageIn(blob_mdm::Client &blob_mdm, StageInTask *task, RunContext &rctx) override {
+    if (flags_.Any(HERMES_STAGE_NO_READ)) {
+      return;
+    }
+    std::string blob_name = task->blob_name_->str();
+    std::string dset_name;
+    std::vector<hsize_t> chunk_idx, off, count;
+    DecodeBlobName(blob_name, dset_name, chunk_idx);
+    bool raw = false;
+    size_t blob_size = 0;
+    {
+      hshm::ScopedMutex lock(GetHdf5Lock(), 0);
+      Dataset *dset = OpenDataset(dset_name);
+      if (!dset || !GetChunkRegion(*dset, chunk_idx, off, count)) {
+        return;
+      }
+      raw = dset->chunked_ && flags_.Any(HERMES_STAGE_RAW_CHUNKS);
+      if (raw) {
+        hsize_t nbytes = 0;
+        if (H5Dget_chunk_storage_size(dset->id_, off.data(), &nbytes) < 0) {
+          return;
+        }
+        blob_size = nbytes;
+      } else {
+        blob_size = GetRegionSize(*dset, count);
+      }
+    }
+    if (blob_size == 0) {
+      // The chunk was never written
+      return;
+    }
+    HILOG(kDebug, "Attempting to stage {} bytes from chunk of {} in {}",
+          blob_size, dset_name, path_);
+    LPointer<char> blob = HRUN_CLIENT->AllocateBufferServer<TASK_YIELD_STD>(blob_size);
+    herr_t ret;
+    {
+      hshm::ScopedMutex lock(GetHdf5Lock(), 0);
+      Dataset &dset = dsets_[dset_name];
+      if (raw) {
+        u32 filter_mask = 0;
+        ret = H5Dread_chunk(dset.id_, H5P_DEFAULT, off.data(),
+                            &filter_mask, blob.ptr_);
+        filter_masks_[blob_name] = filter_mask;
+      } else {
+        ret = TransferRegion(dset, off, count, blob.ptr_, false);
+      }
+    }
+    if (ret < 0) {
+      HELOG(kError, "Failed to stage in chunk of {} from {}",
+            dset_name, path_);
+      HRUN_CLIENT->FreeBuffer(blob);
+      return;
+    }
+    HILOG(kDebug, "Submitting put blob {} ({}) to blob mdm ({})",
+          dset_name, task->bkt_id_, blob_mdm.id_)
+    hapi::Context ctx;
+    ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
+    LPointer<blob_mdm::PutBlobTask> put_task =
+        blob_mdm.AsyncPutBlob(task->task_node_ + 1,
+                              task->bkt_id_,
+                              hshm::to_charbuf(*task->blob_name_),
+                              hermes::BlobId::GetNull(),
+                              0, blob_size, blob.shm_, task->score_, 0,
+                              ctx, TASK_DATA_OWNER | TASK_LOW_LATENCY);
+    put_task->Wait<TASK_YIELD_CO>(task);
+    HRUN_CLIENT->DelTask(put_task);
+  }
+
+  /** Stage a chunk out to the HDF5 file */
+  void StageOut(blob_mdm::Client &blob_mdm, StageOutTask *task, RunContext &rctx) override {
+    if (flags_.Any(HERMES_STAGE_NO_WRITE)) {
+      return;
+    }
+    std::string blob_name = task->blob_name_->str();
+    std::string dset_name;
+    std::vector<hsize_t> chunk_idx, off, count;
+    DecodeBlobName(blob_name, dset_name, chunk_idx);
+    char *data = HRUN_CLIENT->GetDataPointer(task->data_);
+    hshm::ScopedMutex lock(GetHdf5Lock(), 0);
+    Dataset *dset = OpenDataset(dset_name);
+    if (!dset || !GetChunkRegion(*dset, chunk_idx, off, count)) {
+      HELOG(kError, "Cannot stage out chunk of {} to {}: no such chunk",
+            dset_name, path_);
+      return;
+    }
+    herr_t ret;
+    if (dset->chunked_ && flags_.Any(HERMES_STAGE_RAW_CHUNKS)) {
+      // Chunks produced by the VFD already passed through the filters
+      u32 filter_mask = 0;
+      auto it = filter_masks_.find(blob_name);
+      if (it != filter_masks_.end()) {
+        filter_mask = it->second;
+      }
+      ret = H5Dwrite_chunk(dset->id_, H5P_DEFAULT, filter_mask,
+                           off.data(), task->data_size_, data);
+    } else if (task->data_size_ != GetRegionSize(*dset, count)) {
+      HELOG(kError, "Cannot stage out chunk of {} to {}: expected {} bytes "
+            "but the blob has {}", dset_name, path_,
+            GetRegionSize(*dset, count), task->data_size_);
+      return;
+    } else {
+      ret = TransferRegion(*dset, off, count, data, true);
+    }
+    if (ret < 0) {
+      HELOG(kError, "Failed to stage out chunk of {} to {}",
+            dset_name, path_);
+      return;
+    }
+    H5Fflush(file_, H5F_SCOPE_LOCAL);
+    HILOG(kDebug, "Staged out {} bytes to chunk of {} in {}",
+          task->data_size_, dset_name, path_);
+  }
+
+  /** Update the bucket size to cover the chunk's logical byte range */
+  void UpdateSize(bucket_mdm::Client &bkt_mdm, UpdateSizeTask *task, RunContext &rctx) override {
+    std::string dset_name;
+    std::vector<hsize_t> chunk_idx;
+    DecodeBlobName(task->blob_name_->str(), dset_name, chunk_idx);
+    size_t bucket_off;
+    {
+      hshm::ScopedMutex lock(GetHdf5Lock(), 0);
+      Dataset *dset = OpenDataset(dset_name);
+      if (!dset || dset->chunk_.size() != chunk_idx.size()) {
+        return;
+      }
+      // Linearize the chunk coordinates in row-major order
+      size_t chunk_id = 0;
+      for (size_t i = 0; i < chunk_idx.size(); ++i) {
+        hsize_t nchunks = (dset->dims_[i] + dset->chunk_[i] - 1) /
+            dset->chunk_[i];
+        chunk_id = chunk_id * nchunks + chunk_idx[i];
+      }
+      bucket_off = chunk_id * GetRegionSize(*dset, dset->chunk_);
+    }
+    bkt_mdm.AsyncUpdateSize(task->task_node_ + 1,
+                            task->bkt_id_,
+                            bucket_off + task->blob_off_ + task->data_size_,
+                            bucket_mdm::UpdateSizeMode::kCap);
+  }
+
+ private:
+  /**
+   * The HDF5 library is usually not built thread-safe, so every stager
+   * in the runtime shares this lock. It is never held across a yield.
+   * */
+  static hshm::Mutex& GetHdf5Lock() {
+    static hshm::Mutex lock;
+    return lock;
+  }
+
+  /** Open the file and dataset, caching the handles. Requires the lock. */
+  Dataset* OpenDataset(const std::string &dset_name) {
+    auto it = dsets_.find(dset_name);
+    if (it != dsets_.end()) {
+      return &it->second;
+    }
+    if (file_ < 0) {
+      // The runtime and the application may both have the file open
+      hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+      H5Pset_file_locking(fapl, false, true);
+      H5E_BEGIN_TRY {
+        file_ = H5Fopen(path_.c_str(), H5F_ACC_RDWR, fapl);
+      } H5E_END_TRY;
+      H5Pclose(fapl);
+      if (file_ < 0) {
+        HELOG(kError, "Failed to open HDF5 file {}", path_);
+        return nullptr;
+      }
+    }
+    Dataset dset;
+    H5E_BEGIN_TRY {
+      dset.id_ = H5Dopen2(file_, dset_name.c_str(), H5P_DEFAULT);
+    } H5E_END_TRY;
+    if (dset.id_ < 0) {
+      HELOG(kError, "Failed to open dataset {} in {}", dset_name, path_);
+      return nullptr;
+    }
+    hid_t ftype = H5Dget_type(dset.id_);
+    dset.type_ = H5Tget_native_type(ftype, H5T_DIR_DEFAULT);
+    dset.elmt_size_ = H5Tget_size(dset.type_);
+    H5Tclose(ftype);
+    hid_t space = H5Dget_space(dset.id_);
+    int ndims = H5Sget_simple_extent_ndims(space);
+    dset.dims_.resize(ndims);
+    dset.chunk_.resize(ndims);
+    H5Sget_simple_extent_dims(space, dset.dims_.data(), nullptr);
+    H5Sclose(space);
+    hid_t dcpl = H5Dget_create_plist(dset.id_);
+    dset.chunked_ = H5Pget_layout(dcpl) == H5D_CHUNKED;
+    if (dset.chunked_) {
+      H5Pget_chunk(dcpl, ndims, dset.chunk_.data());
+    } else if (ndims > 0) {
+      // Tile contiguous datasets into pages of whole rows
+      size_t row_size = dset.elmt_size_;
+      for (int i = 1; i < ndims; ++i) {
+        dset.chunk_[i] = dset.dims_[i];
+        row_size *= dset.dims_[i];
+      }
+      dset.chunk_[0] = std::max<size_t>(page_size_ / row_size, 1);
+    }
+    H5Pclose(dcpl);
+    return &dsets_.emplace(dset_name, std::move(dset)).first->second;
+  }
+
+  /** Get the offset and shape of a chunk, clipped to the extent */
+  static bool GetChunkRegion(const Dataset &dset,
+                             const std::vector<hsize_t> &chunk_idx,
+                             std::vector<hsize_t> &off,
+                             std::vector<hsize_t> &count) {
+    if (chunk_idx.size() != dset.dims_.size()) {
+      return false;
+    }
+    off.resize(chunk_idx.size());
+    count.resize(chunk_idx.size());
+    for (size_t i = 0; i < chunk_idx.size(); ++i) {
+      off[i] = chunk_idx[i] * dset.chunk_[i];
+      if (off[i] >= dset.dims_[i]) {
+        return false;
+      }
+      count[i] = std::min(dset.chunk_[i], dset.dims_[i] - off[i]);
+    }
+    return true;
+  }
+
+  /** Get the size of a region in memory */
+  static size_t GetRegionSize(const Dataset &dset,
+                              const std::vector<hsize_t> &count) {
+    size_t size = dset.elmt_size_;
+    for (hsize_t dim : count) {
+      size *= dim;
+    }
+    return size;
+  }
+
+  /** Read or write a region through the filter pipeline */
+  static herr_t TransferRegion(Dataset &dset,
+                               const std::vector<hsize_t> &off,
+                               const std::vector<hsize_t> &count,
+                               char *buf, bool write) {
+    hid_t fspace = H5Dget_space(dset.id_);
+    hid_t mspace;
+    if (count.empty()) {
+      mspace = H5Screate(H5S_SCALAR);
+    } else {
+      H5Sselect_hyperslab(fspace, H5S_SELECT_SET, off.data(), nullptr,
+                          count.data(), nullptr);
+      mspace = H5Screate_simple((int)count.size(), count.data(), nullptr);
+    }
+    herr_t ret;
+    if (write) {
+      ret = H5Dwrite(dset.id_, dset.type_, mspace, fspace, H5P_DEFAULT, buf);
+    } else {
+      ret = H5Dread(dset.id_, dset.type_, mspace, fspace, H5P_DEFAULT, buf);
+    }
+    H5Sclose(mspace);
+    H5Sclose(fspace);
+    return ret;
+  }
+};
+
+}  // namespace hermes::data_stager
+
+#endif  // HERMES_TASKS_DATA_STAGER_SRC_HDF5_STAGER_H_
@@ -0,0 +1,274 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_TASKS_DATA_STAGER_SRC_PARQUET_STAGER_H_
+#define HERMES_TASKS_DATA_STAGER_SRC_PARQUET_STAGER_H_
+
+#include <limits>
+#include <parquet/file_reader.h>
+#include <parquet/metadata.h>
+#include "abstract_stager.h"
+
+namespace hermes::data_stager {
+
+/**
+ * Stages the column chunks of a Parquet file.
+ *
+ * Each blob is one column chunk of one row group, stored exactly as it
+ * is encoded in the file. Readers which only touch a few columns only
+ * stage in those columns. The footer is parsed once per file when the
+ * first blob is staged, and is also exposed as a blob (see
+ * CreateFooterBlobName) so clients can plan reads without opening the file.
+ * */
+class ParquetStager : public AbstractStager {
+ public:
+  /** The row group id used to name the footer blob */
+  static const u32 kFooter = std::numeric_limits<u32>::max();
+
+  /** The location of a column chunk in the file */
+  struct ColumnRange {
+    size_t off_;   /**< Offset of the first page of the chunk */
+    size_t size_;  /**< Size of the encoded chunk */
+  };
+
+ public:
+  bitfield32_t flags_;
+  bool did_load_ = false;            /**< Whether the footer was parsed */
+  size_t num_columns_ = 0;           /**< Columns per row group */
+  std::vector<ColumnRange> ranges_;  /**< Indexed by rg * ncol + col */
+  ColumnRange footer_;               /**< The footer and trailing magic */
+
+ public:
+  /** Default constructor */
+  ParquetStager() = default;
+
+  /** Destructor */
+  ~ParquetStager() override = default;
+
+  /** Build context for staging */
+  static Context BuildContext(u32 flags = 0) {
+    Context ctx;
+    ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
+    ctx.bkt_params_ = BuildFileParams(flags);
+    return ctx;
+  }
+
+  /** Build serialized file parameter pack */
+  static std::string BuildFileParams(u32 flags = 0) {
+    hshm::charbuf params(32);
+    hrun::LocalSerialize srl(params);
+    srl << std::string("parquet");
+    srl << flags;
+    return params.str();
+  }
+
+  /** Create the name of the blob holding a column chunk */
+  static hshm::charbuf CreateBlobName(u32 row_group, u32 column) {
+    hshm::charbuf buf(sizeof(u32) * 2);
+    hrun::LocalSerialize srl(buf);
+    srl << row_group;
+    srl << column;
+    return buf;
+  }
+
+  /** Create the name of the blob holding the file footer */
+  static hshm::charbuf CreateFooterBlobName() {
+    return CreateBlobName(kFooter, 0);
+  }
+
+  /** Decode the row group and column from a blob name */
+  template<typename StringT>
+  static void DecodeBlobName(const StringT &blob_name,
+                             u32 &row_group, u32 &column) {
+    hrun::LocalDeserialize srl(blob_name);
+    srl >> row_group;
+    srl >> column;
+  }
+
+  /** Create the data stager payload */
+  void RegisterStager(RegisterStagerTask *task, RunContext &rctx) override {
+    std::string params = task->params_->str();
+    std::string protocol;
+    hrun::LocalDeserialize srl(params);
+    srl >> protocol;
+    srl >> flags_.bits_;
+    path_ = task->tag_name_->str();
+  }
+
+  /** Stage a column chunk in from the Parquet file */
+  void StageIn(blob_mdm::Client &blob_mdm, StageInTask *task, RunContext &rctx) override {
+    if (flags_.Any(HERMES_STAGE_NO_READ)) {
+      return;
+    }
+    ColumnRange range;
+    if (!GetRange(*task->blob_name_, range) || range.size_ == 0) {
+      return;
+    }
+    HILOG(kDebug, "Attempting to stage {} bytes from the parquet file {} "
+          "at offset {}", range.size_, path_, range.off_);
+    LPointer<char> blob = HRUN_CLIENT->AllocateBufferServer<TASK_YIELD_STD>(range.size_);
+    int fd = fd_cache_->Open(path_);
+    if (fd < 0) {
+      HELOG(kError, "Failed to open file {}", path_);
+      HRUN_CLIENT->FreeBuffer(blob);
+      return;
+    }
+    ssize_t real_size = HERMES_POSIX_API->pread(fd,
+                                                blob.ptr_,
+                                                range.size_,
+                                                (off_t)range.off_);
+    if (real_size != (ssize_t)range.size_) {
+      HELOG(kError, "Failed to stage in {} bytes from {} at offset {}",
+            range.size_, path_, range.off_);
+      HRUN_CLIENT->FreeBuffer(blob);
+      return;
+    }
+    HILOG(kDebug, "Submitting put blob {} ({}) to blob mdm ({})",
+          task->blob_name_->str(), task->bkt_id_, blob_mdm.id_)
+    hapi::Context ctx;
+    ctx.flags_.SetBits(HERMES_SHOULD_STAGE);
+    LPointer<blob_mdm::PutBlobTask> put_task =
+        blob_mdm.AsyncPutBlob(task->task_node_ + 1,
+                              task->bkt_id_,
+                              hshm::to_charbuf(*task->blob_name_),
+                              hermes::BlobId::GetNull(),
+                              0, real_size, blob.shm_, task->score_, 0,
+                              ctx, TASK_DATA_OWNER | TASK_LOW_LATENCY);
+    put_task->Wait<TASK_YIELD_CO>(task);
+    HRUN_CLIENT->DelTask(put_task);
+  }
+
+  /**
+   * Stage a column chunk out to the Parquet file
+   *
+   * The layout of a Parquet file is fixed by its footer, so a column
+   * chunk can only be rewritten in place with an encoding of equal size.
+   * */
+  void StageOut(blob_mdm::Client &blob_mdm, StageOutTask *task, RunContext &rctx) override {
+    if (flags_.Any(HERMES_STAGE_NO_WRITE)) {
+      return;
+    }
+    ColumnRange range;
+    if (!GetRange(*task->blob_name_, range)) {
+      HELOG(kError, "Cannot stage out to {}: no such column chunk", path_);
+      return;
+    }
+    if (task->data_size_ != range.size_) {
+      HELOG(kError, "Cannot stage out to {}: column chunk at offset {} "
+            "has {} bytes, but the blob has {}",
+            path_, range.off_, range.size_, task->data_size_);
+      return;
+    }
+    int fd = fd_cache_->Open(path_);
+    if (fd < 0) {
+      HELOG(kError, "Failed to open file {}", path_);
+      return;
+    }
+    char *data = HRUN_CLIENT->GetDataPointer(task->data_);
+    ssize_t real_size = HERMES_POSIX_API->pwrite(fd,
+                                                 data,
+                                                 range.size_,
+                                                 (off_t)range.off_);
+    if (real_size != (ssize_t)range.size_) {
+      HELOG(kError, "Failed to stage out {} bytes to {} at offset {}",
+            range.size_, path_, range.off_);
+      return;
+    }
+    HILOG(kDebug, "Staged out {} bytes to the parquet file {}",
+          real_size, path_);
+  }
+
+  /** Update the bucket size to cover the column chunk */
+  void UpdateSize(bucket_mdm::Client &bkt_mdm, UpdateSizeTask *task, RunContext &rctx) override {
+    ColumnRange range;
+    if (!GetRange(*task->blob_name_, range)) {
+      return;
+    }
+    bkt_mdm.AsyncUpdateSize(task->task_node_ + 1,
+                            task->bkt_id_,
+                            range.off_ + task->blob_off_ + task->data_size_,
+                            bucket_mdm::UpdateSizeMode::kCap);
+  }
+
+ private:
+  /** Get the byte range of the blob in the file */
+  template<typename StringT>
+  bool GetRange(const StringT &blob_name, ColumnRange &range) {
+    if (!LoadFooter()) {
+      return false;
+    }
+    u32 row_group, column;
+    DecodeBlobName(blob_name, row_group, column);
+    if (row_group == kFooter) {
+      range = footer_;
+      return true;
+    }
+    if (column >= num_columns_) {
+      return false;
+    }
+    size_t idx = (size_t)row_group * num_columns_ + column;
+    if (idx >= ranges_.size()) {
+      return false;
+    }
+    range = ranges_[idx];
+    return true;
+  }
+
+  /** Parse the footer of the file, the first time it is needed */
+  bool LoadFooter() {
+    if (did_load_) {
+      return true;
+    }
+    std::shared_ptr<parquet::FileMetaData> meta;
+    try {
+      meta = parquet::ParquetFileReader::OpenFile(path_)->metadata();
+    } catch (std::exception &e) {
+      HELOG(kError, "Failed to read the parquet footer of {}: {}",
+            path_, e.what());
+      return false;
+    }
+    // The footer is followed by its length (4 bytes) and magic (4 bytes)
+    int fd = fd_cache_->Open(path_);
+    struct stat st;
+    if (fd < 0 || HERMES_POSIX_API->fstat(fd, &st) != 0) {
+      HELOG(kError, "Failed to stat file {}", path_);
+      return false;
+    }
+    footer_.size_ = meta->size() + 8;
+    footer_.off_ = st.st_size - footer_.size_;
+    num_columns_ = meta->num_columns();
+    ranges_.resize((size_t)meta->num_row_groups() * num_columns_);
+    for (int rg = 0; rg < meta->num_row_groups(); ++rg) {
+      std::unique_ptr<parquet::RowGroupMetaData> rg_meta = meta->RowGroup(rg);
+      for (int col = 0; col < (int)num_columns_; ++col) {
+        std::unique_ptr<parquet::ColumnChunkMetaData> col_meta =
+            rg_meta->ColumnChunk(col);
+        ColumnRange &range = ranges_[rg * num_columns_ + col];
+        range.off_ = col_meta->data_page_offset();
+        if (col_meta->has_dictionary_page() &&
+            col_meta->dictionary_page_offset() > 0) {
+          range.off_ = std::min<size_t>(range.off_,
+                                        col_meta->dictionary_page_offset());
+        }
+        range.size_ = col_meta->total_compressed_size();
+      }
+    }
+    HILOG(kDebug, "Loaded the parquet footer of {}: {} row groups, {} columns",
+          path_, meta->num_row_groups(), num_columns_);
+    did_load_ = true;
+    return true;
+  }
+};
+
+}  // namespace hermes::data_stager
+
+#endif  // HERMES_TASKS_DATA_STAGER_SRC_PARQUET_STAGER_H_
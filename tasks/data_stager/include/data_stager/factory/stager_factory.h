@@ -8,6 +8,12 @@
 #include "../data_stager.h"
 #include "abstract_stager.h"
 #include "binary_stager.h"
+#ifdef HERMES_ENABLE_HDF5_STAGER
+#include "hdf5_stager.h"
+#endif
+#ifdef HERMES_ENABLE_PARQUET_STAGER
+#include "parquet_stager.h"
+#endif
 
 namespace hermes::data_stager {
 
@@ -23,7 +29,17 @@ class StagerFactory {
     if (protocol == "file") {
       stager = std::make_unique<BinaryFileStager>();
     } else if (protocol == "parquet") {
+#ifdef HERMES_ENABLE_PARQUET_STAGER
+      stager = std::make_unique<ParquetStager>();
+#else
+      throw std::runtime_error("Hermes was not built with the parquet stager");
+#endif
     } else if (protocol == "hdf5") {
+#ifdef HERMES_ENABLE_HDF5_STAGER
+      stager = std::make_unique<Hdf5Stager>();
+#else
+      throw std::runtime_error("Hermes was not built with the HDF5 stager");
+#endif
     } else {
       throw std::runtime_error("Unknown stager type");
     }
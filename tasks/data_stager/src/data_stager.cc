@@ -10,12 +10,15 @@
 #include "hermes_blob_mdm/hermes_blob_mdm.h"
 #include "data_stager/factory/stager_factory.h"
 #include "hermes_bucket_mdm/hermes_bucket_mdm.h"
+#include "hermes/config_manager.h"
 
 namespace hermes::data_stager {
 
 class Server : public TaskLib {
  public:
   std::vector<std::unordered_map<hermes::BucketId, std::unique_ptr<AbstractStager>>> url_map_;
+  std::vector<FdCache> fd_cache_;
+  size_t max_batch_size_;
   blob_mdm::Client blob_mdm_;
   bucket_mdm::Client bkt_mdm_;
 
@@ -26,6 +29,14 @@ class Server : public TaskLib {
   void Construct(ConstructTask *task, RunContext &rctx) {
     task->Deserialize();
     url_map_.resize(HRUN_QM_RUNTIME->max_lanes_);
+    // Divide the open file budget among the lanes
+    fd_cache_.resize(HRUN_QM_RUNTIME->max_lanes_);
+    size_t max_open_fds = HERMES_SERVER_CONF.stager_.max_open_fds_;
+    for (FdCache &fd_cache : fd_cache_) {
+      fd_cache.Init(max_open_fds / HRUN_QM_RUNTIME->max_lanes_);
+    }
+    max_batch_size_ = std::max<size_t>(
+        HERMES_SERVER_CONF.stager_.max_batch_size_, 1);
     blob_mdm_.Init(task->blob_mdm_, HRUN_ADMIN->queue_id_);
     bkt_mdm_.Init(task->bkt_mdm_, HRUN_ADMIN->queue_id_);
     HILOG(kInfo, "(node {}) BLOB MDM: {}", HRUN_CLIENT->node_id_, blob_mdm_.id_);
@@ -47,6 +58,8 @@ class Server : public TaskLib {
     std::string params = task->params_->str();
     HILOG(kDebug, "Registering stager {}: {}", task->bkt_id_, tag_name);
     std::unique_ptr<AbstractStager> stager = StagerFactory::Get(tag_name, params);
+    stager->fd_cache_ = &fd_cache_[rctx.lane_id_];
+    stager->max_batch_size_ = max_batch_size_;
     stager->RegisterStager(task, rctx);
     url_map_[rctx.lane_id_].emplace(task->bkt_id_, std::move(stager));
     task->SetModuleComplete();
@@ -57,11 +70,14 @@ class Server : public TaskLib {
   /** Unregister stager */
   void UnregisterStager(UnregisterStagerTask *task, RunContext &rctx) {
     HILOG(kDebug, "Unregistering stager {}", task->bkt_id_);
-    if (url_map_[rctx.lane_id_].find(task->bkt_id_) == url_map_[rctx.lane_id_].end()) {
+    std::unordered_map<hermes::BucketId, std::unique_ptr<AbstractStager>>::iterator it =
+        url_map_[rctx.lane_id_].find(task->bkt_id_);
+    if (it == url_map_[rctx.lane_id_].end()) {
       task->SetModuleComplete();
       return;
     }
-    url_map_[rctx.lane_id_].erase(task->bkt_id_);
+    fd_cache_[rctx.lane_id_].Close(it->second->path_);
+    url_map_[rctx.lane_id_].erase(it);
     task->SetModuleComplete();
   }
   void MonitorUnregisterStager(u32 mode, UnregisterStagerTask *task, RunContext &rctx) {
@@ -262,6 +262,48 @@ class Client : public TaskLibClient {
   }
   HRUN_TASK_NODE_PUSH_ROOT(GetBlobId);
 
+  /**
+   * Lock \a blob_name BLOB of \a tag_id bucket. Held until UnlockBlob.
+   * */
+  void AsyncLockBlobConstruct(LockBlobTask *task,
+                              const TaskNode &task_node,
+                              const TagId &tag_id,
+                              const hshm::charbuf &blob_name) {
+    u32 hash = HashBlobName(tag_id, blob_name);
+    HRUN_CLIENT->ConstructTask<LockBlobTask>(
+        task, task_node, DomainId::GetNode(HASH_TO_NODE_ID(hash)), id_,
+        tag_id, blob_name);
+  }
+  void LockBlobRoot(const TagId &tag_id,
+                    const hshm::charbuf &blob_name) {
+    LPointer<hrunpq::TypedPushTask<LockBlobTask>> push_task =
+        AsyncLockBlobRoot(tag_id, blob_name);
+    push_task->Wait();
+    HRUN_CLIENT->DelTask(push_task);
+  }
+  HRUN_TASK_NODE_PUSH_ROOT(LockBlob);
+
+  /**
+   * Unlock \a blob_name BLOB of \a tag_id bucket
+   * */
+  void AsyncUnlockBlobConstruct(UnlockBlobTask *task,
+                                const TaskNode &task_node,
+                                const TagId &tag_id,
+                                const hshm::charbuf &blob_name) {
+    u32 hash = HashBlobName(tag_id, blob_name);
+    HRUN_CLIENT->ConstructTask<UnlockBlobTask>(
+        task, task_node, DomainId::GetNode(HASH_TO_NODE_ID(hash)), id_,
+        tag_id, blob_name);
+  }
+  void UnlockBlobRoot(const TagId &tag_id,
+                      const hshm::charbuf &blob_name) {
+    LPointer<hrunpq::TypedPushTask<UnlockBlobTask>> push_task =
+        AsyncUnlockBlobRoot(tag_id, blob_name);
+    push_task->Wait();
+    HRUN_CLIENT->DelTask(push_task);
+  }
+  HRUN_TASK_NODE_PUSH_ROOT(UnlockBlob);
+
   /**
    * Get \a blob_name BLOB name from \a blob_id BLOB id
    * */
@@ -387,16 +429,18 @@ class Client : public TaskLibClient {
                                   const TaskNode &task_node,
                                   const TagId &tag_id,
                                   const BlobId &blob_id,
-                                  size_t new_size) {
+                                  size_t new_size,
+                                  bool update_size = true) {
     HRUN_CLIENT->ConstructTask<TruncateBlobTask>(
         task, task_node, DomainId::GetNode(blob_id.node_id_), id_,
-        tag_id, blob_id, new_size);
+        tag_id, blob_id, new_size, update_size);
   }
   void TruncateBlobRoot(const TagId &tag_id,
                         const BlobId &blob_id,
-                        size_t new_size) {
+                        size_t new_size,
+                        bool update_size = true) {
     LPointer<hrunpq::TypedPushTask<TruncateBlobTask>> push_task =
-                                                          AsyncTruncateBlobRoot(tag_id, blob_id, new_size);
+        AsyncTruncateBlobRoot(tag_id, blob_id, new_size, update_size);
     push_task->Wait();
     HRUN_CLIENT->DelTask(push_task);
   }
@@ -433,6 +477,15 @@ class Client : public TaskLibClient {
   }
   HRUN_TASK_NODE_PUSH_ROOT(FlushData);
 
+  /** Initialize automatic eviction */
+  void AsyncEvictBlobsConstruct(EvictBlobsTask *task,
+                                const TaskNode &task_node,
+                                size_t period_ms) {
+    HRUN_CLIENT->ConstructTask<EvictBlobsTask>(
+        task, task_node, id_, period_ms);
+  }
+  HRUN_TASK_NODE_PUSH_ROOT(EvictBlobs);
+
   /**
    * Get all blob metadata
    * */
@@ -472,6 +525,48 @@ class Client : public TaskLibClient {
     return target_mdms;
   }
   HRUN_TASK_NODE_PUSH_ROOT(PollTargetMetadata);
+
+  /**
+   * Get the read cache of this node's blob_mdm.
+   * Null if the read cache is disabled.
+   * */
+  void AsyncGetReadCacheConstruct(GetReadCacheTask *task,
+                                  const TaskNode &task_node) {
+    HRUN_CLIENT->ConstructTask<GetReadCacheTask>(
+        task, task_node, id_);
+  }
+  BlobReadCache* GetReadCacheRoot() {
+    LPointer<hrunpq::TypedPushTask<GetReadCacheTask>> push_task =
+        AsyncGetReadCacheRoot();
+    push_task->Wait();
+    GetReadCacheTask *task = push_task->get();
+    BlobReadCache *cache = nullptr;
+    if (!task->cache_.IsNull()) {
+      cache = HRUN_CLIENT->GetDataPointer<BlobReadCache>(task->cache_);
+    }
+    HRUN_CLIENT->DelTask(push_task);
+    return cache;
+  }
+  HRUN_TASK_NODE_PUSH_ROOT(GetReadCache);
+
+  /**
+   * Get the QoS statistics of every tenant on every node
+   * */
+  void AsyncPollQosStatsConstruct(PollQosStatsTask *task,
+                                  const TaskNode &task_node) {
+    HRUN_CLIENT->ConstructTask<PollQosStatsTask>(
+        task, task_node, id_);
+  }
+  std::vector<QosTenantStats> PollQosStatsRoot() {
+    LPointer<hrunpq::TypedPushTask<PollQosStatsTask>> push_task =
+        AsyncPollQosStatsRoot();
+    push_task->Wait();
+    PollQosStatsTask *task = push_task->get();
+    std::vector<QosTenantStats> stats = task->DeserializeQosStats();
+    HRUN_CLIENT->DelTask(push_task);
+    return stats;
+  }
+  HRUN_TASK_NODE_PUSH_ROOT(PollQosStats);
 };
 
 }  // namespace hrun
@@ -84,6 +84,26 @@ void Run(u32 method, Task *task, RunContext &rctx) override {
       PollTargetMetadata(reinterpret_cast<PollTargetMetadataTask *>(task), rctx);
       break;
     }
+    case Method::kGetReadCache: {
+      GetReadCache(reinterpret_cast<GetReadCacheTask *>(task), rctx);
+      break;
+    }
+    case Method::kPollQosStats: {
+      PollQosStats(reinterpret_cast<PollQosStatsTask *>(task), rctx);
+      break;
+    }
+    case Method::kEvictBlobs: {
+      EvictBlobs(reinterpret_cast<EvictBlobsTask *>(task), rctx);
+      break;
+    }
+    case Method::kLockBlob: {
+      LockBlob(reinterpret_cast<LockBlobTask *>(task), rctx);
+      break;
+    }
+    case Method::kUnlockBlob: {
+      UnlockBlob(reinterpret_cast<UnlockBlobTask *>(task), rctx);
+      break;
+    }
   }
 }
 /** Execute a task */
@@ -169,6 +189,26 @@ void Monitor(u32 mode, Task *task, RunContext &rctx) override {
       MonitorPollTargetMetadata(mode, reinterpret_cast<PollTargetMetadataTask *>(task), rctx);
       break;
     }
+    case Method::kGetReadCache: {
+      MonitorGetReadCache(mode, reinterpret_cast<GetReadCacheTask *>(task), rctx);
+      break;
+    }
+    case Method::kPollQosStats: {
+      MonitorPollQosStats(mode, reinterpret_cast<PollQosStatsTask *>(task), rctx);
+      break;
+    }
+    case Method::kEvictBlobs: {
+      MonitorEvictBlobs(mode, reinterpret_cast<EvictBlobsTask *>(task), rctx);
+      break;
+    }
+    case Method::kLockBlob: {
+      MonitorLockBlob(mode, reinterpret_cast<LockBlobTask *>(task), rctx);
+      break;
+    }
+    case Method::kUnlockBlob: {
+      MonitorUnlockBlob(mode, reinterpret_cast<UnlockBlobTask *>(task), rctx);
+      break;
+    }
   }
 }
 /** Delete a task */
@@ -254,6 +294,26 @@ void Del(u32 method, Task *task) override {
       HRUN_CLIENT->DelTask<PollTargetMetadataTask>(reinterpret_cast<PollTargetMetadataTask *>(task));
       break;
     }
+    case Method::kGetReadCache: {
+      HRUN_CLIENT->DelTask<GetReadCacheTask>(reinterpret_cast<GetReadCacheTask *>(task));
+      break;
+    }
+    case Method::kPollQosStats: {
+      HRUN_CLIENT->DelTask<PollQosStatsTask>(reinterpret_cast<PollQosStatsTask *>(task));
+      break;
+    }
+    case Method::kEvictBlobs: {
+      HRUN_CLIENT->DelTask<EvictBlobsTask>(reinterpret_cast<EvictBlobsTask *>(task));
+      break;
+    }
+    case Method::kLockBlob: {
+      HRUN_CLIENT->DelTask<LockBlobTask>(reinterpret_cast<LockBlobTask *>(task));
+      break;
+    }
+    case Method::kUnlockBlob: {
+      HRUN_CLIENT->DelTask<UnlockBlobTask>(reinterpret_cast<UnlockBlobTask *>(task));
+      break;
+    }
   }
 }
 /** Duplicate a task */
@@ -339,6 +399,26 @@ void Dup(u32 method, Task *orig_task, std::vector<LPointer<Task>> &dups) overrid
       hrun::CALL_DUPLICATE(reinterpret_cast<PollTargetMetadataTask*>(orig_task), dups);
       break;
     }
+    case Method::kGetReadCache: {
+      hrun::CALL_DUPLICATE(reinterpret_cast<GetReadCacheTask*>(orig_task), dups);
+      break;
+    }
+    case Method::kPollQosStats: {
+      hrun::CALL_DUPLICATE(reinterpret_cast<PollQosStatsTask*>(orig_task), dups);
+      break;
+    }
+    case Method::kEvictBlobs: {
+      hrun::CALL_DUPLICATE(reinterpret_cast<EvictBlobsTask*>(orig_task), dups);
+      break;
+    }
+    case Method::kLockBlob: {
+      hrun::CALL_DUPLICATE(reinterpret_cast<LockBlobTask*>(orig_task), dups);
+      break;
+    }
+    case Method::kUnlockBlob: {
+      hrun::CALL_DUPLICATE(reinterpret_cast<UnlockBlobTask*>(orig_task), dups);
+      break;
+    }
   }
 }
 /** Register the duplicate output with the origin task */
@@ -424,6 +504,26 @@ void DupEnd(u32 method, u32 replica, Task *orig_task, Task *dup_task) override {
       hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<PollTargetMetadataTask*>(orig_task), reinterpret_cast<PollTargetMetadataTask*>(dup_task));
       break;
     }
+    case Method::kGetReadCache: {
+      hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<GetReadCacheTask*>(orig_task), reinterpret_cast<GetReadCacheTask*>(dup_task));
+      break;
+    }
+    case Method::kPollQosStats: {
+      hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<PollQosStatsTask*>(orig_task), reinterpret_cast<PollQosStatsTask*>(dup_task));
+      break;
+    }
+    case Method::kEvictBlobs: {
+      hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<EvictBlobsTask*>(orig_task), reinterpret_cast<EvictBlobsTask*>(dup_task));
+      break;
+    }
+    case Method::kLockBlob: {
+      hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<LockBlobTask*>(orig_task), reinterpret_cast<LockBlobTask*>(dup_task));
+      break;
+    }
+    case Method::kUnlockBlob: {
+      hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<UnlockBlobTask*>(orig_task), reinterpret_cast<UnlockBlobTask*>(dup_task));
+      break;
+    }
   }
 }
 /** Ensure there is space to store replicated outputs */
@@ -509,6 +609,26 @@ void ReplicateStart(u32 method, u32 count, Task *task) override {
       hrun::CALL_REPLICA_START(count, reinterpret_cast<PollTargetMetadataTask*>(task));
       break;
     }
+    case Method::kGetReadCache: {
+      hrun::CALL_REPLICA_START(count, reinterpret_cast<GetReadCacheTask*>(task));
+      break;
+    }
+    case Method::kPollQosStats: {
+      hrun::CALL_REPLICA_START(count, reinterpret_cast<PollQosStatsTask*>(task));
+      break;
+    }
+    case Method::kEvictBlobs: {
+      hrun::CALL_REPLICA_START(count, reinterpret_cast<EvictBlobsTask*>(task));
+      break;
+    }
+    case Method::kLockBlob: {
+      hrun::CALL_REPLICA_START(count, reinterpret_cast<LockBlobTask*>(task));
+      break;
+    }
+    case Method::kUnlockBlob: {
+      hrun::CALL_REPLICA_START(count, reinterpret_cast<UnlockBlobTask*>(task));
+      break;
+    }
   }
 }
 /** Determine success and handle failures */
@@ -594,6 +714,26 @@ void ReplicateEnd(u32 method, Task *task) override {
       hrun::CALL_REPLICA_END(reinterpret_cast<PollTargetMetadataTask*>(task));
       break;
     }
+    case Method::kGetReadCache: {
+      hrun::CALL_REPLICA_END(reinterpret_cast<GetReadCacheTask*>(task));
+      break;
+    }
+    case Method::kPollQosStats: {
+      hrun::CALL_REPLICA_END(reinterpret_cast<PollQosStatsTask*>(task));
+      break;
+    }
+    case Method::kEvictBlobs: {
+      hrun::CALL_REPLICA_END(reinterpret_cast<EvictBlobsTask*>(task));
+      break;
+    }
+    case Method::kLockBlob: {
+      hrun::CALL_REPLICA_END(reinterpret_cast<LockBlobTask*>(task));
+      break;
+    }
+    case Method::kUnlockBlob: {
+      hrun::CALL_REPLICA_END(reinterpret_cast<UnlockBlobTask*>(task));
+      break;
+    }
   }
 }
 /** Serialize a task when initially pushing into remote */
@@ -679,6 +819,26 @@ std::vector<DataTransfer> SaveStart(u32 method, BinaryOutputArchive<true> &ar, T
       ar << *reinterpret_cast<PollTargetMetadataTask*>(task);
       break;
     }
+    case Method::kGetReadCache: {
+      ar << *reinterpret_cast<GetReadCacheTask*>(task);
+      break;
+    }
+    case Method::kPollQosStats: {
+      ar << *reinterpret_cast<PollQosStatsTask*>(task);
+      break;
+    }
+    case Method::kEvictBlobs: {
+      ar << *reinterpret_cast<EvictBlobsTask*>(task);
+      break;
+    }
+    case Method::kLockBlob: {
+      ar << *reinterpret_cast<LockBlobTask*>(task);
+      break;
+    }
+    case Method::kUnlockBlob: {
+      ar << *reinterpret_cast<UnlockBlobTask*>(task);
+      break;
+    }
   }
   return ar.Get();
 }
@@ -786,6 +946,31 @@ TaskPointer LoadStart(u32 method, BinaryInputArchive<true> &ar) override {
       ar >> *reinterpret_cast<PollTargetMetadataTask*>(task_ptr.ptr_);
       break;
     }
+    case Method::kGetReadCache: {
+      task_ptr.ptr_ = HRUN_CLIENT->NewEmptyTask<GetReadCacheTask>(task_ptr.shm_);
+      ar >> *reinterpret_cast<GetReadCacheTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kPollQosStats: {
+      task_ptr.ptr_ = HRUN_CLIENT->NewEmptyTask<PollQosStatsTask>(task_ptr.shm_);
+      ar >> *reinterpret_cast<PollQosStatsTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kEvictBlobs: {
+      task_ptr.ptr_ = HRUN_CLIENT->NewEmptyTask<EvictBlobsTask>(task_ptr.shm_);
+      ar >> *reinterpret_cast<EvictBlobsTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kLockBlob: {
+      task_ptr.ptr_ = HRUN_CLIENT->NewEmptyTask<LockBlobTask>(task_ptr.shm_);
+      ar >> *reinterpret_cast<LockBlobTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kUnlockBlob: {
+      task_ptr.ptr_ = HRUN_CLIENT->NewEmptyTask<UnlockBlobTask>(task_ptr.shm_);
+      ar >> *reinterpret_cast<UnlockBlobTask*>(task_ptr.ptr_);
+      break;
+    }
   }
   return task_ptr;
 }
@@ -872,6 +1057,26 @@ std::vector<DataTransfer> SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Ta
       ar << *reinterpret_cast<PollTargetMetadataTask*>(task);
       break;
     }
+    case Method::kGetReadCache: {
+      ar << *reinterpret_cast<GetReadCacheTask*>(task);
+      break;
+    }
+    case Method::kPollQosStats: {
+      ar << *reinterpret_cast<PollQosStatsTask*>(task);
+      break;
+    }
+    case Method::kEvictBlobs: {
+      ar << *reinterpret_cast<EvictBlobsTask*>(task);
+      break;
+    }
+    case Method::kLockBlob: {
+      ar << *reinterpret_cast<LockBlobTask*>(task);
+      break;
+    }
+    case Method::kUnlockBlob: {
+      ar << *reinterpret_cast<UnlockBlobTask*>(task);
+      break;
+    }
   }
   return ar.Get();
 }
@@ -958,6 +1163,26 @@ void LoadEnd(u32 replica, u32 method, BinaryInputArchive<false> &ar, Task *task)
       ar.Deserialize(replica, *reinterpret_cast<PollTargetMetadataTask*>(task));
       break;
     }
+    case Method::kGetReadCache: {
+      ar.Deserialize(replica, *reinterpret_cast<GetReadCacheTask*>(task));
+      break;
+    }
+    case Method::kPollQosStats: {
+      ar.Deserialize(replica, *reinterpret_cast<PollQosStatsTask*>(task));
+      break;
+    }
+    case Method::kEvictBlobs: {
+      ar.Deserialize(replica, *reinterpret_cast<EvictBlobsTask*>(task));
+      break;
+    }
+    case Method::kLockBlob: {
+      ar.Deserialize(replica, *reinterpret_cast<LockBlobTask*>(task));
+      break;
+    }
+    case Method::kUnlockBlob: {
+      ar.Deserialize(replica, *reinterpret_cast<UnlockBlobTask*>(task));
+      break;
+    }
   }
 }
 /** Get the grouping of the task */
@@ -1023,6 +1248,21 @@ u32 GetGroup(u32 method, Task *task, hshm::charbuf &group) override {
     case Method::kPollTargetMetadata: {
       return reinterpret_cast<PollTargetMetadataTask*>(task)->GetGroup(group);
     }
+    case Method::kGetReadCache: {
+      return reinterpret_cast<GetReadCacheTask*>(task)->GetGroup(group);
+    }
+    case Method::kPollQosStats: {
+      return reinterpret_cast<PollQosStatsTask*>(task)->GetGroup(group);
+    }
+    case Method::kEvictBlobs: {
+      return reinterpret_cast<EvictBlobsTask*>(task)->GetGroup(group);
+    }
+    case Method::kLockBlob: {
+      return reinterpret_cast<LockBlobTask*>(task)->GetGroup(group);
+    }
+    case Method::kUnlockBlob: {
+      return reinterpret_cast<UnlockBlobTask*>(task)->GetGroup(group);
+    }
   }
   return -1;
 }
@@ -21,6 +21,11 @@ struct Method : public TaskMethod {
   TASK_METHOD_T kFlushData = kLast + 17;
   TASK_METHOD_T kPollBlobMetadata = kLast + 18;
   TASK_METHOD_T kPollTargetMetadata = kLast + 19;
+  TASK_METHOD_T kGetReadCache = kLast + 20;
+  TASK_METHOD_T kPollQosStats = kLast + 21;
+  TASK_METHOD_T kEvictBlobs = kLast + 22;
+  TASK_METHOD_T kLockBlob = kLast + 23;
+  TASK_METHOD_T kUnlockBlob = kLast + 24;
 };
 
 #endif  // HRUN_HERMES_BLOB_MDM_METHODS_H_
\ No newline at end of file
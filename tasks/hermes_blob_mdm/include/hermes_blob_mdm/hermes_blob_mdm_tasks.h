@@ -10,6 +10,7 @@
 #include "hrun_admin/hrun_admin.h"
 #include "hrun/queue_manager/queue_manager_client.h"
 #include "hermes/hermes_types.h"
+#include "hermes/blob_read_cache.h"
 #include "bdev/bdev.h"
 #include "hrun/api/hrun_client.h"
 #include "proc_queue/proc_queue.h"
@@ -235,6 +236,12 @@ class PutBlobPhase {
 #define HERMES_GET_BLOB_ID BIT_OPT(u32, 7)
 #define HERMES_HAS_DERIVED BIT_OPT(u32, 8)
 #define HERMES_USER_SCORE_STATIONARY BIT_OPT(u32, 9)
+#define HERMES_STAGE_RAW_CHUNKS BIT_OPT(u32, 10)
+#define HERMES_READ_CACHE_PENDING BIT_OPT(u32, 11)
+#define HERMES_BLOB_INTERNAL_IO BIT_OPT(u32, 12)
+#define HERMES_BLOB_DEDUP BIT_OPT(u32, 13)
+#define HERMES_BLOB_CHECKSUM BIT_OPT(u32, 14)
+#define HERMES_BLOB_FLUSH_FAILED BIT_OPT(u32, 15)
 
 /** A task to put data in a blob */
 struct PutBlobTask : public Task, TaskFlags<TF_SRL_ASYM_START | TF_SRL_SYM_END> {
@@ -246,6 +253,9 @@ struct PutBlobTask : public Task, TaskFlags<TF_SRL_ASYM_START | TF_SRL_SYM_END>
   IN float score_;
   IN bitfield32_t flags_;
   IN BlobId blob_id_;
+  IN u32 evict_policy_;
+  IN float evict_ttl_;
+  OUT int rc_;  /**< The Status code, e.g., BLOB_NO_SPACE */
 
   /** SHM default constructor */
   HSHM_ALWAYS_INLINE explicit
@@ -291,6 +301,16 @@ struct PutBlobTask : public Task, TaskFlags<TF_SRL_ASYM_START | TF_SRL_SYM_END>
     data_ = data;
     score_ = score;
     flags_ = bitfield32_t(flags | ctx.flags_.bits_);
+    if (ctx.dedup_) {
+      flags_.SetBits(HERMES_BLOB_DEDUP);
+    }
+    if (ctx.checksum_) {
+      flags_.SetBits(HERMES_BLOB_CHECKSUM);
+    }
+    evict_policy_ = (u32)ctx.evict_policy_;
+    evict_ttl_ = ctx.evict_ttl_;
+    rc_ = 0;
+    SetQos(GetQosTenant(tag_id, ctx), data_size);
     // HILOG(kInfo, "Creating PUT {} of size {}", task_node_, data_size_);
   }
 
@@ -311,7 +331,8 @@ struct PutBlobTask : public Task, TaskFlags<TF_SRL_ASYM_START | TF_SRL_SYM_END>
                       data_size_, domain_id_);
     task_serialize<Ar>(ar);
     ar & xfer;
-    ar(tag_id_, blob_name_, blob_id_, blob_off_, data_size_, score_, flags_);
+    ar(tag_id_, blob_name_, blob_id_, blob_off_, data_size_, score_, flags_,
+       evict_policy_, evict_ttl_);
   }
 
   /** Deserialize message call */
@@ -321,12 +342,14 @@ struct PutBlobTask : public Task, TaskFlags<TF_SRL_ASYM_START | TF_SRL_SYM_END>
     task_serialize<Ar>(ar);
     ar & xfer;
     data_ = HERMES_MEMORY_MANAGER->Convert<void, hipc::Pointer>(xfer.data_);
-    ar(tag_id_, blob_name_, blob_id_, blob_off_, data_size_, score_, flags_);
+    ar(tag_id_, blob_name_, blob_id_, blob_off_, data_size_, score_, flags_,
+       evict_policy_, evict_ttl_);
   }
 
   /** (De)serialize message return */
   template<typename Ar>
   void SerializeEnd(u32 replica, Ar &ar) {
+    ar(rc_);
     if (flags_.Any(HERMES_GET_BLOB_ID)) {
       ar(blob_id_);
     }
@@ -358,6 +381,7 @@ struct GetBlobTask : public Task, TaskFlags<TF_SRL_ASYM_START | TF_SRL_SYM_END>
   IN hipc::Pointer data_;
   INOUT size_t data_size_;
   IN bitfield32_t flags_;
+  OUT int rc_;  /**< The Status code, e.g., BLOB_CHECKSUM_MISMATCH */
 
   /** SHM default constructor */
   HSHM_ALWAYS_INLINE explicit
@@ -398,6 +422,8 @@ struct GetBlobTask : public Task, TaskFlags<TF_SRL_ASYM_START | TF_SRL_SYM_END>
     data_size_ = data_size;
     data_ = data;
     flags_ = bitfield32_t(flags | ctx.flags_.bits_);
+    rc_ = 0;
+    SetQos(GetQosTenant(tag_id, ctx), data_size);
     HSHM_MAKE_AR(blob_name_, alloc, blob_name);
   }
 
@@ -448,6 +474,7 @@ struct GetBlobTask : public Task, TaskFlags<TF_SRL_ASYM_START | TF_SRL_SYM_END>
   /** (De)serialize message return */
   template<typename Ar>
   void SerializeEnd(u32 replica, Ar &ar) {
+    ar(rc_);
     if (flags_.Any(HERMES_GET_BLOB_ID)) {
       ar(blob_id_);
     }
@@ -960,6 +987,7 @@ struct TruncateBlobTask : public Task, TaskFlags<TF_SRL_SYM> {
   IN TagId tag_id_;
   IN BlobId blob_id_;
   IN u64 size_;
+  IN bool update_size_;
 
   /** SHM default constructor */
   HSHM_ALWAYS_INLINE explicit
@@ -973,7 +1001,8 @@ struct TruncateBlobTask : public Task, TaskFlags<TF_SRL_SYM> {
                    const TaskStateId &state_id,
                    const TagId &tag_id,
                    const BlobId &blob_id,
-                   u64 size) : Task(alloc) {
+                   u64 size,
+                   bool update_size) : Task(alloc) {
     // Initialize task
     task_node_ = task_node;
     lane_hash_ = blob_id.hash_;
@@ -987,13 +1016,14 @@ struct TruncateBlobTask : public Task, TaskFlags<TF_SRL_SYM> {
     tag_id_ = tag_id;
     blob_id_ = blob_id;
     size_ = size;
+    update_size_ = update_size;
   }
 
   /** (De)serialize message call */
   template<typename Ar>
   void SerializeStart(Ar &ar) {
     task_serialize<Ar>(ar);
-    ar(tag_id_, blob_id_, size_);
+    ar(tag_id_, blob_id_, size_, update_size_);
   }
 
   /** (De)serialize message return */
@@ -1219,6 +1249,67 @@ struct FlushDataTask : public Task, TaskFlags<TF_SRL_SYM | TF_REPLICA> {
   }
 };
 
+/** A task to evict blobs from targets which are filling up */
+struct EvictBlobsTask : public Task, TaskFlags<TF_SRL_SYM | TF_REPLICA> {
+  /** SHM default constructor */
+  HSHM_ALWAYS_INLINE explicit
+  EvictBlobsTask(hipc::Allocator *alloc) : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_ALWAYS_INLINE explicit
+  EvictBlobsTask(hipc::Allocator *alloc,
+                 const TaskNode &task_node,
+                 const TaskStateId &state_id,
+                 size_t period_ms) : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    lane_hash_ = 0;
+    prio_ = TaskPrio::kLongRunningTether;
+    task_state_ = state_id;
+    method_ = Method::kEvictBlobs;
+    task_flags_.SetBits(
+        TASK_LANE_ALL |
+        TASK_FIRE_AND_FORGET |
+        TASK_LONG_RUNNING |
+        TASK_COROUTINE |
+        TASK_REMOTE_DEBUG_MARK);
+    SetPeriodMs((double)period_ms);
+    domain_id_ = DomainId::GetLocal();
+  }
+
+  /** Duplicate message */
+  void Dup(hipc::Allocator *alloc, EvictBlobsTask &other) {
+    task_dup(other);
+  }
+
+  /** Process duplicate message output */
+  void DupEnd(u32 replica, EvictBlobsTask &dup_task) {
+  }
+
+  /** (De)serialize message call */
+  template<typename Ar>
+  void SerializeStart(Ar &ar) {
+    task_serialize<Ar>(ar);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void SerializeEnd(u32 replica, Ar &ar) {
+  }
+
+  /** Begin replication */
+  void ReplicateStart(u32 count) {}
+
+  /** Finalize replication */
+  void ReplicateEnd() {}
+
+  /** Create group */
+  HSHM_ALWAYS_INLINE
+  u32 GetGroup(hshm::charbuf &group) {
+    return TASK_UNORDERED;
+  }
+};
+
 /** A task to collect blob metadata */
 struct PollBlobMetadataTask : public Task, TaskFlags<TF_SRL_SYM_START | TF_SRL_ASYM_END | TF_REPLICA> {
   TEMP hipc::ShmArchive<hipc::string> my_blob_mdm_;
@@ -1457,6 +1548,285 @@ struct PollTargetMetadataTask : public Task, TaskFlags<TF_SRL_SYM_START | TF_SRL
   }
 };
 
+/** A task to get the node-local blob read cache */
+struct GetReadCacheTask : public Task, TaskFlags<TF_SRL_SYM> {
+  OUT hipc::Pointer cache_;  /**< The BlobReadCache (node-local only) */
+
+  /** SHM default constructor */
+  HSHM_ALWAYS_INLINE explicit
+  GetReadCacheTask(hipc::Allocator *alloc) : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_ALWAYS_INLINE explicit
+  GetReadCacheTask(hipc::Allocator *alloc,
+                   const TaskNode &task_node,
+                   const TaskStateId &state_id) : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    lane_hash_ = 0;
+    prio_ = TaskPrio::kLowLatency;
+    task_state_ = state_id;
+    method_ = Method::kGetReadCache;
+    task_flags_.SetBits(TASK_LOW_LATENCY);
+    domain_id_ = DomainId::GetLocal();
+
+    // Custom params
+    cache_.SetNull();
+  }
+
+  /** (De)serialize message call */
+  template<typename Ar>
+  void SerializeStart(Ar &ar) {
+    task_serialize<Ar>(ar);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void SerializeEnd(u32 replica, Ar &ar) {
+    // cache_ is only meaningful on this node
+  }
+
+  /** Create group */
+  HSHM_ALWAYS_INLINE
+  u32 GetGroup(hshm::charbuf &group) {
+    return TASK_UNORDERED;
+  }
+};
+
+/** A task to collect the QoS statistics of every tenant */
+struct PollQosStatsTask : public Task, TaskFlags<TF_SRL_SYM_START | TF_SRL_ASYM_START | TF_REPLICA> {
+  OUT hipc::ShmArchive<hipc::string> my_stats_;
+  TEMP hipc::ShmArchive<hipc::vector<hipc::string>> stats_;
+
+  /** SHM default constructor */
+  HSHM_ALWAYS_INLINE explicit
+  PollQosStatsTask(hipc::Allocator *alloc) : Task(alloc) {
+    HSHM_MAKE_AR0(stats_, alloc)
+  }
+
+  /** Emplace constructor */
+  HSHM_ALWAYS_INLINE explicit
+  PollQosStatsTask(hipc::Allocator *alloc,
+                   const TaskNode &task_node,
+                   const TaskStateId &state_id) : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    lane_hash_ = 0;
+    prio_ = TaskPrio::kLowLatency;
+    task_state_ = state_id;
+    method_ = Method::kPollQosStats;
+    task_flags_.SetBits(TASK_COROUTINE);
+    domain_id_ = DomainId::GetGlobal();
+
+    // Custom params
+    HSHM_MAKE_AR0(my_stats_, alloc)
+    HSHM_MAKE_AR0(stats_, alloc)
+  }
+
+  /** Serialize tenant stats */
+  void SerializeQosStats(const std::vector<QosTenantStats> &stats) {
+    std::stringstream ss;
+    cereal::BinaryOutputArchive ar(ss);
+    ar << stats;
+    (*my_stats_) = ss.str();
+  }
+
+  /** Deserialize tenant stats */
+  void DeserializeQosStats(const std::string &srl,
+                           std::vector<QosTenantStats> &stats) {
+    std::vector<QosTenantStats> tmp_stats;
+    std::stringstream ss(srl);
+    cereal::BinaryInputArchive ar(ss);
+    ar >> tmp_stats;
+    for (QosTenantStats &tenant : tmp_stats) {
+      stats.emplace_back(tenant);
+    }
+  }
+
+  /** Get combined output of all replicas */
+  std::vector<QosTenantStats> MergeQosStats() {
+    std::vector<QosTenantStats> stats;
+    for (const hipc::string &srl : *stats_) {
+      DeserializeQosStats(srl.str(), stats);
+    }
+    return stats;
+  }
+
+  /** Deserialize final query output */
+  std::vector<QosTenantStats> DeserializeQosStats() {
+    std::vector<QosTenantStats> stats;
+    DeserializeQosStats(my_stats_->str(), stats);
+    return stats;
+  }
+
+  /** Destructor */
+  ~PollQosStatsTask() {
+    HSHM_DESTROY_AR(my_stats_)
+    HSHM_DESTROY_AR(stats_)
+  }
+
+  /** Duplicate message */
+  void Dup(hipc::Allocator *alloc, PollQosStatsTask &other) {}
+
+  /** Process duplicate message output */
+  void DupEnd(u32 replica, PollQosStatsTask &dup_task) {
+    (*stats_)[replica] = (*dup_task.my_stats_);
+  }
+
+  /** (De)serialize message call */
+  template<typename Ar>
+  void SerializeStart(Ar &ar) {
+    task_serialize<Ar>(ar);
+    ar(my_stats_);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void SaveEnd(Ar &ar) {
+    ar(my_stats_);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void LoadEnd(u32 replica, Ar &ar) {
+    ar(my_stats_);
+    DupEnd(replica, *this);
+  }
+
+  /** Begin replication */
+  void ReplicateStart(u32 count) {
+    stats_->resize(count);
+  }
+
+  /** Finalize replication */
+  void ReplicateEnd() {
+    std::vector<QosTenantStats> stats = MergeQosStats();
+    SerializeQosStats(stats);
+  }
+
+  /** Create group */
+  HSHM_ALWAYS_INLINE
+  u32 GetGroup(hshm::charbuf &group) {
+    return TASK_UNORDERED;
+  }
+};
+
+/**
+ * Lock \a blob_name blob across processes. Waits while another client
+ * holds the lock. The blob need not exist.
+ * */
+struct LockBlobTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN TagId tag_id_;
+  IN hipc::ShmArchive<hipc::charbuf> blob_name_;
+
+  /** SHM default constructor */
+  HSHM_ALWAYS_INLINE explicit
+  LockBlobTask(hipc::Allocator *alloc) : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_ALWAYS_INLINE explicit
+  LockBlobTask(hipc::Allocator *alloc,
+               const TaskNode &task_node,
+               const DomainId &domain_id,
+               const TaskStateId &state_id,
+               const TagId &tag_id,
+               const hshm::charbuf &blob_name) : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    lane_hash_ = HashBlobName(tag_id, blob_name);
+    prio_ = TaskPrio::kLowLatency;
+    task_state_ = state_id;
+    method_ = Method::kLockBlob;
+    task_flags_.SetBits(TASK_LOW_LATENCY | TASK_COROUTINE);
+    domain_id_ = domain_id;
+
+    // Custom
+    tag_id_ = tag_id;
+    HSHM_MAKE_AR(blob_name_, alloc, blob_name)
+  }
+
+  /** Destructor */
+  ~LockBlobTask() {
+    HSHM_DESTROY_AR(blob_name_)
+  }
+
+  /** (De)serialize message call */
+  template<typename Ar>
+  void SerializeStart(Ar &ar) {
+    task_serialize<Ar>(ar);
+    ar(tag_id_, blob_name_);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void SerializeEnd(u32 replica, Ar &ar) {
+  }
+
+  /**
+   * Create group. A waiting lock must not hold back the blob
+   * operations of the tag, including the holder's unlock.
+   * */
+  HSHM_ALWAYS_INLINE
+  u32 GetGroup(hshm::charbuf &group) {
+    return TASK_UNORDERED;
+  }
+};
+
+/** Release the lock on \a blob_name blob taken by LockBlobTask */
+struct UnlockBlobTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN TagId tag_id_;
+  IN hipc::ShmArchive<hipc::charbuf> blob_name_;
+
+  /** SHM default constructor */
+  HSHM_ALWAYS_INLINE explicit
+  UnlockBlobTask(hipc::Allocator *alloc) : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_ALWAYS_INLINE explicit
+  UnlockBlobTask(hipc::Allocator *alloc,
+                 const TaskNode &task_node,
+                 const DomainId &domain_id,
+                 const TaskStateId &state_id,
+                 const TagId &tag_id,
+                 const hshm::charbuf &blob_name) : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    lane_hash_ = HashBlobName(tag_id, blob_name);
+    prio_ = TaskPrio::kLowLatency;
+    task_state_ = state_id;
+    method_ = Method::kUnlockBlob;
+    task_flags_.SetBits(TASK_LOW_LATENCY);
+    domain_id_ = domain_id;
+
+    // Custom
+    tag_id_ = tag_id;
+    HSHM_MAKE_AR(blob_name_, alloc, blob_name)
+  }
+
+  /** Destructor */
+  ~UnlockBlobTask() {
+    HSHM_DESTROY_AR(blob_name_)
+  }
+
+  /** (De)serialize message call */
+  template<typename Ar>
+  void SerializeStart(Ar &ar) {
+    task_serialize<Ar>(ar);
+    ar(tag_id_, blob_name_);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void SerializeEnd(u32 replica, Ar &ar) {
+  }
+
+  /** Create group */
+  HSHM_ALWAYS_INLINE
+  u32 GetGroup(hshm::charbuf &group) {
+    return TASK_UNORDERED;
+  }
+};
+
 }  // namespace hermes::blob_mdm
 
 #endif //HRUN_TASKS_HERMES_BLOB_MDM_INCLUDE_HERMES_BLOB_MDM_HERMES_BLOB_MDM_TASKS_H_
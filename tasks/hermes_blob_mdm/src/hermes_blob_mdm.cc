@@ -12,12 +12,17 @@
 #include "data_stager/data_stager.h"
 #include "hermes_data_op/hermes_data_op.h"
 #include "hermes/score_histogram.h"
+#include "hermes/eviction/evictor_factory.h"
+#include "hermes/dedup_index.h"
+#include "hermes/crc32c.h"
+#include <unordered_set>
 
 namespace hermes::blob_mdm {
 
 /** Type name simplification for the various map types */
 typedef std::unordered_map<hshm::charbuf, BlobId> BLOB_ID_MAP_T;
 typedef std::unordered_map<BlobId, BlobInfo> BLOB_MAP_T;
+typedef std::unordered_set<hshm::charbuf> BLOB_LOCK_SET_T;
 typedef hipc::mpsc_queue<IoStat> IO_PATTERN_LOG_T;
 
 class Server : public TaskLib {
@@ -32,6 +37,7 @@ class Server : public TaskLib {
    * ===================================*/
   std::vector<BLOB_ID_MAP_T> blob_id_map_;
   std::vector<BLOB_MAP_T> blob_map_;
+  std::vector<BLOB_LOCK_SET_T> blob_locks_;  /**< Blob names locked by clients */
   std::atomic<u64> id_alloc_;
 
   /**====================================
@@ -54,6 +60,28 @@ class Server : public TaskLib {
   data_op::Client op_mdm_;
   LPointer<FlushDataTask> flush_task_;
 
+  /**====================================
+   * Read cache
+   * ===================================*/
+  BlobReadCache *read_cache_ = nullptr;  /**< Null if disabled */
+  hipc::Pointer read_cache_p_;           /**< Shared-memory read_cache_ */
+
+  /**====================================
+   * Eviction
+   * ===================================*/
+  std::vector<EvictionIndex> evict_index_;  /**< Eviction order per lane */
+  LPointer<EvictBlobsTask> evict_task_;
+
+  /**====================================
+   * Deduplication
+   * ===================================*/
+  DedupIndex dedup_index_;  /**< The shared buffers of this node's targets */
+
+  /**====================================
+   * Checksums
+   * ===================================*/
+  std::unordered_map<TargetId, std::atomic<size_t>> crc_errors_;
+
  public:
   Server() = default;
 
@@ -64,11 +92,15 @@ class Server : public TaskLib {
     // Initialize blob maps
     blob_id_map_.resize(HRUN_QM_RUNTIME->max_lanes_);
     blob_map_.resize(HRUN_QM_RUNTIME->max_lanes_);
+    blob_locks_.resize(HRUN_QM_RUNTIME->max_lanes_);
+    evict_index_.resize(HRUN_QM_RUNTIME->max_lanes_);
     // Initialize targets
     target_tasks_.reserve(HERMES_SERVER_CONF.devices_.size());
     for (DeviceInfo &dev : HERMES_SERVER_CONF.devices_) {
       std::string dev_type;
-      if (dev.mount_dir_.empty()) {
+      if (dev.io_api_ == IoInterface::kMmap) {
+        dev_type = "mmap_bdev";
+      } else if (dev.mount_dir_.empty()) {
         dev_type = "ram_bdev";
         dev.mount_point_ =
             hshm::Formatter::format("{}/{}", dev.mount_dir_, dev.dev_name_);
@@ -103,10 +135,41 @@ class Server : public TaskLib {
     }
     for (bdev::Client &client : targets_) {
       target_map_.emplace(client.id_, &client);
+      crc_errors_[client.id_].store(0);
       HILOG(kInfo, "(node {}) Target {} has bw {} and score {}", HRUN_CLIENT->node_id_,
             client.id_, client.bandwidth_, client.bw_score_);
     }
     fallback_target_ = &targets_.back();
+    // Create the read cache in the data segment, which clients map
+    config::ReadCacheInfo &cache_info = HERMES_SERVER_CONF.read_cache_;
+    read_cache_p_.SetNull();
+    if (cache_info.enabled_ && cache_info.ways_ > 0 &&
+        cache_info.max_blob_size_ > 0) {
+      size_t cache_size = BlobReadCache::GetAllocSize(
+          cache_info.capacity_, cache_info.max_blob_size_, cache_info.ways_);
+      LPointer<char> p =
+          HRUN_CLIENT->data_alloc_->AllocateLocalPtr<char>(cache_size);
+      read_cache_ = reinterpret_cast<BlobReadCache*>(p.ptr_);
+      read_cache_p_ = p.shm_;
+      read_cache_->Init(cache_info.capacity_, cache_info.max_blob_size_,
+                        cache_info.ways_);
+      HILOG(kInfo, "(node {}) Created a read cache of {} bytes",
+            HRUN_CLIENT->node_id_, cache_size);
+    }
+    // Install the QoS policies of tenants into the workers
+    config::QosInfo &qos_info = HERMES_SERVER_CONF.qos_;
+    if (qos_info.enabled_) {
+      hrun::QosManager &qos = HRUN_WORK_ORCHESTRATOR->qos_;
+      for (config::QosTenantInfo &tenant : qos_info.tenants_) {
+        hrun::QosPolicy policy;
+        policy.weight_ = tenant.weight_;
+        policy.max_bw_ = tenant.max_bw_;
+        policy.max_ops_ = tenant.max_ops_;
+        qos.SetPolicy(hrun::HashQosTenant(hshm::charbuf(tenant.name_)),
+                      tenant.name_, policy);
+      }
+      qos.Enable(qos_info.quantum_);
+    }
     blob_mdm_.Init(id_, HRUN_ADMIN->queue_id_);
     HILOG(kInfo, "(node {}) Created Blob MDM", HRUN_CLIENT->node_id_);
     task->SetModuleComplete();
@@ -142,6 +205,8 @@ class Server : public TaskLib {
       op_mdm_.Init(task->op_mdm_, HRUN_ADMIN->queue_id_);
       flush_task_ = blob_mdm_.AsyncFlushData(
           task->task_node_ + 1, HERMES_SERVER_CONF.borg_.flush_period_);
+      evict_task_ = blob_mdm_.AsyncEvictBlobs(
+          task->task_node_ + 1, HERMES_SERVER_CONF.eviction_.period_ms_);
     }
     task->SetModuleComplete();
   }
@@ -302,9 +367,23 @@ class Server : public TaskLib {
                                    blob_info.name_,
                                    blob_info.blob_id_,
                                    0, blob_info.blob_size_,
-                                   data.shm_);
+                                   data.shm_, Context(),
+                                   HERMES_BLOB_INTERNAL_IO);
         get_blob->Wait<TASK_YIELD_CO>(task);
+        bool is_valid = get_blob->rc_ == 0 &&
+            get_blob->data_size_ == blob_info.blob_size_;
         HRUN_CLIENT->DelTask(get_blob);
+        if (!is_valid) {
+          // Never stage out data which failed verification. The blob stays
+          // dirty, so it is retried and never dropped by the eviction task.
+          if (!blob_info.flags_.Any(HERMES_BLOB_FLUSH_FAILED)) {
+            HELOG(kError, "Not flushing blob {}, which could not be read",
+                  blob_info.blob_id_);
+            blob_info.flags_.SetBits(HERMES_BLOB_FLUSH_FAILED);
+          }
+          HRUN_CLIENT->FreeBuffer(data);
+          continue;
+        }
         flush_info.stage_task_ =
           stager_mdm_.AsyncStageOut(task->task_node_ + 1,
                                     blob_info.tag_id_,
@@ -322,6 +401,7 @@ class Server : public TaskLib {
       BlobInfo &blob_info = *flush_info.blob_info_;
       flush_info.stage_task_->Wait<TASK_YIELD_CO>(task);
       blob_info.last_flush_ = flush_info.mod_count_;
+      blob_info.flags_.UnsetBits(HERMES_BLOB_FLUSH_FAILED);
       HRUN_CLIENT->DelTask(flush_info.stage_task_);
     }
   }
@@ -329,6 +409,10 @@ class Server : public TaskLib {
     BLOB_MAP_T &blob_map = blob_map_[rctx.lane_id_];
     for (auto &it : blob_map) {
       BlobInfo &blob_info = it.second;
+      // Blobs which cannot be read would otherwise stall every flush
+      if (blob_info.flags_.Any(HERMES_BLOB_FLUSH_FAILED)) {
+        continue;
+      }
       if (blob_info.last_flush_ > 0 &&
           blob_info.mod_count_ > blob_info.last_flush_) {
         rctx.flush_->count_ += 1;
@@ -337,22 +421,246 @@ class Server : public TaskLib {
     }
   }
 
+  /**
+   * Long-running task to drop expired blobs and to evict blobs from
+   * targets above their high watermark
+   * */
+  static const size_t kMaxEvictScan = 1024;
+  void EvictBlobs(EvictBlobsTask *task, RunContext &rctx) {
+    EvictionIndex &index = evict_index_[rctx.lane_id_];
+    if (index.size() == 0) {
+      return;
+    }
+    // Drop expired blobs. Pinned blobs and blobs whose backend copy is
+    // stale stay until their next put instead of expiring every period.
+    BLOB_MAP_T &blob_map = blob_map_[rctx.lane_id_];
+    std::vector<BlobId> victims;
+    index.GetExpired(victims);
+    for (BlobId &blob_id : victims) {
+      if (EvictDropBlob(blob_id, task, rctx)) {
+        continue;
+      }
+      auto it = blob_map.find(blob_id);
+      if (it != blob_map.end() &&
+          it->second.flags_.Any(HERMES_USER_SCORE_STATIONARY |
+                                HERMES_BLOB_FLUSH_FAILED)) {
+        index.Retain(blob_id);
+      }
+    }
+    // Free space on targets above their high watermark
+    config::EvictionInfo &conf = HERMES_SERVER_CONF.eviction_;
+    MultiQueue *queue = HRUN_CLIENT->GetQueue(queue_id_);
+    size_t num_lanes = std::max<size_t>(
+        queue->GetGroup(TaskPrio::kLowLatency).num_lanes_, 1);
+    for (size_t tgt_idx = 0; tgt_idx < targets_.size(); ++tgt_idx) {
+      bdev::Client &target = targets_[tgt_idx];
+      size_t used = target.max_cap_ - target.monitor_task_->rem_cap_;
+      float thresh = target.max_cap_ * target.borg_max_thresh_;
+      size_t high = (size_t)(thresh * conf.high_watermark_);
+      size_t low = (size_t)(thresh * conf.low_watermark_);
+      if (used <= high) {
+        continue;
+      }
+      // Blobs are spread over the lanes, so each lane frees its share
+      size_t to_free = (used - low) / num_lanes + 1;
+      size_t freed = 0;
+      // Blobs on other targets, e.g., ones demoted earlier, stay at the
+      // cold end. Widen the scan past them until enough space is freed.
+      std::unordered_set<BlobId> scanned;
+      for (size_t scan = kMaxEvictScan; freed < to_free; scan *= 2) {
+        victims.clear();
+        index.GetVictims(scan, victims);
+        for (BlobId &blob_id : victims) {
+          if (freed >= to_free) {
+            break;
+          }
+          if (!scanned.emplace(blob_id).second) {
+            continue;
+          }
+          freed += EvictBlob(blob_id, tgt_idx, task, rctx);
+        }
+        if (victims.size() < scan) {
+          break;
+        }
+      }
+      HILOG(kDebug, "(node {}) Evicted {} bytes from target {}",
+            HRUN_CLIENT->node_id_, freed, target.id_);
+    }
+  }
+  void MonitorEvictBlobs(u32 mode, EvictBlobsTask *task, RunContext &rctx) {
+  }
+
+  /** Whether \a target stays under its high watermark after \a size bytes */
+  bool HasEvictionRoom(const bdev::Client &target, size_t size) {
+    config::EvictionInfo &conf = HERMES_SERVER_CONF.eviction_;
+    size_t used = target.max_cap_ - target.monitor_task_->rem_cap_;
+    float high = target.max_cap_ * target.borg_max_thresh_ *
+        conf.high_watermark_;
+    return used + size <= high;
+  }
+
+  /**
+   * Evict a blob from the target at \a tgt_idx. Demotes it to the fastest
+   * slower target with room. Otherwise, drops it if it can be staged in
+   * from its backend again. Returns the bytes freed on the target, which
+   * exclude buffers that other blobs still reference.
+   * */
+  size_t EvictBlob(const BlobId &blob_id, size_t tgt_idx,
+                   EvictBlobsTask *task, RunContext &rctx) {
+    BLOB_MAP_T &blob_map = blob_map_[rctx.lane_id_];
+    auto it = blob_map.find(blob_id);
+    if (it == blob_map.end()) {
+      return 0;
+    }
+    BlobInfo &blob_info = it->second;
+    if (blob_info.flags_.Any(HERMES_USER_SCORE_STATIONARY)) {
+      return 0;
+    }
+    const bdev::Client &target = targets_[tgt_idx];
+    size_t tgt_size = 0;
+    for (BufferInfo &buf : blob_info.buffers_) {
+      if (buf.tid_ == target.id_ && !dedup_index_.IsShared(buf)) {
+        tgt_size += buf.t_size_;
+      }
+    }
+    // Evicting a blob whose buffers are all shared frees nothing
+    if (tgt_size == 0) {
+      return 0;
+    }
+    // Demote to a slower target
+    for (size_t i = tgt_idx + 1; i < targets_.size(); ++i) {
+      const bdev::Client &lower = targets_[i];
+      if (!HasEvictionRoom(lower, blob_info.blob_size_)) {
+        continue;
+      }
+      HILOG(kDebug, "Evicting blob {} from tgt={} to tgt={}",
+            blob_id, target.id_, lower.id_);
+      LPointer<ReorganizeBlobTask> reorg_task =
+          blob_mdm_.AsyncReorganizeBlob(task->task_node_ + 1,
+                                        blob_info.tag_id_,
+                                        hshm::charbuf(""),
+                                        blob_id,
+                                        lower.score_, false, Context(),
+                                        TASK_LOW_LATENCY);
+      reorg_task->Wait<TASK_YIELD_CO>(task);
+      HRUN_CLIENT->DelTask(reorg_task);
+      return tgt_size;
+    }
+    // Only drop blobs which the data stager can restore
+    if (blob_info.last_flush_ == 0) {
+      return 0;
+    }
+    HILOG(kDebug, "Evicting blob {} from tgt={} to its backend",
+          blob_id, target.id_);
+    return EvictDropBlob(blob_id, task, rctx) ? tgt_size : 0;
+  }
+
+  /**
+   * Drop a blob from the hierarchy, staging it out first if it is dirty.
+   * Returns false if the blob could not be read or was modified while it
+   * was staged out.
+   * */
+  bool EvictDropBlob(const BlobId &blob_id,
+                     EvictBlobsTask *task, RunContext &rctx) {
+    BLOB_MAP_T &blob_map = blob_map_[rctx.lane_id_];
+    auto it = blob_map.find(blob_id);
+    if (it == blob_map.end()) {
+      evict_index_[rctx.lane_id_].Erase(blob_id);
+      return false;
+    }
+    if (it->second.flags_.Any(HERMES_USER_SCORE_STATIONARY)) {
+      // Pinned by the user, even once its TTL expires
+      return false;
+    }
+    if (it->second.flags_.Any(HERMES_BLOB_FLUSH_FAILED)) {
+      // The backend holds stale data, so this is the only copy
+      return false;
+    }
+    TagId tag_id = it->second.tag_id_;
+    bool staged = it->second.last_flush_ > 0;
+    size_t mod_count = it->second.mod_count_;
+    if (staged && mod_count > it->second.last_flush_) {
+      hshm::charbuf blob_name = it->second.name_;
+      size_t blob_size = it->second.blob_size_;
+      LPointer<char> data = HRUN_CLIENT->AllocateBufferServer<TASK_YIELD_CO>(
+          blob_size, task);
+      LPointer<GetBlobTask> get_blob =
+          blob_mdm_.AsyncGetBlob(task->task_node_ + 1,
+                                 tag_id, blob_name, blob_id,
+                                 0, blob_size, data.shm_, Context(),
+                                 HERMES_BLOB_INTERNAL_IO);
+      get_blob->Wait<TASK_YIELD_CO>(task);
+      bool is_valid = get_blob->rc_ == 0 && get_blob->data_size_ == blob_size;
+      HRUN_CLIENT->DelTask(get_blob);
+      if (!is_valid) {
+        HELOG(kError, "Not evicting blob {}, which could not be read",
+              blob_id);
+        HRUN_CLIENT->FreeBuffer(data);
+        it = blob_map.find(blob_id);
+        if (it != blob_map.end()) {
+          it->second.flags_.SetBits(HERMES_BLOB_FLUSH_FAILED);
+        }
+        return false;
+      }
+      LPointer<data_stager::StageOutTask> stage_task =
+          stager_mdm_.AsyncStageOut(task->task_node_ + 1,
+                                    tag_id, blob_name,
+                                    data.shm_, blob_size,
+                                    TASK_DATA_OWNER);
+      stage_task->Wait<TASK_YIELD_CO>(task);
+      HRUN_CLIENT->DelTask(stage_task);
+      it = blob_map.find(blob_id);
+      if (it == blob_map.end() || it->second.mod_count_ != mod_count) {
+        return false;
+      }
+      it->second.last_flush_ = mod_count;
+    }
+    // Staged blobs are sized by the stager, not the bucket
+    evict_index_[rctx.lane_id_].Evict(blob_id);
+    LPointer<DestroyBlobTask> destroy_task =
+        blob_mdm_.AsyncDestroyBlob(task->task_node_ + 1,
+                                   tag_id, blob_id, !staged);
+    destroy_task->Wait<TASK_YIELD_CO>(task);
+    HRUN_CLIENT->DelTask(destroy_task);
+    LPointer<bucket_mdm::TagRemoveBlobTask> remove_task =
+        bkt_mdm_.AsyncTagRemoveBlob(task->task_node_ + 1, tag_id, blob_id);
+    remove_task->Wait<TASK_YIELD_CO>(task);
+    HRUN_CLIENT->DelTask(remove_task);
+    if (staged) {
+      bkt_mdm_.AsyncTagInvalidateBlobIds(task->task_node_ + 1, tag_id);
+    }
+    return true;
+  }
+
   /**
    * Create a blob's metadata
    * */
   void PutBlob(PutBlobTask *task, RunContext &rctx) {
     // Get the blob info data structure
     hshm::charbuf blob_name = hshm::to_charbuf(*task->blob_name_);
-    if (task->blob_id_.IsNull()) {
-      task->blob_id_ = GetOrCreateBlobId(task->tag_id_, task->lane_hash_,
-                                         blob_name, rctx, task->flags_);
-    }
     HILOG(kDebug, "Beginning PUT for (hash: {})",
           std::hash<hshm::charbuf>{}(blob_name));
-    BLOB_MAP_T &blob_map = blob_map_[rctx.lane_id_];
-    BlobInfo &blob_info = blob_map[task->blob_id_];
+    BlobInfo *blob_ptr = ResolveBlob(task->tag_id_, task->lane_hash_,
+                                     blob_name, task->blob_id_, rctx,
+                                     task->flags_);
+    if (blob_ptr == nullptr) {
+      task->SetModuleComplete();
+      return;
+    }
+    BlobInfo &blob_info = *blob_ptr;
     blob_info.score_ = task->score_;
     blob_info.user_score_ = task->score_;
+    if (task->flags_.Any(HERMES_USER_SCORE_STATIONARY)) {
+      // The score does not decay with access patterns
+      blob_info.flags_.SetBits(HERMES_USER_SCORE_STATIONARY);
+    }
+    if (task->flags_.Any(HERMES_BLOB_DEDUP)) {
+      // Later puts, e.g., by the BORG, keep deduplicating the blob
+      blob_info.flags_.SetBits(HERMES_BLOB_DEDUP);
+    }
+    if (task->flags_.Any(HERMES_BLOB_CHECKSUM)) {
+      blob_info.flags_.SetBits(HERMES_BLOB_CHECKSUM);
+    }
 
     // Stage Blob
     if (task->flags_.Any(HERMES_SHOULD_STAGE) && blob_info.last_flush_ == 0) {
@@ -428,13 +736,19 @@ class Server : public TaskLib {
     // Place blob in buffers
     std::vector<LPointer<bdev::WriteTask>> write_tasks;
     write_tasks.reserve(blob_info.buffers_.size());
+    std::vector<DedupPending> dedup_pending;
+    std::vector<ChecksumPending> crc_pending;
+    bool dedup = blob_info.flags_.Any(HERMES_BLOB_DEDUP);
+    bool checksum = blob_info.flags_.Any(HERMES_BLOB_CHECKSUM);
+    size_t dedup_min_size = HERMES_SERVER_CONF.dedup_.min_size_;
     size_t blob_off = task->blob_off_, buf_off = 0;
     size_t buf_left = 0, buf_right = 0;
     size_t blob_right = task->blob_off_ + task->data_size_;
     char *blob_buf = HRUN_CLIENT->GetDataPointer(task->data_);
     HILOG(kDebug, "Number of buffers {}", blob_info.buffers_.size());
     bool found_left = false;
-    for (BufferInfo &buf : blob_info.buffers_) {
+    for (size_t buf_idx = 0; buf_idx < blob_info.buffers_.size(); ++buf_idx) {
+      BufferInfo &buf = blob_info.buffers_[buf_idx];
       buf_right = buf_left + buf.t_size_;
       if (blob_off >= blob_right) {
         break;
@@ -444,18 +758,56 @@ class Server : public TaskLib {
       }
       if (found_left) {
         size_t rel_off = blob_off - buf_left;
-        size_t tgt_off = buf.t_off_ + rel_off;
         size_t buf_size = buf.t_size_ - rel_off;
         if (buf_right > blob_right) {
           buf_size = blob_right - (buf_left + rel_off);
         }
-        HILOG(kDebug, "Writing {} bytes at off {} from target {}", buf_size, tgt_off, buf.tid_)
-        TargetInfo &target = *target_map_[buf.tid_];
-        LPointer<bdev::WriteTask> write_task =
-            target.AsyncWrite(task->task_node_ + 1,
-                              blob_buf + buf_off,
-                              tgt_off, buf_size);
-        write_tasks.emplace_back(write_task);
+        // Shared buffers are never modified. A buffer whose valid bytes
+        // are all overwritten may be shared in turn.
+        size_t buf_len = std::min(buf.t_size_,
+                                  blob_info.blob_size_ - buf_left);
+        bool is_whole = rel_off == 0 && buf_size == buf_len;
+        bool do_write = true;
+        if (dedup && is_whole && buf_len >= dedup_min_size) {
+          BufferFingerprint fp = FingerprintBuffer(blob_buf + buf_off,
+                                                   buf_len);
+          if (DedupShareBuffer(buf, fp, blob_buf + buf_off, buf_len,
+                               blob_info.score_, task)) {
+            do_write = false;
+            if (checksum) {
+              buf.crc_ = Crc32c::Compute(blob_buf + buf_off, buf_len);
+              buf.crc_size_ = buf_len;
+            }
+          } else {
+            do_write = CopyOnWrite(buf, blob_info.score_, false, task);
+            if (do_write) {
+              dedup_pending.emplace_back(DedupPending{buf_idx, buf, fp,
+                                                      buf_len});
+            } else {
+              task->rc_ = BLOB_NO_SPACE.code_;
+            }
+          }
+        } else {
+          do_write = CopyOnWrite(buf, blob_info.score_, !is_whole, task);
+          if (!do_write) {
+            task->rc_ = BLOB_NO_SPACE.code_;
+          }
+        }
+        if (do_write) {
+          size_t tgt_off = buf.t_off_ + rel_off;
+          HILOG(kDebug, "Writing {} bytes at off {} from target {}", buf_size, tgt_off, buf.tid_)
+          TargetInfo &target = *target_map_[buf.tid_];
+          if (checksum) {
+            crc_pending.emplace_back(ChecksumPending{
+                buf_idx, buf, write_tasks.size(), rel_off, buf_size});
+          }
+          LPointer<bdev::WriteTask> write_task =
+              target.AsyncWrite(task->task_node_ + 1,
+                                blob_buf + buf_off,
+                                tgt_off, buf_size,
+                                checksum ? buf_size : 0);
+          write_tasks.emplace_back(write_task);
+        }
         buf_off += buf_size;
         blob_off = buf_right;
       }
@@ -464,11 +816,52 @@ class Server : public TaskLib {
     blob_info.max_blob_size_ = blob_off;
 
     // Wait for the placements to complete
-    for (LPointer<bdev::WriteTask> &write_task : write_tasks) {
+    std::vector<u32> write_crcs(write_tasks.size());
+    for (size_t i = 0; i < write_tasks.size(); ++i) {
+      LPointer<bdev::WriteTask> &write_task = write_tasks[i];
       write_task->Wait<TASK_YIELD_CO>(task);
+      write_crcs[i] = write_task->crc_;
       HRUN_CLIENT->DelTask(write_task);
     }
 
+    // Extend the checksums of the written buffers
+    for (ChecksumPending &pending : crc_pending) {
+      if (pending.idx_ >= blob_info.buffers_.size()) {
+        continue;
+      }
+      BufferInfo &buf = blob_info.buffers_[pending.idx_];
+      if (buf.tid_ != pending.buf_.tid_ || buf.t_off_ != pending.buf_.t_off_) {
+        continue;
+      }
+      u32 crc = write_crcs[pending.write_idx_];
+      if (pending.rel_off_ == 0 && pending.size_ >= buf.crc_size_) {
+        buf.crc_ = crc;
+        buf.crc_size_ = pending.size_;
+      } else if (buf.crc_size_ > 0 && pending.rel_off_ == buf.crc_size_) {
+        buf.crc_ = Crc32c::Combine(buf.crc_, crc, pending.size_);
+        buf.crc_size_ += pending.size_;
+      } else {
+        ChecksumBuffer(buf, std::max(buf.crc_size_,
+                                     pending.rel_off_ + pending.size_), task);
+      }
+    }
+
+    // Share the new contents with later puts
+    for (DedupPending &pending : dedup_pending) {
+      if (pending.idx_ >= blob_info.buffers_.size()) {
+        continue;
+      }
+      BufferInfo &buf = blob_info.buffers_[pending.idx_];
+      if (buf.tid_ != pending.buf_.tid_ || buf.t_off_ != pending.buf_.t_off_ ||
+          !buf.fp_.IsNull()) {
+        continue;
+      }
+      buf.fp_ = pending.fp_;
+      if (!dedup_index_.Insert(buf, pending.len_)) {
+        buf.fp_.SetNull();
+      }
+    }
+
     // Update information
     if (task->flags_.Any(HERMES_SHOULD_STAGE)) {
       stager_mdm_.AsyncUpdateSize(task->task_node_ + 1,
@@ -497,8 +890,28 @@ class Server : public TaskLib {
     }
 
     // Free data
+    if (task->rc_ == BLOB_NO_SPACE.code_) {
+      HELOG(kError, "The put to {} was not fully applied: {}",
+            blob_name.str(), BLOB_NO_SPACE.Msg());
+    }
     HILOG(kDebug, "Completing PUT for {}", blob_name.str());
     blob_info.UpdateWriteStats();
+    // The put dirtied the blob, so the next flush tries to verify it again
+    blob_info.flags_.UnsetBits(HERMES_BLOB_FLUSH_FAILED);
+    if (!task->flags_.Any(HERMES_BLOB_INTERNAL_IO)) {
+      EvictionPolicy policy = (EvictionPolicy)task->evict_policy_;
+      if (policy != EvictionPolicy::kNone) {
+        blob_info.evict_policy_ = policy;
+        blob_info.evict_ttl_ = task->evict_ttl_;
+      }
+      evict_index_[rctx.lane_id_].Touch(blob_info, true);
+    }
+    if (read_cache_) {
+      read_cache_->Invalidate(task->blob_id_);
+      if (task->flags_.Any(HERMES_READ_CACHE_PENDING)) {
+        read_cache_->EndPut(task->blob_id_);
+      }
+    }
     task->SetModuleComplete();
   }
   void MonitorPutBlob(u32 mode, PutBlobTask *task, RunContext &rctx) {
@@ -507,26 +920,185 @@ class Server : public TaskLib {
   /** Release buffers */
   void PutBlobFreeBuffersPhase(BlobInfo &blob_info, PutBlobTask *task, RunContext &rctx) {
     for (BufferInfo &buf : blob_info.buffers_) {
-      TargetInfo &target = *target_map_[buf.tid_];
-      std::vector<BufferInfo> buf_vec = {buf};
-      target.AsyncFree(task->task_node_ + 1,
-                       blob_info.score_,
-                       std::move(buf_vec), true);
+      ReleaseBuffer(buf, blob_info.score_, task);
     }
     blob_info.buffers_.clear();
     blob_info.max_blob_size_ = 0;
     blob_info.blob_size_ = 0;
   }
 
+  /** A buffer written by a put which is shared once the write completes */
+  struct DedupPending {
+    size_t idx_;             /**< The index of the buffer in the blob */
+    BufferInfo buf_;         /**< The buffer which was written */
+    BufferFingerprint fp_;   /**< The fingerprint of its contents */
+    size_t len_;             /**< The number of bytes fingerprinted */
+  };
+
+  /** A buffer written by a put whose checksum is updated once it completes */
+  struct ChecksumPending {
+    size_t idx_;         /**< The index of the buffer in the blob */
+    BufferInfo buf_;     /**< The buffer which was written */
+    size_t write_idx_;   /**< The index of the write task */
+    size_t rel_off_;     /**< The offset of the write in the buffer */
+    size_t size_;        /**< The size of the write */
+  };
+
+  /** A read of a checksummed buffer, verified once it completes */
+  struct ChecksumRead {
+    size_t read_idx_;            /**< The index of the read task */
+    BufferInfo buf_;             /**< The buffer which was read */
+    std::vector<char> scratch_;  /**< The checked prefix, if not read in place */
+    char *dst_;                  /**< Where the requested bytes go */
+    size_t rel_off_;             /**< The offset of those bytes in the buffer */
+    size_t size_;                /**< The number of requested bytes */
+  };
+
+  /**
+   * Checksum the first \a size bytes of \a buf as they are stored. Used
+   * when a write neither replaces nor extends the checked prefix.
+   * */
+  void ChecksumBuffer(BufferInfo &buf, size_t size, Task *task) {
+    std::vector<char> data(size);
+    TargetInfo &target = *target_map_[buf.tid_];
+    LPointer<bdev::ReadTask> read_task =
+        target.AsyncRead(task->task_node_ + 1, data.data(),
+                         buf.t_off_, size, size);
+    read_task->Wait<TASK_YIELD_CO>(task);
+    buf.crc_ = read_task->crc_;
+    buf.crc_size_ = size;
+    HRUN_CLIENT->DelTask(read_task);
+  }
+
+  /** Drop a blob's reference to \a buf, freeing it if it was the last */
+  void ReleaseBuffer(const BufferInfo &buf, float score, Task *task) {
+    if (!dedup_index_.Release(buf)) {
+      return;
+    }
+    TargetInfo &target = *target_map_[buf.tid_];
+    std::vector<BufferInfo> buf_vec = {buf};
+    target.AsyncFree(task->task_node_ + 1, score, std::move(buf_vec), true);
+  }
+
+  /**
+   * Replace \a buf with a shared buffer on the same target which holds
+   * the \a len bytes at \a data, and release \a buf. Returns false if no
+   * buffer matches the fingerprint \a fp.
+   * */
+  bool DedupShareBuffer(BufferInfo &buf, const BufferFingerprint &fp,
+                        const char *data, size_t len,
+                        float score, Task *task) {
+    BufferInfo shared;
+    if (!dedup_index_.Find(buf.tid_, fp, buf.t_size_, len, shared)) {
+      return false;
+    }
+    if (HERMES_SERVER_CONF.dedup_.verify_) {
+      std::vector<char> stored(len);
+      TargetInfo &target = *target_map_[shared.tid_];
+      LPointer<bdev::ReadTask> read_task =
+          target.AsyncRead(task->task_node_ + 1, stored.data(),
+                           shared.t_off_, len);
+      read_task->Wait<TASK_YIELD_CO>(task);
+      HRUN_CLIENT->DelTask(read_task);
+      if (memcmp(stored.data(), data, len) != 0) {
+        HILOG(kDebug, "Fingerprint collision on target {}", shared.tid_);
+        ReleaseBuffer(shared, score, task);
+        return false;
+      }
+    }
+    ReleaseBuffer(buf, score, task);
+    buf = shared;
+    return true;
+  }
+
+  /**
+   * Give a blob a private copy of \a buf before modifying it, if the
+   * buffer is shared with other blobs. The copy has the same size, so
+   * the layout of the blob is unchanged. The contents are only copied if
+   * \a copy is true. Returns false if there was no space for the copy.
+   * */
+  bool CopyOnWrite(BufferInfo &buf, float score, bool copy, Task *task) {
+    if (dedup_index_.TryUnshare(buf)) {
+      return true;
+    }
+    BufferInfo new_buf;
+    if (!CopyBuffer(buf, score, copy, task, new_buf)) {
+      return false;
+    }
+    ReleaseBuffer(buf, score, task);
+    buf = new_buf;
+    return true;
+  }
+
+  /**
+   * Allocate a buffer of the same size as \a buf in \a new_buf, on the
+   * same target if possible, else on the other targets from fastest to
+   * slowest. Copy the contents if \a copy is true. \a buf is not
+   * released. Yields, so \a buf must not reference blob metadata.
+   * Returns false if no target had space for the copy.
+   * */
+  bool CopyBuffer(const BufferInfo &buf, float score, bool copy, Task *task,
+                  BufferInfo &new_buf) {
+    std::vector<TargetInfo*> targets = {target_map_[buf.tid_]};
+    for (TargetInfo &target : targets_) {
+      if (&target != targets[0]) {
+        targets.emplace_back(&target);
+      }
+    }
+    bool found = false;
+    for (TargetInfo *target : targets) {
+      std::vector<BufferInfo> bufs;
+      LPointer<bdev::AllocateTask> alloc_task =
+          target->AsyncAllocate(task->task_node_ + 1, score,
+                                buf.t_size_, bufs);
+      alloc_task->Wait<TASK_YIELD_CO>(task);
+      HRUN_CLIENT->DelTask(alloc_task);
+      if (bufs.size() == 1 && bufs[0].t_size_ == buf.t_size_) {
+        new_buf = bufs[0];
+        found = true;
+        break;
+      }
+      if (!bufs.empty()) {
+        target->AsyncFree(task->task_node_ + 1, score, std::move(bufs), true);
+      }
+    }
+    if (!found) {
+      HELOG(kError, "No space to copy a shared buffer of {} bytes",
+            buf.t_size_);
+      return false;
+    }
+    if (copy) {
+      std::vector<char> data(buf.t_size_);
+      TargetInfo &src = *target_map_[buf.tid_];
+      LPointer<bdev::ReadTask> read_task =
+          src.AsyncRead(task->task_node_ + 1, data.data(),
+                        buf.t_off_, buf.t_size_);
+      read_task->Wait<TASK_YIELD_CO>(task);
+      HRUN_CLIENT->DelTask(read_task);
+      TargetInfo &dst = *target_map_[new_buf.tid_];
+      LPointer<bdev::WriteTask> write_task =
+          dst.AsyncWrite(task->task_node_ + 1, data.data(),
+                         new_buf.t_off_, new_buf.t_size_);
+      write_task->Wait<TASK_YIELD_CO>(task);
+      HRUN_CLIENT->DelTask(write_task);
+    }
+    new_buf.crc_ = buf.crc_;
+    new_buf.crc_size_ = buf.crc_size_;
+    return true;
+  }
+
   /** Get a blob's data */
   void GetBlob(GetBlobTask *task, RunContext &rctx) {
-    if (task->blob_id_.IsNull()) {
-      hshm::charbuf blob_name = hshm::to_charbuf(*task->blob_name_);
-      task->blob_id_ = GetOrCreateBlobId(task->tag_id_, task->lane_hash_,
-                                         blob_name, rctx, task->flags_);
+    hshm::charbuf blob_name = hshm::to_charbuf(*task->blob_name_);
+    BlobInfo *blob_ptr = ResolveBlob(task->tag_id_, task->lane_hash_,
+                                     blob_name, task->blob_id_, rctx,
+                                     task->flags_);
+    if (blob_ptr == nullptr) {
+      task->data_size_ = 0;
+      task->SetModuleComplete();
+      return;
     }
-    BLOB_MAP_T &blob_map = blob_map_[rctx.lane_id_];
-    BlobInfo &blob_info = blob_map[task->blob_id_];
+    BlobInfo &blob_info = *blob_ptr;
 
     // Stage Blob
     if (task->flags_.Any(HERMES_SHOULD_STAGE) && blob_info.last_flush_ == 0) {
@@ -541,8 +1113,25 @@ class Server : public TaskLib {
       HRUN_CLIENT->DelTask(stage_task);
     }
 
-    // Read blob from buffers
+    // Read the current version of the blob from the read cache
+    char *blob_buf = HRUN_CLIENT->GetDataPointer(task->data_);
+    size_t mod_count = blob_info.mod_count_;
+    size_t cached_size;
+    if (read_cache_ &&
+        read_cache_->Read(task->blob_id_, task->blob_off_, blob_buf,
+                          task->data_size_, cached_size, mod_count)) {
+      task->data_size_ = cached_size;
+      if (!task->flags_.Any(HERMES_BLOB_INTERNAL_IO)) {
+        evict_index_[rctx.lane_id_].Touch(blob_info, false);
+      }
+      task->SetModuleComplete();
+      return;
+    }
+
+    // Read blob from buffers. Checksummed buffers are read from their
+    // start through the end of the checked prefix, so it can be verified.
     std::vector<bdev::ReadTask*> read_tasks;
+    std::vector<ChecksumRead> crc_reads;
     read_tasks.reserve(blob_info.buffers_.size());
     HILOG(kDebug, "Getting blob {} of size {} starting at offset {} (total_blob_size={}, buffers={})",
           task->blob_id_, task->data_size_, task->blob_off_, blob_info.blob_size_, blob_info.buffers_.size());
@@ -551,7 +1140,6 @@ class Server : public TaskLib {
     size_t buf_off = 0;
     size_t blob_right = task->blob_off_ + task->data_size_;
     bool found_left = false;
-    char *blob_buf = HRUN_CLIENT->GetDataPointer(task->data_);
     for (BufferInfo &buf : blob_info.buffers_) {
       buf_right = buf_left + buf.t_size_;
       if (blob_off >= blob_right) {
@@ -569,19 +1157,72 @@ class Server : public TaskLib {
         }
         HILOG(kDebug, "Loading {} bytes at off {} from target {}", buf_size, tgt_off, buf.tid_)
         TargetInfo &target = *target_map_[buf.tid_];
-        bdev::ReadTask *read_task = target.AsyncRead(task->task_node_ + 1,
-                                                     blob_buf + buf_off,
-                                                     tgt_off, buf_size).ptr_;
+        bdev::ReadTask *read_task;
+        if (buf.crc_size_ == 0) {
+          read_task = target.AsyncRead(task->task_node_ + 1,
+                                       blob_buf + buf_off,
+                                       tgt_off, buf_size).ptr_;
+        } else if (rel_off == 0 && buf_size >= buf.crc_size_) {
+          crc_reads.emplace_back(ChecksumRead{
+              read_tasks.size(), buf, {}, blob_buf + buf_off, 0, buf_size});
+          read_task = target.AsyncRead(task->task_node_ + 1,
+                                       blob_buf + buf_off,
+                                       tgt_off, buf_size,
+                                       buf.crc_size_).ptr_;
+        } else {
+          crc_reads.emplace_back(ChecksumRead{
+              read_tasks.size(), buf, {}, blob_buf + buf_off,
+              rel_off, buf_size});
+          std::vector<char> &scratch = crc_reads.back().scratch_;
+          scratch.resize(std::max(buf.crc_size_, rel_off + buf_size));
+          read_task = target.AsyncRead(task->task_node_ + 1,
+                                       scratch.data(), buf.t_off_,
+                                       scratch.size(),
+                                       buf.crc_size_).ptr_;
+        }
         read_tasks.emplace_back(read_task);
         buf_off += buf_size;
         blob_off = buf_right;
       }
       buf_left += buf.t_size_;
     }
-    for (bdev::ReadTask *&read_task : read_tasks) {
+    std::vector<u32> read_crcs(read_tasks.size());
+    for (size_t i = 0; i < read_tasks.size(); ++i) {
+      bdev::ReadTask *read_task = read_tasks[i];
       read_task->Wait<TASK_YIELD_CO>(task);
+      read_crcs[i] = read_task->crc_;
       HRUN_CLIENT->DelTask(read_task);
     }
+    // Verify the checked buffers. Data which fails is never returned.
+    bool is_valid = true;
+    for (ChecksumRead &check : crc_reads) {
+      if (read_crcs[check.read_idx_] != check.buf_.crc_) {
+        HELOG(kError, "(node {}) Checksum mismatch in blob {} on target {} "
+              "at offset {} ({} bytes)", HRUN_CLIENT->node_id_,
+              task->blob_id_, check.buf_.tid_, check.buf_.t_off_,
+              check.buf_.crc_size_);
+        crc_errors_[check.buf_.tid_].fetch_add(1);
+        is_valid = false;
+      } else if (!check.scratch_.empty()) {
+        memcpy(check.dst_, check.scratch_.data() + check.rel_off_,
+               check.size_);
+      }
+    }
+    if (!is_valid) {
+      task->rc_ = BLOB_CHECKSUM_MISMATCH.code_;
+      task->data_size_ = 0;
+      task->SetModuleComplete();
+      return;
+    }
+    // Cache whole blobs, unless a put changed them while reading
+    if (read_cache_ && task->blob_off_ == 0 && buf_off > 0 &&
+        buf_off == blob_info.blob_size_ &&
+        blob_info.mod_count_ == mod_count) {
+      read_cache_->Insert(task->blob_id_, mod_count, blob_buf, buf_off);
+    }
+    if (!task->flags_.Any(HERMES_BLOB_INTERNAL_IO)) {
+      evict_index_[rctx.lane_id_].Touch(blob_info, false);
+    }
     task->data_size_ = buf_off;
     task->SetModuleComplete();
   }
@@ -649,14 +1290,49 @@ class Server : public TaskLib {
       blob_info.mod_count_ = 0;
       blob_info.access_freq_ = 0;
       blob_info.last_flush_ = 0;
+      blob_info.evict_policy_ = HERMES_SERVER_CONF.eviction_.default_policy_;
+      blob_info.evict_ttl_ = 0;
       return blob_id;
     }
     return it->second;
   }
+
+  /**
+   * Find the metadata of \a blob_id, or of \a blob_name if the id is null.
+   * An id which is not in the map is stale, e.g., cached by a client before
+   * the blob was destroyed. It is re-resolved by name, so the stale id never
+   * creates an entry of its own. Returns null if the id is stale and there
+   * is no name to fall back on.
+   * */
+  BlobInfo* ResolveBlob(TagId &tag_id, u32 lane_hash,
+                        const hshm::charbuf &blob_name, BlobId &blob_id,
+                        RunContext &rctx, bitfield32_t &flags) {
+    BLOB_MAP_T &blob_map = blob_map_[rctx.lane_id_];
+    if (!blob_id.IsNull()) {
+      auto it = blob_map.find(blob_id);
+      if (it != blob_map.end()) {
+        return &it->second;
+      }
+      HILOG(kDebug, "Blob {} no longer exists, resolving it by name",
+            blob_id);
+      if (blob_name.size() == 0) {
+        blob_id = BlobId::GetNull();
+        return nullptr;
+      }
+    }
+    blob_id = GetOrCreateBlobId(tag_id, lane_hash, blob_name, rctx, flags);
+    return &blob_map[blob_id];
+  }
   void GetOrCreateBlobId(GetOrCreateBlobIdTask *task, RunContext &rctx) {
     hshm::charbuf blob_name = hshm::to_charbuf(*task->blob_name_);
     bitfield32_t flags;
     task->blob_id_ = GetOrCreateBlobId(task->tag_id_, task->lane_hash_, blob_name, rctx, flags);
+    if (flags.Any(HERMES_BLOB_DID_CREATE)) {
+      // The put which later fills the blob will not see it created
+      bkt_mdm_.AsyncTagAddBlob(task->task_node_ + 1,
+                               task->tag_id_,
+                               task->blob_id_);
+    }
     task->SetModuleComplete();
   }
   void MonitorGetOrCreateBlobId(u32 mode, GetOrCreateBlobIdTask *task, RunContext &rctx) {
@@ -684,6 +1360,37 @@ class Server : public TaskLib {
   void MonitorGetBlobId(u32 mode, GetBlobIdTask *task, RunContext &rctx) {
   }
 
+  /**
+   * Lock \a blob_name BLOB, waiting for the current holder to unlock it
+   * */
+  void LockBlob(LockBlobTask *task, RunContext &rctx) {
+    hshm::charbuf blob_name = hshm::to_charbuf(*task->blob_name_);
+    hshm::charbuf blob_name_unique =
+        GetBlobNameWithBucket(task->tag_id_, blob_name);
+    while (!blob_locks_[rctx.lane_id_].emplace(blob_name_unique).second) {
+      task->Yield<TASK_YIELD_CO>();
+    }
+    task->SetModuleComplete();
+  }
+  void MonitorLockBlob(u32 mode, LockBlobTask *task, RunContext &rctx) {
+  }
+
+  /**
+   * Unlock \a blob_name BLOB
+   * */
+  void UnlockBlob(UnlockBlobTask *task, RunContext &rctx) {
+    hshm::charbuf blob_name = hshm::to_charbuf(*task->blob_name_);
+    hshm::charbuf blob_name_unique =
+        GetBlobNameWithBucket(task->tag_id_, blob_name);
+    if (blob_locks_[rctx.lane_id_].erase(blob_name_unique) == 0) {
+      HELOG(kError, "Blob {} in {} was not locked",
+            blob_name.str(), task->tag_id_);
+    }
+    task->SetModuleComplete();
+  }
+  void MonitorUnlockBlob(u32 mode, UnlockBlobTask *task, RunContext &rctx) {
+  }
+
   /**
    * Get \a blob_name BLOB name from \a blob_id BLOB id
    * */
@@ -772,14 +1479,34 @@ class Server : public TaskLib {
     }
     BLOB_ID_MAP_T &blob_id_map = blob_id_map_[rctx.lane_id_];
     BlobInfo &blob = it->second;
-    blob_id_map.erase(blob.name_);
-    blob_id_map[blob.name_] = task->blob_id_;
-    blob.name_ = hshm::to_charbuf(*task->new_blob_name_);
+    hshm::charbuf new_name = hshm::to_charbuf(*task->new_blob_name_);
+    blob_id_map.erase(GetBlobNameWithBucket(blob.tag_id_, blob.name_));
+    blob_id_map[GetBlobNameWithBucket(blob.tag_id_, new_name)] =
+        task->blob_id_;
+    blob.name_ = new_name;
+    bkt_mdm_.AsyncTagInvalidateBlobIds(task->task_node_ + 1, blob.tag_id_);
     task->SetModuleComplete();
   }
   void MonitorRenameBlob(u32 mode, RenameBlobTask *task, RunContext &rctx) {
   }
 
+  /**
+   * Find \a blob_id after a yield, if it still exists and its last buffer
+   * is still \a buf. Returns nullptr otherwise.
+   * */
+  BlobInfo* FindTailBuffer(BLOB_MAP_T &blob_map, const BlobId &blob_id,
+                           const BufferInfo &buf) {
+    auto it = blob_map.find(blob_id);
+    if (it == blob_map.end() || it->second.buffers_.empty()) {
+      return nullptr;
+    }
+    BufferInfo &tail = it->second.buffers_.back();
+    if (tail.tid_ != buf.tid_ || tail.t_off_ != buf.t_off_) {
+      return nullptr;
+    }
+    return &it->second;
+  }
+
   /**
    * Truncate a blob to a new size
    * */
@@ -791,7 +1518,112 @@ class Server : public TaskLib {
       return;
     }
     BlobInfo &blob_info = it->second;
-    // TODO(llogan): truncate blob
+    if (task->size_ >= blob_info.blob_size_) {
+      task->SetModuleComplete();
+      return;
+    }
+    size_t old_size = blob_info.blob_size_;
+    float score = blob_info.score_;
+
+    // Keep the buffers overlapping the new size, group the rest by target
+    std::vector<BufferInfo> buffers;
+    std::unordered_map<TargetId, std::vector<BufferInfo>> free_bufs;
+    size_t buf_left = 0;
+    for (BufferInfo &buf : blob_info.buffers_) {
+      if (buf_left < task->size_) {
+        buffers.emplace_back(buf);
+      } else if (dedup_index_.Release(buf)) {
+        free_bufs[buf.tid_].emplace_back(buf);
+      }
+      buf_left += buf.t_size_;
+    }
+    blob_info.buffers_ = std::move(buffers);
+    blob_info.max_blob_size_ = buf_left = 0;
+    for (BufferInfo &buf : blob_info.buffers_) {
+      buf_left = blob_info.max_blob_size_;
+      blob_info.max_blob_size_ += buf.t_size_;
+    }
+    blob_info.blob_size_ = task->size_;
+    blob_info.UpdateWriteStats();
+    if (read_cache_) {
+      read_cache_->Invalidate(task->blob_id_);
+    }
+
+    // The truncated tail of the last buffer is zeroed, so a later write
+    // past the new end does not expose the old data. A buffer held only
+    // by this blob is made private here, before anything yields.
+    bool zero_tail = blob_info.max_blob_size_ > task->size_;
+    bool shared_tail = zero_tail &&
+        !dedup_index_.TryUnshare(blob_info.buffers_.back());
+    BufferInfo last;
+    if (zero_tail) {
+      last = blob_info.buffers_.back();
+    }
+    size_t rel_off = task->size_ - buf_left;
+
+    // Free the trailing buffers with one task per target
+    std::vector<std::pair<TargetInfo*, LPointer<bdev::FreeTask>>> free_tasks;
+    free_tasks.reserve(free_bufs.size());
+    for (auto &tgt_bufs : free_bufs) {
+      TargetInfo &target = *target_map_[tgt_bufs.first];
+      free_tasks.emplace_back(&target, target.AsyncFree(
+          task->task_node_ + 1, score,
+          std::move(tgt_bufs.second), false));
+    }
+    if (task->update_size_) {
+      bkt_mdm_.AsyncUpdateSize(task->task_node_ + 1,
+                               task->tag_id_,
+                               -(ssize_t)(old_size - task->size_),
+                               bucket_mdm::UpdateSizeMode::kAdd);
+    }
+
+    // Nothing below may use blob_info: a destroy or eviction on this lane
+    // can run while the task yields, so the blob is looked up again after
+    // every wait.
+    for (auto &free_task : free_tasks) {
+      free_task.second->Wait<TASK_YIELD_CO>(task);
+      // Publish the reclaimed capacity before the next StatBdev
+      free_task.first->monitor_task_->rem_cap_.store(
+          free_task.second->rem_cap_);
+      HRUN_CLIENT->DelTask(free_task.second);
+    }
+    if (!zero_tail) {
+      task->SetModuleComplete();
+      return;
+    }
+    if (shared_tail) {
+      BufferInfo copy;
+      if (!CopyBuffer(last, score, true, task, copy)) {
+        task->SetModuleComplete();
+        return;
+      }
+      BlobInfo *blob = FindTailBuffer(blob_map, task->blob_id_, last);
+      if (blob == nullptr) {
+        ReleaseBuffer(copy, score, task);
+        task->SetModuleComplete();
+        return;
+      }
+      ReleaseBuffer(last, score, task);
+      blob->buffers_.back() = copy;
+      last = copy;
+    }
+    std::vector<char> zeros(last.t_size_ - rel_off, 0);
+    TargetInfo &target = *target_map_[last.tid_];
+    LPointer<bdev::WriteTask> zero_task =
+        target.AsyncWrite(task->task_node_ + 1, zeros.data(),
+                          last.t_off_ + rel_off, zeros.size());
+    zero_task->Wait<TASK_YIELD_CO>(task);
+    HRUN_CLIENT->DelTask(zero_task);
+    // The checked prefix of the last buffer now ends at the new size
+    if (last.crc_size_ > rel_off) {
+      ChecksumBuffer(last, rel_off, task);
+      BlobInfo *blob = FindTailBuffer(blob_map, task->blob_id_, last);
+      if (blob != nullptr) {
+        BufferInfo &buf = blob->buffers_.back();
+        buf.crc_ = last.crc_;
+        buf.crc_size_ = last.crc_size_;
+      }
+    }
     task->SetModuleComplete();
   }
   void MonitorTruncateBlob(u32 mode, TruncateBlobTask *task, RunContext &rctx) {
@@ -813,9 +1645,16 @@ class Server : public TaskLib {
         BlobInfo &blob_info = it->second;
         hshm::charbuf unique_name = GetBlobNameWithBucket(blob_info.tag_id_, blob_info.name_);
         blob_id_map.erase(unique_name);
+        if (read_cache_) {
+          read_cache_->Invalidate(task->blob_id_);
+        }
+        evict_index_[rctx.lane_id_].Erase(task->blob_id_);
         HSHM_MAKE_AR0(task->free_tasks_, nullptr);
         task->free_tasks_->reserve(blob_info.buffers_.size());
         for (BufferInfo &buf : blob_info.buffers_) {
+          if (!dedup_index_.Release(buf)) {
+            continue;
+          }
           TargetInfo &tgt_info = *target_map_[buf.tid_];
           std::vector<BufferInfo> buf_vec = {buf};
           bdev::FreeTask *free_task = tgt_info.AsyncFree(
@@ -836,15 +1675,27 @@ class Server : public TaskLib {
           HRUN_CLIENT->DelTask(free_task);
         }
         BLOB_MAP_T &blob_map = blob_map_[rctx.lane_id_];
-        BlobInfo &blob_info = blob_map[task->blob_id_];
+        auto it = blob_map.find(task->blob_id_);
+        HSHM_DESTROY_AR(task->free_tasks_);
+        if (it == blob_map.end()) {
+          task->SetModuleComplete();
+          return;
+        }
+        BlobInfo &blob_info = it->second;
+        TagId tag_id = blob_info.tag_id_;
         if (task->update_size_) {
           bkt_mdm_.AsyncUpdateSize(task->task_node_ + 1,
                                    task->tag_id_,
                                    -(ssize_t) blob_info.blob_size_,
                                    bucket_mdm::UpdateSizeMode::kAdd);
         }
-        HSHM_DESTROY_AR(task->free_tasks_);
-        blob_map.erase(task->blob_id_);
+        blob_map.erase(it);
+        if (task->update_size_) {
+          // Cached ids are dropped once the blob is gone, so a client cannot
+          // cache its id again. Destroys issued by the bucket_mdm invalidate
+          // the tag themselves.
+          bkt_mdm_.AsyncTagInvalidateBlobIds(task->task_node_ + 1, tag_id);
+        }
         task->SetModuleComplete();
       }
     }
@@ -890,7 +1741,9 @@ class Server : public TaskLib {
                                                  task->blob_id_,
                                                  0,
                                                  task->data_size_,
-                                                 task->data_).ptr_;
+                                                 task->data_,
+                                                 Context(),
+                                                 HERMES_BLOB_INTERNAL_IO).ptr_;
         task->tag_id_ = blob_info.tag_id_;
         task->phase_ = ReorganizeBlobPhase::kWaitGet;
       }
@@ -898,7 +1751,15 @@ class Server : public TaskLib {
         if (!task->get_task_->IsComplete()) {
           return;
         }
+        bool is_valid = task->get_task_->rc_ == 0 &&
+            task->get_task_->data_size_ == task->data_size_;
         HRUN_CLIENT->DelTask(task->get_task_);
+        if (!is_valid) {
+          // Leave data which failed verification where it is
+          HRUN_CLIENT->FreeBuffer(task->data_);
+          task->SetModuleComplete();
+          return;
+        }
         task->phase_ = ReorganizeBlobPhase::kPut;
       }
       case ReorganizeBlobPhase::kPut: {
@@ -909,7 +1770,7 @@ class Server : public TaskLib {
             task->data_size_,
             task->data_,
             task->score_,
-            HERMES_BLOB_REPLACE | TASK_FIRE_AND_FORGET | TASK_DATA_OWNER).ptr_;
+            HERMES_BLOB_REPLACE | HERMES_BLOB_INTERNAL_IO).ptr_;
         task->SetModuleComplete();
       }
     }
@@ -955,6 +1816,11 @@ class Server : public TaskLib {
       stats.bandwidth_ = bdev_client.bandwidth_;
       stats.latency_ = bdev_client.latency_;
       stats.score_ = bdev_client.score_;
+      DedupStats dedup = dedup_index_.GetStats(bdev_client.id_);
+      stats.dedup_logical_ = dedup.logical_;
+      stats.dedup_physical_ = dedup.physical_;
+      stats.dedup_index_size_ = dedup.entries_ * DedupIndex::kEntryBytes;
+      stats.crc_errors_ = crc_errors_[bdev_client.id_].load();
       target_mdms.emplace_back(stats);
     }
     task->SerializeTargetMetadata(target_mdms);
@@ -963,6 +1829,27 @@ class Server : public TaskLib {
   void MonitorPollTargetMetadata(u32 mode, PollTargetMetadataTask *task, RunContext &rctx) {
   }
 
+  /** Get the QoS statistics of the tenants of this node */
+  void PollQosStats(PollQosStatsTask *task, RunContext &rctx) {
+    std::vector<QosTenantStats> stats =
+        HRUN_WORK_ORCHESTRATOR->qos_.GetStats();
+    for (QosTenantStats &tenant : stats) {
+      tenant.node_id_ = HRUN_CLIENT->node_id_;
+    }
+    task->SerializeQosStats(stats);
+    task->SetModuleComplete();
+  }
+  void MonitorPollQosStats(u32 mode, PollQosStatsTask *task, RunContext &rctx) {
+  }
+
+  /** Get the node-local read cache */
+  void GetReadCache(GetReadCacheTask *task, RunContext &rctx) {
+    task->cache_ = read_cache_p_;
+    task->SetModuleComplete();
+  }
+  void MonitorGetReadCache(u32 mode, GetReadCacheTask *task, RunContext &rctx) {
+  }
+
  public:
 #include "hermes_blob_mdm/hermes_blob_mdm_lib_exec.h"
 };
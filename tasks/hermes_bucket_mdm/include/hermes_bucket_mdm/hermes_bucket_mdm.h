@@ -143,6 +143,30 @@ class Client : public TaskLibClient {
     HRUN_CLIENT->DelTask(push_task);
     return tag_id;
   }
+  /**
+   * Get or create a tag. The erasure code of \a ctx is only used if the
+   * tag is created. \a ec_data and \a ec_parity are set to the code the
+   * tag was created with.
+   * */
+  HSHM_ALWAYS_INLINE
+  TagId GetOrCreateTagRoot(const hshm::charbuf &tag_name,
+                           bool blob_owner,
+                           const std::vector<TraitId> &traits,
+                           size_t backend_size,
+                           u32 flags,
+                           const Context &ctx,
+                           u32 &ec_data,
+                           u32 &ec_parity) {
+    LPointer<hrunpq::TypedPushTask<GetOrCreateTagTask>> push_task =
+        AsyncGetOrCreateTagRoot(tag_name, blob_owner, traits, backend_size, flags, ctx);
+    push_task->Wait();
+    GetOrCreateTagTask *task = push_task->get();
+    TagId tag_id = task->tag_id_;
+    ec_data = task->ec_data_;
+    ec_parity = task->ec_parity_;
+    HRUN_CLIENT->DelTask(push_task);
+    return tag_id;
+  }
   HRUN_TASK_NODE_PUSH_ROOT(GetOrCreateTag);
 
   /** Get tag ID */
@@ -238,6 +262,17 @@ class Client : public TaskLibClient {
   }
   HRUN_TASK_NODE_PUSH_ROOT(TagAddBlob);
 
+  /** Invalidate the blob IDs clients cached for a tag */
+  void AsyncTagInvalidateBlobIdsConstruct(TagInvalidateBlobIdsTask *task,
+                                          const TaskNode &task_node,
+                                          const TagId &tag_id) {
+    u32 hash = tag_id.hash_;
+    HRUN_CLIENT->ConstructTask<TagInvalidateBlobIdsTask>(
+        task, task_node, DomainId::GetNode(HASH_TO_NODE_ID(hash)), id_,
+        tag_id);
+  }
+  HRUN_TASK_NODE_PUSH_ROOT(TagInvalidateBlobIds);
+
   /** Remove a blob from a tag */
   void AsyncTagRemoveBlobConstruct(TagRemoveBlobTask *task,
                                    const TaskNode &task_node,
@@ -272,14 +307,36 @@ class Client : public TaskLibClient {
   }
   HRUN_TASK_NODE_PUSH_ROOT(TagClearBlobs);
 
+  /** Truncate a tag whose blobs are fixed-size pages */
+  void AsyncTruncateTagConstruct(TruncateTagTask *task,
+                                 const TaskNode &task_node,
+                                 const TagId &tag_id,
+                                 size_t new_size,
+                                 size_t page_size) {
+    u32 hash = tag_id.hash_;
+    HRUN_CLIENT->ConstructTask<TruncateTagTask>(
+        task, task_node, DomainId::GetNode(HASH_TO_NODE_ID(hash)), id_,
+        tag_id, new_size, page_size);
+  }
+  void TruncateTagRoot(const TagId &tag_id,
+                       size_t new_size,
+                       size_t page_size) {
+    LPointer<hrunpq::TypedPushTask<TruncateTagTask>> push_task =
+        AsyncTruncateTagRoot(tag_id, new_size, page_size);
+    push_task->Wait();
+    HRUN_CLIENT->DelTask(push_task);
+  }
+  HRUN_TASK_NODE_PUSH_ROOT(TruncateTag);
+
   /** Get the size of a bucket */
   void AsyncGetSizeConstruct(GetSizeTask *task,
                              const TaskNode &task_node,
-                             const TagId &tag_id) {
+                             const TagId &tag_id,
+                             bool attach_shm = false) {
     u32 hash = tag_id.hash_;
     HRUN_CLIENT->ConstructTask<GetSizeTask>(
         task, task_node, DomainId::GetNode(HASH_TO_NODE_ID(hash)), id_,
-        tag_id);
+        tag_id, attach_shm);
   }
   size_t GetSizeRoot(const TagId &tag_id) {
     LPointer<hrunpq::TypedPushTask<GetSizeTask>> push_task =
@@ -290,8 +347,36 @@ class Client : public TaskLibClient {
     HRUN_CLIENT->DelTask(push_task);
     return size;
   }
+  /**
+   * Get the size of a bucket owned by this node, and take a reference to
+   * its TagShm slot. A non-null \a shm must be released by ReleaseTagShm.
+   * */
+  size_t GetSizeRoot(const TagId &tag_id,
+                     u64 &shrink_count,
+                     hipc::Pointer &shm) {
+    LPointer<hrunpq::TypedPushTask<GetSizeTask>> push_task =
+        AsyncGetSizeRoot(tag_id, true);
+    push_task->Wait();
+    GetSizeTask *task = push_task->get();
+    size_t size = task->size_;
+    shrink_count = task->shrink_count_;
+    shm = task->shm_;
+    HRUN_CLIENT->DelTask(push_task);
+    return size;
+  }
   HRUN_TASK_NODE_PUSH_ROOT(GetSize);
 
+  /** Drop a reference to the TagShm slot \a p, freeing it once unused */
+  static void ReleaseTagShm(const hipc::Pointer &p) {
+    TagShm *shm = HRUN_CLIENT->GetMainPointer<TagShm>(p);
+    if (shm->ref_count_.fetch_sub(1) == 1) {
+      LPointer<char> slot;
+      slot.ptr_ = reinterpret_cast<char*>(shm);
+      slot.shm_ = p;
+      HRUN_CLIENT->main_alloc_->FreeLocalPtr(slot);
+    }
+  }
+
   /** Get contained blob ids */
   void AsyncGetContainedBlobIdsConstruct(GetContainedBlobIdsTask *task,
                              const TaskNode &task_node,
@@ -72,6 +72,14 @@ void Run(u32 method, Task *task, RunContext &rctx) override {
       PollTagMetadata(reinterpret_cast<PollTagMetadataTask *>(task), rctx);
       break;
     }
+    case Method::kTruncateTag: {
+      TruncateTag(reinterpret_cast<TruncateTagTask *>(task), rctx);
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      TagInvalidateBlobIds(reinterpret_cast<TagInvalidateBlobIdsTask *>(task), rctx);
+      break;
+    }
   }
 }
 /** Execute a task */
@@ -145,6 +153,14 @@ void Monitor(u32 mode, Task *task, RunContext &rctx) override {
       MonitorPollTagMetadata(mode, reinterpret_cast<PollTagMetadataTask *>(task), rctx);
       break;
     }
+    case Method::kTruncateTag: {
+      MonitorTruncateTag(mode, reinterpret_cast<TruncateTagTask *>(task), rctx);
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      MonitorTagInvalidateBlobIds(mode, reinterpret_cast<TagInvalidateBlobIdsTask *>(task), rctx);
+      break;
+    }
   }
 }
 /** Delete a task */
@@ -218,6 +234,14 @@ void Del(u32 method, Task *task) override {
       HRUN_CLIENT->DelTask<PollTagMetadataTask>(reinterpret_cast<PollTagMetadataTask *>(task));
       break;
     }
+    case Method::kTruncateTag: {
+      HRUN_CLIENT->DelTask<TruncateTagTask>(reinterpret_cast<TruncateTagTask *>(task));
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      HRUN_CLIENT->DelTask<TagInvalidateBlobIdsTask>(reinterpret_cast<TagInvalidateBlobIdsTask *>(task));
+      break;
+    }
   }
 }
 /** Duplicate a task */
@@ -291,6 +315,14 @@ void Dup(u32 method, Task *orig_task, std::vector<LPointer<Task>> &dups) overrid
       hrun::CALL_DUPLICATE(reinterpret_cast<PollTagMetadataTask*>(orig_task), dups);
       break;
     }
+    case Method::kTruncateTag: {
+      hrun::CALL_DUPLICATE(reinterpret_cast<TruncateTagTask*>(orig_task), dups);
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      hrun::CALL_DUPLICATE(reinterpret_cast<TagInvalidateBlobIdsTask*>(orig_task), dups);
+      break;
+    }
   }
 }
 /** Register the duplicate output with the origin task */
@@ -364,6 +396,14 @@ void DupEnd(u32 method, u32 replica, Task *orig_task, Task *dup_task) override {
       hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<PollTagMetadataTask*>(orig_task), reinterpret_cast<PollTagMetadataTask*>(dup_task));
       break;
     }
+    case Method::kTruncateTag: {
+      hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<TruncateTagTask*>(orig_task), reinterpret_cast<TruncateTagTask*>(dup_task));
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<TagInvalidateBlobIdsTask*>(orig_task), reinterpret_cast<TagInvalidateBlobIdsTask*>(dup_task));
+      break;
+    }
   }
 }
 /** Ensure there is space to store replicated outputs */
@@ -437,6 +477,14 @@ void ReplicateStart(u32 method, u32 count, Task *task) override {
       hrun::CALL_REPLICA_START(count, reinterpret_cast<PollTagMetadataTask*>(task));
       break;
     }
+    case Method::kTruncateTag: {
+      hrun::CALL_REPLICA_START(count, reinterpret_cast<TruncateTagTask*>(task));
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      hrun::CALL_REPLICA_START(count, reinterpret_cast<TagInvalidateBlobIdsTask*>(task));
+      break;
+    }
   }
 }
 /** Determine success and handle failures */
@@ -510,6 +558,14 @@ void ReplicateEnd(u32 method, Task *task) override {
       hrun::CALL_REPLICA_END(reinterpret_cast<PollTagMetadataTask*>(task));
       break;
     }
+    case Method::kTruncateTag: {
+      hrun::CALL_REPLICA_END(reinterpret_cast<TruncateTagTask*>(task));
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      hrun::CALL_REPLICA_END(reinterpret_cast<TagInvalidateBlobIdsTask*>(task));
+      break;
+    }
   }
 }
 /** Serialize a task when initially pushing into remote */
@@ -583,6 +639,14 @@ std::vector<DataTransfer> SaveStart(u32 method, BinaryOutputArchive<true> &ar, T
       ar << *reinterpret_cast<PollTagMetadataTask*>(task);
       break;
     }
+    case Method::kTruncateTag: {
+      ar << *reinterpret_cast<TruncateTagTask*>(task);
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      ar << *reinterpret_cast<TagInvalidateBlobIdsTask*>(task);
+      break;
+    }
   }
   return ar.Get();
 }
@@ -675,6 +739,16 @@ TaskPointer LoadStart(u32 method, BinaryInputArchive<true> &ar) override {
       ar >> *reinterpret_cast<PollTagMetadataTask*>(task_ptr.ptr_);
       break;
     }
+    case Method::kTruncateTag: {
+      task_ptr.ptr_ = HRUN_CLIENT->NewEmptyTask<TruncateTagTask>(task_ptr.shm_);
+      ar >> *reinterpret_cast<TruncateTagTask*>(task_ptr.ptr_);
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      task_ptr.ptr_ = HRUN_CLIENT->NewEmptyTask<TagInvalidateBlobIdsTask>(task_ptr.shm_);
+      ar >> *reinterpret_cast<TagInvalidateBlobIdsTask*>(task_ptr.ptr_);
+      break;
+    }
   }
   return task_ptr;
 }
@@ -749,6 +823,14 @@ std::vector<DataTransfer> SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Ta
       ar << *reinterpret_cast<PollTagMetadataTask*>(task);
       break;
     }
+    case Method::kTruncateTag: {
+      ar << *reinterpret_cast<TruncateTagTask*>(task);
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      ar << *reinterpret_cast<TagInvalidateBlobIdsTask*>(task);
+      break;
+    }
   }
   return ar.Get();
 }
@@ -823,6 +905,14 @@ void LoadEnd(u32 replica, u32 method, BinaryInputArchive<false> &ar, Task *task)
       ar.Deserialize(replica, *reinterpret_cast<PollTagMetadataTask*>(task));
       break;
     }
+    case Method::kTruncateTag: {
+      ar.Deserialize(replica, *reinterpret_cast<TruncateTagTask*>(task));
+      break;
+    }
+    case Method::kTagInvalidateBlobIds: {
+      ar.Deserialize(replica, *reinterpret_cast<TagInvalidateBlobIdsTask*>(task));
+      break;
+    }
   }
 }
 /** Get the grouping of the task */
@@ -879,6 +969,12 @@ u32 GetGroup(u32 method, Task *task, hshm::charbuf &group) override {
     case Method::kPollTagMetadata: {
       return reinterpret_cast<PollTagMetadataTask*>(task)->GetGroup(group);
     }
+    case Method::kTruncateTag: {
+      return reinterpret_cast<TruncateTagTask*>(task)->GetGroup(group);
+    }
+    case Method::kTagInvalidateBlobIds: {
+      return reinterpret_cast<TagInvalidateBlobIdsTask*>(task)->GetGroup(group);
+    }
   }
   return -1;
 }
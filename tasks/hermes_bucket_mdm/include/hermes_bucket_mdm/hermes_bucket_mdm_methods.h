@@ -18,6 +18,8 @@ struct Method : public TaskMethod {
   TASK_METHOD_T kSetBlobMdm = kLast + 15;
   TASK_METHOD_T kGetContainedBlobIds = kLast + 16;
   TASK_METHOD_T kPollTagMetadata = kLast + 17;
+  TASK_METHOD_T kTruncateTag = kLast + 18;
+  TASK_METHOD_T kTagInvalidateBlobIds = kLast + 19;
 };
 
 #endif  // HRUN_HERMES_BUCKET_MDM_METHODS_H_
\ No newline at end of file
@@ -354,6 +354,8 @@ struct GetOrCreateTagTask : public Task, TaskFlags<TF_SRL_SYM> {
   IN hipc::ShmArchive<hipc::vector<TraitId>> traits_;
   IN size_t backend_size_;
   IN bitfield32_t flags_;
+  INOUT u32 ec_data_;    /**< Erasure code of the tag, set on create */
+  INOUT u32 ec_parity_;  /**< Parity fragments of the tag's code */
   OUT TagId tag_id_;
 
   /** SHM default constructor */
@@ -387,6 +389,8 @@ struct GetOrCreateTagTask : public Task, TaskFlags<TF_SRL_SYM> {
     HSHM_MAKE_AR(traits_, alloc, traits)
     HSHM_MAKE_AR(params_, alloc, ctx.bkt_params_)
     flags_ = bitfield32_t(flags | ctx.flags_.bits_);
+    ec_data_ = ctx.ec_data_;
+    ec_parity_ = ctx.ec_parity_;
   }
 
   /** Destructor */
@@ -400,13 +404,14 @@ struct GetOrCreateTagTask : public Task, TaskFlags<TF_SRL_SYM> {
   template<typename Ar>
   void SerializeStart(Ar &ar) {
     task_serialize<Ar>(ar);
-    ar(tag_name_, blob_owner_, traits_, backend_size_, flags_, params_);
+    ar(tag_name_, blob_owner_, traits_, backend_size_, flags_, params_,
+       ec_data_, ec_parity_);
   }
 
   /** (De)serialize message return */
   template<typename Ar>
   void SerializeEnd(u32 replica, Ar &ar) {
-    ar(tag_id_);
+    ar(tag_id_, ec_data_, ec_parity_);
   }
 
   /** Create group */
@@ -701,6 +706,58 @@ struct TagAddBlobTask : public Task, TaskFlags<TF_SRL_SYM> {
   }
 };
 
+/**
+ * A task to invalidate the blob IDs that clients cached for a tag,
+ * e.g., after a blob was destroyed or renamed
+ * */
+struct TagInvalidateBlobIdsTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN TagId tag_id_;
+
+  /** SHM default constructor */
+  HSHM_ALWAYS_INLINE explicit
+  TagInvalidateBlobIdsTask(hipc::Allocator *alloc) : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_ALWAYS_INLINE explicit
+  TagInvalidateBlobIdsTask(hipc::Allocator *alloc,
+                           const TaskNode &task_node,
+                           const DomainId &domain_id,
+                           const TaskStateId &state_id,
+                           TagId tag_id) : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    lane_hash_ = tag_id.hash_;
+    prio_ = TaskPrio::kLowLatency;
+    task_state_ = state_id;
+    method_ = Method::kTagInvalidateBlobIds;
+    task_flags_.SetBits(TASK_LOW_LATENCY | TASK_FIRE_AND_FORGET);
+    domain_id_ = domain_id;
+
+    // Custom params
+    tag_id_ = tag_id;
+  }
+
+  /** (De)serialize message call */
+  template<typename Ar>
+  void SerializeStart(Ar &ar) {
+    task_serialize<Ar>(ar);
+    ar(tag_id_);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void SerializeEnd(u32 replica, Ar &ar) {}
+
+  /** Create group */
+  HSHM_ALWAYS_INLINE
+  u32 GetGroup(hshm::charbuf &group) {
+    hrun::LocalSerialize srl(group);
+    srl << task_state_;
+    srl << lane_hash_;
+    return 0;
+  }
+};
+
 /** A task to remove a blob from a tag */
 struct TagRemoveBlobTask : public Task, TaskFlags<TF_SRL_SYM> {
   IN TagId tag_id_;
@@ -763,8 +820,17 @@ struct TagAddTraitTask : public Task, TaskFlags<TF_SRL_SYM> {};
 struct TagRemoveTraitTask : public Task, TaskFlags<TF_SRL_SYM> {};
 
 /** A task to destroy all blobs in the tag */
+/** Phases of the tag clear blobs task */
+class TagClearBlobsPhase {
+ public:
+  TASK_METHOD_T kDestroyBlobs = 0;
+  TASK_METHOD_T kWaitDestroyBlobs = 1;
+};
+
 struct TagClearBlobsTask : public Task, TaskFlags<TF_SRL_SYM> {
   IN TagId tag_id_;
+  TEMP int phase_ = TagClearBlobsPhase::kDestroyBlobs;
+  TEMP hipc::ShmArchive<std::vector<blob_mdm::DestroyBlobTask*>> destroy_tasks_;
 
   /** SHM default constructor */
   HSHM_ALWAYS_INLINE explicit
@@ -811,10 +877,83 @@ struct TagClearBlobsTask : public Task, TaskFlags<TF_SRL_SYM> {
   }
 };
 
+/** Phases of the truncate tag task */
+class TruncateTagPhase {
+ public:
+  TASK_METHOD_T kGetBlobIds = 0;
+  TASK_METHOD_T kWaitBlobIds = 1;
+  TASK_METHOD_T kWaitTruncate = 2;
+};
+
+/**
+ * A task to truncate a tag to a new size. Assumes that the blobs in
+ * the tag are pages of a fixed size named 0 ... N, as in AppendBlob.
+ * */
+struct TruncateTagTask : public Task, TaskFlags<TF_SRL_SYM> {
+  IN TagId tag_id_;
+  IN size_t new_size_;
+  IN size_t page_size_;
+  TEMP int phase_ = TruncateTagPhase::kGetBlobIds;
+  TEMP hipc::ShmArchive<std::vector<blob_mdm::GetBlobIdTask*>> blob_id_tasks_;
+  TEMP hipc::ShmArchive<std::vector<blob_mdm::DestroyBlobTask*>> destroy_tasks_;
+  TEMP blob_mdm::TruncateBlobTask *truncate_task_ = nullptr;
+
+  /** SHM default constructor */
+  HSHM_ALWAYS_INLINE explicit
+  TruncateTagTask(hipc::Allocator *alloc) : Task(alloc) {}
+
+  /** Emplace constructor */
+  HSHM_ALWAYS_INLINE explicit
+  TruncateTagTask(hipc::Allocator *alloc,
+                  const TaskNode &task_node,
+                  const DomainId &domain_id,
+                  const TaskStateId &state_id,
+                  const TagId &tag_id,
+                  size_t new_size,
+                  size_t page_size) : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    lane_hash_ = tag_id.hash_;
+    prio_ = TaskPrio::kLowLatency;
+    task_state_ = state_id;
+    method_ = Method::kTruncateTag;
+    task_flags_.SetBits(TASK_LOW_LATENCY);
+    domain_id_ = domain_id;
+
+    // Custom params
+    tag_id_ = tag_id;
+    new_size_ = new_size;
+    page_size_ = page_size;
+  }
+
+  /** (De)serialize message call */
+  template<typename Ar>
+  void SerializeStart(Ar &ar) {
+    task_serialize<Ar>(ar);
+    ar(tag_id_, new_size_, page_size_);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void SerializeEnd(u32 replica, Ar &ar) {}
+
+  /** Create group */
+  HSHM_ALWAYS_INLINE
+  u32 GetGroup(hshm::charbuf &group) {
+    hrun::LocalSerialize srl(group);
+    srl << task_state_;
+    srl << lane_hash_;
+    return 0;
+  }
+};
+
 /** A task to destroy all blobs in the tag */
 struct GetSizeTask : public Task, TaskFlags<TF_SRL_SYM> {
   IN TagId tag_id_;
   OUT size_t size_;
+  OUT u64 shrink_count_;
+  IN bool attach_shm_ = false;  /**< Take a reference to the TagShm slot */
+  OUT hipc::Pointer shm_;  /**< The TagShm slot (node-local only) */
 
   /** SHM default constructor */
   HSHM_ALWAYS_INLINE explicit
@@ -826,7 +965,8 @@ struct GetSizeTask : public Task, TaskFlags<TF_SRL_SYM> {
                     const TaskNode &task_node,
                     const DomainId &domain_id,
                     const TaskStateId &state_id,
-                    TagId tag_id) : Task(alloc) {
+                    TagId tag_id,
+                    bool attach_shm = false) : Task(alloc) {
     // Initialize task
     task_node_ = task_node;
     lane_hash_ = tag_id.hash_;
@@ -838,11 +978,16 @@ struct GetSizeTask : public Task, TaskFlags<TF_SRL_SYM> {
 
     // Custom params
     tag_id_ = tag_id;
+    attach_shm_ = attach_shm;
+    size_ = 0;
+    shrink_count_ = 0;
+    shm_.SetNull();
   }
 
   /** (De)serialize message call */
   template<typename Ar>
   void SerializeStart(Ar &ar) {
+    // attach_shm_ is not sent, so remote nodes never take a reference
     task_serialize<Ar>(ar);
     ar(tag_id_);
   }
@@ -850,7 +995,8 @@ struct GetSizeTask : public Task, TaskFlags<TF_SRL_SYM> {
   /** (De)serialize message return */
   template<typename Ar>
   void SerializeEnd(u32 replica, Ar &ar) {
-    ar(size_);
+    // shm_ is only meaningful on the node that owns the tag
+    ar(size_, shrink_count_);
   }
 
   /** Create group */
@@ -71,7 +71,7 @@ class Server : public TaskLib {
     }
     HILOG(kDebug, "Updating size of tag {} from {} to {} with update {} (mode={})",
           task->tag_id_, tag_info.internal_size_, internal_size, task->update_, task->mode_)
-    tag_info.internal_size_ = (size_t) internal_size;
+    tag_info.SetSize((size_t) internal_size);
     task->SetModuleComplete();
   }
   void MonitorUpdateSize(u32 mode, UpdateSizeTask *task, RunContext &rctx) {
@@ -236,6 +236,11 @@ class Server : public TaskLib {
       tag_info.tag_id_ = tag_id;
       tag_info.owner_ = task->blob_owner_;
       tag_info.internal_size_ = task->backend_size_;
+      tag_info.ec_data_ = task->ec_data_;
+      tag_info.ec_parity_ = task->ec_parity_;
+      tag_info.shm_ =
+          HRUN_CLIENT->main_alloc_->NewObj<TagShm>(tag_info.shm_p_);
+      tag_info.shm_->size_ = task->backend_size_;
       if (task->flags_.Any(HERMES_SHOULD_STAGE)) {
         stager_mdm_.AsyncRegisterStager(task->task_node_ + 1,
                                         tag_id,
@@ -251,6 +256,13 @@ class Server : public TaskLib {
         HILOG(kDebug, "Found existing tag: {}", task->tag_id_)
         tag_id = task->tag_id_;
       }
+      // Openers always see the erasure code the tag was created with
+      TAG_MAP_T &tag_map = tag_map_[rctx.lane_id_];
+      auto it = tag_map.find(tag_id);
+      if (it != tag_map.end()) {
+        task->ec_data_ = it->second.ec_data_;
+        task->ec_parity_ = it->second.ec_parity_;
+      }
     }
 
     task->tag_id_ = tag_id;
@@ -313,9 +325,10 @@ class Server : public TaskLib {
         TagInfo &tag = tag_map[task->tag_id_];
         tag_id_map.erase(tag.name_);
         HSHM_MAKE_AR0(task->destroy_blob_tasks_, nullptr);
-        std::vector<blob_mdm::DestroyBlobTask*> blob_tasks = *task->destroy_blob_tasks_;
+        std::vector<blob_mdm::DestroyBlobTask*> &blob_tasks =
+            *task->destroy_blob_tasks_;
         blob_tasks.reserve(tag.blobs_.size());
-        for (BlobId &blob_id : tag.blobs_) {
+        for (const BlobId &blob_id : tag.blobs_) {
           blob_mdm::DestroyBlobTask *blob_task =
               blob_mdm_.AsyncDestroyBlob(task->task_node_ + 1,
                                          task->tag_id_, blob_id, false).ptr_;
@@ -328,7 +341,8 @@ class Server : public TaskLib {
         return;
       }
       case DestroyTagPhase::kWaitDestroyBlobs: {
-        std::vector<blob_mdm::DestroyBlobTask*> blob_tasks = *task->destroy_blob_tasks_;
+        std::vector<blob_mdm::DestroyBlobTask*> &blob_tasks =
+            *task->destroy_blob_tasks_;
         for (blob_mdm::DestroyBlobTask *&blob_task : blob_tasks) {
           if (!blob_task->IsComplete()) {
             return;
@@ -339,6 +353,12 @@ class Server : public TaskLib {
         }
         HSHM_DESTROY_AR(task->destroy_blob_tasks_);
         TAG_MAP_T &tag_map = tag_map_[rctx.lane_id_];
+        auto it = tag_map.find(task->tag_id_);
+        if (it != tag_map.end() && it->second.shm_) {
+          // Freed once the clients attached to the slot release it
+          it->second.shm_->valid_ = false;
+          Client::ReleaseTagShm(it->second.shm_p_);
+        }
         tag_map.erase(task->tag_id_);
         HILOG(kDebug, "Finished destroying the tag");
         task->SetModuleComplete();
@@ -357,7 +377,7 @@ class Server : public TaskLib {
       return;
     }
     TagInfo &tag = it->second;
-    tag.blobs_.emplace_back(task->blob_id_);
+    tag.blobs_.insert(task->blob_id_);
     task->SetModuleComplete();
   }
   void MonitorTagAddBlob(u32 mode, TagAddBlobTask *task, RunContext &rctx) {
@@ -372,34 +392,177 @@ class Server : public TaskLib {
       return;
     }
     TagInfo &tag = it->second;
-    auto blob_it = std::find(tag.blobs_.begin(), tag.blobs_.end(), task->blob_id_);
-    tag.blobs_.erase(blob_it);
+    tag.blobs_.erase(task->blob_id_);
     task->SetModuleComplete();
   }
   void MonitorTagRemoveBlob(u32 mode, TagRemoveBlobTask *task, RunContext &rctx) {
   }
 
-  /** Clear blobs from a tag */
-  void TagClearBlobs(TagClearBlobsTask *task, RunContext &rctx) {
+  /** Invalidate the blob IDs clients cached for a tag */
+  void TagInvalidateBlobIds(TagInvalidateBlobIdsTask *task, RunContext &rctx) {
     TAG_MAP_T &tag_map = tag_map_[rctx.lane_id_];
     auto it = tag_map.find(task->tag_id_);
-    if (it == tag_map.end()) {
-      task->SetModuleComplete();
-      return;
+    if (it != tag_map.end()) {
+      it->second.InvalidateBlobIds();
     }
-    TagInfo &tag = it->second;
-    if (tag.owner_) {
-      for (BlobId &blob_id : tag.blobs_) {
-        blob_mdm_.AsyncDestroyBlob(task->task_node_ + 1, task->tag_id_, blob_id);
+    task->SetModuleComplete();
+  }
+  void MonitorTagInvalidateBlobIds(u32 mode, TagInvalidateBlobIdsTask *task,
+                                   RunContext &rctx) {
+  }
+
+  /** Clear blobs from a tag */
+  void TagClearBlobs(TagClearBlobsTask *task, RunContext &rctx) {
+    switch (task->phase_) {
+      case TagClearBlobsPhase::kDestroyBlobs: {
+        TAG_MAP_T &tag_map = tag_map_[rctx.lane_id_];
+        auto it = tag_map.find(task->tag_id_);
+        if (it == tag_map.end()) {
+          task->SetModuleComplete();
+          return;
+        }
+        TagInfo &tag = it->second;
+        HSHM_MAKE_AR0(task->destroy_tasks_, nullptr);
+        if (tag.owner_) {
+          std::vector<blob_mdm::DestroyBlobTask*> &destroy_tasks =
+              *task->destroy_tasks_;
+          destroy_tasks.reserve(tag.blobs_.size());
+          for (const BlobId &blob_id : tag.blobs_) {
+            destroy_tasks.emplace_back(blob_mdm_.AsyncDestroyBlob(
+                task->task_node_ + 1, task->tag_id_, blob_id, false).ptr_);
+          }
+        }
+        tag.blobs_.clear();
+        tag.SetSize(0);
+        task->phase_ = TagClearBlobsPhase::kWaitDestroyBlobs;
+      }
+      case TagClearBlobsPhase::kWaitDestroyBlobs: {
+        std::vector<blob_mdm::DestroyBlobTask*> &destroy_tasks =
+            *task->destroy_tasks_;
+        for (blob_mdm::DestroyBlobTask *&destroy_task : destroy_tasks) {
+          if (!destroy_task->IsComplete()) {
+            return;
+          }
+        }
+        for (blob_mdm::DestroyBlobTask *&destroy_task : destroy_tasks) {
+          HRUN_CLIENT->DelTask(destroy_task);
+        }
+        HSHM_DESTROY_AR(task->destroy_tasks_);
+        // Cached ids are dropped once the blobs are gone, so a client
+        // cannot cache the id of a blob still being destroyed
+        TAG_MAP_T &tag_map = tag_map_[rctx.lane_id_];
+        auto it = tag_map.find(task->tag_id_);
+        if (it != tag_map.end()) {
+          it->second.InvalidateBlobIds();
+        }
+        task->SetModuleComplete();
       }
     }
-    tag.blobs_.clear();
-    tag.internal_size_ = 0;
-    task->SetModuleComplete();
   }
   void MonitorTagClearBlobs(u32 mode, TagClearBlobsTask *task, RunContext &rctx) {
   }
 
+  /**
+   * Truncate a tag to a new size. Pages past the new size are
+   * destroyed and the page containing the new end is truncated.
+   * The size of the tag is updated before the blobs are freed.
+   * */
+  void TruncateTag(TruncateTagTask *task, RunContext &rctx) {
+    switch (task->phase_) {
+      case TruncateTagPhase::kGetBlobIds: {
+        TAG_MAP_T &tag_map = tag_map_[rctx.lane_id_];
+        auto it = tag_map.find(task->tag_id_);
+        if (it == tag_map.end()) {
+          task->SetModuleComplete();
+          return;
+        }
+        TagInfo &tag = it->second;
+        size_t old_size = tag.internal_size_;
+        tag.SetSize(task->new_size_);
+        HSHM_MAKE_AR0(task->blob_id_tasks_, nullptr);
+        HSHM_MAKE_AR0(task->destroy_tasks_, nullptr);
+        if (task->new_size_ < old_size && task->page_size_ > 0) {
+          // Find the pages overlapping the truncated range
+          size_t first_page = task->new_size_ / task->page_size_;
+          size_t last_page = (old_size - 1) / task->page_size_;
+          std::vector<blob_mdm::GetBlobIdTask*> &blob_id_tasks =
+              *task->blob_id_tasks_;
+          blob_id_tasks.reserve(last_page - first_page + 1);
+          for (size_t page = first_page; page <= last_page; ++page) {
+            blob_id_tasks.emplace_back(blob_mdm_.AsyncGetBlobId(
+                task->task_node_ + 1, task->tag_id_,
+                adapter::BlobPlacement::CreateBlobName(page)).ptr_);
+          }
+        }
+        HILOG(kDebug, "Truncating tag {} from {} to {} bytes",
+              task->tag_id_, old_size, task->new_size_);
+        task->phase_ = TruncateTagPhase::kWaitBlobIds;
+      }
+      case TruncateTagPhase::kWaitBlobIds: {
+        std::vector<blob_mdm::GetBlobIdTask*> &blob_id_tasks =
+            *task->blob_id_tasks_;
+        for (blob_mdm::GetBlobIdTask *&blob_id_task : blob_id_tasks) {
+          if (!blob_id_task->IsComplete()) {
+            return;
+          }
+        }
+        std::vector<blob_mdm::DestroyBlobTask*> &destroy_tasks =
+            *task->destroy_tasks_;
+        destroy_tasks.reserve(blob_id_tasks.size());
+        for (size_t i = 0; i < blob_id_tasks.size(); ++i) {
+          BlobId blob_id = blob_id_tasks[i]->blob_id_;
+          HRUN_CLIENT->DelTask(blob_id_tasks[i]);
+          if (blob_id.IsNull()) {
+            continue;
+          }
+          size_t page_off = task->new_size_ % task->page_size_;
+          if (i == 0 && page_off > 0) {
+            task->truncate_task_ = blob_mdm_.AsyncTruncateBlob(
+                task->task_node_ + 1, task->tag_id_,
+                blob_id, page_off, false).ptr_;
+          } else {
+            destroy_tasks.emplace_back(blob_mdm_.AsyncDestroyBlob(
+                task->task_node_ + 1, task->tag_id_,
+                blob_id, false).ptr_);
+          }
+        }
+        HSHM_DESTROY_AR(task->blob_id_tasks_);
+        task->phase_ = TruncateTagPhase::kWaitTruncate;
+      }
+      case TruncateTagPhase::kWaitTruncate: {
+        std::vector<blob_mdm::DestroyBlobTask*> &destroy_tasks =
+            *task->destroy_tasks_;
+        if (task->truncate_task_ && !task->truncate_task_->IsComplete()) {
+          return;
+        }
+        for (blob_mdm::DestroyBlobTask *&destroy_task : destroy_tasks) {
+          if (!destroy_task->IsComplete()) {
+            return;
+          }
+        }
+        // The tag may have been destroyed while waiting on the blobs
+        TAG_MAP_T &tag_map = tag_map_[rctx.lane_id_];
+        auto it = tag_map.find(task->tag_id_);
+        for (blob_mdm::DestroyBlobTask *&destroy_task : destroy_tasks) {
+          if (it != tag_map.end()) {
+            it->second.blobs_.erase(destroy_task->blob_id_);
+          }
+          HRUN_CLIENT->DelTask(destroy_task);
+        }
+        if (it != tag_map.end()) {
+          it->second.InvalidateBlobIds();
+        }
+        if (task->truncate_task_) {
+          HRUN_CLIENT->DelTask(task->truncate_task_);
+        }
+        HSHM_DESTROY_AR(task->destroy_tasks_);
+        task->SetModuleComplete();
+      }
+    }
+  }
+  void MonitorTruncateTag(u32 mode, TruncateTagTask *task, RunContext &rctx) {
+  }
+
   /** Get size of the bucket */
   void GetSize(GetSizeTask *task, RunContext &rctx) {
     TAG_MAP_T &tag_map = tag_map_[rctx.lane_id_];
@@ -411,6 +574,12 @@ class Server : public TaskLib {
     }
     TagInfo &tag = it->second;
     task->size_ = tag.internal_size_;
+    task->shrink_count_ = tag.shrink_count_;
+    if (task->attach_shm_ && tag.shm_) {
+      // Released by the client, so the slot outlives the tag if needed
+      tag.shm_->ref_count_.fetch_add(1);
+      task->shm_ = tag.shm_p_;
+    }
     task->SetModuleComplete();
   }
   void MonitorGetSize(u32 mode, GetSizeTask *task, RunContext &rctx) {
@@ -427,7 +596,7 @@ class Server : public TaskLib {
     TagInfo &tag = it->second;
     hipc::vector<BlobId> &blobs = (*task->blob_ids_);
     blobs.reserve(tag.blobs_.size());
-    for (BlobId &blob_id : tag.blobs_) {
+    for (const BlobId &blob_id : tag.blobs_) {
       blobs.emplace_back(blob_id);
     }
     task->SetModuleComplete();
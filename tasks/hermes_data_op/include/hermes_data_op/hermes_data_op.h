@@ -90,6 +90,24 @@ class Client : public TaskLibClient {
         task, task_node, id_);
   }
   HRUN_TASK_NODE_PUSH_ROOT(RunOp);
+
+  /** Get the execution statistics of each operator on each node */
+  HSHM_ALWAYS_INLINE
+  void AsyncPollOpStatsConstruct(PollOpStatsTask *task,
+                                 const TaskNode &task_node) {
+    HRUN_CLIENT->ConstructTask<PollOpStatsTask>(
+        task, task_node, id_);
+  }
+  std::vector<OpStats> PollOpStatsRoot() {
+    LPointer<hrunpq::TypedPushTask<PollOpStatsTask>> push_task =
+        AsyncPollOpStatsRoot();
+    push_task->Wait();
+    PollOpStatsTask *task = push_task->get();
+    std::vector<OpStats> stats = task->DeserializeOpStats();
+    HRUN_CLIENT->DelTask(push_task);
+    return stats;
+  }
+  HRUN_TASK_NODE_PUSH_ROOT(PollOpStats);
 };
 
 }  // namespace hrun
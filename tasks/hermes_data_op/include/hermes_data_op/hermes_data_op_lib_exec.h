@@ -24,6 +24,10 @@ void Run(u32 method, Task *task, RunContext &rctx) override {
       RunOp(reinterpret_cast<RunOpTask *>(task), rctx);
       break;
     }
+    case Method::kPollOpStats: {
+      PollOpStats(reinterpret_cast<PollOpStatsTask *>(task), rctx);
+      break;
+    }
   }
 }
 /** Execute a task */
@@ -49,6 +53,10 @@ void Monitor(u32 mode, Task *task, RunContext &rctx) override {
       MonitorRunOp(mode, reinterpret_cast<RunOpTask *>(task), rctx);
       break;
     }
+    case Method::kPollOpStats: {
+      MonitorPollOpStats(mode, reinterpret_cast<PollOpStatsTask *>(task), rctx);
+      break;
+    }
   }
 }
 /** Delete a task */
@@ -74,6 +82,10 @@ void Del(u32 method, Task *task) override {
       HRUN_CLIENT->DelTask<RunOpTask>(reinterpret_cast<RunOpTask *>(task));
       break;
     }
+    case Method::kPollOpStats: {
+      HRUN_CLIENT->DelTask<PollOpStatsTask>(reinterpret_cast<PollOpStatsTask *>(task));
+      break;
+    }
   }
 }
 /** Duplicate a task */
@@ -99,6 +111,10 @@ void Dup(u32 method, Task *orig_task, std::vector<LPointer<Task>> &dups) overrid
       hrun::CALL_DUPLICATE(reinterpret_cast<RunOpTask*>(orig_task), dups);
       break;
     }
+    case Method::kPollOpStats: {
+      hrun::CALL_DUPLICATE(reinterpret_cast<PollOpStatsTask*>(orig_task), dups);
+      break;
+    }
   }
 }
 /** Register the duplicate output with the origin task */
@@ -124,6 +140,10 @@ void DupEnd(u32 method, u32 replica, Task *orig_task, Task *dup_task) override {
       hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<RunOpTask*>(orig_task), reinterpret_cast<RunOpTask*>(dup_task));
       break;
     }
+    case Method::kPollOpStats: {
+      hrun::CALL_DUPLICATE_END(replica, reinterpret_cast<PollOpStatsTask*>(orig_task), reinterpret_cast<PollOpStatsTask*>(dup_task));
+      break;
+    }
   }
 }
 /** Ensure there is space to store replicated outputs */
@@ -149,6 +169,10 @@ void ReplicateStart(u32 method, u32 count, Task *task) override {
       hrun::CALL_REPLICA_START(count, reinterpret_cast<RunOpTask*>(task));
       break;
     }
+    case Method::kPollOpStats: {
+      hrun::CALL_REPLICA_START(count, reinterpret_cast<PollOpStatsTask*>(task));
+      break;
+    }
   }
 }
 /** Determine success and handle failures */
@@ -174,6 +198,10 @@ void ReplicateEnd(u32 method, Task *task) override {
       hrun::CALL_REPLICA_END(reinterpret_cast<RunOpTask*>(task));
       break;
     }
+    case Method::kPollOpStats: {
+      hrun::CALL_REPLICA_END(reinterpret_cast<PollOpStatsTask*>(task));
+      break;
+    }
   }
 }
 /** Serialize a task when initially pushing into remote */
@@ -199,6 +227,10 @@ std::vector<DataTransfer> SaveStart(u32 method, BinaryOutputArchive<true> &ar, T
       ar << *reinterpret_cast<RunOpTask*>(task);
       break;
     }
+    case Method::kPollOpStats: {
+      ar << *reinterpret_cast<PollOpStatsTask*>(task);
+      break;
+    }
   }
   return ar.Get();
 }
@@ -231,6 +263,11 @@ TaskPointer LoadStart(u32 method, BinaryInputArchive<true> &ar) override {
       ar >> *reinterpret_cast<RunOpTask*>(task_ptr.ptr_);
       break;
     }
+    case Method::kPollOpStats: {
+      task_ptr.ptr_ = HRUN_CLIENT->NewEmptyTask<PollOpStatsTask>(task_ptr.shm_);
+      ar >> *reinterpret_cast<PollOpStatsTask*>(task_ptr.ptr_);
+      break;
+    }
   }
   return task_ptr;
 }
@@ -257,6 +294,10 @@ std::vector<DataTransfer> SaveEnd(u32 method, BinaryOutputArchive<false> &ar, Ta
       ar << *reinterpret_cast<RunOpTask*>(task);
       break;
     }
+    case Method::kPollOpStats: {
+      ar << *reinterpret_cast<PollOpStatsTask*>(task);
+      break;
+    }
   }
   return ar.Get();
 }
@@ -283,6 +324,10 @@ void LoadEnd(u32 replica, u32 method, BinaryInputArchive<false> &ar, Task *task)
       ar.Deserialize(replica, *reinterpret_cast<RunOpTask*>(task));
       break;
     }
+    case Method::kPollOpStats: {
+      ar.Deserialize(replica, *reinterpret_cast<PollOpStatsTask*>(task));
+      break;
+    }
   }
 }
 /** Get the grouping of the task */
@@ -303,6 +348,9 @@ u32 GetGroup(u32 method, Task *task, hshm::charbuf &group) override {
     case Method::kRunOp: {
       return reinterpret_cast<RunOpTask*>(task)->GetGroup(group);
     }
+    case Method::kPollOpStats: {
+      return reinterpret_cast<PollOpStatsTask*>(task)->GetGroup(group);
+    }
   }
   return -1;
 }
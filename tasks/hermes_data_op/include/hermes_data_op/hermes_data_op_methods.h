@@ -6,6 +6,7 @@ struct Method : public TaskMethod {
   TASK_METHOD_T kRegisterOp = kLast + 0;
   TASK_METHOD_T kRegisterData = kLast + 1;
   TASK_METHOD_T kRunOp = kLast + 2;
+  TASK_METHOD_T kPollOpStats = kLast + 3;
 };
 
 #endif  // HRUN_HERMES_DATA_OP_METHODS_H_
\ No newline at end of file
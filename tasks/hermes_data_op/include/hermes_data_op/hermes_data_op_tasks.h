@@ -45,11 +45,14 @@ struct Op {
   std::vector<OpBucketName> in_;  // Input URLs, indicates data format as well
   OpBucketName var_name_;         // Output URL
   std::string op_name_;           // Operation name
+  std::string data_type_ = "float";  // Element type of the input data
+  std::vector<double> args_;      // Operation arguments (e.g., histogram bins)
   u32 op_id_;                     // Operation ID (internal)
+  u32 type_id_;                   // Data type ID (internal)
 
   template<typename Ar>
   void serialize(Ar &ar) {
-    ar(in_, var_name_, op_name_);
+    ar(in_, var_name_, op_name_, data_type_, args_);
   }
 };
 
@@ -63,6 +66,28 @@ struct OpGraph {
   }
 };
 
+/** Execution statistics of one operator on one node */
+struct OpStats {
+  u32 node_id_;             // Node executing the operator
+  std::string op_name_;     // Operation name
+  std::string var_name_;    // Output URL
+  size_t backlog_;          // Data waiting to be processed
+  size_t num_processed_;    // Blobs processed
+  size_t bytes_processed_;  // Bytes of input processed
+  double busy_usec_;        // Time spent computing
+
+  /** Input throughput in MBps while busy */
+  double GetMBps() const {
+    return busy_usec_ > 0 ? bytes_processed_ / busy_usec_ : 0;
+  }
+
+  template<typename Ar>
+  void serialize(Ar &ar) {
+    ar(node_id_, op_name_, var_name_, backlog_, num_processed_,
+       bytes_processed_, busy_usec_);
+  }
+};
+
 /**
  * A task to create hermes_data_op
  * */
@@ -296,7 +321,7 @@ struct RunOpTask : public Task, TaskFlags<TF_LOCAL | TF_REPLICA> {
     task_flags_.SetBits(
         TASK_LONG_RUNNING | TASK_COROUTINE | TASK_LANE_ALL |
         TASK_REMOTE_DEBUG_MARK);
-    SetPeriodSec(1);  // TODO(llogan): don't hardcode this
+    SetPeriodMs(10);  // TODO(llogan): don't hardcode this
     domain_id_ = DomainId::GetLocal();
   }
 
@@ -321,6 +346,123 @@ struct RunOpTask : public Task, TaskFlags<TF_LOCAL | TF_REPLICA> {
   }
 };
 
+/** A task to collect the statistics of each operator */
+struct PollOpStatsTask : public Task, TaskFlags<TF_SRL_SYM_START | TF_SRL_ASYM_START | TF_REPLICA> {
+  OUT hipc::ShmArchive<hipc::string> my_stats_;
+  TEMP hipc::ShmArchive<hipc::vector<hipc::string>> stats_;
+
+  /** SHM default constructor */
+  HSHM_ALWAYS_INLINE explicit
+  PollOpStatsTask(hipc::Allocator *alloc) : Task(alloc) {
+    HSHM_MAKE_AR0(stats_, alloc)
+  }
+
+  /** Emplace constructor */
+  HSHM_ALWAYS_INLINE explicit
+  PollOpStatsTask(hipc::Allocator *alloc,
+                  const TaskNode &task_node,
+                  const TaskStateId &state_id) : Task(alloc) {
+    // Initialize task
+    task_node_ = task_node;
+    lane_hash_ = 0;
+    prio_ = TaskPrio::kLowLatency;
+    task_state_ = state_id;
+    method_ = Method::kPollOpStats;
+    task_flags_.SetBits(TASK_COROUTINE);
+    domain_id_ = DomainId::GetGlobal();
+
+    // Custom params
+    HSHM_MAKE_AR0(my_stats_, alloc)
+    HSHM_MAKE_AR0(stats_, alloc)
+  }
+
+  /** Serialize operator stats */
+  void SerializeOpStats(const std::vector<OpStats> &stats) {
+    std::stringstream ss;
+    cereal::BinaryOutputArchive ar(ss);
+    ar << stats;
+    (*my_stats_) = ss.str();
+  }
+
+  /** Deserialize operator stats */
+  void DeserializeOpStats(const std::string &srl, std::vector<OpStats> &stats) {
+    std::vector<OpStats> tmp_stats;
+    std::stringstream ss(srl);
+    cereal::BinaryInputArchive ar(ss);
+    ar >> tmp_stats;
+    for (OpStats &op_stats : tmp_stats) {
+      stats.emplace_back(op_stats);
+    }
+  }
+
+  /** Get combined output of all replicas */
+  std::vector<OpStats> MergeOpStats() {
+    std::vector<OpStats> stats;
+    for (const hipc::string &srl : *stats_) {
+      DeserializeOpStats(srl.str(), stats);
+    }
+    return stats;
+  }
+
+  /** Deserialize final query output */
+  std::vector<OpStats> DeserializeOpStats() {
+    std::vector<OpStats> stats;
+    DeserializeOpStats(my_stats_->str(), stats);
+    return stats;
+  }
+
+  /** Destructor */
+  ~PollOpStatsTask() {
+    HSHM_DESTROY_AR(my_stats_)
+    HSHM_DESTROY_AR(stats_)
+  }
+
+  /** Duplicate message */
+  void Dup(hipc::Allocator *alloc, PollOpStatsTask &other) {}
+
+  /** Process duplicate message output */
+  void DupEnd(u32 replica, PollOpStatsTask &dup_task) {
+    (*stats_)[replica] = (*dup_task.my_stats_);
+  }
+
+  /** (De)serialize message call */
+  template<typename Ar>
+  void SerializeStart(Ar &ar) {
+    task_serialize<Ar>(ar);
+    ar(my_stats_);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void SaveEnd(Ar &ar) {
+    ar(my_stats_);
+  }
+
+  /** (De)serialize message return */
+  template<typename Ar>
+  void LoadEnd(u32 replica, Ar &ar) {
+    ar(my_stats_);
+    DupEnd(replica, *this);
+  }
+
+  /** Begin replication */
+  void ReplicateStart(u32 count) {
+    stats_->resize(count);
+  }
+
+  /** Finalize replication */
+  void ReplicateEnd() {
+    std::vector<OpStats> stats = MergeOpStats();
+    SerializeOpStats(stats);
+  }
+
+  /** Create group */
+  HSHM_ALWAYS_INLINE
+  u32 GetGroup(hshm::charbuf &group) {
+    return TASK_UNORDERED;
+  }
+};
+
 }  // namespace hermes::data_op
 
 #endif  // HRUN_TASKS_TASK_TEMPL_INCLUDE_hermes_data_op_hermes_data_op_TASKS_H_
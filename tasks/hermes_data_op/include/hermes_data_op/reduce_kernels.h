@@ -0,0 +1,68 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_TASKS_HERMES_DATA_OP_INCLUDE_HERMES_DATA_OP_REDUCE_KERNELS_H_
+#define HERMES_TASKS_HERMES_DATA_OP_INCLUDE_HERMES_DATA_OP_REDUCE_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hermes::data_op {
+
+/** The instruction sets the reduction kernels are compiled for */
+enum class SimdLevel {
+  kScalar = 0,
+  kAvx2 = 1,
+  kAvx512 = 2
+};
+
+/**
+ * Reductions over an array of one element type.
+ *
+ * Floating-point sums are accumulated in double precision, so the
+ * vectorized kernels may differ from the scalar ones in the last bits.
+ * */
+template<typename T>
+struct ReduceKernels {
+  /** The minimum element, or the largest T if \a count is 0 */
+  T (*min_)(const T *data, size_t count);
+  /** The maximum element, or the lowest T if \a count is 0 */
+  T (*max_)(const T *data, size_t count);
+  /** The sum of the elements */
+  double (*sum_)(const T *data, size_t count);
+  /** The sum of (x - mean)^2, used to compute the variance */
+  double (*sum_sq_diff_)(const T *data, size_t count, double mean);
+  /**
+   * Add the count of the elements in each of \a nbins equal bins
+   * over [lo, hi] to \a bins. Elements outside of the range are ignored.
+   * */
+  void (*histogram_)(const T *data, size_t count,
+                     double lo, double hi,
+                     uint64_t *bins, size_t nbins);
+};
+
+/** Get the best instruction set supported by this CPU */
+SimdLevel GetSimdLevel();
+
+/** Get the kernels for \a level, or the best level below it this build has */
+template<typename T>
+const ReduceKernels<T>& GetReduceKernels(SimdLevel level);
+
+/** Get the kernels for the best instruction set of this CPU */
+template<typename T>
+const ReduceKernels<T>& GetReduceKernels() {
+  return GetReduceKernels<T>(GetSimdLevel());
+}
+
+}  // namespace hermes::data_op
+
+#endif  // HERMES_TASKS_HERMES_DATA_OP_INCLUDE_HERMES_DATA_OP_REDUCE_KERNELS_H_
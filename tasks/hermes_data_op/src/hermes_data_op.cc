@@ -6,23 +6,79 @@
 #include "hrun/api/hrun_runtime.h"
 #include "hermes_data_op/hermes_data_op.h"
 #include "hermes_bucket_mdm/hermes_bucket_mdm.h"
+#include "hermes_data_op/reduce_kernels.h"
 
 namespace hermes::data_op {
 
-struct OpPendingData {
-  std::list<OpData> pending_;
-  u32 num_refs_;
-  u64 data_id_;
+/** The reductions supported by OpGraphs */
+enum class OpId : u32 {
+  kMin,
+  kMax,
+  kSum,
+  kMean,
+  kVariance,
+  kHistogram
+};
+
+/** The element types supported by OpGraphs */
+enum class OpType : u32 {
+  kFloat,
+  kDouble,
+  kInt32,
+  kUint32,
+  kInt64,
+  kUint64
+};
+
+/**
+ * An operator of an OpGraph, executed as a pipeline stage.
+ *
+ * Producers (RegisterData) append to the bounded input queue from any lane.
+ * The bound is checked against depth_ without taking lock_, so producers
+ * racing past it may overshoot kMaxDepth by one datum each.
+ * The RegisterData which makes a stage non-empty claims and runs it, so
+ * results follow each Put. Every RunOp lane also scans the stages and claims
+ * idle ones to drain data left behind while a stage was claimed. One stage
+ * runs on one worker at a time while independent stages run on different
+ * workers. The statistics are atomic since PollOpStats reads them unlocked.
+ * */
+struct OpStage {
+  static const size_t kMaxDepth = 256;  /**< Bound of the input queue */
+  static const size_t kMaxBatch = 32;   /**< Data processed per claim */
+
+  Op op_;                           /**< The operator */
+  Mutex lock_;                      /**< Protects queue_ */
+  std::list<OpData> queue_;         /**< Input data to process */
+  std::atomic<size_t> depth_;       /**< Size of queue_, readable unlocked */
+  std::atomic<bool> claimed_;       /**< Whether a lane is running the stage */
+  std::atomic<size_t> num_processed_;    /**< Blobs processed */
+  std::atomic<size_t> bytes_processed_;  /**< Bytes of input processed */
+  std::atomic<size_t> busy_nsec_;        /**< Time spent computing */
+
+  /** Emplace constructor */
+  explicit OpStage(const Op &op)
+      : op_(op), depth_(0), claimed_(false),
+        num_processed_(0), bytes_processed_(0), busy_nsec_(0) {}
 
-  OpPendingData() : num_refs_(0) {}
+  /** Claim the stage for the calling lane */
+  bool TryClaim() {
+    bool expected = false;
+    return claimed_.compare_exchange_strong(expected, true);
+  }
+
+  /** Release the stage */
+  void Release() {
+    claimed_.store(false);
+  }
 };
 
 class Server : public TaskLib {
  public:
-  std::vector<std::list<OpGraph>> op_graphs_;
   std::unordered_map<std::string, u32> op_id_map_;
-  Mutex op_data_lock_;
-  std::unordered_map<BucketId, OpPendingData> op_data_map_;
+  std::unordered_map<std::string, u32> op_type_map_;
+  RwLock stage_lock_;  /**< Protects stages_ and consumers_ */
+  std::list<OpStage> stages_;
+  std::unordered_map<BucketId, std::vector<OpStage*>> consumers_;
   hermes::bucket_mdm::Client bkt_mdm_;
   hermes::blob_mdm::Client blob_mdm_;
   Client client_;
@@ -37,9 +93,19 @@ class Server : public TaskLib {
     bkt_mdm_.Init(task->bkt_mdm_, HRUN_ADMIN->queue_id_);
     blob_mdm_.Init(task->blob_mdm_, HRUN_ADMIN->queue_id_);
     client_.Init(id_, HRUN_ADMIN->queue_id_);
-    op_id_map_["min"] = 0;
-    op_id_map_["max"] = 1;
-    op_graphs_.resize(HRUN_QM_RUNTIME->max_lanes_);
+    op_id_map_["min"] = (u32)OpId::kMin;
+    op_id_map_["max"] = (u32)OpId::kMax;
+    op_id_map_["sum"] = (u32)OpId::kSum;
+    op_id_map_["mean"] = (u32)OpId::kMean;
+    op_id_map_["variance"] = (u32)OpId::kVariance;
+    op_id_map_["histogram"] = (u32)OpId::kHistogram;
+    op_type_map_["float"] = (u32)OpType::kFloat;
+    op_type_map_["double"] = (u32)OpType::kDouble;
+    op_type_map_["int32"] = (u32)OpType::kInt32;
+    op_type_map_["uint32"] = (u32)OpType::kUint32;
+    op_type_map_["int64"] = (u32)OpType::kInt64;
+    op_type_map_["uint64"] = (u32)OpType::kUint64;
+    HILOG(kInfo, "Data operators use SIMD level {}", (int)GetSimdLevel());
     run_task_ = client_.AsyncRunOp(task->task_node_ + 1);
     task->SetModuleComplete();
   }
@@ -56,8 +122,21 @@ class Server : public TaskLib {
   /** Registor operators */
   void RegisterOp(RegisterOpTask *task, RunContext &rctx) {
     // Load OpGraph
-    op_graphs_[rctx.lane_id_].push_back(task->GetOpGraph());
-    OpGraph &op_graph = op_graphs_[rctx.lane_id_].back();
+    OpGraph op_graph = task->GetOpGraph();
+
+    // Reject graphs with operators or data types we cannot run
+    for (Op &op : op_graph.ops_) {
+      auto op_it = op_id_map_.find(op.op_name_);
+      auto type_it = op_type_map_.find(op.data_type_);
+      if (op_it == op_id_map_.end() || type_it == op_type_map_.end()) {
+        HELOG(kError, "Rejecting operator graph: unknown operator {} "
+              "or data type {}", op.op_name_, op.data_type_);
+        task->SetModuleComplete();
+        return;
+      }
+      op.op_id_ = op_it->second;
+      op.type_id_ = type_it->second;
+    }
 
     // Get or create all needed bucket IDs
     std::vector<TraitId> traits;
@@ -76,8 +155,6 @@ class Server : public TaskLib {
                                        hshm::charbuf(op.var_name_.url_),
                                        true,
                                        traits, 0, 0);
-      // Set the op ID
-      op.op_id_ = op_id_map_[op.op_name_];
     }
 
     // Complete all bucket ID tasks
@@ -86,93 +163,135 @@ class Server : public TaskLib {
       for (OpBucketName &bkt_name : op.in_) {
         bkt_name.bkt_id_task_->Wait<TASK_YIELD_CO>(task);
         bkt_name.bkt_id_ = bkt_name.bkt_id_task_->tag_id_;
-        op_data_map_.emplace(bkt_name.bkt_id_, OpPendingData());
         HRUN_CLIENT->DelTask(bkt_name.bkt_id_task_);
       }
       // Spawn bucket ID task for the output
       op.var_name_.bkt_id_task_->Wait<TASK_YIELD_CO>(task);
       op.var_name_.bkt_id_ = op.var_name_.bkt_id_task_->tag_id_;
-      op_data_map_.emplace(op.var_name_.bkt_id_, OpPendingData());
       HRUN_CLIENT->DelTask(op.var_name_.bkt_id_task_);
     }
 
-    // Get number of operations that depend on each data object
+    // Create a stage per operator and connect it to its inputs
+    ScopedRwWriteLock lock(stage_lock_, 0);
     for (Op &op : op_graph.ops_) {
+      OpStage &stage = stages_.emplace_back(op);
       for (OpBucketName &bkt_name : op.in_) {
-        op_data_map_[bkt_name.bkt_id_].num_refs_++;
+        consumers_[bkt_name.bkt_id_].emplace_back(&stage);
       }
     }
-
-    // Store the operator to perform
     task->SetModuleComplete();
   }
   void MonitorRegisterOp(u32 mode, RegisterOpTask *task, RunContext &rctx) {
   }
 
-  /** Inform that data is ready for operators */
+  /**
+   * Inform that data is ready for operators.
+   * If a consuming stage is full, the task is retried later, which
+   * pushes back on the producer.
+   * */
   void RegisterData(RegisterDataTask *task, RunContext &rctx) {
-    if (!op_data_lock_.TryLock(0)) {
-      return;
+    std::vector<OpStage*> ready;
+    {
+      ScopedRwReadLock lock(stage_lock_, 0);
+      auto it = consumers_.find(task->data_.bkt_id_);
+      if (it == consumers_.end()) {
+        task->SetModuleComplete();
+        return;
+      }
+      std::vector<OpStage*> &stages = it->second;
+      for (OpStage *stage : stages) {
+        if (stage->depth_.load() >= OpStage::kMaxDepth) {
+          return;
+        }
+      }
+      ready.reserve(stages.size());
+      for (OpStage *stage : stages) {
+        hshm::ScopedMutex stage_lock(stage->lock_, 0);
+        stage->queue_.emplace_back(task->data_);
+        stage->depth_.store(stage->queue_.size());
+        ready.emplace_back(stage);
+      }
+    }
+
+    // Compute over the new data now instead of waiting for RunOp.
+    // Stages are never removed, so the pointers outlive stage_lock_.
+    for (OpStage *stage : ready) {
+      if (!stage->TryClaim()) {
+        continue;
+      }
+      RunStage(task, *stage);
+      stage->Release();
     }
-    OpPendingData &op_data = op_data_map_[task->data_.bkt_id_];
-    task->data_.data_id_ = op_data.data_id_++;
-    op_data.pending_.emplace_back(task->data_);
-    op_data_lock_.Unlock();
     task->SetModuleComplete();
   }
   void MonitorRegisterData(u32 mode, RegisterDataTask *task, RunContext &rctx) {
   }
 
-  /** Run the operator */
+  /** Run the stages which have pending data */
   void RunOp(RunOpTask *task, RunContext &rctx) {
-    for (OpGraph &op_graph : op_graphs_[rctx.lane_id_]) {
-      for (Op &op : op_graph.ops_) {
-        switch(op.op_id_) {
-          case 0:
-            RunMin(task, op);
-            break;
-          case 1:
-            RunMax(task, op);
-            break;
-        }
+    std::vector<OpStage*> stages;
+    {
+      ScopedRwReadLock lock(stage_lock_, 0);
+      stages.reserve(stages_.size());
+      for (OpStage &stage : stages_) {
+        stages.emplace_back(&stage);
       }
     }
+    // Lanes start at different stages to spread them across workers
+    for (size_t i = 0; i < stages.size(); ++i) {
+      OpStage &stage = *stages[(rctx.lane_id_ + i) % stages.size()];
+      if (stage.depth_.load() == 0 || !stage.TryClaim()) {
+        continue;
+      }
+      RunStage(task, stage);
+      stage.Release();
+    }
   }
   void MonitorRunOp(u32 mode, RunOpTask *task, RunContext &rctx) {
   }
 
-  /** Get pending data needed for the operator */
-  std::list<OpData> GetPendingData(Op &op) {
-    std::list<OpData> pending;
-    if (!op_data_lock_.TryLock(0)) {
-      return pending;
-    }
-    for (OpBucketName &bkt_name : op.in_) {
-      if (op_data_map_.find(bkt_name.bkt_id_) == op_data_map_.end()) {
-        continue;
-      }
-      OpPendingData &op_data = op_data_map_[bkt_name.bkt_id_];
-      pending = op_data.pending_;
-      std::list<OpData> pruned;
-      for (auto iter = pending.begin(); iter != pending.end(); ++iter) {
-        OpData &data = *iter;
-        ++data.refcnt_;
-        if (data.refcnt_ < op_data.num_refs_) {
-          pruned.push_back(data);
-        }
-        op_data.pending_ = pruned;
+  /** Get the statistics of each stage on this node */
+  void PollOpStats(PollOpStatsTask *task, RunContext &rctx) {
+    std::vector<OpStats> stats;
+    {
+      ScopedRwReadLock lock(stage_lock_, 0);
+      for (OpStage &stage : stages_) {
+        OpStats &op_stats = stats.emplace_back();
+        op_stats.node_id_ = HRUN_CLIENT->node_id_;
+        op_stats.op_name_ = stage.op_.op_name_;
+        op_stats.var_name_ = stage.op_.var_name_.url_;
+        op_stats.backlog_ = stage.depth_.load();
+        op_stats.num_processed_ = stage.num_processed_.load();
+        op_stats.bytes_processed_ = stage.bytes_processed_.load();
+        op_stats.busy_usec_ = stage.busy_nsec_.load() / 1000.0;
       }
     }
-    op_data_lock_.Unlock();
-    return pending;
+    task->SerializeOpStats(stats);
+    task->SetModuleComplete();
+  }
+  void MonitorPollOpStats(u32 mode, PollOpStatsTask *task, RunContext &rctx) {
   }
 
-  /** Get the minimum of data */
-  void RunMin(RunOpTask *task, Op &op) {
-    // Get the pending data from Hermes
-    std::list<OpData> op_data = GetPendingData(op);
-    if (op_data.empty()) {
-      return;
+  /** Reduce a batch of the stage's pending blobs, one output blob each */
+  void RunStage(Task *task, OpStage &stage) {
+    Op &op = stage.op_;
+    // Dequeue a batch of input data
+    std::list<OpData> op_data;
+    {
+      hshm::ScopedMutex lock(stage.lock_, 0);
+      while (!stage.queue_.empty() && op_data.size() < OpStage::kMaxBatch) {
+        op_data.splice(op_data.end(), stage.queue_, stage.queue_.begin());
+      }
+      stage.depth_.store(stage.queue_.size());
+    }
+
+    // Outputs read by other stages are registered as their input
+    u32 out_flags = 0;
+    {
+      ScopedRwReadLock lock(stage_lock_, 0);
+      if (consumers_.find(op.var_name_.bkt_id_) != consumers_.end()) {
+        out_flags = HERMES_HAS_DERIVED;
+      }
     }
 
     // Get the input data from Hermes
@@ -193,7 +312,7 @@ class Server : public TaskLib {
       in_tasks.emplace_back(data, data_ptr, in_task);
     }
 
-    // Calculate the min of input data
+    // Reduce the input data
     for (DataPair &data_pair : in_tasks) {
       // Wait for data to be available
       OpData &data = std::get<0>(data_pair);
@@ -201,30 +320,114 @@ class Server : public TaskLib {
       LPointer<blob_mdm::GetBlobTask> &in_task = std::get<2>(data_pair);
       in_task->Wait<TASK_YIELD_CO>(task);
 
-      // Calaculate the minimum
-      LPointer<char> min_lptr =
-          HRUN_CLIENT->AllocateBufferServer<TASK_YIELD_CO>(sizeof(float), task);
-      float *min_ptr = (float*)min_lptr.ptr_;
-      *min_ptr = std::numeric_limits<float>::max();
-      for (size_t i = 0; i < in_task->data_size_; i += sizeof(float)) {
-        *min_ptr = std::min(*min_ptr, *(float*)(data_ptr.ptr_ + i));
-      }
-
-      // Store the minimum in Hermes
-      std::string min_blob_name = data.blob_name_;
-      blob_mdm_.AsyncPutBlob(task->task_node_ + 1,
-                             op.var_name_.bkt_id_,
-                             hshm::charbuf(min_blob_name),
-                             BlobId::GetNull(),
-                             0, sizeof(float),
-                             min_lptr.shm_, 0, 0);
+      // Reduce directly over the buffer the blob was read into
+      LPointer<char> out_lptr;
+      size_t out_size = 0;
+      hshm::Timepoint start;
+      start.Now();
+      switch (static_cast<OpType>(op.type_id_)) {
+        case OpType::kFloat:
+          out_size = Reduce<float>(task, op, data_ptr.ptr_,
+                                   in_task->data_size_, out_lptr);
+          break;
+        case OpType::kDouble:
+          out_size = Reduce<double>(task, op, data_ptr.ptr_,
+                                    in_task->data_size_, out_lptr);
+          break;
+        case OpType::kInt32:
+          out_size = Reduce<int32_t>(task, op, data_ptr.ptr_,
+                                     in_task->data_size_, out_lptr);
+          break;
+        case OpType::kUint32:
+          out_size = Reduce<uint32_t>(task, op, data_ptr.ptr_,
+                                      in_task->data_size_, out_lptr);
+          break;
+        case OpType::kInt64:
+          out_size = Reduce<int64_t>(task, op, data_ptr.ptr_,
+                                     in_task->data_size_, out_lptr);
+          break;
+        case OpType::kUint64:
+          out_size = Reduce<uint64_t>(task, op, data_ptr.ptr_,
+                                      in_task->data_size_, out_lptr);
+          break;
+      }
+      stage.busy_nsec_.fetch_add((size_t)start.GetNsecFromStart());
+      stage.num_processed_.fetch_add(1);
+      stage.bytes_processed_.fetch_add(in_task->data_size_);
+
+      // Store the result in Hermes
+      if (out_size > 0) {
+        blob_mdm_.AsyncPutBlob(task->task_node_ + 1,
+                               op.var_name_.bkt_id_,
+                               hshm::charbuf(data.blob_name_),
+                               BlobId::GetNull(),
+                               0, out_size,
+                               out_lptr.shm_, 0, out_flags);
+      }
       HRUN_CLIENT->FreeBuffer(in_task->data_);
       HRUN_CLIENT->DelTask(in_task);
     }
   }
 
-  /** Get the maximum of data */
-  void RunMax(RunOpTask *task, Op &op) {
+  /**
+   * Compute the op over one blob of T elements.
+   * Returns the size of the result stored in \a out, or 0 on error.
+   * */
+  template<typename T>
+  size_t Reduce(Task *task, Op &op,
+                const char *buf, size_t size,
+                LPointer<char> &out) {
+    const ReduceKernels<T> &kernels = GetReduceKernels<T>();
+    const T *data = reinterpret_cast<const T*>(buf);
+    size_t count = size / sizeof(T);
+    switch (static_cast<OpId>(op.op_id_)) {
+      case OpId::kMin: {
+        out = HRUN_CLIENT->AllocateBufferServer<TASK_YIELD_CO>(sizeof(T), task);
+        *(T*)out.ptr_ = kernels.min_(data, count);
+        return sizeof(T);
+      }
+      case OpId::kMax: {
+        out = HRUN_CLIENT->AllocateBufferServer<TASK_YIELD_CO>(sizeof(T), task);
+        *(T*)out.ptr_ = kernels.max_(data, count);
+        return sizeof(T);
+      }
+      case OpId::kSum: {
+        out = HRUN_CLIENT->AllocateBufferServer<TASK_YIELD_CO>(
+            sizeof(double), task);
+        *(double*)out.ptr_ = kernels.sum_(data, count);
+        return sizeof(double);
+      }
+      case OpId::kMean:
+      case OpId::kVariance: {
+        out = HRUN_CLIENT->AllocateBufferServer<TASK_YIELD_CO>(
+            sizeof(double), task);
+        double mean = count ? kernels.sum_(data, count) / count : 0;
+        if (op.op_id_ == (u32)OpId::kMean) {
+          *(double*)out.ptr_ = mean;
+        } else {
+          // Two passes avoid the cancellation of E[x^2] - E[x]^2
+          *(double*)out.ptr_ = count ?
+              kernels.sum_sq_diff_(data, count, mean) / count : 0;
+        }
+        return sizeof(double);
+      }
+      case OpId::kHistogram: {
+        // args: number of bins, lower bound, upper bound
+        if (op.args_.size() < 3 || op.args_[0] < 1) {
+          HELOG(kError, "The histogram of {} needs (nbins, lo, hi) args",
+                op.var_name_.url_);
+          return 0;
+        }
+        size_t nbins = (size_t)op.args_[0];
+        size_t out_size = nbins * sizeof(u64);
+        out = HRUN_CLIENT->AllocateBufferServer<TASK_YIELD_CO>(out_size, task);
+        memset(out.ptr_, 0, out_size);
+        kernels.histogram_(data, count, op.args_[1], op.args_[2],
+                           (u64*)out.ptr_, nbins);
+        return out_size;
+      }
+    }
+    return 0;
   }
 
  public:
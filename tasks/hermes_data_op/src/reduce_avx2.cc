@@ -0,0 +1,164 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <immintrin.h>
+#include "reduce_kernels_impl.h"
+
+/** Reduction kernels compiled with -mavx2 -mfma */
+
+namespace hermes::data_op {
+
+namespace {
+
+/** Double vector ops */
+struct Avx2Double {
+  typedef __m256d Vec;
+  static Vec Zero() { return _mm256_setzero_pd(); }
+  static Vec Set1(double val) { return _mm256_set1_pd(val); }
+  static Vec Add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+  static Vec Sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+  static Vec Fmadd(Vec a, Vec b, Vec c) { return _mm256_fmadd_pd(a, b, c); }
+  static double HSum(Vec a) {
+    __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(a),
+                             _mm256_extractf128_pd(a, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+  }
+};
+
+/** float */
+struct Avx2Float {
+  typedef float T;
+  typedef __m256 Vec;
+  typedef Avx2Double D;
+  static constexpr size_t kLanes = 8;
+  static constexpr size_t kDVecs = 2;
+  static Vec Load(const T *p) { return _mm256_loadu_ps(p); }
+  static void Store(T *p, Vec v) { _mm256_storeu_ps(p, v); }
+  static Vec Min(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+  static void ToDouble(const T *p, D::Vec *d) {
+    d[0] = _mm256_cvtps_pd(_mm_loadu_ps(p));
+    d[1] = _mm256_cvtps_pd(_mm_loadu_ps(p + 4));
+  }
+};
+
+/** double */
+struct Avx2F64 {
+  typedef double T;
+  typedef __m256d Vec;
+  typedef Avx2Double D;
+  static constexpr size_t kLanes = 4;
+  static constexpr size_t kDVecs = 1;
+  static Vec Load(const T *p) { return _mm256_loadu_pd(p); }
+  static void Store(T *p, Vec v) { _mm256_storeu_pd(p, v); }
+  static Vec Min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+  static void ToDouble(const T *p, D::Vec *d) {
+    d[0] = _mm256_loadu_pd(p);
+  }
+};
+
+/** Integer vector load and store */
+template<typename IntT>
+struct Avx2Int {
+  typedef IntT T;
+  typedef __m256i Vec;
+  static constexpr size_t kLanes = 32 / sizeof(T);
+  static Vec Load(const T *p) {
+    return _mm256_loadu_si256((const __m256i*)p);
+  }
+  static void Store(T *p, Vec v) { _mm256_storeu_si256((__m256i*)p, v); }
+};
+
+/** int32_t */
+struct Avx2I32 : public Avx2Int<int32_t> {
+  typedef Avx2Double D;
+  static constexpr size_t kDVecs = 2;
+  static Vec Min(Vec a, Vec b) { return _mm256_min_epi32(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm256_max_epi32(a, b); }
+  static void ToDouble(const T *p, D::Vec *d) {
+    d[0] = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)p));
+    d[1] = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i*)(p + 4)));
+  }
+};
+
+/** uint32_t. AVX2 cannot convert unsigned integers to double. */
+struct Avx2U32 : public Avx2Int<uint32_t> {
+  static Vec Min(Vec a, Vec b) { return _mm256_min_epu32(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm256_max_epu32(a, b); }
+};
+
+/** int64_t. AVX2 has no 64-bit min/max, so they are built from compares. */
+struct Avx2I64 : public Avx2Int<int64_t> {
+  static Vec Min(Vec a, Vec b) {
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+  }
+  static Vec Max(Vec a, Vec b) {
+    return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+  }
+};
+
+template<typename T>
+struct Avx2Table;
+template<>
+struct Avx2Table<float> {
+  static ReduceKernels<float> Make() {
+    return MakeSimdKernels<Avx2Float>();
+  }
+};
+template<>
+struct Avx2Table<double> {
+  static ReduceKernels<double> Make() {
+    return MakeSimdKernels<Avx2F64>();
+  }
+};
+template<>
+struct Avx2Table<int32_t> {
+  static ReduceKernels<int32_t> Make() {
+    return MakeSimdKernels<Avx2I32>();
+  }
+};
+template<>
+struct Avx2Table<uint32_t> {
+  static ReduceKernels<uint32_t> Make() {
+    return MakeSimdMinMaxKernels<Avx2U32>();
+  }
+};
+template<>
+struct Avx2Table<int64_t> {
+  static ReduceKernels<int64_t> Make() {
+    return MakeSimdMinMaxKernels<Avx2I64>();
+  }
+};
+template<>
+struct Avx2Table<uint64_t> {
+  static ReduceKernels<uint64_t> Make() {
+    return MakeScalarKernels<uint64_t>();
+  }
+};
+
+}  // namespace
+
+template<typename T>
+const ReduceKernels<T>& GetAvx2Kernels() {
+  static const ReduceKernels<T> kernels = Avx2Table<T>::Make();
+  return kernels;
+}
+
+template const ReduceKernels<float>& GetAvx2Kernels<float>();
+template const ReduceKernels<double>& GetAvx2Kernels<double>();
+template const ReduceKernels<int32_t>& GetAvx2Kernels<int32_t>();
+template const ReduceKernels<uint32_t>& GetAvx2Kernels<uint32_t>();
+template const ReduceKernels<int64_t>& GetAvx2Kernels<int64_t>();
+template const ReduceKernels<uint64_t>& GetAvx2Kernels<uint64_t>();
+
+}  // namespace hermes::data_op
@@ -0,0 +1,159 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <immintrin.h>
+#include "reduce_kernels_impl.h"
+
+/** Reduction kernels compiled with -mavx512f -mavx512dq */
+
+namespace hermes::data_op {
+
+namespace {
+
+/** Double vector ops */
+struct Avx512Double {
+  typedef __m512d Vec;
+  static Vec Zero() { return _mm512_setzero_pd(); }
+  static Vec Set1(double val) { return _mm512_set1_pd(val); }
+  static Vec Add(Vec a, Vec b) { return _mm512_add_pd(a, b); }
+  static Vec Sub(Vec a, Vec b) { return _mm512_sub_pd(a, b); }
+  static Vec Fmadd(Vec a, Vec b, Vec c) { return _mm512_fmadd_pd(a, b, c); }
+  static double HSum(Vec a) { return _mm512_reduce_add_pd(a); }
+};
+
+/** float */
+struct Avx512Float {
+  typedef float T;
+  typedef __m512 Vec;
+  typedef Avx512Double D;
+  static constexpr size_t kLanes = 16;
+  static constexpr size_t kDVecs = 2;
+  static Vec Load(const T *p) { return _mm512_loadu_ps(p); }
+  static void Store(T *p, Vec v) { _mm512_storeu_ps(p, v); }
+  static Vec Min(Vec a, Vec b) { return _mm512_min_ps(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm512_max_ps(a, b); }
+  static void ToDouble(const T *p, D::Vec *d) {
+    d[0] = _mm512_cvtps_pd(_mm256_loadu_ps(p));
+    d[1] = _mm512_cvtps_pd(_mm256_loadu_ps(p + 8));
+  }
+};
+
+/** double */
+struct Avx512F64 {
+  typedef double T;
+  typedef __m512d Vec;
+  typedef Avx512Double D;
+  static constexpr size_t kLanes = 8;
+  static constexpr size_t kDVecs = 1;
+  static Vec Load(const T *p) { return _mm512_loadu_pd(p); }
+  static void Store(T *p, Vec v) { _mm512_storeu_pd(p, v); }
+  static Vec Min(Vec a, Vec b) { return _mm512_min_pd(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm512_max_pd(a, b); }
+  static void ToDouble(const T *p, D::Vec *d) {
+    d[0] = _mm512_loadu_pd(p);
+  }
+};
+
+/** Integer vector load and store */
+template<typename IntT>
+struct Avx512Int {
+  typedef IntT T;
+  typedef __m512i Vec;
+  typedef Avx512Double D;
+  static constexpr size_t kLanes = 64 / sizeof(T);
+  static constexpr size_t kDVecs = kLanes / 8;
+  static Vec Load(const T *p) { return _mm512_loadu_si512(p); }
+  static void Store(T *p, Vec v) { _mm512_storeu_si512(p, v); }
+};
+
+/** int32_t */
+struct Avx512I32 : public Avx512Int<int32_t> {
+  static Vec Min(Vec a, Vec b) { return _mm512_min_epi32(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm512_max_epi32(a, b); }
+  static void ToDouble(const T *p, D::Vec *d) {
+    d[0] = _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i*)p));
+    d[1] = _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i*)(p + 8)));
+  }
+};
+
+/** uint32_t */
+struct Avx512U32 : public Avx512Int<uint32_t> {
+  static Vec Min(Vec a, Vec b) { return _mm512_min_epu32(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm512_max_epu32(a, b); }
+  static void ToDouble(const T *p, D::Vec *d) {
+    d[0] = _mm512_cvtepu32_pd(_mm256_loadu_si256((const __m256i*)p));
+    d[1] = _mm512_cvtepu32_pd(_mm256_loadu_si256((const __m256i*)(p + 8)));
+  }
+};
+
+/** int64_t */
+struct Avx512I64 : public Avx512Int<int64_t> {
+  static Vec Min(Vec a, Vec b) { return _mm512_min_epi64(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm512_max_epi64(a, b); }
+  static void ToDouble(const T *p, D::Vec *d) {
+    d[0] = _mm512_cvtepi64_pd(_mm512_loadu_si512(p));
+  }
+};
+
+/** uint64_t */
+struct Avx512U64 : public Avx512Int<uint64_t> {
+  static Vec Min(Vec a, Vec b) { return _mm512_min_epu64(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm512_max_epu64(a, b); }
+  static void ToDouble(const T *p, D::Vec *d) {
+    d[0] = _mm512_cvtepu64_pd(_mm512_loadu_si512(p));
+  }
+};
+
+template<typename T>
+struct Avx512Table;
+template<>
+struct Avx512Table<float> {
+  typedef Avx512Float V;
+};
+template<>
+struct Avx512Table<double> {
+  typedef Avx512F64 V;
+};
+template<>
+struct Avx512Table<int32_t> {
+  typedef Avx512I32 V;
+};
+template<>
+struct Avx512Table<uint32_t> {
+  typedef Avx512U32 V;
+};
+template<>
+struct Avx512Table<int64_t> {
+  typedef Avx512I64 V;
+};
+template<>
+struct Avx512Table<uint64_t> {
+  typedef Avx512U64 V;
+};
+
+}  // namespace
+
+template<typename T>
+const ReduceKernels<T>& GetAvx512Kernels() {
+  static const ReduceKernels<T> kernels =
+      MakeSimdKernels<typename Avx512Table<T>::V>();
+  return kernels;
+}
+
+template const ReduceKernels<float>& GetAvx512Kernels<float>();
+template const ReduceKernels<double>& GetAvx512Kernels<double>();
+template const ReduceKernels<int32_t>& GetAvx512Kernels<int32_t>();
+template const ReduceKernels<uint32_t>& GetAvx512Kernels<uint32_t>();
+template const ReduceKernels<int64_t>& GetAvx512Kernels<int64_t>();
+template const ReduceKernels<uint64_t>& GetAvx512Kernels<uint64_t>();
+
+}  // namespace hermes::data_op
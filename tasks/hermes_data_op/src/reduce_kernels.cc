@@ -0,0 +1,58 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "reduce_kernels_impl.h"
+
+namespace hermes::data_op {
+
+/** Detect the instruction set once */
+static SimdLevel DetectSimdLevel() {
+#ifdef HERMES_DATA_OP_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") &&
+      __builtin_cpu_supports("avx512dq")) {
+    return SimdLevel::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return SimdLevel::kAvx2;
+  }
+#endif
+  return SimdLevel::kScalar;
+}
+
+SimdLevel GetSimdLevel() {
+  static const SimdLevel level = DetectSimdLevel();
+  return level;
+}
+
+template<typename T>
+const ReduceKernels<T>& GetReduceKernels(SimdLevel level) {
+#ifdef HERMES_DATA_OP_X86
+  if (level >= SimdLevel::kAvx512) {
+    return GetAvx512Kernels<T>();
+  }
+  if (level >= SimdLevel::kAvx2) {
+    return GetAvx2Kernels<T>();
+  }
+#endif
+  static const ReduceKernels<T> kernels = MakeScalarKernels<T>();
+  return kernels;
+}
+
+template const ReduceKernels<float>& GetReduceKernels<float>(SimdLevel);
+template const ReduceKernels<double>& GetReduceKernels<double>(SimdLevel);
+template const ReduceKernels<int32_t>& GetReduceKernels<int32_t>(SimdLevel);
+template const ReduceKernels<uint32_t>& GetReduceKernels<uint32_t>(SimdLevel);
+template const ReduceKernels<int64_t>& GetReduceKernels<int64_t>(SimdLevel);
+template const ReduceKernels<uint64_t>& GetReduceKernels<uint64_t>(SimdLevel);
+
+}  // namespace hermes::data_op
@@ -0,0 +1,285 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef HERMES_TASKS_HERMES_DATA_OP_SRC_REDUCE_KERNELS_IMPL_H_
+#define HERMES_TASKS_HERMES_DATA_OP_SRC_REDUCE_KERNELS_IMPL_H_
+
+#include <limits>
+#include "hermes_data_op/reduce_kernels.h"
+
+/**
+ * Kernel templates shared by the translation units of each instruction set.
+ * Every TU is compiled with the flags of its instruction set, so nothing
+ * here may be called unless the CPU supports it. The templates have
+ * internal linkage: otherwise, the linker could pick the AVX-512 copy of
+ * ScalarMin for every TU, which faults on CPUs without AVX-512. For the
+ * same reason, nothing here instantiates an inline function of the
+ * standard library, such as std::min or std::vector's members, since
+ * those are emitted as weak symbols shared by every TU.
+ * */
+
+namespace hermes::data_op {
+
+/** Get the kernels compiled with AVX2 + FMA */
+template<typename T>
+const ReduceKernels<T>& GetAvx2Kernels();
+
+/** Get the kernels compiled with AVX-512F + AVX-512DQ */
+template<typename T>
+const ReduceKernels<T>& GetAvx512Kernels();
+
+namespace {
+
+/** The smaller of \a a and \a b */
+template<typename T>
+T MinOf(T a, T b) {
+  return b < a ? b : a;
+}
+
+/** The larger of \a a and \a b */
+template<typename T>
+T MaxOf(T a, T b) {
+  return a < b ? b : a;
+}
+
+/** Scalar minimum */
+template<typename T>
+T ScalarMin(const T *data, size_t count) {
+  constexpr T kInit = std::numeric_limits<T>::max();
+  T min = kInit;
+  for (size_t i = 0; i < count; ++i) {
+    min = MinOf(min, data[i]);
+  }
+  return min;
+}
+
+/** Scalar maximum */
+template<typename T>
+T ScalarMax(const T *data, size_t count) {
+  constexpr T kInit = std::numeric_limits<T>::lowest();
+  T max = kInit;
+  for (size_t i = 0; i < count; ++i) {
+    max = MaxOf(max, data[i]);
+  }
+  return max;
+}
+
+/** Scalar sum */
+template<typename T>
+double ScalarSum(const T *data, size_t count) {
+  double sum = 0;
+  for (size_t i = 0; i < count; ++i) {
+    sum += (double)data[i];
+  }
+  return sum;
+}
+
+/** Scalar sum of squared differences */
+template<typename T>
+double ScalarSumSqDiff(const T *data, size_t count, double mean) {
+  double sum = 0;
+  for (size_t i = 0; i < count; ++i) {
+    double diff = (double)data[i] - mean;
+    sum += diff * diff;
+  }
+  return sum;
+}
+
+/**
+ * Histogram of the elements
+ *
+ * Scatter-increments conflict when neighboring elements land in the same
+ * bin, so this keeps four sub-histograms instead of using vector scatters.
+ * Each sub-histogram has an extra slot for out-of-range elements.
+ * */
+template<typename T>
+void Histogram(const T *data, size_t count,
+               double lo, double hi,
+               uint64_t *bins, size_t nbins) {
+  if (nbins == 0 || !(hi > lo)) {
+    return;
+  }
+  double scale = (double)nbins / (hi - lo);
+  size_t stride = nbins + 1;
+  uint64_t *sub = new uint64_t[stride * 4]();
+  auto bin_of = [lo, hi, scale, nbins](T x) {
+    double val = (double)x;
+    if (!(val >= lo && val <= hi)) {
+      return nbins;
+    }
+    return MinOf((size_t)((val - lo) * scale), nbins - 1);
+  };
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    ++sub[bin_of(data[i])];
+    ++sub[stride + bin_of(data[i + 1])];
+    ++sub[2 * stride + bin_of(data[i + 2])];
+    ++sub[3 * stride + bin_of(data[i + 3])];
+  }
+  for (; i < count; ++i) {
+    ++sub[bin_of(data[i])];
+  }
+  for (size_t b = 0; b < nbins; ++b) {
+    bins[b] += sub[b] + sub[stride + b] + sub[2 * stride + b] +
+        sub[3 * stride + b];
+  }
+  delete[] sub;
+}
+
+/**
+ * Vectorized reductions over the element vector type V.
+ *
+ * V provides T, Vec, kLanes, Load, Store, Min and Max. For sums, it also
+ * provides D (the double vector ops), kDVecs, and ToDouble, which converts
+ * kLanes elements into kDVecs double vectors.
+ * */
+template<typename V>
+struct SimdReduce {
+  typedef typename V::T T;
+  typedef typename V::Vec Vec;
+  static constexpr size_t kLanes = V::kLanes;
+  static constexpr size_t kUnroll = 4;
+
+  /** Minimum */
+  static T Min(const T *data, size_t count) {
+    if (count < kUnroll * kLanes) {
+      return ScalarMin(data, count);
+    }
+    Vec acc[kUnroll];
+    for (size_t k = 0; k < kUnroll; ++k) {
+      acc[k] = V::Load(data + k * kLanes);
+    }
+    size_t i = kUnroll * kLanes;
+    for (; i + kUnroll * kLanes <= count; i += kUnroll * kLanes) {
+      for (size_t k = 0; k < kUnroll; ++k) {
+        acc[k] = V::Min(acc[k], V::Load(data + i + k * kLanes));
+      }
+    }
+    for (; i + kLanes <= count; i += kLanes) {
+      acc[0] = V::Min(acc[0], V::Load(data + i));
+    }
+    for (size_t k = 1; k < kUnroll; ++k) {
+      acc[0] = V::Min(acc[0], acc[k]);
+    }
+    T lanes[kLanes];
+    V::Store(lanes, acc[0]);
+    return MinOf(ScalarMin(lanes, kLanes), ScalarMin(data + i, count - i));
+  }
+
+  /** Maximum */
+  static T Max(const T *data, size_t count) {
+    if (count < kUnroll * kLanes) {
+      return ScalarMax(data, count);
+    }
+    Vec acc[kUnroll];
+    for (size_t k = 0; k < kUnroll; ++k) {
+      acc[k] = V::Load(data + k * kLanes);
+    }
+    size_t i = kUnroll * kLanes;
+    for (; i + kUnroll * kLanes <= count; i += kUnroll * kLanes) {
+      for (size_t k = 0; k < kUnroll; ++k) {
+        acc[k] = V::Max(acc[k], V::Load(data + i + k * kLanes));
+      }
+    }
+    for (; i + kLanes <= count; i += kLanes) {
+      acc[0] = V::Max(acc[0], V::Load(data + i));
+    }
+    for (size_t k = 1; k < kUnroll; ++k) {
+      acc[0] = V::Max(acc[0], acc[k]);
+    }
+    T lanes[kLanes];
+    V::Store(lanes, acc[0]);
+    return MaxOf(ScalarMax(lanes, kLanes), ScalarMax(data + i, count - i));
+  }
+
+  /** Sum, using two sets of accumulators to hide the add latency */
+  static double Sum(const T *data, size_t count) {
+    typedef typename V::D D;
+    typename D::Vec acc[2][V::kDVecs], vals[V::kDVecs];
+    for (size_t k = 0; k < V::kDVecs; ++k) {
+      acc[0][k] = D::Zero();
+      acc[1][k] = D::Zero();
+    }
+    size_t i = 0;
+    for (; i + 2 * kLanes <= count; i += 2 * kLanes) {
+      for (size_t j = 0; j < 2; ++j) {
+        V::ToDouble(data + i + j * kLanes, vals);
+        for (size_t k = 0; k < V::kDVecs; ++k) {
+          acc[j][k] = D::Add(acc[j][k], vals[k]);
+        }
+      }
+    }
+    double sum = 0;
+    for (size_t k = 0; k < V::kDVecs; ++k) {
+      sum += D::HSum(D::Add(acc[0][k], acc[1][k]));
+    }
+    return sum + ScalarSum(data + i, count - i);
+  }
+
+  /** Sum of squared differences from the mean */
+  static double SumSqDiff(const T *data, size_t count, double mean) {
+    typedef typename V::D D;
+    typename D::Vec acc[2][V::kDVecs], vals[V::kDVecs];
+    typename D::Vec dmean = D::Set1(mean);
+    for (size_t k = 0; k < V::kDVecs; ++k) {
+      acc[0][k] = D::Zero();
+      acc[1][k] = D::Zero();
+    }
+    size_t i = 0;
+    for (; i + 2 * kLanes <= count; i += 2 * kLanes) {
+      for (size_t j = 0; j < 2; ++j) {
+        V::ToDouble(data + i + j * kLanes, vals);
+        for (size_t k = 0; k < V::kDVecs; ++k) {
+          typename D::Vec diff = D::Sub(vals[k], dmean);
+          acc[j][k] = D::Fmadd(diff, diff, acc[j][k]);
+        }
+      }
+    }
+    double sum = 0;
+    for (size_t k = 0; k < V::kDVecs; ++k) {
+      sum += D::HSum(D::Add(acc[0][k], acc[1][k]));
+    }
+    return sum + ScalarSumSqDiff(data + i, count - i, mean);
+  }
+};
+
+/** Build a kernel table where every reduction is vectorized */
+template<typename V>
+ReduceKernels<typename V::T> MakeSimdKernels() {
+  typedef typename V::T T;
+  return ReduceKernels<T>{SimdReduce<V>::Min, SimdReduce<V>::Max,
+                          SimdReduce<V>::Sum, SimdReduce<V>::SumSqDiff,
+                          Histogram<T>};
+}
+
+/** Build a kernel table where only min and max are vectorized */
+template<typename V>
+ReduceKernels<typename V::T> MakeSimdMinMaxKernels() {
+  typedef typename V::T T;
+  return ReduceKernels<T>{SimdReduce<V>::Min, SimdReduce<V>::Max,
+                          ScalarSum<T>, ScalarSumSqDiff<T>,
+                          Histogram<T>};
+}
+
+/** Build a kernel table with no explicit vectorization */
+template<typename T>
+ReduceKernels<T> MakeScalarKernels() {
+  return ReduceKernels<T>{ScalarMin<T>, ScalarMax<T>,
+                          ScalarSum<T>, ScalarSumSqDiff<T>,
+                          Histogram<T>};
+}
+
+}  // namespace
+
+}  // namespace hermes::data_op
+
+#endif  // HERMES_TASKS_HERMES_DATA_OP_SRC_REDUCE_KERNELS_IMPL_H_
@@ -0,0 +1,346 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "hrun_admin/hrun_admin.h"
+#include "hrun/api/hrun_runtime.h"
+#include "mmap_bdev/mmap_bdev.h"
+#include "hermes/slab_allocator.h"
+#include "hermes/crc32c.h"
+#include "hermes/pmem_copy.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+#include <numeric>
+
+namespace hermes::mmap_bdev {
+
+/**
+ * The first page of the file of an mmap bdev, followed by the slab map
+ * and the data. A file is only reused if its header matches the device's
+ * configuration.
+ * */
+struct MmapBdevHeader {
+  static const u64 kMagic = 0x5645444250414d4dULL;  /**< "MMAPBDEV" */
+  static const u32 kVersion = 1;
+  static const size_t kMaxSlabs = 64;
+
+  u64 magic_;                   /**< kMagic, written once the rest is */
+  u32 version_;                 /**< kVersion */
+  u32 num_slabs_;               /**< The number of slab sizes */
+  u64 capacity_;                /**< Bytes of data */
+  u64 granule_;                 /**< Bytes of data per slab map entry */
+  u64 data_off_;                /**< Offset of the data in the file */
+  u64 slab_sizes_[kMaxSlabs];   /**< The slab sizes, in order */
+};
+
+class Server : public TaskLib, public bdev::Server {
+ public:
+  /** The header page */
+  static const size_t kHeaderSize = KILOBYTES(4);
+  /** The data is aligned for huge pages on DAX and hugetlbfs */
+  static const size_t kDataAlign = MEGABYTES(2);
+  /** Writes at least this large bypass the caches */
+  static const size_t kNtCopySize = MEGABYTES(2);
+  /** The same, when the caches are written back after each write */
+  static const size_t kNtFlushCopySize = KILOBYTES(4);
+
+  SlabAllocator alloc_;
+  int fd_;
+  std::string path_;
+  char *map_;                   /**< The mapped file */
+  size_t map_size_;             /**< The size of the file */
+  u8 *slab_map_;                /**< The slab of each carved buffer */
+  size_t granule_;              /**< Bytes of data per slab_map_ entry */
+  char *mem_ptr_;               /**< The data */
+  size_t page_size_;            /**< The system page size, for msync */
+  bool is_sync_;                /**< Whether the file is mapped with MAP_SYNC */
+  MmapDurability durability_;   /**< How writes are made durable */
+  size_t nt_copy_size_;         /**< Writes at least this large bypass caches */
+
+ public:
+  /** Construct mmap bdev */
+  void Construct(ConstructTask *task, RunContext &rctx) {
+    DeviceInfo &dev_info = task->info_;
+    rem_cap_ = 0;
+    fd_ = -1;
+    map_ = nullptr;
+    score_hist_.Resize(10);
+    std::string text = dev_info.mount_dir_ +
+        "/" + "slab_" + dev_info.dev_name_;
+    auto canon = stdfs::weakly_canonical(text).string();
+    dev_info.mount_point_ = canon;
+    path_ = canon;
+    page_size_ = sysconf(_SC_PAGESIZE);
+
+    // Determine the layout of the file
+    size_t capacity = dev_info.capacity_;
+    std::vector<size_t> &slab_sizes = dev_info.slab_sizes_;
+    granule_ = 0;
+    for (size_t slab_size : slab_sizes) {
+      granule_ = std::gcd(granule_, slab_size);
+    }
+    if (granule_ == 0 || slab_sizes.size() > MmapBdevHeader::kMaxSlabs) {
+      HELOG(kError, "Invalid slab sizes for {}", path_);
+      FailConstruct(task, slab_sizes);
+      return;
+    }
+    size_t map_entries = (capacity + granule_ - 1) / granule_;
+    size_t data_off = RoundUp(kHeaderSize + map_entries, kDataAlign);
+    map_size_ = data_off + RoundUp(capacity, kDataAlign);
+
+    // Map the file, keeping its contents if it has the same size
+    fd_ = open(path_.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd_ < 0) {
+      HELOG(kError, "Failed to open file: {}", path_);
+      FailConstruct(task, slab_sizes);
+      return;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || (size_t)st.st_size != map_size_) {
+      // Touching pages past the end of a short file raises SIGBUS, so the
+      // file must be resized and its blocks reserved before it is mapped
+      if (ftruncate(fd_, 0) != 0 || ftruncate(fd_, map_size_) != 0) {
+        HELOG(kError, "Failed to resize {}: {}", path_, strerror(errno));
+        FailConstruct(task, slab_sizes);
+        return;
+      }
+      int ret = posix_fallocate(fd_, 0, map_size_);
+      if (ret != 0) {
+        HELOG(kError, "Failed to reserve {} bytes for {}: {}",
+              map_size_, path_, strerror(ret));
+        FailConstruct(task, slab_sizes);
+        return;
+      }
+    }
+    map_ = MapFile();
+    if (map_ == nullptr) {
+      HELOG(kError, "Failed to map {}: {}", path_, strerror(errno));
+      FailConstruct(task, slab_sizes);
+      return;
+    }
+    slab_map_ = reinterpret_cast<u8*>(map_ + kHeaderSize);
+    mem_ptr_ = map_ + data_off;
+
+    // Cache write backs only reach the media of MAP_SYNC mappings
+    durability_ = dev_info.durability_;
+    if (durability_ == MmapDurability::kClwb &&
+        (!is_sync_ || !PmemCopy::HasFlush())) {
+      HILOG(kInfo, "{} is not mapped with DAX, using msync for durability",
+            path_);
+      durability_ = MmapDurability::kMsync;
+    }
+    nt_copy_size_ = durability_ == MmapDurability::kClwb ?
+        kNtFlushCopySize : kNtCopySize;
+
+    // Recover the slab layout, or start a new one
+    rem_cap_ = capacity;
+    alloc_.Init(id_, capacity, slab_sizes);
+    alloc_.SetSlabMap(slab_map_, granule_);
+    auto *header = reinterpret_cast<MmapBdevHeader*>(map_);
+    if (IsLayout(*header, capacity, slab_sizes, data_off)) {
+      size_t recovered = alloc_.Recover();
+      Persist(slab_map_, map_entries, MmapDurability::kMsync);
+      HILOG(kInfo, "Recovered {} bytes of slabs from {}", recovered, path_);
+    } else {
+      memset(map_, 0, kHeaderSize + map_entries);
+      header->version_ = MmapBdevHeader::kVersion;
+      header->num_slabs_ = slab_sizes.size();
+      header->capacity_ = capacity;
+      header->granule_ = granule_;
+      header->data_off_ = data_off;
+      for (size_t i = 0; i < slab_sizes.size(); ++i) {
+        header->slab_sizes_[i] = slab_sizes[i];
+      }
+      Persist(map_, kHeaderSize + map_entries, MmapDurability::kMsync);
+      header->magic_ = MmapBdevHeader::kMagic;
+      Persist(header, sizeof(MmapBdevHeader), MmapDurability::kMsync);
+    }
+    HILOG(kInfo, "Created {} at {} of size {} (MAP_SYNC: {})",
+          dev_info.dev_name_, dev_info.mount_point_, capacity, is_sync_);
+    task->SetModuleComplete();
+  }
+  void MonitorConstruct(u32 mode, ConstructTask *task, RunContext &rctx) {
+  }
+
+  /** Destroy mmap bdev. The file is kept for the next run. */
+  void Destruct(DestructTask *task, RunContext &rctx) {
+    if (map_) {
+      msync(map_, map_size_, MS_SYNC);
+      munmap(map_, map_size_);
+      map_ = nullptr;
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+    task->SetModuleComplete();
+  }
+  void MonitorDestruct(u32 mode, DestructTask *task, RunContext &rctx) {
+  }
+
+  /** Allocate space from bdev */
+  void Allocate(AllocateTask *task, RunContext &rctx) {
+    std::vector<BufferInfo> &buffers = *task->buffers_;
+    size_t first = buffers.size();
+    alloc_.Allocate(task->size_, buffers, task->alloc_size_);
+    HILOG(kDebug, "Allocated {}/{} bytes ({})", task->alloc_size_, task->size_, path_);
+    // Persist the slab map entries of the buffers
+    if (durability_ != MmapDurability::kNone && first < buffers.size()) {
+      size_t lo = buffers[first].t_off_, hi = lo;
+      for (size_t i = first; i < buffers.size(); ++i) {
+        lo = std::min(lo, buffers[i].t_off_);
+        hi = std::max(hi, buffers[i].t_off_);
+      }
+      Persist(slab_map_ + lo / granule_, (hi - lo) / granule_ + 1,
+              durability_);
+    }
+    rem_cap_ -= task->alloc_size_;
+    score_hist_.Increment(task->score_);
+    task->SetModuleComplete();
+  }
+  void MonitorAllocate(u32 mode, AllocateTask *task, RunContext &rctx) {
+  }
+
+  /** Free space from bdev */
+  void Free(FreeTask *task, RunContext &rctx) {
+    rem_cap_ += alloc_.Free(task->buffers_);
+    score_hist_.Decrement(task->score_);
+    task->rem_cap_ = rem_cap_;
+    task->SetModuleComplete();
+  }
+  void MonitorFree(u32 mode, FreeTask *task, RunContext &rctx) {
+  }
+
+  /** Write to bdev */
+  void Write(WriteTask *task, RunContext &rctx) {
+    HILOG(kDebug, "Writing {} bytes to {}", task->size_, path_);
+    char *dst = mem_ptr_ + task->disk_off_;
+    size_t crc_size = std::min(task->crc_size_, task->size_);
+    if (task->size_ >= nt_copy_size_) {
+      task->crc_ = hermes::Crc32c::Compute(task->buf_, crc_size);
+      PmemCopy::CopyNt(dst, task->buf_, task->size_);
+      if (durability_ == MmapDurability::kMsync) {
+        Persist(dst, task->size_, durability_);
+      }
+    } else {
+      task->crc_ = hermes::Crc32c::Copy(dst, task->buf_, crc_size);
+      memcpy(dst + crc_size, task->buf_ + crc_size, task->size_ - crc_size);
+      Persist(dst, task->size_, durability_);
+    }
+    task->SetModuleComplete();
+  }
+  void MonitorWrite(u32 mode, WriteTask *task, RunContext &rctx) {
+  }
+
+  /** Read from bdev */
+  void Read(ReadTask *task, RunContext &rctx) {
+    HILOG(kDebug, "Reading {} bytes from {}", task->size_, path_);
+    const char *src = mem_ptr_ + task->disk_off_;
+    size_t crc_size = std::min(task->crc_size_, task->size_);
+    task->crc_ = hermes::Crc32c::Copy(task->buf_, src, crc_size);
+    memcpy(task->buf_ + crc_size, src + crc_size, task->size_ - crc_size);
+    task->SetModuleComplete();
+  }
+  void MonitorRead(u32 mode, ReadTask *task, RunContext &rctx) {
+  }
+
+ private:
+  /** Leave the device with no capacity after a failed construct */
+  void FailConstruct(ConstructTask *task, std::vector<size_t> &slab_sizes) {
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+    rem_cap_ = 0;
+    alloc_.Init(id_, 0, slab_sizes);
+    task->SetModuleComplete();
+  }
+
+  /** Round \a size up to a multiple of \a align */
+  static size_t RoundUp(size_t size, size_t align) {
+    return (size + align - 1) / align * align;
+  }
+
+  /**
+   * Map the file. MAP_SYNC is requested first, which only succeeds on DAX
+   * file systems: page faults then persist the file's metadata, so cache
+   * write backs alone make data durable.
+   * */
+  char* MapFile() {
+    void *ptr;
+    is_sync_ = false;
+#if defined(MAP_SYNC) && defined(MAP_SHARED_VALIDATE)
+    ptr = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE,
+               MAP_SHARED_VALIDATE | MAP_SYNC, fd_, 0);
+    if (ptr != MAP_FAILED) {
+      is_sync_ = true;
+      return reinterpret_cast<char*>(ptr);
+    }
+#endif
+    ptr = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE,
+               MAP_SHARED, fd_, 0);
+    if (ptr == MAP_FAILED) {
+      return nullptr;
+    }
+    return reinterpret_cast<char*>(ptr);
+  }
+
+  /** Whether \a header describes the layout this device would create */
+  bool IsLayout(const MmapBdevHeader &header, size_t capacity,
+                const std::vector<size_t> &slab_sizes, size_t data_off) {
+    if (header.magic_ != MmapBdevHeader::kMagic ||
+        header.version_ != MmapBdevHeader::kVersion ||
+        header.capacity_ != capacity ||
+        header.granule_ != granule_ ||
+        header.data_off_ != data_off ||
+        header.num_slabs_ != slab_sizes.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < slab_sizes.size(); ++i) {
+      if (header.slab_sizes_[i] != slab_sizes[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /** Make [addr, addr + size) of the mapping durable */
+  void Persist(const void *addr, size_t size, MmapDurability durability) {
+    switch (durability) {
+      case MmapDurability::kClwb: {
+        PmemCopy::Flush(addr, size);
+        PmemCopy::Fence();
+        break;
+      }
+      case MmapDurability::kMsync: {
+        uintptr_t start = (uintptr_t)addr & ~(uintptr_t)(page_size_ - 1);
+        msync(reinterpret_cast<void*>(start),
+              (uintptr_t)addr + size - start, MS_SYNC);
+        break;
+      }
+      case MmapDurability::kNone: {
+        break;
+      }
+    }
+  }
+
+ public:
+#include "bdev/bdev_lib_exec.h"
+};
+
+}  // namespace hermes::mmap_bdev
+
+HRUN_TASK_CC(hermes::mmap_bdev::Server, "mmap_bdev");
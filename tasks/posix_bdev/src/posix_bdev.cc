@@ -6,6 +6,7 @@
 #include "hrun/api/hrun_runtime.h"
 #include "posix_bdev/posix_bdev.h"
 #include "hermes/slab_allocator.h"
+#include "hermes/crc32c.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -67,6 +68,7 @@ class Server : public TaskLib, public bdev::Server {
   void Free(FreeTask *task, RunContext &rctx) {
     rem_cap_ += alloc_.Free(task->buffers_);
     score_hist_.Decrement(task->score_);
+    task->rem_cap_ = rem_cap_;
     task->SetModuleComplete();
   }
   void MonitorFree(u32 mode, FreeTask *task, RunContext &rctx) {
@@ -75,6 +77,10 @@ class Server : public TaskLib, public bdev::Server {
   /** Write to bdev */
   void Write(WriteTask *task, RunContext &rctx) {
     HILOG(kDebug, "Writing {} bytes to {}", task->size_, path_);
+    if (task->phase_ == 0) {
+      task->crc_ = hermes::Crc32c::Compute(
+          task->buf_, std::min(task->crc_size_, task->size_));
+    }
 #ifdef HERMES_LIBAIO
     switch (task->phase_) {
       case 0: {
@@ -175,6 +181,8 @@ class Server : public TaskLib, public bdev::Server {
             count, task->size_);
     }
 #endif
+    task->crc_ = hermes::Crc32c::Compute(
+        task->buf_, std::min(task->crc_size_, task->size_));
     task->SetModuleComplete();
   }
   void MonitorRead(u32 mode, ReadTask *task, RunContext &rctx) {
@@ -6,6 +6,7 @@
 #include "hrun/api/hrun_runtime.h"
 #include "ram_bdev/ram_bdev.h"
 #include "hermes/slab_allocator.h"
+#include "hermes/crc32c.h"
 
 namespace hermes::ram_bdev {
 
@@ -53,6 +54,7 @@ class Server : public TaskLib, public bdev::Server {
   void Free(FreeTask *task, RunContext &rctx) {
     rem_cap_ += alloc_.Free(task->buffers_);
     score_hist_.Decrement(task->score_);
+    task->rem_cap_ = rem_cap_;
     task->SetModuleComplete();
   }
   void MonitorFree(u32 mode, FreeTask *task, RunContext &rctx) {
@@ -61,7 +63,10 @@ class Server : public TaskLib, public bdev::Server {
   /** Write to bdev */
   void Write(WriteTask *task, RunContext &rctx) {
     HILOG(kDebug, "Writing {} bytes to RAM", task->size_);
-    memcpy(mem_ptr_ + task->disk_off_, task->buf_, task->size_);
+    char *dst = mem_ptr_ + task->disk_off_;
+    size_t crc_size = std::min(task->crc_size_, task->size_);
+    task->crc_ = hermes::Crc32c::Copy(dst, task->buf_, crc_size);
+    memcpy(dst + crc_size, task->buf_ + crc_size, task->size_ - crc_size);
     task->SetModuleComplete();
   }
   void MonitorWrite(u32 mode, WriteTask *task, RunContext &rctx) {
@@ -70,7 +75,10 @@ class Server : public TaskLib, public bdev::Server {
   /** Read from bdev */
   void Read(ReadTask *task, RunContext &rctx) {
     HILOG(kDebug, "Reading {} bytes from RAM", task->size_);
-    memcpy(task->buf_, mem_ptr_ + task->disk_off_, task->size_);
+    const char *src = mem_ptr_ + task->disk_off_;
+    size_t crc_size = std::min(task->crc_size_, task->size_);
+    task->crc_ = hermes::Crc32c::Copy(task->buf_, src, crc_size);
+    memcpy(task->buf_ + crc_size, src + crc_size, task->size_ - crc_size);
     task->SetModuleComplete();
   }
   void MonitorRead(u32 mode, ReadTask *task, RunContext &rctx) {
@@ -40,3 +40,34 @@ TEST_CASE("TestHermesPaths") {
   }
 }
 
+TEST_CASE("TestHermesPathTrie") {
+  hermes::config::ClientConfig conf;
+  conf.CreateAdapterPathTracking("/tmp", true);
+  conf.CreateAdapterPathTracking("/tmp/excluded", false);
+  conf.CreateAdapterPathTracking("/tmp/data/*.json", false);
+  REQUIRE(conf.IsPathTracked("/tmp") == false);
+  REQUIRE(conf.IsPathTracked("/tmp/hi.txt") == true);
+  REQUIRE(conf.IsPathTracked("/tmp/excluded") == false);
+  REQUIRE(conf.IsPathTracked("/tmp/excluded.txt") == true);
+  REQUIRE(conf.IsPathTracked("/tmp/data/hi.json") == false);
+  REQUIRE(conf.IsPathTracked("/tmp/data/hi.txt") == true);
+  REQUIRE(conf.IsPathTracked("/home/hi.txt") == false);
+}
+
+TEST_CASE("TestServerConfigMmap") {
+  hermes::config::ServerConfig conf;
+  conf.LoadFromFile(HERMES_TEST_CONFIG_DIR "/hermes_server_mmap.yaml");
+  REQUIRE(conf.devices_.size() == 3);
+  for (hermes::config::DeviceInfo &dev : conf.devices_) {
+    if (dev.dev_name_ == "ram") {
+      REQUIRE(dev.io_api_ == hermes::IoInterface::kRam);
+    } else if (dev.dev_name_ == "pmem") {
+      REQUIRE(dev.io_api_ == hermes::IoInterface::kMmap);
+      REQUIRE(dev.durability_ == hermes::MmapDurability::kMsync);
+      REQUIRE(dev.capacity_ == MEGABYTES(32));
+    } else {
+      REQUIRE(dev.io_api_ == hermes::IoInterface::kPosix);
+      REQUIRE(dev.durability_ == hermes::MmapDurability::kNone);
+    }
+  }
+}
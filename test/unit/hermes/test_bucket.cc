@@ -15,8 +15,27 @@
 #include "hrun_admin/hrun_admin.h"
 #include "hermes/hermes.h"
 #include "hermes/bucket.h"
+#include "hermes/erasure_code.h"
+#include "hermes/crc32c.h"
+#include "hermes/dedup_index.h"
+#include "hermes/slab_allocator.h"
+#include "hermes/eviction/evictor_factory.h"
+#include "hermes_data_op/reduce_kernels.h"
 #include "data_stager/factory/binary_stager.h"
+#ifdef HERMES_ENABLE_HDF5_STAGER
+#include "data_stager/factory/hdf5_stager.h"
+#endif
+#ifdef HERMES_ENABLE_PARQUET_STAGER
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/writer.h>
+#include "data_stager/factory/parquet_stager.h"
+#endif
 #include <mpi.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <thread>
 
 TEST_CASE("TestHermesConnect") {
   int rank, nprocs;
@@ -262,6 +281,625 @@ TEST_CASE("TestHermesBlobDestroy") {
   }
 }
 
+TEST_CASE("TestHermesBlobIdCache") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Create a bucket
+  hermes::Context ctx;
+  hermes::Bucket bkt("blob_id_cache" + std::to_string(rank));
+
+  size_t count = 16;
+  for (size_t i = 0; i < count; ++i) {
+    hermes::Blob blob(KILOBYTES(4));
+    memset(blob.data(), i % 256, blob.size());
+    bkt.Put(std::to_string(i), blob, ctx);
+  }
+  // Names resolved by the puts are served from the cache
+  for (size_t i = 0; i < count; ++i) {
+    hermes::Blob blob2;
+    bkt.Get(std::to_string(i), blob2, ctx);
+    REQUIRE(blob2.size() == KILOBYTES(4));
+    REQUIRE(blob2.data()[0] == (char)(i % 256));
+  }
+  hermes::BlobIdCacheStats stats = bkt.GetBlobIdCacheStats();
+  HILOG(kInfo, "Blob id cache hit rate: {}", stats.GetHitRate());
+  if (HASH_TO_NODE_ID(bkt.GetId().hash_) == HRUN_CLIENT->node_id_) {
+    REQUIRE(stats.hits_ >= count);
+  }
+  // Destroyed blobs are not resolved from the cache
+  hermes::BlobId blob_id = bkt.GetBlobId("0");
+  bkt.DestroyBlob(blob_id, ctx);
+  REQUIRE(!bkt.ContainsBlob("0"));
+  bkt.Destroy();
+}
+
+TEST_CASE("TestHermesBlobIdCacheStale") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Every process caches the id of the same blob
+  hermes::Context ctx;
+  hermes::Bucket bkt("blob_id_cache_shared");
+  hermes::Blob blob(KILOBYTES(4));
+  memset(blob.data(), 1, blob.size());
+  if (rank == 0) {
+    bkt.Put("shared", blob, ctx);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  hermes::BlobId stale_id = bkt.GetBlobId("shared");
+  REQUIRE(!stale_id.IsNull());
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // One process destroys it, then every process puts it again by name
+  if (rank == 0) {
+    bkt.DestroyBlob(stale_id, ctx);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  memset(blob.data(), 2, blob.size());
+  bkt.Put("shared", blob, ctx);
+  MPI_Barrier(MPI_COMM_WORLD);
+  hermes::Blob blob2;
+  bkt.Get("shared", blob2, ctx);
+  REQUIRE(blob2.size() == KILOBYTES(4));
+  REQUIRE(blob2.data()[0] == 2);
+  REQUIRE(bkt.GetContainedBlobIds().size() == 1);
+  REQUIRE(bkt.GetBlobId("shared") != stale_id);
+
+  // The stale id does not resurrect the blob
+  bkt.Put(stale_id, blob, ctx);
+  hermes::Blob blob3;
+  bkt.Get(stale_id, blob3, ctx);
+  REQUIRE(blob3.size() == 0);
+  REQUIRE(bkt.GetContainedBlobIds().size() == 1);
+  MPI_Barrier(MPI_COMM_WORLD);
+  if (rank == 0) {
+    bkt.Destroy();
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+TEST_CASE("TestHermesReadCache", "[.][read_cache]") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Run by the test_hermes_read_cache pipeline, which enables the cache
+  // on a single node, so every blob is cached locally
+  hermes::BlobReadCache *cache = HERMES_CONF->blob_mdm_.GetReadCacheRoot();
+  REQUIRE(cache != nullptr);
+  hermes::ReadCacheStats before = cache->GetStats();
+
+  // Create a bucket
+  hermes::Context ctx;
+  hermes::Bucket bkt("read_cache" + std::to_string(rank));
+
+  size_t count = 16;
+  std::vector<hermes::BlobId> blob_ids(count);
+  for (size_t i = 0; i < count; ++i) {
+    hermes::Blob blob(KILOBYTES(4));
+    memset(blob.data(), i % 256, blob.size());
+    blob_ids[i] = bkt.Put(std::to_string(i), blob, ctx);
+  }
+  // The first get fills the cache, the rest may hit
+  for (int rep = 0; rep < 3; ++rep) {
+    for (size_t i = 0; i < count; ++i) {
+      hermes::Blob blob2;
+      bkt.Get(blob_ids[i], blob2, ctx);
+      REQUIRE(blob2.size() == KILOBYTES(4));
+      REQUIRE(blob2.data()[0] == (char)(i % 256));
+    }
+  }
+  // Puts are visible to the next get
+  for (size_t i = 0; i < count; ++i) {
+    hermes::Blob blob(KILOBYTES(2));
+    memset(blob.data(), (i + 1) % 256, blob.size());
+    bkt.Put(blob_ids[i], blob, ctx);
+    hermes::Blob blob2;
+    bkt.Get(blob_ids[i], blob2, ctx);
+    REQUIRE(blob2.size() == KILOBYTES(2));
+    REQUIRE(blob2.data()[0] == (char)((i + 1) % 256));
+  }
+  // Async puts by name are visible to a get by id right after
+  for (size_t i = 0; i < count; ++i) {
+    hermes::Blob blob2;
+    bkt.Get(blob_ids[i], blob2, ctx);
+    hermes::Blob blob(KILOBYTES(3));
+    memset(blob.data(), (i + 2) % 256, blob.size());
+    bkt.AsyncPut(std::to_string(i), blob, ctx);
+    hermes::Blob blob3;
+    bkt.Get(blob_ids[i], blob3, ctx);
+    REQUIRE(blob3.size() == KILOBYTES(3));
+    REQUIRE(blob3.data()[0] == (char)((i + 2) % 256));
+  }
+  hermes::ReadCacheStats after = cache->GetStats();
+  HILOG(kInfo, "Read cache hits: {}, invalidations: {}",
+        after.hits_ - before.hits_,
+        after.invalidations_ - before.invalidations_);
+  REQUIRE(after.hits_ > before.hits_);
+  bkt.Destroy();
+}
+
+TEST_CASE("TestBlobReadCache") {
+  // One set of four ways, so every blob competes for the same ways
+  size_t slot_size = KILOBYTES(1);
+  u32 ways = 4;
+  size_t capacity = slot_size * ways;
+  size_t alloc_size = hermes::BlobReadCache::GetAllocSize(
+      capacity, slot_size, ways);
+  std::vector<u64> mem((alloc_size + sizeof(u64) - 1) / sizeof(u64));
+  auto *cache = reinterpret_cast<hermes::BlobReadCache*>(mem.data());
+  cache->Init(capacity, slot_size, ways);
+  std::vector<hermes::BlobId> ids;
+  for (u64 i = 0; i < 6; ++i) {
+    ids.emplace_back(1, 0, i + 1);
+  }
+  std::vector<char> data(slot_size);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (char)(i * 3 + 1);
+  }
+  std::vector<char> buf(slot_size);
+  size_t size;
+
+  // Hits return the cached range of the cached version
+  REQUIRE(!cache->Read(ids[0], 0, buf.data(), buf.size(), size));
+  cache->Insert(ids[0], 3, data.data(), 512);
+  REQUIRE(cache->Read(ids[0], 0, buf.data(), buf.size(), size));
+  REQUIRE(size == 512);
+  REQUIRE(memcmp(buf.data(), data.data(), size) == 0);
+  REQUIRE(cache->Read(ids[0], 100, buf.data(), 50, size, 3));
+  REQUIRE(size == 50);
+  REQUIRE(memcmp(buf.data(), data.data() + 100, size) == 0);
+  REQUIRE(!cache->Read(ids[0], 0, buf.data(), buf.size(), size, 4));
+  REQUIRE(cache->GetBlobSize(ids[0], size));
+  REQUIRE(size == 512);
+
+  // Blobs larger than a slot are not cached
+  std::vector<char> big(2 * slot_size);
+  cache->Insert(ids[5], 0, big.data(), big.size());
+  REQUIRE(!cache->Read(ids[5], 0, buf.data(), buf.size(), size));
+
+  // Puts in flight to the set neither hit nor fill
+  cache->BeginPut(ids[0]);
+  REQUIRE(!cache->Read(ids[0], 0, buf.data(), buf.size(), size));
+  REQUIRE(!cache->GetBlobSize(ids[0], size));
+  cache->Insert(ids[1], 0, data.data(), 256);
+  cache->EndPut(ids[0]);
+  REQUIRE(cache->Read(ids[0], 0, buf.data(), buf.size(), size));
+  REQUIRE(!cache->Read(ids[1], 0, buf.data(), buf.size(), size));
+
+  // Invalidated blobs miss
+  cache->Invalidate(ids[0]);
+  REQUIRE(!cache->Read(ids[0], 0, buf.data(), buf.size(), size));
+
+  // A full set replaces one blob with CLOCK
+  for (size_t i = 1; i < 5; ++i) {
+    cache->Insert(ids[i], 0, data.data(), 128 * i);
+  }
+  size_t hits = 0;
+  for (size_t i = 1; i < 5; ++i) {
+    if (cache->Read(ids[i], 0, buf.data(), buf.size(), size)) {
+      REQUIRE(size == 128 * i);
+      ++hits;
+    }
+  }
+  REQUIRE(hits == ways);
+  hermes::ReadCacheStats stats = cache->GetStats();
+  REQUIRE(stats.inserts_ == 5);
+  REQUIRE(stats.evictions_ == 0);
+  cache->Insert(ids[0], 0, data.data(), 64);
+  REQUIRE(cache->Read(ids[0], 0, buf.data(), buf.size(), size));
+  hits = 0;
+  for (size_t i = 1; i < 5; ++i) {
+    hits += cache->Read(ids[i], 0, buf.data(), buf.size(), size);
+  }
+  REQUIRE(hits == ways - 1);
+  stats = cache->GetStats();
+  REQUIRE(stats.inserts_ == 6);
+  REQUIRE(stats.evictions_ == 1);
+  REQUIRE(stats.invalidations_ == 1);
+  REQUIRE(stats.hits_ > 0);
+  REQUIRE(stats.misses_ > 0);
+}
+
+TEST_CASE("TestErasureCode") {
+  // Any k of the k + m fragments recover the data
+  size_t k = 4, m = 2;
+  hermes::ReedSolomon rs(k, m);
+  size_t size = KILOBYTES(64) + 3;
+  size_t frag_size = rs.GetFragmentSize(size);
+  std::vector<std::vector<char>> frags(k + m, std::vector<char>(frag_size, 0));
+  for (size_t i = 0; i < size; ++i) {
+    frags[i / frag_size][i % frag_size] = (char)(i * 7 + 1);
+  }
+  std::vector<const char*> data(k);
+  std::vector<char*> parity(m);
+  for (size_t j = 0; j < k; ++j) {
+    data[j] = frags[j].data();
+  }
+  for (size_t j = 0; j < m; ++j) {
+    parity[j] = frags[k + j].data();
+  }
+  rs.Encode(data, parity, frag_size);
+  for (size_t lost1 = 0; lost1 < k + m; ++lost1) {
+    for (size_t lost2 = lost1 + 1; lost2 < k + m; ++lost2) {
+      std::vector<const char*> avail(k + m);
+      for (size_t i = 0; i < k + m; ++i) {
+        avail[i] = (i == lost1 || i == lost2) ? nullptr : frags[i].data();
+      }
+      std::vector<std::vector<char>> bufs(k, std::vector<char>(frag_size));
+      std::vector<char*> out(k);
+      for (size_t j = 0; j < k; ++j) {
+        out[j] = bufs[j].data();
+      }
+      REQUIRE(rs.Decode(avail, out, frag_size));
+      for (size_t j = 0; j < k; ++j) {
+        const char *frag = avail[j] ? avail[j] : out[j];
+        REQUIRE(memcmp(frag, frags[j].data(), frag_size) == 0);
+      }
+    }
+  }
+  // Losing more than m fragments is unrecoverable
+  std::vector<const char*> avail(k + m, nullptr);
+  avail[0] = frags[0].data();
+  std::vector<char*> out(k, nullptr);
+  REQUIRE(!rs.Decode(avail, out, frag_size));
+}
+
+TEST_CASE("TestEvictionPolicies") {
+  auto make_blob = [](u64 id, hermes::EvictionPolicy policy) {
+    hermes::BlobInfo blob_info;
+    blob_info.blob_id_ = hermes::BlobId(1, 0, id);
+    blob_info.name_ = hshm::charbuf(std::to_string(id));
+    blob_info.evict_policy_ = policy;
+    blob_info.evict_ttl_ = 0;
+    return blob_info;
+  };
+  std::vector<hermes::BlobId> victims;
+
+  // LRU evicts the blob accessed longest ago
+  hermes::EvictionIndex lru;
+  for (u64 i = 1; i <= 4; ++i) {
+    lru.Touch(make_blob(i, hermes::EvictionPolicy::kLru), true);
+  }
+  lru.Touch(make_blob(1, hermes::EvictionPolicy::kLru), false);
+  lru.GetVictims(4, victims);
+  REQUIRE(victims.size() == 4);
+  REQUIRE(victims[0].unique_ == 2);
+  REQUIRE(victims[3].unique_ == 1);
+
+  // LFU evicts the blob accessed least often
+  hermes::EvictionIndex lfu;
+  for (u64 i = 1; i <= 3; ++i) {
+    lfu.Touch(make_blob(i, hermes::EvictionPolicy::kLfu), true);
+  }
+  lfu.Touch(make_blob(1, hermes::EvictionPolicy::kLfu), false);
+  lfu.Touch(make_blob(1, hermes::EvictionPolicy::kLfu), false);
+  lfu.Touch(make_blob(2, hermes::EvictionPolicy::kLfu), false);
+  victims.clear();
+  lfu.GetVictims(3, victims);
+  REQUIRE(victims[0].unique_ == 3);
+  REQUIRE(victims[2].unique_ == 1);
+
+  // ARC evicts blobs seen once before blobs seen again
+  hermes::EvictionIndex arc;
+  for (u64 i = 1; i <= 4; ++i) {
+    arc.Touch(make_blob(i, hermes::EvictionPolicy::kArc), true);
+  }
+  arc.Touch(make_blob(1, hermes::EvictionPolicy::kArc), false);
+  victims.clear();
+  arc.GetVictims(4, victims);
+  REQUIRE(victims[0].unique_ == 2);
+  REQUIRE(victims[3].unique_ == 1);
+  arc.Evict(victims[0]);
+  REQUIRE(arc.size() == 3);
+  // The evicted blob comes back under a new id and hits its ghost
+  hermes::BlobInfo recreated = make_blob(5, hermes::EvictionPolicy::kArc);
+  recreated.name_ = hshm::charbuf("2");
+  arc.Touch(recreated, true);
+  REQUIRE(arc.size() == 4);
+  victims.clear();
+  arc.GetVictims(4, victims);
+  REQUIRE(victims[0].unique_ == 3);
+  REQUIRE(victims[2].unique_ == 5);
+
+  // TTL drops blobs once they expire
+  hermes::EvictionIndex ttl;
+  hermes::BlobInfo scratch = make_blob(1, hermes::EvictionPolicy::kTtl);
+  scratch.evict_ttl_ = .01;
+  ttl.Touch(scratch, true);
+  ttl.Touch(make_blob(2, hermes::EvictionPolicy::kTtl), true);
+  usleep(20000);
+  victims.clear();
+  ttl.GetExpired(victims);
+  REQUIRE(victims.size() == 1);
+  REQUIRE(victims[0].unique_ == 1);
+  // A retained blob no longer expires, but is evicted last
+  ttl.Retain(victims[0]);
+  victims.clear();
+  ttl.GetExpired(victims);
+  REQUIRE(victims.empty());
+  ttl.GetVictims(2, victims);
+  REQUIRE(victims[1].unique_ == 1);
+}
+
+TEST_CASE("TestCrc32c") {
+  const char *check = "123456789";
+  REQUIRE(hermes::Crc32c::Compute(check, 9) == 0xe3069283);
+  REQUIRE(hermes::Crc32c::Compute(check, 0) == 0);
+
+  // Sizes and alignments around the block sizes of the hardware path
+  std::vector<char> src(70000), dst(src.size() + 8);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = (char)(i * 131 + (i >> 8));
+  }
+  const hermes::Crc32c &crc32c = hermes::Crc32c::Get();
+  for (size_t size : {1, 7, 8, 255, 769, 3 * 8192, 3 * 8192 + 5, 69990}) {
+    for (size_t off : {0, 3}) {
+      const char *data = src.data() + off;
+      u32 crc = hermes::Crc32c::Compute(data, size);
+      REQUIRE(crc == crc32c.RunSw<false>(nullptr, data, size, 0));
+      REQUIRE(hermes::Crc32c::Copy(dst.data() + off, data, size) == crc);
+      REQUIRE(memcmp(dst.data() + off, data, size) == 0);
+      // A checksum can be extended, or combined from its parts
+      size_t half = size / 2;
+      u32 crc_a = hermes::Crc32c::Compute(data, half);
+      u32 crc_b = hermes::Crc32c::Compute(data + half, size - half);
+      REQUIRE(hermes::Crc32c::Compute(data + half, size - half, crc_a) == crc);
+      REQUIRE(hermes::Crc32c::Combine(crc_a, crc_b, size - half) == crc);
+    }
+  }
+}
+
+TEST_CASE("TestXxh64") {
+  // The sanity checks of the reference implementation (xxhsum)
+  const u64 prime32 = 2654435761U;
+  std::vector<char> buf(222);
+  u64 gen = prime32;
+  for (char &c : buf) {
+    c = (char)(gen >> 56);
+    gen *= 11400714785074694797ULL;
+  }
+  REQUIRE(hermes::Xxh64::Hash(buf.data(), 0, 0) == 0xEF46DB3751D8E999ULL);
+  REQUIRE(hermes::Xxh64::Hash(buf.data(), 0, prime32) ==
+      0xAC75FDA2929B17EFULL);
+  REQUIRE(hermes::Xxh64::Hash(buf.data(), 1, 0) == 0xE934A84ADB052768ULL);
+  REQUIRE(hermes::Xxh64::Hash(buf.data(), 1, prime32) ==
+      0x5014607643A9B4C3ULL);
+  REQUIRE(hermes::Xxh64::Hash(buf.data(), 14, 0) == 0x8282DCC4994E35C8ULL);
+  REQUIRE(hermes::Xxh64::Hash(buf.data(), 14, prime32) ==
+      0xC3BD6BF63DEB6DF0ULL);
+  REQUIRE(hermes::Xxh64::Hash(buf.data(), 222, 0) == 0xB641AE8CB691C174ULL);
+  REQUIRE(hermes::Xxh64::Hash(buf.data(), 222, prime32) ==
+      0x20CB8AB7AE10C14AULL);
+}
+
+/** Compare the kernels of every instruction set of this CPU to scalar */
+template<typename T>
+static void CompareReduceKernels() {
+  using hermes::data_op::SimdLevel;
+  const hermes::data_op::ReduceKernels<T> &scalar =
+      hermes::data_op::GetReduceKernels<T>(SimdLevel::kScalar);
+  // Quarters keep floating-point sums exact in any order
+  std::vector<T> data(4099);
+  for (size_t i = 0; i < data.size(); ++i) {
+    double val = (double)((i * 7919) % 1000);
+    if (std::is_floating_point_v<T>) {
+      val = val / 4 - 100;
+    } else if (std::is_signed_v<T>) {
+      val -= 500;
+    }
+    data[i] = (T)val;
+  }
+  for (int level = (int)SimdLevel::kAvx2;
+       level <= (int)hermes::data_op::GetSimdLevel(); ++level) {
+    const hermes::data_op::ReduceKernels<T> &simd =
+        hermes::data_op::GetReduceKernels<T>((SimdLevel)level);
+    // Sizes below, at and around the unrolled vector width
+    for (size_t count : {0, 1, 3, 8, 17, 64, 65, 127, 1000, 4099}) {
+      const T *ptr = data.data();
+      REQUIRE(simd.min_(ptr, count) == scalar.min_(ptr, count));
+      REQUIRE(simd.max_(ptr, count) == scalar.max_(ptr, count));
+      double sum = scalar.sum_(ptr, count);
+      REQUIRE(simd.sum_(ptr, count) == sum);
+      double mean = count ? sum / count : 0;
+      REQUIRE(simd.sum_sq_diff_(ptr, count, mean) ==
+          Catch::Approx(scalar.sum_sq_diff_(ptr, count, mean)));
+      std::vector<uint64_t> simd_bins(16, 0), scalar_bins(16, 0);
+      simd.histogram_(ptr, count, 0, 200, simd_bins.data(), 16);
+      scalar.histogram_(ptr, count, 0, 200, scalar_bins.data(), 16);
+      REQUIRE(simd_bins == scalar_bins);
+    }
+  }
+}
+
+TEST_CASE("TestReduceKernels") {
+  CompareReduceKernels<float>();
+  CompareReduceKernels<double>();
+  CompareReduceKernels<int32_t>();
+  CompareReduceKernels<uint32_t>();
+  CompareReduceKernels<int64_t>();
+  CompareReduceKernels<uint64_t>();
+}
+
+TEST_CASE("TestSlabAllocatorRecover") {
+  std::vector<size_t> slab_sizes = {KILOBYTES(4), KILOBYTES(16)};
+  size_t dev_size = KILOBYTES(64);
+  std::vector<u8> slab_map(dev_size / KILOBYTES(4), 0);
+
+  // Carve a few buffers, recording their slabs in the map
+  hermes::SlabAllocator alloc;
+  alloc.Init(hermes::TargetId(), dev_size, slab_sizes);
+  alloc.SetSlabMap(slab_map.data(), KILOBYTES(4));
+  std::vector<hermes::BufferInfo> buffers;
+  size_t alloc_size;
+  alloc.Allocate(KILOBYTES(20), buffers, alloc_size);
+  alloc.Allocate(KILOBYTES(4), buffers, alloc_size);
+  REQUIRE(buffers.size() == 3);
+  size_t heap = alloc.heap_.load();
+  REQUIRE(heap == KILOBYTES(24));
+
+  // A restarted allocator gets the same slabs back, all free
+  hermes::SlabAllocator recovered;
+  recovered.Init(hermes::TargetId(), dev_size, slab_sizes);
+  recovered.SetSlabMap(slab_map.data(), KILOBYTES(4));
+  REQUIRE(recovered.Recover() == heap);
+  REQUIRE(recovered.heap_.load() == heap);
+  std::vector<hermes::BufferInfo> again;
+  recovered.Allocate(KILOBYTES(20), again, alloc_size);
+  REQUIRE(alloc_size == KILOBYTES(20));
+  recovered.Allocate(KILOBYTES(4), again, alloc_size);
+  REQUIRE(alloc_size == KILOBYTES(4));
+  REQUIRE(again.size() == 3);
+  REQUIRE(recovered.heap_.load() == heap);
+  for (auto &buf : again) {
+    REQUIRE(buf.t_off_ < heap);
+    REQUIRE(buf.t_size_ == slab_sizes[buf.t_slab_]);
+  }
+
+  // Entries past an unrecorded slab are dropped
+  slab_map[heap / KILOBYTES(4) + 2] = 1;
+  hermes::SlabAllocator partial;
+  partial.Init(hermes::TargetId(), dev_size, slab_sizes);
+  partial.SetSlabMap(slab_map.data(), KILOBYTES(4));
+  REQUIRE(partial.Recover() == heap);
+  REQUIRE(slab_map[heap / KILOBYTES(4) + 2] == 0);
+}
+
+TEST_CASE("TestHermesErasureCodedBucket") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Create a 2 + 1 bucket
+  hermes::Context ctx;
+  ctx.ec_data_ = 2;
+  ctx.ec_parity_ = 1;
+  hermes::Bucket bkt = HERMES->GetBucket("ec" + std::to_string(rank), ctx);
+  size_t count = 16;
+  size_t total_size = 0;
+  for (size_t i = 0; i < count; ++i) {
+    hermes::Blob blob(KILOBYTES(16) + i);
+    memset(blob.data(), i % 256, blob.size());
+    hermes::BlobId blob_id = bkt.Put(std::to_string(i), blob, ctx);
+    REQUIRE(!blob_id.IsNull());
+    REQUIRE(bkt.GetBlobName(blob_id) == std::to_string(i));
+    total_size += blob.size();
+  }
+  // Sizes and blob lists count blobs, not fragments
+  REQUIRE(bkt.GetSize() == total_size);
+  REQUIRE(bkt.GetContainedBlobIds().size() == count);
+  for (size_t i = 0; i < count; ++i) {
+    hermes::Blob blob2;
+    bkt.Get(std::to_string(i), blob2, ctx);
+    REQUIRE(blob2.size() == KILOBYTES(16) + i);
+    REQUIRE(blob2.data()[0] == (char)(i % 256));
+    REQUIRE(blob2.data()[blob2.size() - 1] == (char)(i % 256));
+    REQUIRE(bkt.GetBlobSize(std::to_string(i)) == KILOBYTES(16) + i);
+  }
+
+  // Partial puts re-encode the blob
+  hermes::Blob patch(KILOBYTES(1));
+  memset(patch.data(), 0xff, patch.size());
+  bkt.PartialPut("0", patch, KILOBYTES(15), ctx);
+  hermes::Blob blob0;
+  bkt.PartialGet("0", blob0, KILOBYTES(15), ctx);
+  REQUIRE(blob0.size() == KILOBYTES(1));
+  REQUIRE(blob0.data()[0] == (char)0xff);
+
+  // Concurrent partial puts to other ranges of a blob are not lost
+  hermes::Blob shared(KILOBYTES(16));
+  memset(shared.data(), 0x11, shared.size());
+  bkt.Put("shared", shared, ctx);
+  size_t nthreads = 4;
+  std::vector<std::thread> writers;
+  for (size_t t = 0; t < nthreads; ++t) {
+    writers.emplace_back([&bkt, t]() {
+      hermes::Context thread_ctx;
+      hermes::Blob range(KILOBYTES(1));
+      memset(range.data(), (int)(0xa0 + t), range.size());
+      bkt.PartialPut("shared", range, t * KILOBYTES(2), thread_ctx);
+    });
+  }
+  for (std::thread &writer : writers) {
+    writer.join();
+  }
+  hermes::Blob shared2;
+  bkt.Get("shared", shared2, ctx);
+  REQUIRE(shared2.size() == KILOBYTES(16));
+  for (size_t t = 0; t < nthreads; ++t) {
+    REQUIRE(shared2.data()[t * KILOBYTES(2)] == (char)(0xa0 + t));
+    REQUIRE(shared2.data()[t * KILOBYTES(2) + KILOBYTES(1)] == (char)0x11);
+  }
+
+  // Lose one fragment of each blob, as if its node failed
+  for (size_t i = 0; i < count; ++i) {
+    std::string frag_name = bkt.GetFragmentName(std::to_string(i), i % 3);
+    hermes::BlobId frag_id = HERMES_CONF->blob_mdm_.GetBlobIdRoot(
+        bkt.GetId(), hshm::to_charbuf(frag_name));
+    REQUIRE(!frag_id.IsNull());
+    HERMES_CONF->blob_mdm_.DestroyBlobRoot(bkt.GetId(), frag_id);
+  }
+  // Degraded reads rebuild the data from parity
+  for (size_t i = 1; i < count; ++i) {
+    hermes::Blob blob2;
+    bkt.Get(std::to_string(i), blob2, ctx);
+    REQUIRE(blob2.size() == KILOBYTES(16) + i);
+    for (size_t j = 0; j < blob2.size(); j += KILOBYTES(1)) {
+      REQUIRE(blob2.data()[j] == (char)(i % 256));
+    }
+  }
+
+  // Opening the bucket without a code uses the code it was created with
+  hermes::Context plain_ctx;
+  hermes::Bucket plain = HERMES->GetBucket("ec" + std::to_string(rank),
+                                           plain_ctx);
+  REQUIRE(plain.GetContext().ec_data_ == 2);
+  REQUIRE(plain.GetContext().ec_parity_ == 1);
+  REQUIRE(plain.GetBlobSize("1") == KILOBYTES(16) + 1);
+
+  // Blob ids address the erasure-coded blob
+  REQUIRE(plain.ContainsBlob("1"));
+  REQUIRE(!plain.ContainsBlob("missing"));
+  hermes::BlobId blob_id = plain.GetBlobId("1");
+  REQUIRE(!blob_id.IsNull());
+  REQUIRE(plain.GetBlobName(blob_id) == "1");
+  REQUIRE(plain.GetBlobSize(blob_id) == KILOBYTES(16) + 1);
+  hermes::Blob by_id;
+  plain.Get(blob_id, by_id, plain_ctx);
+  REQUIRE(by_id.size() == KILOBYTES(16) + 1);
+  REQUIRE(by_id.data()[0] == (char)1);
+  plain.RenameBlob(blob_id, "renamed", plain_ctx);
+  REQUIRE(!plain.ContainsBlob("1"));
+  REQUIRE(plain.GetBlobSize("renamed") == KILOBYTES(16) + 1);
+  plain.DestroyBlob(plain.GetBlobId("renamed"), plain_ctx);
+  REQUIRE(!plain.ContainsBlob("renamed"));
+  for (size_t i = 0; i < 3; ++i) {
+    hermes::BlobId frag_id = HERMES_CONF->blob_mdm_.GetBlobIdRoot(
+        plain.GetId(), hshm::to_charbuf(plain.GetFragmentName("renamed", i)));
+    REQUIRE(frag_id.IsNull());
+  }
+  bkt.Destroy();
+}
+
 TEST_CASE("TestHermesBucketDestroy") {
   // TODO(llogan): need to inform bucket when a blob has been placed in it
   int rank, nprocs;
@@ -295,6 +933,46 @@ TEST_CASE("TestHermesBucketDestroy") {
   }
 }
 
+TEST_CASE("TestHermesBucketDestroyShm") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Only buckets owned by this node publish a TagShm slot
+  std::string name = "destroy_shm_test" + std::to_string(rank);
+  hermes::Bucket bkt = HERMES->GetBucket(name);
+  bkt.GetSize();
+  hermes::TagShm *shm = bkt.size_cache_->shm_;
+  if (HASH_TO_NODE_ID(bkt.GetId().hash_) != HRUN_CLIENT->node_id_) {
+    REQUIRE(shm == nullptr);
+    MPI_Barrier(MPI_COMM_WORLD);
+    return;
+  }
+
+  // Each size cache holds a reference besides the bucket_mdm's
+  REQUIRE(shm != nullptr);
+  REQUIRE(shm->ref_count_ == 2);
+  {
+    hermes::Bucket other = HERMES->GetBucket(name);
+    other.GetSize();
+    REQUIRE(other.size_cache_->shm_ == shm);
+    REQUIRE(shm->ref_count_ == 3);
+  }
+  REQUIRE(shm->ref_count_ == 2);
+
+  // Destroying the tag drops the bucket_mdm's reference. The slot stays
+  // readable until the last cache releases it.
+  bkt.Destroy();
+  REQUIRE(!shm->valid_);
+  REQUIRE(shm->ref_count_ == 1);
+  REQUIRE(bkt.GetSize() == 0);
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
 TEST_CASE("TestHermesReorganizeBlob") {
   int rank, nprocs;
   MPI_Barrier(MPI_COMM_WORLD);
@@ -524,6 +1202,248 @@ TEST_CASE("TestHermesDataStager") {
   HILOG(kInfo, "Flushing finished")
 }
 
+/** The number of fds of any visible process which refer to \a path */
+static size_t CountOpenFds(const std::string &path) {
+  char real_path[PATH_MAX];
+  if (realpath(path.c_str(), real_path) == nullptr) {
+    return 0;
+  }
+  size_t count = 0;
+  DIR *procs = opendir("/proc");
+  if (procs == nullptr) {
+    return 0;
+  }
+  while (struct dirent *proc = readdir(procs)) {
+    std::string fd_dir = std::string("/proc/") + proc->d_name + "/fd";
+    DIR *fds = opendir(fd_dir.c_str());
+    if (fds == nullptr) {
+      continue;
+    }
+    while (struct dirent *fd = readdir(fds)) {
+      char link[PATH_MAX];
+      std::string fd_path = fd_dir + "/" + fd->d_name;
+      ssize_t len = readlink(fd_path.c_str(), link, sizeof(link) - 1);
+      if (len > 0) {
+        link[len] = 0;
+        count += strcmp(link, real_path) == 0;
+      }
+    }
+    closedir(fds);
+  }
+  closedir(procs);
+  return count;
+}
+
+TEST_CASE("TestHermesDataStagerUnregister") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // create dataset
+  std::string home_dir = getenv("HOME");
+  std::string path = home_dir + "/test_unregister" +
+      std::to_string(rank) + ".txt";
+  size_t page_size = KILOBYTES(4);
+  std::vector<char> data(page_size * 4, 0);
+  FILE *file = fopen(path.c_str(), "w");
+  fwrite(data.data(), sizeof(char), data.size(), file);
+  fclose(file);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Staging in a page leaves the backend file open in the runtime
+  using hermes::data_stager::BinaryFileStager;
+  hermes::Context ctx = BinaryFileStager::BuildContext(page_size);
+  hermes::Bucket bkt(path, ctx, data.size());
+  hshm::charbuf blob_name = hermes::adapter::BlobPlacement::CreateBlobName(0);
+  hermes::Blob blob;
+  bkt.Get(blob_name.str(), blob, ctx);
+  REQUIRE(blob.size() == page_size);
+  REQUIRE(CountOpenFds(path) > 0);
+
+  // Destroying the bucket unregisters its stager, which closes the file
+  bkt.Destroy();
+  for (int i = 0; i < 100 && CountOpenFds(path) > 0; ++i) {
+    usleep(10000);
+  }
+  REQUIRE(CountOpenFds(path) == 0);
+  remove(path.c_str());
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+#ifdef HERMES_ENABLE_HDF5_STAGER
+TEST_CASE("TestHermesHdf5Stager") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Create a chunked dataset where each rank owns a band of chunks
+  std::string home_dir = getenv("HOME");
+  std::string path = home_dir + "/test.h5";
+  hsize_t chunk_dims[2] = {16, 16};
+  hsize_t dims[2] = {(hsize_t)nprocs * 64, 64};
+  std::vector<int> data(dims[0] * dims[1]);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = (int)i;
+  }
+  hid_t fapl = H5Pcreate(H5P_FILE_ACCESS);
+  H5Pset_file_locking(fapl, false, true);
+  if (rank == 0) {
+    hid_t file = H5Fcreate(path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl);
+    hid_t space = H5Screate_simple(2, dims, nullptr);
+    hid_t dcpl = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_chunk(dcpl, 2, chunk_dims);
+    hid_t dset = H5Dcreate2(file, "/dset", H5T_NATIVE_INT, space,
+                            H5P_DEFAULT, dcpl, H5P_DEFAULT);
+    H5Dwrite(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+             data.data());
+    H5Dclose(dset);
+    H5Pclose(dcpl);
+    H5Sclose(space);
+    H5Fclose(file);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Create a stageable bucket
+  using hermes::data_stager::Hdf5Stager;
+  hermes::Context ctx = Hdf5Stager::BuildContext(KILOBYTES(4));
+  hermes::Bucket bkt(path, ctx);
+
+  // Read each chunk of this rank and negate it
+  size_t chunk_size = chunk_dims[0] * chunk_dims[1] * sizeof(int);
+  for (hsize_t i = rank * 4; i < (hsize_t)(rank + 1) * 4; ++i) {
+    for (hsize_t j = 0; j < 4; ++j) {
+      HILOG(kInfo, "Chunk: ({}, {})", i, j);
+      hshm::charbuf blob_name = Hdf5Stager::CreateBlobName("/dset", {i, j});
+      hermes::Blob blob;
+      bkt.Get(blob_name.str(), blob, ctx);
+      REQUIRE(blob.size() == chunk_size);
+      int *vals = (int*)blob.data();
+      for (hsize_t r = 0; r < chunk_dims[0]; ++r) {
+        for (hsize_t c = 0; c < chunk_dims[1]; ++c) {
+          hsize_t row = i * chunk_dims[0] + r;
+          hsize_t col = j * chunk_dims[1] + c;
+          REQUIRE(vals[r * chunk_dims[1] + c] == (int)(row * dims[1] + col));
+          vals[r * chunk_dims[1] + c] *= -1;
+        }
+      }
+      bkt.Put(blob_name.str(), blob, ctx);
+    }
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // Verify the chunks were staged out
+  HRUN_ADMIN->FlushRoot(DomainId::GetGlobal());
+  HILOG(kInfo, "Flushing finished")
+  if (rank == 0) {
+    std::vector<int> staged(data.size());
+    hid_t file = H5Fopen(path.c_str(), H5F_ACC_RDONLY, fapl);
+    hid_t dset = H5Dopen2(file, "/dset", H5P_DEFAULT);
+    H5Dread(dset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT,
+            staged.data());
+    H5Dclose(dset);
+    H5Fclose(file);
+    for (size_t i = 0; i < staged.size(); ++i) {
+      REQUIRE(staged[i] == -data[i]);
+    }
+  }
+  H5Pclose(fapl);
+}
+#endif
+
+#ifdef HERMES_ENABLE_PARQUET_STAGER
+TEST_CASE("TestHermesParquetStager") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Create a parquet file where each rank owns a few row groups
+  std::string home_dir = getenv("HOME");
+  std::string path = home_dir + "/test.parquet";
+  int64_t rows_per_group = 1024;
+  int groups_per_proc = 4;
+  int64_t nrows = rows_per_group * groups_per_proc * nprocs;
+  if (rank == 0) {
+    arrow::Int64Builder id_builder;
+    arrow::DoubleBuilder val_builder;
+    for (int64_t i = 0; i < nrows; ++i) {
+      REQUIRE(id_builder.Append(i).ok());
+      REQUIRE(val_builder.Append(i * .5).ok());
+    }
+    std::shared_ptr<arrow::Array> ids, vals;
+    REQUIRE(id_builder.Finish(&ids).ok());
+    REQUIRE(val_builder.Finish(&vals).ok());
+    std::shared_ptr<arrow::Table> table = arrow::Table::Make(
+        arrow::schema({arrow::field("id", arrow::int64()),
+                       arrow::field("val", arrow::float64())}),
+        {ids, vals});
+    std::shared_ptr<arrow::io::FileOutputStream> out =
+        arrow::io::FileOutputStream::Open(path).ValueOrDie();
+    REQUIRE(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(),
+                                       out, rows_per_group).ok());
+    REQUIRE(out->Close().ok());
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  std::shared_ptr<parquet::FileMetaData> meta =
+      parquet::ParquetFileReader::OpenFile(path)->metadata();
+  REQUIRE(meta->num_row_groups() == groups_per_proc * nprocs);
+  std::vector<char> file_data;
+  {
+    FILE *file = fopen(path.c_str(), "r");
+    fseek(file, 0, SEEK_END);
+    file_data.resize(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    REQUIRE(fread(file_data.data(), 1, file_data.size(), file) ==
+            file_data.size());
+    fclose(file);
+  }
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Create a stageable bucket
+  using hermes::data_stager::ParquetStager;
+  hermes::Context ctx = ParquetStager::BuildContext();
+  hermes::Bucket bkt(path, ctx);
+
+  // The footer is staged as a blob
+  hermes::Blob footer;
+  bkt.Get(ParquetStager::CreateFooterBlobName().str(), footer, ctx);
+  REQUIRE(footer.size() == meta->size() + 8);
+  REQUIRE(memcmp(footer.data() + footer.size() - 4, "PAR1", 4) == 0);
+
+  // Only stage the second column of each row group of this rank
+  for (int rg = rank * groups_per_proc;
+       rg < (rank + 1) * groups_per_proc; ++rg) {
+    HILOG(kInfo, "Row group: {}", rg);
+    std::unique_ptr<parquet::ColumnChunkMetaData> col_meta =
+        meta->RowGroup(rg)->ColumnChunk(1);
+    size_t off = col_meta->data_page_offset();
+    if (col_meta->has_dictionary_page()) {
+      off = std::min<size_t>(off, col_meta->dictionary_page_offset());
+    }
+    hshm::charbuf blob_name = ParquetStager::CreateBlobName(rg, 1);
+    hermes::Blob blob;
+    bkt.Get(blob_name.str(), blob, ctx);
+    REQUIRE(blob.size() == (size_t)col_meta->total_compressed_size());
+    REQUIRE(memcmp(blob.data(), file_data.data() + off, blob.size()) == 0);
+  }
+  for (int rg = rank * groups_per_proc;
+       rg < (rank + 1) * groups_per_proc; ++rg) {
+    REQUIRE(bkt.ContainsBlob(ParquetStager::CreateBlobName(rg, 1).str()));
+    REQUIRE(!bkt.ContainsBlob(ParquetStager::CreateBlobName(rg, 0).str()));
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+#endif
+
 TEST_CASE("TestHermesDataOp") {
   int rank, nprocs;
   MPI_Barrier(MPI_COMM_WORLD);
@@ -585,6 +1505,13 @@ TEST_CASE("TestHermesDataOp") {
   REQUIRE(min == 5);
 
   HILOG(kInfo, "MINIMUM VALUE QUERY FROM EMPRESS: {}", min);
+
+  // Verify every stage drained its input
+  std::vector<hermes::data_op::OpStats> stats = HERMES->PollOpStats();
+  REQUIRE(stats.size() > 0);
+  for (hermes::data_op::OpStats &op_stats : stats) {
+    REQUIRE(op_stats.backlog_ == 0);
+  }
 }
 
 TEST_CASE("TestHermesCollectMetadata") {
@@ -618,6 +1545,426 @@ TEST_CASE("TestHermesCollectMetadata") {
   MPI_Barrier(MPI_COMM_WORLD);
 }
 
+TEST_CASE("TestHermesQos", "[.][qos]") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Run by the test_hermes_qos pipeline, which enables QoS
+  REQUIRE(HERMES_SERVER_CONF.qos_.enabled_);
+
+  // Charge the I/O of a bucket to a named tenant
+  hermes::Context ctx;
+  ctx.qos_tenant_ = "qos_tenant" + std::to_string(rank);
+  hermes::Bucket bkt("qos_test" + std::to_string(rank));
+  u32 num_blobs = 256;
+  for (u32 i = 0; i < num_blobs; ++i) {
+    hermes::Blob blob(KILOBYTES(4));
+    memset(blob.data(), i % 256, blob.size());
+    bkt.Put(std::to_string(i), blob, ctx);
+  }
+  for (u32 i = 0; i < num_blobs; ++i) {
+    hermes::Blob blob;
+    bkt.Get(std::to_string(i), blob, ctx);
+    REQUIRE(blob.size() == KILOBYTES(4));
+    REQUIRE(blob.data()[0] == (char)(i % 256));
+  }
+
+  // A get must not overtake an earlier put of the same blob which
+  // QoS is holding back
+  for (u32 i = 0; i < num_blobs; ++i) {
+    std::string blob_name = "async" + std::to_string(i);
+    hermes::Blob blob(KILOBYTES(8));
+    memset(blob.data(), (i + 1) % 256, blob.size());
+    bkt.AsyncPut(blob_name, blob, ctx);
+    hermes::Blob read_blob;
+    bkt.Get(blob_name, read_blob, ctx);
+    REQUIRE(read_blob.size() == KILOBYTES(8));
+    REQUIRE(read_blob.data()[0] == (char)((i + 1) % 256));
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // Gets may be served by the read cache, but every put is scheduled
+  u32 tenant = hrun::HashQosTenant(hshm::charbuf(ctx.qos_tenant_));
+  size_t tasks = 0;
+  std::vector<hermes::QosTenantStats> stats = HERMES->PollQosStats();
+  for (hermes::QosTenantStats &tenant_stats : stats) {
+    if (tenant_stats.tenant_ == tenant) {
+      tasks += tenant_stats.tasks_;
+    }
+  }
+  REQUIRE(tasks >= 2 * num_blobs);
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/** The server config of the device behind \a tgt_stats */
+static hermes::DeviceInfo* FindDevice(const hermes::TargetStats &tgt_stats) {
+  for (hermes::DeviceInfo &dev : HERMES_SERVER_CONF.devices_) {
+    if (dev.capacity_ == tgt_stats.max_cap_ &&
+        dev.bandwidth_ == (float)tgt_stats.bandwidth_) {
+      return &dev;
+    }
+  }
+  return nullptr;
+}
+
+TEST_CASE("TestHermesEvictionTtl") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Scratch blobs of the bucket expire a moment after their put
+  hermes::Context ctx;
+  ctx.evict_policy_ = hermes::EvictionPolicy::kTtl;
+  ctx.evict_ttl_ = .25;
+  hermes::Bucket bkt = HERMES->GetBucket(
+      "evict_ttl_test" + std::to_string(rank), ctx);
+  u32 num_blobs = 16;
+  for (u32 i = 0; i < num_blobs; ++i) {
+    hermes::Blob blob(KILOBYTES(4));
+    memset(blob.data(), i % 256, blob.size());
+    hermes::Context put_ctx;
+    bkt.Put(std::to_string(i), blob, put_ctx);
+  }
+  REQUIRE(bkt.ContainsBlob("0"));
+
+  // Expired blobs are dropped even though the targets have space
+  sleep(2);
+  for (u32 i = 0; i < num_blobs; ++i) {
+    REQUIRE(!bkt.ContainsBlob(std::to_string(i)));
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+TEST_CASE("TestHermesEvictionWatermark") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Find the fastest target and its high watermark
+  auto get_fastest = []() {
+    std::vector<hermes::TargetStats> stats =
+        HERMES->CollectMetadataSnapshot().target_info_;
+    hermes::TargetStats fastest = stats[0];
+    for (hermes::TargetStats &tgt_stats : stats) {
+      if (tgt_stats.score_ > fastest.score_) {
+        fastest = tgt_stats;
+      }
+    }
+    return fastest;
+  };
+  hermes::TargetStats fastest = get_fastest();
+  hermes::DeviceInfo *dev = FindDevice(fastest);
+  REQUIRE(dev != nullptr);
+  size_t high = (size_t)(fastest.max_cap_ * dev->borg_max_thresh_ *
+      HERMES_SERVER_CONF.eviction_.high_watermark_);
+
+  // Each wave overfills the target. The blobs demoted by earlier waves
+  // stay the coldest, and later waves must evict past them.
+  hermes::Context ctx;
+  ctx.evict_policy_ = hermes::EvictionPolicy::kLru;
+  hermes::Bucket bkt = HERMES->GetBucket(
+      "evict_watermark_test" + std::to_string(rank), ctx);
+  size_t blob_size = std::max<size_t>(KILOBYTES(4),
+                                      fastest.max_cap_ / 16384);
+  hermes::Blob blob(blob_size);
+  memset(blob.data(), rank, blob.size());
+  size_t blob_idx = 0;
+  for (int wave = 0; wave < 3; ++wave) {
+    size_t used = fastest.max_cap_ - fastest.rem_cap_;
+    size_t count = 64;
+    if (used < high) {
+      count += (high - used) / blob_size / nprocs;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      hermes::Context put_ctx;
+      bkt.Put(std::to_string(blob_idx++), blob, put_ctx);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    sleep(2);
+    fastest = get_fastest();
+    REQUIRE(fastest.max_cap_ - fastest.rem_cap_ <= high);
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+  // Demoted blobs are still readable
+  hermes::Blob out;
+  bkt.Get("0", out, ctx);
+  REQUIRE(out.size() == blob_size);
+  REQUIRE(out.data()[0] == (char)rank);
+  bkt.Destroy();
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+TEST_CASE("TestHermesDedup") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Blobs of the bucket repeat a few contents
+  hermes::Context ctx;
+  ctx.dedup_ = true;
+  hermes::Bucket bkt = HERMES->GetBucket(
+      "dedup_test" + std::to_string(rank), ctx);
+  u32 num_blobs = 64, num_distinct = 4;
+  for (int i = 0; i < num_blobs; ++i) {
+    hermes::Blob blob(KILOBYTES(64));
+    memset(blob.data(), i % num_distinct, blob.size());
+    hermes::Context put_ctx;
+    bkt.Put(std::to_string(i), blob, put_ctx);
+  }
+  std::vector<hermes::TargetStats> stats =
+      HERMES->CollectMetadataSnapshot().target_info_;
+  size_t logical = 0, physical = 0;
+  for (hermes::TargetStats &tgt_stats : stats) {
+    logical += tgt_stats.dedup_logical_;
+    physical += tgt_stats.dedup_physical_;
+  }
+  REQUIRE(physical > 0);
+  REQUIRE(physical < logical);
+
+  // A partial put copies the shared buffer instead of modifying it
+  hermes::Blob patch(KILOBYTES(1));
+  memset(patch.data(), 255, patch.size());
+  hermes::Context put_ctx;
+  bkt.PartialPut("0", patch, 0, put_ctx);
+  for (int i = 0; i < num_blobs; i += num_distinct) {
+    hermes::Blob blob;
+    bkt.Get(std::to_string(i), blob, put_ctx);
+    REQUIRE(blob.size() == KILOBYTES(64));
+    REQUIRE(blob.data()[0] == (i == 0 ? (char)255 : 0));
+    REQUIRE(blob.data()[KILOBYTES(1)] == 0);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/** Sum the deduplication statistics and remaining capacity of targets */
+static void SumDedupStats(size_t &logical, size_t &physical, size_t &rem_cap) {
+  logical = physical = rem_cap = 0;
+  for (hermes::TargetStats &stats :
+       HERMES->CollectMetadataSnapshot().target_info_) {
+    logical += stats.dedup_logical_;
+    physical += stats.dedup_physical_;
+    rem_cap += stats.rem_cap_;
+  }
+}
+
+TEST_CASE("TestHermesDedupRelease") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // The statistics are per target, so only one rank changes them
+  if (rank == 0) {
+    HRUN_ADMIN->FlushRoot(DomainId::GetGlobal());
+    size_t logical0, physical0, rem_cap0;
+    SumDedupStats(logical0, physical0, rem_cap0);
+
+    // Every blob shares the buffers of the first
+    hermes::Context ctx;
+    ctx.dedup_ = true;
+    hermes::Bucket bkt = HERMES->GetBucket("dedup_release", ctx);
+    size_t num_blobs = 8;
+    for (size_t i = 0; i < num_blobs; ++i) {
+      hermes::Blob blob(KILOBYTES(64));
+      memset(blob.data(), 7, blob.size());
+      bkt.Put(std::to_string(i), blob, ctx);
+    }
+    size_t logical, physical, rem_cap;
+    SumDedupStats(logical, physical, rem_cap);
+    size_t shared = physical - physical0;
+    REQUIRE(shared > 0);
+    REQUIRE(logical - logical0 == num_blobs * shared);
+
+    // Destroying a sharer drops one reference, not the buffers
+    for (size_t i = 0; i < num_blobs - 2; ++i) {
+      bkt.DestroyBlob(std::to_string(i), ctx);
+    }
+    SumDedupStats(logical, physical, rem_cap);
+    REQUIRE(physical - physical0 == shared);
+    REQUIRE(logical - logical0 == 2 * shared);
+
+    // Truncating a sharer leaves the other intact
+    hermes::BlobId trunc_id = bkt.GetBlobId(std::to_string(num_blobs - 2));
+    HERMES_CONF->blob_mdm_.TruncateBlobRoot(bkt.GetId(), trunc_id,
+                                            KILOBYTES(4), true);
+    SumDedupStats(logical, physical, rem_cap);
+    REQUIRE(physical - physical0 <= shared);
+    REQUIRE(logical - logical0 < 2 * shared);
+    hermes::Blob blob;
+    bkt.Get(std::to_string(num_blobs - 1), blob, ctx);
+    REQUIRE(blob.size() == KILOBYTES(64));
+    REQUIRE(std::all_of(blob.data(), blob.data() + blob.size(),
+                        [](char c) { return c == 7; }));
+    hermes::Blob trunc_blob;
+    bkt.Get(trunc_id, trunc_blob, ctx);
+    REQUIRE(trunc_blob.size() == KILOBYTES(4));
+    REQUIRE(std::all_of(trunc_blob.data(),
+                        trunc_blob.data() + trunc_blob.size(),
+                        [](char c) { return c == 7; }));
+
+    // Destroying the last references frees each buffer exactly once
+    bkt.DestroyBlob(std::to_string(num_blobs - 2), ctx);
+    bkt.DestroyBlob(std::to_string(num_blobs - 1), ctx);
+    HRUN_ADMIN->FlushRoot(DomainId::GetGlobal());
+    SumDedupStats(logical, physical, rem_cap);
+    REQUIRE(physical == physical0);
+    REQUIRE(logical == logical0);
+    REQUIRE(rem_cap == rem_cap0);
+    bkt.Destroy();
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+TEST_CASE("TestHermesChecksum") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Full, partial and appending puts keep the checksums valid
+  hermes::Context ctx;
+  ctx.checksum_ = true;
+  hermes::Bucket bkt = HERMES->GetBucket(
+      "checksum_test" + std::to_string(rank), ctx);
+  hermes::Context put_ctx;
+  hermes::Blob blob(MEGABYTES(1));
+  for (size_t i = 0; i < blob.size(); ++i) {
+    blob.data()[i] = (char)(i % 251);
+  }
+  bkt.Put("0", blob, put_ctx);
+  hermes::Blob patch(KILOBYTES(4));
+  memset(patch.data(), 7, patch.size());
+  bkt.PartialPut("0", patch, KILOBYTES(100), put_ctx);
+  bkt.PartialPut("0", patch, blob.size(), put_ctx);
+  std::vector<char> expected(blob.data(), blob.data() + blob.size());
+  memcpy(expected.data() + KILOBYTES(100), patch.data(), patch.size());
+  expected.insert(expected.end(), patch.data(), patch.data() + patch.size());
+
+  // Every read is verified
+  hermes::Blob out;
+  bkt.Get("0", out, put_ctx);
+  REQUIRE(out.size() == expected.size());
+  REQUIRE(memcmp(out.data(), expected.data(), expected.size()) == 0);
+  hermes::Blob part(KILOBYTES(8));
+  bkt.PartialGet("0", part, KILOBYTES(98), put_ctx);
+  REQUIRE(memcmp(part.data(), expected.data() + KILOBYTES(98),
+                 part.size()) == 0);
+
+  std::vector<hermes::TargetStats> stats =
+      HERMES->CollectMetadataSnapshot().target_info_;
+  for (hermes::TargetStats &tgt_stats : stats) {
+    REQUIRE(tgt_stats.crc_errors_ == 0);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
+/** Overwrite the start of \a buf in the slab file of its posix target */
+static bool CorruptBuffer(const hermes::BufferInfo &buf,
+                          const std::vector<hermes::TargetStats> &stats) {
+  for (const hermes::TargetStats &tgt_stats : stats) {
+    if (tgt_stats.tgt_id_ != buf.tid_) {
+      continue;
+    }
+    hermes::DeviceInfo *dev = FindDevice(tgt_stats);
+    if (dev == nullptr || dev->mount_dir_.empty() ||
+        dev->io_api_ == hermes::IoInterface::kMmap) {
+      return false;
+    }
+    std::string path = dev->mount_dir_ + "/slab_" + dev->dev_name_;
+    int fd = open(path.c_str(), O_WRONLY);
+    if (fd < 0) {
+      return false;
+    }
+    std::vector<char> garbage(KILOBYTES(4), (char)0xA5);
+    ssize_t ret = pwrite(fd, garbage.data(), garbage.size(), buf.t_off_);
+    close(fd);
+    return ret == (ssize_t)garbage.size();
+  }
+  return false;
+}
+
+TEST_CASE("TestHermesChecksumCorrupt") {
+  int rank, nprocs;
+  MPI_Barrier(MPI_COMM_WORLD);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+
+  // Initialize Hermes on all nodes
+  HERMES->ClientInit();
+
+  // Place the blob on the slowest target, which is file-backed
+  hermes::Context ctx;
+  ctx.checksum_ = true;
+  hermes::Bucket bkt = HERMES->GetBucket(
+      "checksum_corrupt_test" + std::to_string(rank), ctx);
+  hermes::Context put_ctx;
+  put_ctx.blob_score_ = 0;
+  hermes::Blob blob(MEGABYTES(1));
+  memset(blob.data(), 3, blob.size());
+  bkt.Put("0", blob, put_ctx);
+
+  // Corrupt the stored data behind the blob mdm's back
+  std::vector<hermes::TargetStats> stats =
+      HERMES->CollectMetadataSnapshot().target_info_;
+  size_t crc_errors = 0;
+  for (hermes::TargetStats &tgt_stats : stats) {
+    crc_errors += tgt_stats.crc_errors_;
+  }
+  hermes::BlobId blob_id = bkt.GetBlobId("0");
+  std::vector<hermes::BufferInfo> buffers =
+      HERMES_CONF->blob_mdm_.GetBlobBuffersRoot(bkt.GetId(), blob_id);
+  REQUIRE(buffers.size() > 0);
+  REQUIRE(CorruptBuffer(buffers[0], stats));
+
+  // The read fails verification instead of returning bad data
+  hermes::Blob out;
+  REQUIRE(bkt.Get("0", out, put_ctx).IsNull());
+  REQUIRE(out.size() == 0);
+  hermes::Blob async_out(blob.size());
+  LPointer<hrunpq::TypedPushTask<hermes::GetBlobTask>> get_task =
+      bkt.AsyncGet(blob_id, async_out, put_ctx);
+  get_task->Wait();
+  REQUIRE(get_task->get()->rc_ == hermes::BLOB_CHECKSUM_MISMATCH.code_);
+  HRUN_CLIENT->FreeBuffer(get_task->get()->data_);
+  HRUN_CLIENT->DelTask(get_task);
+  stats = HERMES->CollectMetadataSnapshot().target_info_;
+  size_t new_crc_errors = 0;
+  for (hermes::TargetStats &tgt_stats : stats) {
+    new_crc_errors += tgt_stats.crc_errors_;
+  }
+  REQUIRE(new_crc_errors > crc_errors);
+
+  // Flushing does not stall on, or drop, the unreadable blob
+  HRUN_ADMIN->FlushRoot(DomainId::GetGlobal());
+  REQUIRE(bkt.ContainsBlob("0"));
+  bkt.Destroy();
+  MPI_Barrier(MPI_COMM_WORLD);
+}
+
 /*
 TEST_CASE("TestHermesDataPlacement") {
   int rank, nprocs;
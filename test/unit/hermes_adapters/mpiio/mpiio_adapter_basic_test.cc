@@ -988,6 +988,78 @@ TEST_CASE("SingleReadCollective", "[process=" +
   TESTER->Posttest();
 }
 
+TEST_CASE("CollectiveAggregation", "[process=" +
+    std::to_string(TESTER->comm_size_) +
+    "]"
+    "[operation=collective_aggregation]"
+    "[synchronicity=sync]"
+    "[coordination=collective]"
+    "[request_size=type-fixed][repetition=1]"
+    "[file=1]") {
+  TESTER->Pretest();
+  SECTION("write_all then read_all disjoint extents") {
+    TESTER->test_open(TESTER->shared_new_file_,
+                      MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_COMM_WORLD);
+    REQUIRE(TESTER->status_orig_ == MPI_SUCCESS);
+    TESTER->test_seek(TESTER->rank_ * TESTER->request_size_, MPI_SEEK_SET);
+    REQUIRE(TESTER->status_orig_ == 0);
+    TESTER->test_write_all(TESTER->write_data_.data(),
+                           TESTER->request_size_, MPI_CHAR);
+    REQUIRE((size_t)TESTER->size_written_orig_ == TESTER->request_size_);
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == MPI_SUCCESS);
+    MPI_Barrier(MPI_COMM_WORLD);
+    REQUIRE(stdfs::file_size(TESTER->shared_new_file_.hermes_) ==
+        TESTER->request_size_ * TESTER->comm_size_);
+
+    TESTER->test_open(TESTER->shared_new_file_, MPI_MODE_RDONLY,
+                      MPI_COMM_WORLD);
+    REQUIRE(TESTER->status_orig_ == MPI_SUCCESS);
+    TESTER->test_seek(TESTER->rank_ * TESTER->request_size_, MPI_SEEK_SET);
+    REQUIRE(TESTER->status_orig_ == 0);
+    TESTER->test_read_all(TESTER->read_data_.data(),
+                          TESTER->request_size_, MPI_CHAR);
+    REQUIRE((size_t)TESTER->size_read_orig_ == TESTER->request_size_);
+    REQUIRE(memcmp(TESTER->read_data_.data(), TESTER->write_data_.data(),
+                   TESTER->request_size_) == 0);
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == MPI_SUCCESS);
+  }
+
+  // Only rank 0 seeks to the end, so the ranks disagree locally on
+  // whether the call can be aggregated. They must still agree.
+  SECTION("write_all and read_all after a local SEEK_END") {
+    TESTER->test_open(TESTER->shared_existing_file_, MPI_MODE_RDWR,
+                      MPI_COMM_WORLD);
+    REQUIRE(TESTER->status_orig_ == MPI_SUCCESS);
+    if (TESTER->rank_ == 0) {
+      TESTER->test_seek(0, MPI_SEEK_END);
+    } else {
+      TESTER->test_seek(TESTER->rank_ * TESTER->request_size_, MPI_SEEK_SET);
+    }
+    REQUIRE(TESTER->status_orig_ == 0);
+    TESTER->test_write_all(TESTER->write_data_.data(),
+                           TESTER->request_size_, MPI_CHAR);
+    REQUIRE((size_t)TESTER->size_written_orig_ == TESTER->request_size_);
+    if (TESTER->rank_ == 0) {
+      TESTER->test_seek(0, MPI_SEEK_END);
+    } else {
+      TESTER->test_seek(TESTER->rank_ * TESTER->request_size_, MPI_SEEK_SET);
+    }
+    REQUIRE(TESTER->status_orig_ == 0);
+    TESTER->test_read_all(TESTER->read_data_.data(),
+                          TESTER->request_size_, MPI_CHAR);
+    if (TESTER->rank_ == 0) {
+      REQUIRE(TESTER->size_read_orig_ == 0);
+    } else {
+      REQUIRE((size_t)TESTER->size_read_orig_ == TESTER->request_size_);
+    }
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == MPI_SUCCESS);
+  }
+  TESTER->Posttest();
+}
+
 TEST_CASE("SingleAsyncRead", "[process=" + std::to_string(TESTER->comm_size_) +
     "]"
     "[operation=single_read]"
@@ -11,6 +11,7 @@
 * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include <sys/stat.h>
+#include <algorithm>
 #include "posix_adapter_test.h"
 
 TEST_CASE("Open", "[process=" + std::to_string(TESTER->comm_size_) +
@@ -1527,3 +1528,57 @@ TEST_CASE("fstat") {
 
   TESTER->Posttest();
 }
+
+TEST_CASE("ftruncate") {
+  TESTER->Pretest();
+
+  SECTION("shrink a new file") {
+    TESTER->test_open(TESTER->new_file_, O_RDWR | O_CREAT | O_EXCL, 0600);
+    REQUIRE(TESTER->fh_orig_ != -1);
+    TESTER->test_write(TESTER->write_data_.data(), TESTER->request_size_);
+    REQUIRE(TESTER->size_written_orig_ == TESTER->request_size_);
+
+    size_t new_size = TESTER->request_size_ / 2;
+    int result = ftruncate(TESTER->fh_orig_, new_size);
+    REQUIRE(result == 0);
+    struct stat buf = {};
+    result = fstat(TESTER->fh_orig_, &buf);
+    REQUIRE(result == 0);
+    REQUIRE(buf.st_size == (off_t)new_size);
+
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == 0);
+  }
+
+  SECTION("extend a new file") {
+    TESTER->test_open(TESTER->new_file_, O_RDWR | O_CREAT | O_EXCL, 0600);
+    REQUIRE(TESTER->fh_orig_ != -1);
+    TESTER->test_write(TESTER->write_data_.data(), TESTER->request_size_);
+    REQUIRE(TESTER->size_written_orig_ == TESTER->request_size_);
+
+    size_t new_size = TESTER->request_size_ * 2 + 1;
+    int result = ftruncate(TESTER->fh_orig_, new_size);
+    REQUIRE(result == 0);
+    result = ftruncate(TESTER->fh_cmp_, new_size);
+    REQUIRE(result == 0);
+    struct stat buf = {};
+    result = fstat(TESTER->fh_orig_, &buf);
+    REQUIRE(result == 0);
+    REQUIRE(buf.st_size == (off_t)new_size);
+
+    // The extended range reads back as zeros
+    TESTER->test_seek(TESTER->request_size_, SEEK_SET);
+    REQUIRE(TESTER->status_orig_ == (int)TESTER->request_size_);
+    std::vector<char> read_data(new_size - TESTER->request_size_, 'r');
+    TESTER->test_read(read_data.data(), read_data.size());
+    REQUIRE(TESTER->size_read_orig_ == read_data.size());
+    size_t nonzero = std::count_if(read_data.begin(), read_data.end(),
+                                   [](char c) { return c != 0; });
+    REQUIRE(nonzero == 0);
+
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == 0);
+  }
+
+  TESTER->Posttest();
+}
@@ -0,0 +1,220 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+* Distributed under BSD 3-Clause license.                                   *
+* Copyright by The HDF Group.                                               *
+* Copyright by the Illinois Institute of Technology.                        *
+* All rights reserved.                                                      *
+*                                                                           *
+* This file is part of Hermes. The full Hermes copyright notice, including  *
+* terms governing use, modification, and redistribution, is contained in    *
+* the COPYING file, which can be found at the top directory. If you do not  *
+* have access to the file, you may request a copy from help@hdfgroup.org.   *
+* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <sys/stat.h>
+#include "posix_adapter_test.h"
+
+/**
+ * Enables the write-back buffer for files opened in this scope.
+ * The flush interval is long enough that the buffer is only
+ * drained by the operations under test.
+ * */
+struct ScopedWriteBuffer {
+  size_t size_;
+  size_t flush_ms_;
+
+  explicit ScopedWriteBuffer(size_t size) {
+    hermes::adapter::AdapterObjectConfig &conf =
+        HERMES_CLIENT_CONF.base_adapter_config_;
+    size_ = conf.write_buffer_size_;
+    flush_ms_ = conf.write_buffer_flush_ms_;
+    conf.write_buffer_size_ = size;
+    conf.write_buffer_flush_ms_ = 60 * 1000;
+  }
+
+  ~ScopedWriteBuffer() {
+    hermes::adapter::AdapterObjectConfig &conf =
+        HERMES_CLIENT_CONF.base_adapter_config_;
+    conf.write_buffer_size_ = size_;
+    conf.write_buffer_flush_ms_ = flush_ms_;
+  }
+};
+
+/** Read the backend copy of a file, bypassing Hermes */
+static std::vector<char> LoadBackend(const std::string &path) {
+  TESTER->IgnoreAllFiles();
+  std::vector<char> data(stdfs::file_size(path));
+  FILE *fh = fopen(path.c_str(), "r");
+  REQUIRE(fh != nullptr);
+  size_t load_size = fread(data.data(), 1, data.size(), fh);
+  fclose(fh);
+  TESTER->TrackAllFiles();
+  REQUIRE(load_size == data.size());
+  return data;
+}
+
+/** Write \a count small chunks of the test pattern sequentially */
+static void WriteChunks(size_t chunk_size, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    const char *ptr = TESTER->write_data_.data() +
+        (i * chunk_size) % (TESTER->request_size_ - chunk_size + 1);
+    TESTER->test_write(ptr, chunk_size);
+    REQUIRE(TESTER->size_written_orig_ == chunk_size);
+  }
+}
+
+TEST_CASE("WriteBufferCoherence",
+          "[process=" + std::to_string(TESTER->comm_size_) +
+              "]"
+              "[operation=write_buffer]"
+              "[repetition=1][file=1]") {
+  TESTER->Pretest();
+  size_t chunk_size = std::min<size_t>(512, TESTER->request_size_);
+  size_t num_chunks = 32;
+  size_t total = chunk_size * num_chunks;
+  ScopedWriteBuffer wbuf(MEGABYTES(1));
+
+  SECTION("read after buffered write") {
+    TESTER->test_open(TESTER->new_file_, O_RDWR | O_CREAT | O_EXCL, 0600);
+    REQUIRE(TESTER->fh_orig_ != -1);
+    WriteChunks(chunk_size, num_chunks);
+    // The whole dirty extent
+    std::vector<char> read_data(total, 'r');
+    TESTER->test_seek(0, SEEK_SET);
+    REQUIRE(TESTER->status_orig_ == 0);
+    TESTER->test_read(read_data.data(), total);
+    REQUIRE(TESTER->size_read_orig_ == total);
+    // A range strictly inside the dirty extent
+    TESTER->test_seek(chunk_size + 7, SEEK_SET);
+    TESTER->test_read(read_data.data(), chunk_size);
+    REQUIRE(TESTER->size_read_orig_ == chunk_size);
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == 0);
+  }
+
+  SECTION("read overlapping buffered and clean data") {
+    TESTER->test_open(TESTER->existing_file_, O_RDWR);
+    REQUIRE(TESTER->fh_orig_ != -1);
+    size_t dirty_off = TESTER->request_size_;
+    TESTER->test_seek(dirty_off, SEEK_SET);
+    REQUIRE(TESTER->status_orig_ == (int)dirty_off);
+    WriteChunks(chunk_size, num_chunks);
+    // Straddle the start and the end of the dirty extent
+    std::vector<char> read_data(total + 2 * chunk_size, 'r');
+    TESTER->test_seek(dirty_off - chunk_size, SEEK_SET);
+    TESTER->test_read(read_data.data(), read_data.size());
+    REQUIRE(TESTER->size_read_orig_ == read_data.size());
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == 0);
+  }
+
+  SECTION("fsync publishes buffered data") {
+    TESTER->test_open(TESTER->new_file_, O_RDWR | O_CREAT | O_EXCL, 0600);
+    REQUIRE(TESTER->fh_orig_ != -1);
+    WriteChunks(chunk_size, num_chunks);
+    REQUIRE(fsync(TESTER->fh_orig_) == 0);
+    REQUIRE(fsync(TESTER->fh_cmp_) == 0);
+#if HERMES_INTERCEPT == 1
+    std::vector<char> backend = LoadBackend(TESTER->new_file_.hermes_);
+    std::vector<char> expected = LoadBackend(TESTER->new_file_.cmp_);
+    REQUIRE(backend.size() == total);
+    REQUIRE(backend == expected);
+#endif
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == 0);
+  }
+
+  SECTION("close publishes buffered data") {
+    TESTER->test_open(TESTER->new_file_, O_RDWR | O_CREAT | O_EXCL, 0600);
+    REQUIRE(TESTER->fh_orig_ != -1);
+    WriteChunks(chunk_size, num_chunks);
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == 0);
+    TESTER->test_open(TESTER->new_file_, O_RDONLY);
+    REQUIRE(TESTER->fh_orig_ != -1);
+    std::vector<char> read_data(total, 'r');
+    TESTER->test_read(read_data.data(), total);
+    REQUIRE(TESTER->size_read_orig_ == total);
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == 0);
+  }
+
+  SECTION("another descriptor reads buffered data") {
+    TESTER->test_open(TESTER->new_file_, O_RDWR | O_CREAT | O_EXCL, 0600);
+    REQUIRE(TESTER->fh_orig_ != -1);
+    WriteChunks(chunk_size, num_chunks);
+    int fd2 = open(TESTER->new_file_.hermes_.c_str(), O_RDONLY);
+    int cmp_fd2 = open(TESTER->new_file_.cmp_.c_str(), O_RDONLY);
+    REQUIRE(fd2 != -1);
+    REQUIRE(cmp_fd2 != -1);
+    std::vector<char> read_data(total, 'r');
+    std::vector<char> cmp_data(total, 'c');
+    REQUIRE(pread(fd2, read_data.data(), total, 0) == (ssize_t)total);
+    REQUIRE(pread(cmp_fd2, cmp_data.data(), total, 0) == (ssize_t)total);
+    REQUIRE(read_data == cmp_data);
+    struct stat st;
+    REQUIRE(fstat(fd2, &st) == 0);
+    REQUIRE((size_t)st.st_size == total);
+    REQUIRE(close(fd2) == 0);
+    REQUIRE(close(cmp_fd2) == 0);
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == 0);
+  }
+
+  SECTION("concurrent readers of a buffered file") {
+    TESTER->test_open(TESTER->new_file_, O_RDWR | O_CREAT | O_EXCL, 0600);
+    REQUIRE(TESTER->fh_orig_ != -1);
+    std::vector<char> pattern = TESTER->GenRandom(total, 300);
+    std::atomic<size_t> written(0);
+    std::atomic<size_t> mismatches(0);
+    std::atomic<bool> done(false);
+    int fd = TESTER->fh_orig_;
+
+    // Readers only ask for ranges the writer has already returned from
+    size_t nreaders = 4;
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < nreaders; ++r) {
+      readers.emplace_back([&, r]() {
+        std::vector<char> buf(chunk_size);
+        size_t iter = r;
+        while (!done.load()) {
+          size_t end = written.load();
+          if (end == 0) {
+            continue;
+          }
+          size_t size = std::min(chunk_size, end);
+          size_t off = (iter++ * 97) % (end - size + 1);
+          ssize_t ret = pread(fd, buf.data(), size, off);
+          if (ret != (ssize_t)size ||
+              memcmp(buf.data(), pattern.data() + off, size) != 0) {
+            mismatches.fetch_add(1);
+          }
+        }
+      });
+    }
+    size_t short_writes = 0;
+    for (size_t i = 0; i < num_chunks; ++i) {
+      size_t off = i * chunk_size;
+      ssize_t ret = pwrite(fd, pattern.data() + off, chunk_size, off);
+      if (ret != (ssize_t)chunk_size) {
+        ++short_writes;
+        break;
+      }
+      written.store(off + chunk_size);
+    }
+    done.store(true);
+    for (std::thread &reader : readers) {
+      reader.join();
+    }
+    REQUIRE(short_writes == 0);
+    REQUIRE(mismatches.load() == 0);
+    REQUIRE(write(TESTER->fh_cmp_, pattern.data(), total) == (ssize_t)total);
+    TESTER->test_close();
+    REQUIRE(TESTER->status_orig_ == 0);
+  }
+
+  TESTER->Posttest();
+}
@@ -11,6 +11,9 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include "hermes_vfd_test.h"
+#include <H5FDdevelop.h>
+#include <algorithm>
+#include "H5FDhermes_io.h"
 using hermes::adapter::test::MuteHdf5Errors;
 
 /** Returns a number in the range [1, upper_bound] */
@@ -742,3 +745,180 @@ TEST_CASE("ScratchMode", "[mode=scratch]") {
 
   TESTER->Posttest();
 }
+
+/** The page size of raw data in the Hermes VFD */
+static size_t VfdRawPageSize() {
+  size_t page_size = HERMES_CLIENT_CONF.vfd_raw_page_size_;
+  if (page_size == 0) {
+    page_size = HERMES_CLIENT_CONF.base_adapter_config_.page_size_;
+  }
+  return page_size;
+}
+
+TEST_CASE("VectorIo") {
+  TESTER->Pretest();
+  size_t page_size = VfdRawPageSize();
+  H5FD_t *file = H5FDopen(TESTER->new_file_.hermes_.c_str(),
+                          H5F_ACC_RDWR | H5F_ACC_CREAT | H5F_ACC_TRUNC,
+                          H5P_DEFAULT, HADDR_UNDEF);
+  REQUIRE(file != nullptr);
+  REQUIRE(H5FDset_eoa(file, H5FD_MEM_DRAW, 4 * page_size) >= 0);
+
+  SECTION("read an extent spanning a hole") {
+    // Write the first and third page, leaving a hole in between
+    std::vector<char> first(page_size, 'a'), third(KILOBYTES(4), 'c');
+    H5FD_mem_t types[2] = {H5FD_MEM_DRAW, H5FD_MEM_DRAW};
+    haddr_t addrs[2] = {0, 2 * page_size};
+    size_t sizes[2] = {first.size(), third.size()};
+    const void *wbufs[2] = {first.data(), third.data()};
+    REQUIRE(H5FDwrite_vector(file, H5P_DEFAULT, 2,
+                             types, addrs, sizes, wbufs) >= 0);
+
+    // Read all three pages as one extent
+    size_t size = 2 * page_size + third.size();
+    std::vector<char> buf(size, 'x');
+    haddr_t addr = 0;
+    void *rbuf = buf.data();
+    REQUIRE(H5FDread_vector(file, H5P_DEFAULT, 1,
+                            types, &addr, &size, &rbuf) >= 0);
+    REQUIRE(std::all_of(buf.begin(), buf.begin() + page_size,
+                        [](char c) { return c == 'a'; }));
+    REQUIRE(std::all_of(buf.begin() + page_size, buf.begin() + 2 * page_size,
+                        [](char c) { return c == 0; }));
+    REQUIRE(std::all_of(buf.begin() + 2 * page_size, buf.end(),
+                        [](char c) { return c == 'c'; }));
+  }
+
+  SECTION("read past the end of the file") {
+    std::vector<char> data(KILOBYTES(4), 'd');
+    H5FD_mem_t type = H5FD_MEM_DRAW;
+    haddr_t addr = page_size - data.size() / 2;
+    size_t size = data.size();
+    const void *wbuf = data.data();
+    REQUIRE(H5FDwrite_vector(file, H5P_DEFAULT, 1,
+                             &type, &addr, &size, &wbuf) >= 0);
+    size = 2 * data.size();
+    std::vector<char> buf(size, 'x');
+    void *rbuf = buf.data();
+    REQUIRE(H5FDread_vector(file, H5P_DEFAULT, 1,
+                            &type, &addr, &size, &rbuf) >= 0);
+    REQUIRE(memcmp(buf.data(), data.data(), data.size()) == 0);
+    REQUIRE(std::all_of(buf.begin() + data.size(), buf.end(),
+                        [](char c) { return c == 0; }));
+  }
+
+  SECTION("strided selection") {
+    // Every other pair of ints, across a page boundary
+    hsize_t nelems = 4096;
+    hid_t file_space = H5Screate_simple(1, &nelems, nullptr);
+    hsize_t start = 0, stride = 4, count = nelems / 4, block = 2;
+    REQUIRE(H5Sselect_hyperslab(file_space, H5S_SELECT_SET,
+                                &start, &stride, &count, &block) >= 0);
+    hsize_t npoints = count * block;
+    hid_t mem_space = H5Screate_simple(1, &npoints, nullptr);
+    std::vector<int> data(npoints), buf(npoints, -1);
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = (int)i;
+    }
+    haddr_t offset = page_size - nelems * sizeof(int) / 2;
+    size_t elmt_size = sizeof(int);
+    const void *wbuf = data.data();
+    REQUIRE(H5FDwrite_selection(file, H5FD_MEM_DRAW, H5P_DEFAULT, 1,
+                                &mem_space, &file_space, &offset,
+                                &elmt_size, &wbuf) >= 0);
+    void *rbuf = buf.data();
+    REQUIRE(H5FDread_selection(file, H5FD_MEM_DRAW, H5P_DEFAULT, 1,
+                               &mem_space, &file_space, &offset,
+                               &elmt_size, &rbuf) >= 0);
+    REQUIRE(buf == data);
+
+    // The selected elements are where a vector read expects them
+    size_t size = nelems * sizeof(int);
+    std::vector<int> whole(nelems);
+    H5FD_mem_t type = H5FD_MEM_DRAW;
+    void *whole_buf = whole.data();
+    REQUIRE(H5FDread_vector(file, H5P_DEFAULT, 1,
+                            &type, &offset, &size, &whole_buf) >= 0);
+    for (size_t i = 0; i < npoints; ++i) {
+      REQUIRE(whole[(i / 2) * 4 + i % 2] == data[i]);
+    }
+    H5Sclose(mem_space);
+    H5Sclose(file_space);
+  }
+
+  REQUIRE(H5FDclose(file) >= 0);
+  TESTER->Posttest(false);
+}
+
+TEST_CASE("VfdExtentSet") {
+  hermes::adapter::ExtentSet set;
+  set.Add(10, 20);
+  set.Add(30, 40);
+  REQUIRE(set.extents_.size() == 2);
+  REQUIRE(set.Contains(12, 18));
+  REQUIRE(!set.Contains(15, 35));
+  // Adjacent and overlapping ranges merge
+  set.Add(20, 30);
+  REQUIRE(set.extents_.size() == 1);
+  REQUIRE(set.Contains(10, 40));
+  // Removing the middle splits the range
+  set.Remove(15, 25);
+  REQUIRE(set.extents_.size() == 2);
+  REQUIRE(!set.Contains(14, 16));
+  REQUIRE(set.Contains(25, 40));
+  auto ranges = set.Intersect(0, 30);
+  REQUIRE(ranges.size() == 2);
+  REQUIRE(ranges[0] == hermes::adapter::ExtentSet::RANGE_T(10, 15));
+  REQUIRE(ranges[1] == hermes::adapter::ExtentSet::RANGE_T(25, 30));
+  set.clear();
+  REQUIRE(set.empty());
+}
+
+TEST_CASE("VfdMetadataCache") {
+  HERMES->ClientInit();
+  size_t page_size = KILOBYTES(4);
+  hermes::adapter::VfdMetadataCache cache(
+      TESTER->new_file_.hermes_, page_size);
+  std::vector<char> meta(5000, 'm'), file(3 * page_size, 'f');
+
+  // Written metadata is dirty and readable across pages
+  cache.Write(100, meta.size(), meta.data());
+  REQUIRE(cache.Contains(100, meta.size()));
+  REQUIRE(!cache.Contains(0, 200));
+  std::vector<char> buf(meta.size());
+  cache.Read(100, buf.size(), buf.data());
+  REQUIRE(buf == meta);
+
+  // Filling with file data does not overwrite the dirty range
+  cache.Fill(0, file.size(), file.data());
+  REQUIRE(cache.Contains(0, file.size()));
+  std::vector<char> expected(file);
+  memcpy(expected.data() + 100, meta.data(), meta.size());
+  buf.resize(file.size());
+  cache.Read(0, buf.size(), buf.data());
+  REQUIRE(buf == expected);
+
+  // Dirty metadata is laid over stale file data
+  buf = file;
+  cache.Overlay(0, buf.size(), buf.data());
+  REQUIRE(buf == expected);
+
+  // Taking the dirty ranges leaves the cache clean
+  std::vector<char> dirty;
+  std::vector<hermes::adapter::FsIoVec> iov;
+  cache.TakeDirty(dirty, iov);
+  REQUIRE(iov.size() == 1);
+  REQUIRE(iov[0].off_ == 100);
+  REQUIRE(iov[0].size_ == meta.size());
+  REQUIRE(memcmp(iov[0].buf_, meta.data(), meta.size()) == 0);
+  buf = file;
+  cache.Overlay(0, buf.size(), buf.data());
+  REQUIRE(buf == file);
+
+  // Raw writes invalidate the cached range
+  cache.Invalidate(0, 200);
+  REQUIRE(!cache.Contains(0, 100));
+  REQUIRE(cache.Contains(200, 100));
+  cache.Destroy();
+  REQUIRE(!cache.Contains(200, 100));
+}
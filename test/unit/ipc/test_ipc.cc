@@ -19,6 +19,9 @@
 #include "hermes_shm/util/timer.h"
 #include "hrun/work_orchestrator/affinity.h"
 #include "omp.h"
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
 
 TEST_CASE("TestIpc") {
   int rank, nprocs;
@@ -112,6 +115,40 @@ TEST_CASE("TestIpcMultithread32") {
   TestIpcMultithread(32);
 }
 
+TEST_CASE("TestIpcQueueResize") {
+  hrun::small_message::Client client;
+  HRUN_ADMIN->RegisterTaskLibRoot(hrun::DomainId::GetGlobal(), "small_message");
+  client.CreateRoot(hrun::DomainId::GetGlobal(), "ipc_test");
+  MultiQueue *queue = HRUN_CLIENT->GetQueue(client.queue_id_);
+  hrun::LaneGroup &group = queue->GetGroup(TaskPrio::kLowLatency);
+  u32 max_lanes = group.max_lanes_, depth = group.depth_;
+
+  // Tasks in flight while lanes are removed are migrated by the workers
+  // of the retired lanes, and lanes are resized by their workers
+  size_t ops = 4096, window = 64;
+  std::vector<LPointer<hrun::small_message::MdTask>> tasks;
+  for (size_t i = 0; i < ops; i += window) {
+    for (size_t j = 0; j < window; ++j) {
+      tasks.emplace_back(client.AsyncMdRoot(hrun::DomainId::GetLocal()));
+    }
+    size_t round = i / window;
+    HRUN_ADMIN->ResizeQueueRoot(hrun::DomainId::GetLocal(), client.queue_id_,
+                                TaskPrio::kLowLatency,
+                                1 + round % max_lanes,
+                                (round % 2) ? depth / 2 : depth * 2);
+    for (LPointer<hrun::small_message::MdTask> &task : tasks) {
+      task->Wait();
+      REQUIRE(task->ret_[0] == 1);
+      HRUN_CLIENT->DelTask(task);
+    }
+    tasks.clear();
+  }
+  HRUN_ADMIN->ResizeQueueRoot(hrun::DomainId::GetLocal(), client.queue_id_,
+                              TaskPrio::kLowLatency, max_lanes, depth);
+  REQUIRE(group.num_lanes_ == max_lanes);
+  REQUIRE(group.depth_ == depth);
+}
+
 TEST_CASE("TestIO") {
   int rank, nprocs;
   MPI_Barrier(MPI_COMM_WORLD);
@@ -141,6 +178,88 @@ TEST_CASE("TestIO") {
   HILOG(kInfo, "Latency: {} MOps", ops / t.GetUsec());
 }
 
+TEST_CASE("TestAllocWaitQueue") {
+  // Exhaust the client data segment
+  size_t size = KILOBYTES(64);
+  std::vector<LPointer<char>> held;
+  while (true) {
+    LPointer<char> p = HRUN_CLIENT->TryAllocateBufferClient(size);
+    if (p.shm_.IsNull()) {
+      break;
+    }
+    held.emplace_back(p);
+  }
+  REQUIRE(held.size() > 8);
+  REQUIRE(HRUN_CLIENT->AllocateBufferClient(size, 1000).shm_.IsNull());
+
+  // Waiters are served in turn as buffers are freed
+  int nthreads = 4;
+  std::atomic<int> served(0);
+  std::vector<LPointer<char>> got(nthreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < nthreads; ++i) {
+    threads.emplace_back([&, i]() {
+      got[i] = HRUN_CLIENT->AllocateBufferClient(size);
+      served.fetch_add(1);
+    });
+  }
+  usleep(50000);
+  REQUIRE(served.load() == 0);
+  for (int i = 0; i < nthreads; ++i) {
+    HRUN_CLIENT->FreeBuffer(held.back());
+    held.pop_back();
+    hshm::Timepoint freed;
+    freed.Now();
+    while (served.load() < i + 1 && freed.GetUsecFromStart() < 5000000) {
+      usleep(1000);
+    }
+    REQUIRE(served.load() == i + 1);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  REQUIRE(served.load() == nthreads);
+  REQUIRE(!HRUN_CLIENT->header_->data_waitq_.HasWaiters());
+  for (LPointer<char> &p : got) {
+    REQUIRE(!p.shm_.IsNull());
+    HRUN_CLIENT->FreeBuffer(p);
+  }
+  for (LPointer<char> &p : held) {
+    HRUN_CLIENT->FreeBuffer(p);
+  }
+
+  // The fast path works again once the queue drains
+  LPointer<char> p = HRUN_CLIENT->TryAllocateBufferClient(size);
+  REQUIRE(!p.shm_.IsNull());
+  HRUN_CLIENT->FreeBuffer(p);
+}
+
+TEST_CASE("TestAllocWaitQueueReap") {
+  auto *waitq = reinterpret_cast<hrun::AllocWaitQueue*>(
+      mmap(nullptr, sizeof(hrun::AllocWaitQueue), PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+  REQUIRE(waitq != MAP_FAILED);
+  waitq->Init();
+
+  // A process exits while holding the served ticket
+  pid_t child = fork();
+  if (child == 0) {
+    waitq->Enqueue();
+    _exit(0);
+  }
+  waitpid(child, nullptr, 0);
+  REQUIRE(waitq->HasWaiters());
+
+  // The next waiter skips it rather than waiting forever
+  hshm::Timepoint start;
+  start.Now();
+  u32 ticket = waitq->Enqueue();
+  REQUIRE(waitq->WaitTurn(ticket, start, 10 * hrun::AllocWaitQueue::kReapUs));
+  waitq->Dequeue(ticket);
+  REQUIRE(!waitq->HasWaiters());
+  munmap(waitq, sizeof(hrun::AllocWaitQueue));
+}
+
 // TEST_CASE("TestHostfile") {
 //  for (u32 node_id = 1; node_id <
 //  HRUN_THALLIUM->rpc_->hosts_.size() + 1; ++node_id) {
@@ -148,3 +267,54 @@ TEST_CASE("TestIO") {
 //    HRUN_THALLIUM->GetServerName(node_id));
 //  }
 // }
+
+TEST_CASE("TestTaskCache") {
+  hipc::Allocator *alloc = HRUN_CLIENT->main_alloc_;
+  hrun::TaskCache::Depot &depot = hrun::TaskCache::GetDepot();
+  size_t size = 200;
+  size_t cls = hrun::TaskCache::GetClass(size);
+  size_t depth = hrun::TaskCache::GetDepth(cls);
+  size_t batch = hrun::TaskCache::GetBatchSize(cls);
+  depot.Flush();
+  size_t base = alloc->GetCurrentlyAllocatedSize();
+
+  // An empty list is refilled with a whole batch
+  hrun::TaskCache cache;
+  LPointer<char> p = cache.Allocate(alloc, size);
+  REQUIRE(!p.shm_.IsNull());
+  REQUIRE(cache.free_[cls].size() == batch - 1);
+  memset(p.ptr_, 0, hrun::TaskCache::GetClassSize(cls));
+
+  // Freed objects are reused
+  cache.Free(alloc, size, p);
+  LPointer<char> q = cache.Allocate(alloc, size);
+  REQUIRE(q.shm_ == p.shm_);
+  cache.Free(alloc, size, q);
+
+  // A full list gives its oldest batch to the depot
+  std::vector<LPointer<char>> objs;
+  for (size_t i = 0; i < depth + 1; ++i) {
+    objs.emplace_back(cache.Allocate(alloc, size));
+    REQUIRE(!objs.back().shm_.IsNull());
+  }
+  for (LPointer<char> &obj : objs) {
+    cache.Free(alloc, size, obj);
+  }
+  REQUIRE(cache.free_[cls].size() < depth);
+  REQUIRE(depot.batches_[cls].size() == 1);
+
+  // Another cache refills from the depot instead of the allocator
+  hrun::TaskCache other;
+  LPointer<char> r = other.Allocate(alloc, size);
+  REQUIRE(!r.shm_.IsNull());
+  REQUIRE(depot.batches_[cls].empty());
+  REQUIRE(other.free_[cls].size() == batch - 1);
+  other.Free(alloc, size, r);
+
+  // Flushing returns every object to the allocator
+  other.Flush();
+  cache.Flush();
+  REQUIRE(cache.free_[cls].empty());
+  depot.Flush();
+  REQUIRE(alloc->GetCurrentlyAllocatedSize() == base);
+}
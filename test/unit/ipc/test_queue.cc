@@ -0,0 +1,325 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ * Distributed under BSD 3-Clause license.                                   *
+ * Copyright by The HDF Group.                                               *
+ * Copyright by the Illinois Institute of Technology.                        *
+ * All rights reserved.                                                      *
+ *                                                                           *
+ * This file is part of Hermes. The full Hermes copyright notice, including  *
+ * terms governing use, modification, and redistribution, is contained in    *
+ * the COPYING file, which can be found at the top directory. If you do not  *
+ * have access to the file, you may request a copy from help@hdfgroup.org.   *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "basic_test.h"
+#include "hrun/api/hrun_client.h"
+#include "hrun/queue_manager/task_batch.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/** A lane entry which carries \a val in its pointer offset */
+static hrun::LaneData MakeEntry(size_t val) {
+  hipc::Pointer p(hipc::allocator_id_t(0, 1), val);
+  return hrun::LaneData(p, false);
+}
+
+/** The value carried by a lane entry */
+static size_t EntryVal(const hrun::LaneData &entry) {
+  return entry.p_.off_.load();
+}
+
+/** Pop every entry of a lane */
+static std::vector<size_t> DrainLane(hrun::Lane &lane) {
+  std::vector<size_t> vals;
+  hrun::LaneData entries[16];
+  size_t count;
+  while ((count = lane.pop_n(entries, 16)) > 0) {
+    for (size_t i = 0; i < count; ++i) {
+      vals.emplace_back(EntryVal(entries[i]));
+    }
+  }
+  return vals;
+}
+
+TEST_CASE("TestTaskBatchLanes") {
+  hrun::QueueId qid(0, 4);
+  std::vector<PriorityInfo> queue_info = {
+      {TaskPrio::kAdmin, 4, 4, 64, 0}
+  };
+  auto queue = hipc::make_uptr<hrun::MultiQueue>(qid, queue_info);
+  size_t count = 32;
+
+  // Tasks land in the lane of their hash, in the order they were added
+  {
+    hrun::TaskBatch batch;
+    for (size_t i = 0; i < count; ++i) {
+      hrun::LaneData entry = MakeEntry(i);
+      batch.Add(queue.get(), 0, i, entry.p_);
+    }
+    batch.Submit();
+    for (u32 lane_id = 0; lane_id < 4; ++lane_id) {
+      std::vector<size_t> vals = DrainLane(queue->GetLane(0, lane_id));
+      REQUIRE(vals.size() == count / 4);
+      for (size_t i = 0; i < vals.size(); ++i) {
+        REQUIRE(vals[i] == lane_id + 4 * i);
+      }
+    }
+  }
+
+  // Lanes removed before submission receive nothing
+  {
+    hrun::TaskBatch batch;
+    for (size_t i = 0; i < count; ++i) {
+      hrun::LaneData entry = MakeEntry(i);
+      batch.Add(queue.get(), 0, i, entry.p_);
+    }
+    queue->Resize(0, 2);
+    batch.Submit();
+    for (u32 lane_id = 0; lane_id < 4; ++lane_id) {
+      std::vector<size_t> vals = DrainLane(queue->GetLane(0, lane_id));
+      if (lane_id >= 2) {
+        REQUIRE(vals.empty());
+        continue;
+      }
+      REQUIRE(vals.size() == count / 2);
+      for (size_t i = 0; i < vals.size(); ++i) {
+        REQUIRE(vals[i] == lane_id + 2 * i);
+      }
+    }
+  }
+}
+
+TEST_CASE("TestLaneEmplaceNConcurrent") {
+  hrun::QueueId qid(0, 5);
+  std::vector<PriorityInfo> queue_info = {
+      {TaskPrio::kAdmin, 1, 1, 16, 0}
+  };
+  auto queue = hipc::make_uptr<hrun::MultiQueue>(qid, queue_info);
+  hrun::Lane &lane = queue->GetLane(0, 0);
+  size_t nthreads = 4, per_thread = 4096;
+
+  // Producers emplace batches, some larger than the lane
+  std::vector<std::thread> producers;
+  for (size_t tid = 0; tid < nthreads; ++tid) {
+    producers.emplace_back([&lane, tid, per_thread]() {
+      std::vector<hrun::LaneData> batch;
+      size_t seq = 0;
+      for (size_t size = 1; seq < per_thread; size = size % 40 + 1) {
+        batch.clear();
+        for (size_t i = 0; i < size && seq < per_thread; ++i, ++seq) {
+          batch.emplace_back(MakeEntry((tid << 32) | seq));
+        }
+        lane.emplace_n(batch.data(), batch.size());
+      }
+    });
+  }
+
+  // The consumer shrinks and grows the lane while popping
+  std::vector<size_t> next(nthreads, 0);
+  size_t popped = 0, polls = 0;
+  hrun::LaneData entries[8];
+  while (popped < nthreads * per_thread) {
+    size_t count = lane.pop_n(entries, 8);
+    for (size_t i = 0; i < count; ++i) {
+      size_t val = EntryVal(entries[i]);
+      size_t tid = val >> 32;
+      REQUIRE(tid < nthreads);
+      REQUIRE((val & 0xffffffff) == next[tid]);
+      ++next[tid];
+    }
+    popped += count;
+    if (++polls % 64 == 0) {
+      lane.Resize(lane.GetDepth() == 16 ? 8 : 16);
+    }
+  }
+  for (std::thread &producer : producers) {
+    producer.join();
+  }
+  REQUIRE(lane.GetSize() == 0);
+}
+
+TEST_CASE("TestLaneResize") {
+  hrun::QueueId qid(0, 6);
+  std::vector<PriorityInfo> queue_info = {
+      {TaskPrio::kAdmin, 1, 1, 16, 0}
+  };
+  auto queue = hipc::make_uptr<hrun::MultiQueue>(qid, queue_info);
+  hrun::Lane &lane = queue->GetLane(0, 0);
+
+  // Entries keep their order when the ring wraps and is replaced
+  for (size_t i = 0; i < 12; ++i) {
+    lane.emplace(MakeEntry(i));
+  }
+  REQUIRE(lane.pop_n(8) == 8);
+  for (size_t i = 12; i < 20; ++i) {
+    lane.emplace(MakeEntry(i));
+  }
+  REQUIRE(lane.Resize(64));
+  REQUIRE(lane.GetDepth() == 64);
+  REQUIRE(lane.GetSize() == 12);
+  // Shrinking below the number of entries does nothing
+  REQUIRE(!lane.Resize(8));
+  REQUIRE(lane.GetDepth() == 64);
+  REQUIRE(lane.Resize(12));
+  std::vector<size_t> vals = DrainLane(lane);
+  REQUIRE(vals.size() == 12);
+  for (size_t i = 0; i < vals.size(); ++i) {
+    REQUIRE(vals[i] == i + 8);
+  }
+
+  // A resize requested by a producer is applied by the consumer
+  lane.RequestResize(32);
+  REQUIRE(lane.IsResizeRequested());
+  REQUIRE(lane.Resize(lane.resize_depth_.exchange(0)));
+  REQUIRE(!lane.IsResizeRequested());
+  REQUIRE(lane.GetDepth() == 32);
+}
+
+TEST_CASE("TestMultiQueueResizeLanes") {
+  hrun::QueueId qid(0, 7);
+  std::vector<PriorityInfo> queue_info = {
+      {TaskPrio::kAdmin, 4, 8, 64, 0},
+      {TaskPrio::kLongRunning, 4, 8, 64, QUEUE_TETHERED, TaskPrio::kAdmin}
+  };
+  auto queue = hipc::make_uptr<hrun::MultiQueue>(qid, queue_info);
+  hrun::LaneGroup &group = queue->GetGroup(0);
+  hrun::LaneGroup &tethered = queue->GetGroup(1);
+
+  // Removed lanes are retired and asked to shrink
+  queue->Resize(0, 2);
+  REQUIRE(group.num_lanes_ == 2);
+  REQUIRE(tethered.num_lanes_ == 2);
+  REQUIRE(!group.IsRetired(1));
+  REQUIRE(group.IsRetired(3));
+  REQUIRE(queue->GetLane(0, 3).resize_depth_.load() ==
+      hrun::LaneGroup::kRetiredDepth);
+  hrun::LaneData entry = MakeEntry(3);
+  queue->Emplace(0, 3, entry);
+  REQUIRE(queue->GetLane(0, 1).GetSize() == 1);
+  REQUIRE(queue->GetLane(0, 3).GetSize() == 0);
+
+  // Added lanes are created or restored at the group depth
+  queue->Resize(0, 6);
+  REQUIRE(group.num_lanes_ == 6);
+  REQUIRE(group.lanes_->size() == 6);
+  REQUIRE(queue->GetLane(0, 5).GetDepth() == 64);
+  REQUIRE(queue->GetLane(0, 3).resize_depth_.load() == 64);
+
+  // The lane count stays within [1, max_lanes]
+  queue->Resize(0, 100);
+  REQUIRE(group.num_lanes_ == 8);
+  queue->Resize(0, 0);
+  REQUIRE(group.num_lanes_ == 1);
+  REQUIRE(tethered.num_lanes_ == 1);
+  REQUIRE(!queue->IsEmplacePlugged());
+}
+
+TEST_CASE("TestMultiQueueResizeDepth") {
+  hrun::QueueId qid(0, 8);
+  std::vector<PriorityInfo> queue_info = {
+      {TaskPrio::kAdmin, 2, 4, 64, 0}
+  };
+  auto queue = hipc::make_uptr<hrun::MultiQueue>(qid, queue_info);
+  hrun::LaneGroup &group = queue->GetGroup(0);
+
+  // Only the active lanes are asked to resize, never below retired depth
+  queue->ResizeDepth(0, 4);
+  REQUIRE(group.depth_ == hrun::LaneGroup::kRetiredDepth);
+  REQUIRE(queue->GetLane(0, 0).resize_depth_.load() ==
+      hrun::LaneGroup::kRetiredDepth);
+  queue->ResizeDepth(0, 128);
+  REQUIRE(group.depth_ == 128);
+  REQUIRE(queue->GetLane(0, 1).resize_depth_.load() == 128);
+  hrun::Lane &lane = queue->GetLane(0, 0);
+  REQUIRE(lane.Resize(lane.resize_depth_.exchange(0)));
+  REQUIRE(lane.GetDepth() == 128);
+}
+
+TEST_CASE("TestMultiQueueGrow") {
+  hrun::QueueId qid(0, 9);
+  std::vector<PriorityInfo> queue_info = {
+      {TaskPrio::kAdmin, 1, 2, 16, 0}
+  };
+  auto queue = hipc::make_uptr<hrun::MultiQueue>(qid, queue_info);
+  hrun::LaneGroup &group = queue->GetGroup(0);
+  hrun::Lane &lane = queue->GetLane(0, 0);
+
+  // A busy lane doubles in depth up to max_depth_
+  size_t depth = lane.GetDepth();
+  while (depth < group.max_depth_) {
+    queue->Grow(0, 0);
+    REQUIRE(lane.GetDepth() == std::min<size_t>(depth * 2, group.max_depth_));
+    depth = lane.GetDepth();
+  }
+  REQUIRE(group.num_lanes_ == 1);
+
+  // Then the group gains lanes up to max_lanes_
+  queue->Grow(0, 0);
+  REQUIRE(group.num_lanes_ == 2);
+  queue->Grow(0, 0);
+  REQUIRE(group.num_lanes_ == 2);
+  REQUIRE(lane.GetDepth() == group.max_depth_);
+}
+
+TEST_CASE("TestMultiQueueResizeConcurrent") {
+  hrun::QueueId qid(0, 10);
+  std::vector<PriorityInfo> queue_info = {
+      {TaskPrio::kAdmin, 4, 4, 16, 0}
+  };
+  auto queue = hipc::make_uptr<hrun::MultiQueue>(qid, queue_info);
+  size_t nthreads = 4, per_thread = 8192;
+
+  // Producers emplace single entries over every lane hash
+  std::vector<std::thread> producers;
+  for (size_t tid = 0; tid < nthreads; ++tid) {
+    producers.emplace_back([&queue, tid, per_thread]() {
+      for (size_t seq = 0; seq < per_thread; ++seq) {
+        queue->Emplace(0, (u32)(seq % 7), MakeEntry((tid << 32) | seq));
+      }
+    });
+  }
+
+  // A resizer changes the lane count and depth while producers run
+  std::atomic<bool> done(false);
+  std::thread resizer([&queue, &done]() {
+    for (u32 i = 0; !done.load(); ++i) {
+      queue->Resize(0, 1 + i % 4);
+      queue->ResizeDepth(0, (i % 2) ? 16 : 64);
+      std::this_thread::yield();
+    }
+  });
+
+  // The consumer drains every lane, applying requested resizes, and
+  // receives each entry exactly once
+  std::vector<std::vector<bool>> seen(
+      nthreads, std::vector<bool>(per_thread, false));
+  size_t popped = 0;
+  hrun::LaneData entries[8];
+  while (popped < nthreads * per_thread) {
+    for (u32 lane_id = 0; lane_id < 4; ++lane_id) {
+      hrun::Lane &lane = queue->GetLane(0, lane_id);
+      if (lane.IsResizeRequested()) {
+        u32 depth = lane.resize_depth_.exchange(0);
+        if (!lane.Resize(depth)) {
+          u32 none = 0;
+          lane.resize_depth_.compare_exchange_strong(none, depth);
+        }
+      }
+      size_t count = lane.pop_n(entries, 8);
+      for (size_t i = 0; i < count; ++i) {
+        size_t val = EntryVal(entries[i]);
+        size_t tid = val >> 32, seq = val & 0xffffffff;
+        REQUIRE(tid < nthreads);
+        REQUIRE(seq < per_thread);
+        REQUIRE(!seen[tid][seq]);
+        seen[tid][seq] = true;
+      }
+      popped += count;
+    }
+  }
+  done.store(true);
+  resizer.join();
+  for (std::thread &producer : producers) {
+    producer.join();
+  }
+}
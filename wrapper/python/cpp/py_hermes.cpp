@@ -11,6 +11,7 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 #include <hrun/hrun_types.h>
 #include "hermes/hermes.h"
@@ -28,8 +29,16 @@ using hermes::TargetStats;
 using hermes::TagInfo;
 using hermes::MetadataTable;
 using hermes::Hermes;
+using hermes::Bucket;
+using hermes::Blob;
+using hermes::Context;
+using hermes::EvictionPolicy;
+using hermes::GetBlobTask;
 using hrun::UniqueId;
 
+/** A get in flight, as returned by AsyncGetBlobRoot */
+typedef LPointer<hrunpq::TypedPushTask<GetBlobTask>> GET_TASK_T;
+
 bool TRANSPARENT_HERMES_FUN() {
   if (TRANSPARENT_HRUN()) {
     HERMES_CONF->ClientInit();
@@ -91,7 +100,12 @@ void BindTargetStats(py::module &m) {
       .def_readonly("max_cap", &TargetStats::max_cap_)
       .def_readonly("bandwidth", &TargetStats::bandwidth_)
       .def_readonly("latency", &TargetStats::latency_)
-      .def_readonly("score", &TargetStats::score_);
+      .def_readonly("score", &TargetStats::score_)
+      .def_readonly("dedup_logical", &TargetStats::dedup_logical_)
+      .def_readonly("dedup_physical", &TargetStats::dedup_physical_)
+      .def_readonly("dedup_index_size", &TargetStats::dedup_index_size_)
+      .def_readonly("crc_errors", &TargetStats::crc_errors_)
+      .def("get_dedup_ratio", &TargetStats::GetDedupRatio);
 }
 
 void BindTagInfo(py::module &m) {
@@ -99,7 +113,9 @@ void BindTagInfo(py::module &m) {
       .def(py::init<>())
       .def_readonly("tag_id", &TagInfo::tag_id_)
       .def("get_name", &TagInfo::GetName)
-      .def_readonly("blobs", &TagInfo::blobs_)
+      .def_property_readonly("blobs", [](const TagInfo &tag) {
+        return std::vector<BlobId>(tag.blobs_.begin(), tag.blobs_.end());
+      })
       .def_readonly("traits", &TagInfo::traits_)
       .def_readonly("internal_size", &TagInfo::internal_size_)
       .def_readonly("page_size", &TagInfo::page_size_)
@@ -114,12 +130,308 @@ void BindMetadataTable(py::module &m) {
       .def_readonly("bkt_info", &MetadataTable::bkt_info_);
 }
 
+/**
+ * Wrap a Python object implementing the buffer protocol as a Blob.
+ * The Blob does not own the memory, which must be C-contiguous.
+ * */
+Blob WrapBuffer(const py::buffer &buf, py::buffer_info &info) {
+  info = buf.request();
+  ssize_t stride = info.itemsize;
+  for (ssize_t i = info.ndim - 1; i >= 0; --i) {
+    if (info.shape[i] > 1 && info.strides[i] != stride) {
+      throw py::value_error("Buffer must be C-contiguous");
+    }
+    stride *= info.shape[i];
+  }
+  return Blob((char*)info.ptr, info.size * info.itemsize);
+}
+
+/**
+ * Wrap \a size bytes of shared memory returned by a get as a NumPy array.
+ * The array does not copy the data. The buffer is freed once the array
+ * and every view of it are released.
+ * */
+py::array WrapShmBuffer(hipc::Pointer &data, size_t size,
+                        const py::dtype &dtype) {
+  size_t itemsize = dtype.itemsize();
+  if (size % itemsize != 0) {
+    HRUN_CLIENT->FreeBuffer(data);
+    throw py::value_error("Blob size is not a multiple of the item size");
+  }
+  char *ptr = HRUN_CLIENT->GetDataPointer(data);
+  auto *owned = new hipc::Pointer(data);
+  py::capsule release(owned, [](void *p) {
+    auto *shm = reinterpret_cast<hipc::Pointer*>(p);
+    HRUN_CLIENT->FreeBuffer(*shm);
+    delete shm;
+  });
+  return py::array(dtype, {size / itemsize}, {itemsize}, ptr, release);
+}
+
+/**
+ * A get in flight. Wait returns the data as a NumPy array backed by
+ * shared memory. A get which is never waited for is freed on destruction.
+ * */
+class GetFuture {
+ public:
+  GET_TASK_T task_;  /**< The get task, null once waited for */
+  py::dtype dtype_;  /**< The dtype of the returned array */
+
+ public:
+  /** Emplace constructor */
+  GetFuture(GET_TASK_T task, const py::dtype &dtype)
+      : task_(task), dtype_(dtype) {}
+
+  /** Tasks would be freed twice */
+  GetFuture(const GetFuture &other) = delete;
+
+  /** Move constructor */
+  GetFuture(GetFuture &&other) noexcept
+      : task_(other.task_), dtype_(std::move(other.dtype_)) {
+    other.task_.ptr_ = nullptr;
+  }
+
+  /** Free the get if it was never waited for */
+  ~GetFuture() {
+    if (task_.ptr_ == nullptr) {
+      return;
+    }
+    task_->Wait();
+    HRUN_CLIENT->FreeBuffer(task_->get()->data_);
+    HRUN_CLIENT->DelTask(task_);
+  }
+
+  /** Whether the get has completed */
+  bool IsComplete() {
+    return task_.ptr_ == nullptr || task_->IsComplete();
+  }
+
+  /** Wait for the get and return its data */
+  py::array Wait() {
+    if (task_.ptr_ == nullptr) {
+      throw py::value_error("Get was already waited for");
+    }
+    {
+      py::gil_scoped_release release;
+      task_->Wait();
+    }
+    GetBlobTask *task = task_->get();
+    hipc::Pointer data = task->data_;
+    size_t size = task->data_size_;
+    HRUN_CLIENT->DelTask(task_);
+    task_.ptr_ = nullptr;
+    return WrapShmBuffer(data, size, dtype_);
+  }
+};
+
+/** Start a get of \a size bytes at \a off. A size of 0 gets the blob. */
+GET_TASK_T AsyncGetBlob(Bucket &bkt, const std::string &name,
+                        size_t size, size_t off, Context &ctx) {
+  if (size == 0) {
+    size = bkt.GetBlobSize(name);
+  }
+  Blob blob((char*)nullptr, size);
+  return bkt.AsyncPartialGet(name, blob, off, ctx);
+}
+
+/** Put several blobs, submitting the puts as batches */
+void PutBlobs(Bucket &bkt, const std::vector<std::string> &names,
+              const std::vector<py::buffer> &bufs, Context &ctx) {
+  if (names.size() != bufs.size()) {
+    throw py::value_error("names and buffers differ in length");
+  }
+  std::vector<py::buffer_info> infos(bufs.size());
+  std::vector<Blob> blobs;
+  blobs.reserve(bufs.size());
+  for (size_t i = 0; i < bufs.size(); ++i) {
+    blobs.emplace_back(WrapBuffer(bufs[i], infos[i]));
+  }
+  py::gil_scoped_release release;
+  hrun::TaskBatch batch;
+  for (size_t i = 0; i < names.size(); ++i) {
+    bkt.AsyncPut(batch, names[i], blobs[i], ctx);
+  }
+  batch.Submit();
+}
+
+/** Get several blobs. At most TaskBatch::kMaxTasks gets are in flight. */
+std::vector<py::array> GetBlobs(Bucket &bkt,
+                                const std::vector<std::string> &names,
+                                const py::dtype &dtype, Context &ctx) {
+  std::vector<py::array> arrays;
+  arrays.reserve(names.size());
+  std::vector<GET_TASK_T> tasks;
+  std::vector<GetFuture> futures;
+  for (size_t i = 0; i < names.size(); i += hrun::TaskBatch::kMaxTasks) {
+    size_t end = std::min(names.size(), i + hrun::TaskBatch::kMaxTasks);
+    tasks.clear();
+    futures.clear();
+    {
+      py::gil_scoped_release release;
+      for (size_t j = i; j < end; ++j) {
+        tasks.emplace_back(AsyncGetBlob(bkt, names[j], 0, 0, ctx));
+      }
+    }
+    for (GET_TASK_T &task : tasks) {
+      futures.emplace_back(task, dtype);
+    }
+    for (GetFuture &future : futures) {
+      arrays.emplace_back(future.Wait());
+    }
+  }
+  return arrays;
+}
+
+void BindContext(py::module &m) {
+  py::enum_<EvictionPolicy>(m, "EvictionPolicy")
+      .value("kLru", EvictionPolicy::kLru)
+      .value("kLfu", EvictionPolicy::kLfu)
+      .value("kArc", EvictionPolicy::kArc)
+      .value("kTtl", EvictionPolicy::kTtl)
+      .value("kNone", EvictionPolicy::kNone);
+  py::class_<Context>(m, "Context")
+      .def(py::init<>())
+      .def_readwrite("blob_score", &Context::blob_score_)
+      .def_readwrite("node_id", &Context::node_id_)
+      .def_readwrite("ec_data", &Context::ec_data_)
+      .def_readwrite("ec_parity", &Context::ec_parity_)
+      .def_readwrite("qos_tenant", &Context::qos_tenant_)
+      .def_readwrite("evict_policy", &Context::evict_policy_)
+      .def_readwrite("evict_ttl", &Context::evict_ttl_)
+      .def_readwrite("dedup", &Context::dedup_)
+      .def_readwrite("checksum", &Context::checksum_);
+}
+
+void BindBucket(py::module &m) {
+  py::class_<GetFuture>(m, "GetFuture")
+      .def("IsComplete", &GetFuture::IsComplete)
+      .def("Wait", &GetFuture::Wait);
+
+  py::class_<Bucket>(m, "Bucket")
+      .def(py::init([](const std::string &name, Context &ctx,
+                       size_t backend_size, u32 flags) {
+             return Bucket(name, ctx, backend_size, flags);
+           }),
+           py::arg("name"), py::arg("ctx") = Context(),
+           py::arg("backend_size") = 0, py::arg("flags") = 0)
+      .def("GetName", &Bucket::GetName)
+      .def("GetId", &Bucket::GetId)
+      .def("GetSize", &Bucket::GetSize)
+      .def("Clear", &Bucket::Clear)
+      .def("Destroy", &Bucket::Destroy)
+      .def("GetBlobId", &Bucket::GetBlobId)
+      .def("ContainsBlob", &Bucket::ContainsBlob)
+      .def("GetBlobSize",
+           py::overload_cast<const std::string&>(&Bucket::GetBlobSize))
+      .def("Put",
+           [](Bucket &bkt, const std::string &name, const py::buffer &buf,
+              Context &ctx) {
+             py::buffer_info info;
+             Blob blob = WrapBuffer(buf, info);
+             py::gil_scoped_release release;
+             return bkt.Put(name, blob, ctx);
+           },
+           py::arg("name"), py::arg("buf"), py::arg("ctx") = Context())
+      .def("PartialPut",
+           [](Bucket &bkt, const std::string &name, const py::buffer &buf,
+              size_t off, Context &ctx) {
+             py::buffer_info info;
+             Blob blob = WrapBuffer(buf, info);
+             py::gil_scoped_release release;
+             return bkt.PartialPut(name, blob, off, ctx);
+           },
+           py::arg("name"), py::arg("buf"), py::arg("off"),
+           py::arg("ctx") = Context())
+      .def("AsyncPut",
+           [](Bucket &bkt, const std::string &name, const py::buffer &buf,
+              Context &ctx) {
+             // The data is copied to shared memory before returning
+             py::buffer_info info;
+             Blob blob = WrapBuffer(buf, info);
+             py::gil_scoped_release release;
+             bkt.AsyncPut(name, blob, ctx);
+           },
+           py::arg("name"), py::arg("buf"), py::arg("ctx") = Context())
+      .def("AsyncPartialPut",
+           [](Bucket &bkt, const std::string &name, const py::buffer &buf,
+              size_t off, Context &ctx) {
+             py::buffer_info info;
+             Blob blob = WrapBuffer(buf, info);
+             py::gil_scoped_release release;
+             bkt.AsyncPartialPut(name, blob, off, ctx);
+           },
+           py::arg("name"), py::arg("buf"), py::arg("off"),
+           py::arg("ctx") = Context())
+      .def("Get",
+           [](Bucket &bkt, const std::string &name, const py::dtype &dtype,
+              Context &ctx) {
+             GET_TASK_T task;
+             {
+               py::gil_scoped_release release;
+               task = AsyncGetBlob(bkt, name, 0, 0, ctx);
+             }
+             return GetFuture(task, dtype).Wait();
+           },
+           py::arg("name"), py::arg("dtype") = py::dtype("uint8"),
+           py::arg("ctx") = Context())
+      .def("PartialGet",
+           [](Bucket &bkt, const std::string &name, size_t size, size_t off,
+              const py::dtype &dtype, Context &ctx) {
+             GET_TASK_T task;
+             {
+               py::gil_scoped_release release;
+               task = AsyncGetBlob(bkt, name, size, off, ctx);
+             }
+             return GetFuture(task, dtype).Wait();
+           },
+           py::arg("name"), py::arg("size"), py::arg("off"),
+           py::arg("dtype") = py::dtype("uint8"),
+           py::arg("ctx") = Context())
+      .def("AsyncGet",
+           [](Bucket &bkt, const std::string &name, const py::dtype &dtype,
+              Context &ctx) {
+             GET_TASK_T task;
+             {
+               py::gil_scoped_release release;
+               task = AsyncGetBlob(bkt, name, 0, 0, ctx);
+             }
+             return std::make_unique<GetFuture>(task, dtype);
+           },
+           py::arg("name"), py::arg("dtype") = py::dtype("uint8"),
+           py::arg("ctx") = Context())
+      .def("AsyncPartialGet",
+           [](Bucket &bkt, const std::string &name, size_t size, size_t off,
+              const py::dtype &dtype, Context &ctx) {
+             GET_TASK_T task;
+             {
+               py::gil_scoped_release release;
+               task = AsyncGetBlob(bkt, name, size, off, ctx);
+             }
+             return std::make_unique<GetFuture>(task, dtype);
+           },
+           py::arg("name"), py::arg("size"), py::arg("off"),
+           py::arg("dtype") = py::dtype("uint8"),
+           py::arg("ctx") = Context())
+      .def("PutBlobs", &PutBlobs,
+           py::arg("names"), py::arg("bufs"), py::arg("ctx") = Context())
+      .def("GetBlobs", &GetBlobs,
+           py::arg("names"), py::arg("dtype") = py::dtype("uint8"),
+           py::arg("ctx") = Context());
+}
+
 void BindHermes(py::module &m) {
   py::class_<Hermes>(m, "Hermes")
       .def(py::init<>())
       .def("ClientInit", &Hermes::ClientInit)
       .def("IsInitialized", &Hermes::IsInitialized)
       .def("GetTagId", &Hermes::GetTagId)
+      .def("GetBucket",
+           [](Hermes &hermes, const std::string &name, Context &ctx,
+              size_t backend_size, u32 flags) {
+             return hermes.GetBucket(name, ctx, backend_size, flags);
+           },
+           py::arg("name"), py::arg("ctx") = Context(),
+           py::arg("backend_size") = 0, py::arg("flags") = 0)
       .def("CollectMetadataSnapshot", &Hermes::CollectMetadataSnapshot);
   m.def("TRANSPARENT_HERMES", &TRANSPARENT_HERMES_FUN);
 }
@@ -134,5 +446,7 @@ PYBIND11_MODULE(py_hermes, m) {
   BindTargetStats(m);
   BindTagInfo(m);
   BindMetadataTable(m);
+  BindContext(m);
+  BindBucket(m);
   BindHermes(m);
 }
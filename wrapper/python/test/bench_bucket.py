@@ -0,0 +1,63 @@
+"""
+Measure the throughput of the Python Bucket API.
+
+Usage: python3 bench_bucket.py [max_size_mb] [reps]
+"""
+import sys
+import time
+import numpy as np
+from py_hermes import Hermes, TRANSPARENT_HERMES
+
+
+def timed(fn, reps):
+    start = time.perf_counter()
+    for _ in range(reps):
+        fn()
+    return (time.perf_counter() - start) / reps
+
+
+def report(name, size, secs):
+    print("{:<24} {:>10} {:>10.3f} ms {:>10.1f} MBps".format(
+        name, size, secs * 1000, size / secs / (1 << 20)))
+
+
+def bench_put_get(bkt, size, reps):
+    data = np.random.randint(0, 255, size, dtype=np.uint8)
+    report("Put", size, timed(lambda: bkt.Put("bench", data), reps))
+    # Zero-copy: the array is backed by the shared-memory buffer
+    report("Get", size, timed(lambda: bkt.Get("bench"), reps))
+    # What a Get would cost if it returned a copy
+    report("Get+copy", size, timed(lambda: bkt.Get("bench").tobytes(), reps))
+
+
+def bench_multi(bkt, count, size, reps):
+    data = np.random.randint(0, 255, size, dtype=np.uint8)
+    names = ["multi%d" % i for i in range(count)]
+    bufs = [data] * count
+    total = count * size
+    report("Put (loop)", total,
+           timed(lambda: [bkt.Put(n, data) for n in names], reps))
+    report("PutBlobs", total, timed(lambda: bkt.PutBlobs(names, bufs), reps))
+    report("Get (loop)", total,
+           timed(lambda: [bkt.Get(n) for n in names], reps))
+    report("GetBlobs", total, timed(lambda: bkt.GetBlobs(names), reps))
+
+
+def main():
+    max_mb = int(sys.argv[1]) if len(sys.argv) > 1 else 100
+    reps = int(sys.argv[2]) if len(sys.argv) > 2 else 4
+    TRANSPARENT_HERMES()
+    hermes = Hermes()
+    bkt = hermes.GetBucket("py_bench_bucket")
+    print("{:<24} {:>10} {:>13} {:>15}".format(
+        "Test", "Bytes", "Latency", "Bandwidth"))
+    size = 4096
+    while size <= max_mb * (1 << 20):
+        bench_put_get(bkt, size, reps)
+        size *= 16
+    bench_multi(bkt, 1024, 4096, reps)
+    bkt.Destroy()
+
+
+if __name__ == "__main__":
+    main()
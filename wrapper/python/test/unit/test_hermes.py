@@ -10,3 +10,20 @@ class TestHermes(TestCase):
         mdm = hermes.CollectMetadataSnapshot()
         print(mdm.blob_info)
         print("Done")
+
+    def test_bucket_put_get(self):
+        import numpy as np
+        TRANSPARENT_HERMES()
+        hermes = Hermes()
+        bkt = hermes.GetBucket("py_bucket_put_get")
+        data = np.arange(1024, dtype=np.uint32)
+        bkt.Put("blob", data)
+        out = bkt.Get("blob", dtype=np.uint32)
+        self.assertTrue(np.array_equal(data, out))
+        part = bkt.PartialGet("blob", 16, 4)
+        self.assertEqual(part.tobytes(), data.tobytes()[4:20])
+        names = ["blob%d" % i for i in range(100)]
+        bkt.PutBlobs(names, [data] * len(names))
+        for out in bkt.GetBlobs(names, dtype=np.uint32):
+            self.assertTrue(np.array_equal(data, out))
+        bkt.Destroy()